@@ -0,0 +1,59 @@
+import os
+import time
+import pytest
+
+from tomviz_acquisition.acquisition.vendors.passive import filesystem
+from tomviz_acquisition.acquisition.vendors.passive.filesystem import (
+    InotifyMonitor, PollingMonitor)
+
+monitors = [PollingMonitor]
+if filesystem._libc is not None:
+    monitors.append(InotifyMonitor)
+
+
+def _write(path, name, content='image'):
+    with open(os.path.join(path, name), 'w') as fp:
+        fp.write(content)
+    # Distinct mtimes, to order the files written before the monitor
+    time.sleep(0.01)
+
+
+def _pending(monitor):
+    files = []
+    while True:
+        f = monitor.get()
+        if f is None:
+            return files
+        files.append(os.path.basename(f))
+
+
+@pytest.mark.parametrize('cls', monitors)
+def test_new_files(cls, tmpdir):
+    path = tmpdir.strpath
+    checked = []
+
+    def valid_file_check(filepath):
+        checked.append(os.path.basename(filepath))
+        with open(filepath) as fp:
+            return fp.read() != 'partial'
+
+    _write(path, '0.tif')
+    monitor = cls(path, filename_regex=r'.*\.tif',
+                  valid_file_check=valid_file_check)
+    for i in range(1, 4):
+        _write(path, '%d.tif' % i)
+    _write(path, 'ignored.txt')
+    _write(path, 'partial.tif', 'partial')
+
+    assert _pending(monitor) == ['0.tif', '1.tif', '2.tif', '3.tif']
+    # Each file is only validated once
+    assert sorted(checked) == ['0.tif', '1.tif', '2.tif', '3.tif',
+                               'partial.tif']
+
+    # Files that failed validation are checked again once written
+    _write(path, 'partial.tif', 'image')
+    assert _pending(monitor) == ['partial.tif']
+    assert checked.count('partial.tif') == 2
+    assert _pending(monitor) == []
+
+    monitor.close()
@@ -4,6 +4,8 @@ import hashlib
 import sys
 import os
 import re
+import json
+import struct
 from PIL import Image
 import dm3_lib as dm3
 
@@ -175,6 +177,104 @@ def test_tiff_stem_acquire(passive_acquisition_server, tmpdir,
             assert md5.hexdigest() == expected_md5.hexdigest()
 
 
+def read_frames(response, count=None):
+    """Reads count frames, or all of them until the stream ends."""
+    stream = response.raw
+    frames = []
+    while count is None or len(frames) < count:
+        length = stream.read(4)
+        if count is None and not length:
+            break
+
+        (header_length,) = struct.unpack('<I', length)
+        # Heartbeat
+        if header_length == 0:
+            continue
+
+        header = json.loads(stream.read(header_length).decode('utf8'))
+        data = stream.read(header['size'])
+        assert len(data) == header['size']
+        frames.append((header, data))
+
+    return frames
+
+
+def test_tiff_stream(passive_acquisition_server, tmpdir,
+                     mock_tiff_tiltseries_writer):
+    id = 1234
+    request = jsonrpc_message({
+        'id': id,
+        'method': 'connect',
+        'params': {
+            'path': tmpdir.strpath,
+            'fileNameRegex': r'.*\.tif'
+        }
+    })
+    response = requests.post(passive_acquisition_server.url, json=request)
+    assert response.status_code == 200, response.content
+
+    series_size = mock_tiff_tiltseries_writer.series_size
+    url = '%s/stream?frames=%d' % (passive_acquisition_server.base_url,
+                                   series_size)
+    response = requests.get(url, stream=True, timeout=60)
+    assert response.status_code == 200, response.content
+    assert response.headers['Content-Type'] == \
+        'application/x-tomviz-frames'
+
+    frames = read_frames(response, series_size)
+    # The stream ends after the frames asked for
+    assert response.raw.read() == b''
+    response.close()
+
+    # Now check we got the right images, in order
+    with Image.open(test_image()) as image_stack:
+        for i in range(0, image_stack.n_frames):
+            (header, data) = frames[i]
+            assert header['mimeType'] == 'image/tiff'
+
+            image_stack.seek(i)
+            expected_md5 = hashlib.md5()
+            expected_md5.update(tobytes(image_stack))
+            assert hashlib.md5(data).hexdigest() == expected_md5.hexdigest()
+
+
+def test_tiff_stream_restart(passive_acquisition_server, tmpdir,
+                             mock_tiff_tiltseries_writer):
+    id = 1234
+    request = jsonrpc_message({
+        'id': id,
+        'method': 'connect',
+        'params': {
+            'path': tmpdir.strpath,
+            'fileNameRegex': r'.*\.tif'
+        }
+    })
+    response = requests.post(passive_acquisition_server.url, json=request)
+    assert response.status_code == 200, response.content
+
+    url = '%s/stream' % passive_acquisition_server.base_url
+    first = requests.get(url, stream=True, timeout=60)
+    frames = read_frames(first, 2)
+
+    # A new stream ends the previous one, which has written every frame it
+    # took from the adapter
+    series_size = mock_tiff_tiltseries_writer.series_size
+    second = requests.get(url, params={'frames': series_size}, stream=True,
+                          timeout=60)
+    frames += read_frames(first)
+    first.close()
+    frames += read_frames(second, series_size - len(frames))
+    second.close()
+
+    with Image.open(test_image()) as image_stack:
+        for i in range(0, image_stack.n_frames):
+            image_stack.seek(i)
+            expected_md5 = hashlib.md5()
+            expected_md5.update(tobytes(image_stack))
+            assert hashlib.md5(frames[i][1]).hexdigest() == \
+                expected_md5.hexdigest()
+
+
 def test_dm3_stem_acquire(passive_acquisition_server, tmpdir,
                           mock_dm3_tiltseries_writer):
     id = 1234
@@ -245,3 +345,25 @@ def test_dm3_stem_acquire(passive_acquisition_server, tmpdir,
         expected_md5.update(tiff_image_data)
 
         assert md5.hexdigest() == expected_md5.hexdigest()
+
+
+def test_disconnected_stem_acquire(passive_acquisition_server, tmpdir):
+    id = 1234
+    for method, params in [('connect', {'path': tmpdir.strpath}),
+                           ('disconnect', {})]:
+        request = jsonrpc_message({
+            'id': id,
+            'method': method,
+            'params': params
+        })
+        response = requests.post(passive_acquisition_server.url, json=request)
+        assert response.status_code == 200, response.content
+
+    # Without a monitor there is nothing to acquire
+    request = jsonrpc_message({
+        'id': id,
+        'method': 'stem_acquire'
+    })
+    response = requests.post(passive_acquisition_server.url, json=request)
+    assert response.status_code == 200, response.content
+    assert response.json()['result'] is None
@@ -7,6 +7,7 @@ import inspect
 
 from tomviz_acquisition.jsonrpc import jsonrpc_message
 from tests.mock.source import ApiAdapter
+from tomviz_acquisition.acquisition import server
 
 
 def test_invalid_content_type(acquisition_server):
@@ -370,3 +371,4 @@ def test_deploy(acquisition_dev_server, sentinel_path1, sentinel_path2):
     assert os.path.exists(sentinel_path2)
     with open(sentinel_path2) as fp:
         assert fp.read() == '%sx2' % magic
+
@@ -1,6 +1,12 @@
+import io
 import os
 import sys
+import json
+import struct
 import tempfile
+import time
+import threading
+from collections import deque
 import importlib
 import inspect
 import logging
@@ -19,16 +25,61 @@ try:
 except ImportError:
     pass
 
+try:
+    from socketserver import ThreadingMixIn
+except ImportError:
+    from SocketServer import ThreadingMixIn
+from wsgiref.simple_server import WSGIServer
+
 
 ADAPTER = 'tests.mock.source.ApiAdapter'
 HOST = 'localhost'
 PORT = 8080
 LOG_BUF_SIZE = 65536
+# The most bytes of frames sent in one write of a stream
+STREAM_BATCH_SIZE = 64 * 1024 * 1024
+# How long a stream waits between checks for new frames, in seconds
+STREAM_POLL_INTERVAL = 0.05
+# How often an idle stream writes an empty message, to find closed clients
+STREAM_HEARTBEAT_INTERVAL = 5.0
+STREAM_MIME_TYPE = 'application/x-tomviz-frames'
 
 logger = logging.getLogger('tomviz_acquisition')
 app = Bottle()
 
 
+class ThreadingWSGIServer(ThreadingMixIn, WSGIServer):
+    """A thread per request, so that frame streams don't block the JSON-RPC
+    endpoints."""
+    daemon_threads = True
+
+
+def _encode_frame(source_adapter, data):
+    """Returns the MIME type and bytes of a frame. Arrays are sent raw, after
+    a NumPy header giving their dtype and shape, so the client can use them
+    without decoding an image."""
+    if hasattr(data, 'dtype') and hasattr(data, 'shape'):
+        import numpy as np
+        buffer = io.BytesIO()
+        np.save(buffer, data)
+        return 'application/octet-stream', buffer.getvalue()
+
+    return getattr(source_adapter, 'image_data_mimetype', 'image/tiff'), data
+
+
+def frame_message(mimetype, data, meta=None):
+    """A message of a frame stream: the length of a JSON header as a little
+    endian uint32, the header, then the bytes of the frame. A zero length
+    header, without a frame, keeps an idle stream alive."""
+    header = json.dumps({
+        'mimeType': mimetype,
+        'size': len(data),
+        'meta': meta or {}
+    }).encode('utf8')
+
+    return struct.pack('<I', len(header)) + header + data
+
+
 def _load_source_adapter(source_adapter):
     logger.info('Loading source_adapter: %s', source_adapter)
     # First load the chosen source_adapter
@@ -65,7 +116,30 @@ def _setup_adapter(source_adapter): # noqa
                                AbstractSource.__name__]))
 
     source_adapter = cls()
+    # The latest preview and acquired frame, for clients to fetch
     slices = {}
+    # The adapter is called from several request threads, one at a time
+    adapter_lock = threading.RLock()
+    # Only the latest stream pulls frames, older ones end once it starts
+    streams = {'active': 0}
+    # Frames pulled for a stream that ended before they were written, handed
+    # to the next consumer first
+    unsent = deque()
+
+    def _end_streams(discard_unsent=False):
+        with adapter_lock:
+            streams['active'] += 1
+            if discard_unsent:
+                unsent.clear()
+
+    def _acquire(stream_id=None):
+        with adapter_lock:
+            if stream_id is not None and streams['active'] != stream_id:
+                return None
+            if unsent:
+                return unsent.popleft()
+
+            return source_adapter.stem_acquire()
 
     @jsonrpc.endpoint(path='/acquisition')
     @inject(source_adapter)
@@ -91,22 +165,28 @@ def _setup_adapter(source_adapter): # noqa
     @jsonrpc.endpoint(path='/acquisition')
     @inject(source_adapter)
     def connect(source_adapter, **params):
-        return source_adapter.connect(**params)
+        with adapter_lock:
+            _end_streams(discard_unsent=True)
+            return source_adapter.connect(**params)
 
     @jsonrpc.endpoint(path='/acquisition')
     @inject(source_adapter)
     def disconnect(source_adapter, **params):
-        return source_adapter.disconnect(**params)
+        with adapter_lock:
+            _end_streams(discard_unsent=True)
+            return source_adapter.disconnect(**params)
 
     @jsonrpc.endpoint(path='/acquisition')
     @inject(source_adapter)
     def tilt_params(source_adapter, **params):
-        return source_adapter.tilt_params(**params)
+        with adapter_lock:
+            return source_adapter.tilt_params(**params)
 
     @jsonrpc.endpoint(path='/acquisition')
     @inject(source_adapter)
     def acquisition_params(source_adapter, **params):
-        return source_adapter.acquisition_params(**params)
+        with adapter_lock:
+            return source_adapter.acquisition_params(**params)
 
     def _base_url():
         return '%s://%s' % (bottle.request.urlparts.scheme,
@@ -116,14 +196,15 @@ def _setup_adapter(source_adapter): # noqa
     @inject(source_adapter)
     def preview_scan(source_adapter):
         id = 'preview_scan_slice'
-        slices[id] = source_adapter.preview_scan()
+        with adapter_lock:
+            slices[id] = source_adapter.preview_scan()
         return '%s/data/%s' % (_base_url(), id)
 
     @jsonrpc.endpoint(path='/acquisition')
     @inject(source_adapter)
     def stem_acquire(source_adapter):
         id = 'stem_acquire_slice'
-        data = source_adapter.stem_acquire()
+        data = _acquire()
 
         if data is None:
             return None
@@ -147,15 +228,79 @@ def _setup_adapter(source_adapter): # noqa
     @route('/data/<id>')
     @inject(source_adapter)
     def data(source_adapter, id):
-        bottle.response.headers['Content-Type'] = 'image/tiff'
-        if hasattr(source_adapter, 'image_data_mimetype'):
-            bottle.response.headers['Content-Type'] \
-                = source_adapter.image_data_mimetype
-
-        if id not in slices:
+        try:
+            frame = slices[id]
+        except KeyError:
             raise HTTPResponse(body='Acquisition data not found.', status=404)
 
-        return slices[id]
+        mimetype, data = _encode_frame(source_adapter, frame)
+        bottle.response.headers['Content-Type'] = mimetype
+
+        return data
+
+    @route('/stream')
+    @inject(source_adapter)
+    def stream(source_adapter):
+        """Pushes frames to the client as soon as the adapter has them. The
+        frames that are ready are sent together, in one batch. A batch is
+        only made once the previous one has been written, so a client that
+        falls behind leaves the frames with the adapter rather than in
+        memory. The frames query parameter ends the stream after that many
+        frames.
+
+        Only one stream is active at a time. A new stream, connect or
+        disconnect ends the previous one, and the frames it had pulled but
+        not written go to the next consumer."""
+        limit = int(bottle.request.query.frames or 0)
+        batch_size = int(bottle.request.query.batch or STREAM_BATCH_SIZE)
+        bottle.response.headers['Content-Type'] = STREAM_MIME_TYPE
+        bottle.response.headers['Cache-Control'] = 'no-cache'
+
+        with adapter_lock:
+            _end_streams()
+            stream_id = streams['active']
+
+        def active():
+            return streams['active'] == stream_id
+
+        def frames():
+            sent = 0
+            last_write = time.time()
+            while active() and (limit == 0 or sent < limit):
+                pulled = []
+                batch = []
+                size = 0
+                while size < batch_size and \
+                        (limit == 0 or sent + len(batch) < limit):
+                    data = _acquire(stream_id)
+                    if data is None:
+                        break
+
+                    pulled.append(data)
+                    meta = None
+                    if isinstance(data, tuple):
+                        (meta, data) = data
+                    mimetype, data = _encode_frame(source_adapter, data)
+                    batch.append(frame_message(mimetype, data, meta))
+                    size += len(batch[-1])
+
+                if batch:
+                    try:
+                        yield b''.join(batch)
+                    except GeneratorExit:
+                        # The client has gone, keep the frames for the next
+                        with adapter_lock:
+                            unsent.extendleft(reversed(pulled))
+                        raise
+                    sent += len(batch)
+                    last_write = time.time()
+                elif time.time() - last_write > STREAM_HEARTBEAT_INTERVAL:
+                    last_write = time.time()
+                    yield struct.pack('<I', 0)
+                else:
+                    time.sleep(STREAM_POLL_INTERVAL)
+
+        return frames()
 
 
 def _log(log):
@@ -246,4 +391,5 @@ def start(host=HOST, port=PORT, debug=True, dev=False, adapter=ADAPTER):
     with app:
         setup(adapter, dev)
         logger.info('Starting HTTP server')
-        run(host=host, port=port, debug=debug)
+        run(host=host, port=port, debug=debug,
+            server_class=ThreadingWSGIServer)
@@ -3,12 +3,13 @@ import re
 from PIL import Image
 import struct
 import os
+import threading
 import dm3_lib as dm3
 
 from tomviz_acquisition.acquisition import AbstractSource
 from tomviz_acquisition.acquisition import describe
 from tomviz_acquisition.acquisition.utility import tobytes
-from .filesystem import Monitor
+from .filesystem import create_monitor
 
 try:
     dict.iteritems
@@ -109,6 +110,10 @@ class PassiveWatchSource(AbstractSource):
 
     def __init__(self):
         self._watcher = None
+        self._monitor = None
+        # Guards the monitor, which a stream may be reading from while it is
+        # replaced or closed
+        self._monitor_lock = threading.RLock()
         self.image_data_mimetype = TIFF_MIME_TYPE
         # Register the dm3 mime type.
         mimetypes.add_type(DM3_MIME_TYPE, '.dm3')
@@ -180,18 +185,25 @@ class PassiveWatchSource(AbstractSource):
         self._validate_connection_params(path, fileNameRegex,
                                          fileNameRegexGroups,
                                          groupRegexSubstitutions)
-        self._filename_regex = fileNameRegex
-        self._filename_regex_groups = fileNameRegexGroups
-        self._group_regex_substitutions = groupRegexSubstitutions
-        self._monitor = Monitor(path, filename_regex=fileNameRegex,
-                                valid_file_check=_valid_file_check)
+        with self._monitor_lock:
+            self._filename_regex = fileNameRegex
+            self._filename_regex_groups = fileNameRegexGroups
+            self._group_regex_substitutions = groupRegexSubstitutions
+            if self._monitor is not None:
+                self._monitor.close()
+            self._monitor = create_monitor(
+                path, filename_regex=fileNameRegex,
+                valid_file_check=_valid_file_check)
 
     def disconnect(self, **params):
         """
         :param params: The disconnect parameters.
         :type params: dict
         """
-        pass
+        with self._monitor_lock:
+            if self._monitor is not None:
+                self._monitor.close()
+                self._monitor = None
 
     def tilt_params(self, **params):
         """
@@ -246,6 +258,14 @@ class PassiveWatchSource(AbstractSource):
         there is one
         :returns: The 2D tiff generate by the scan along with its meta data.
         """
+        with self._monitor_lock:
+            return self._stem_acquire()
+
+    def _stem_acquire(self):
+        # Not connected
+        if self._monitor is None:
+            return None
+
         file = self._monitor.get()
 
         # We currently don't have a new image
@@ -1,13 +1,54 @@
+import ctypes
+import errno
+import logging
 import os
 import re
+import struct
+import sys
 try:
     import Queue as queue
 except ImportError:
     # py3
     import queue
 
+logger = logging.getLogger('tomviz_acquisition')
+
+# inotify(7) flags and events
+IN_CLOSE_WRITE = 0x00000008
+IN_MOVED_TO = 0x00000080
+IN_Q_OVERFLOW = 0x00004000
+IN_NONBLOCK = os.O_NONBLOCK
+IN_CLOEXEC = getattr(os, 'O_CLOEXEC', 0o2000000)
+
+# struct inotify_event, followed by len bytes of name
+_INOTIFY_EVENT = struct.Struct('iIII')
+_INOTIFY_READ_SIZE = 64 * 1024
+
+
+def _load_libc():
+    if not sys.platform.startswith('linux') or not hasattr(os, 'fsdecode'):
+        return None
+
+    try:
+        # The C library is already loaded into the interpreter
+        libc = ctypes.CDLL(None, use_errno=True)
+        libc.inotify_init1
+        libc.inotify_add_watch
+    except (OSError, AttributeError):
+        return None
+
+    return libc
+
+
+_libc = _load_libc()
+
 
 class Monitor(object):
+    """
+    Queues the files added to a directory, in the order they were written.
+    Each file is only validated once it has been written, and is only queued
+    once.
+    """
     def __init__(self, path, filename_regex=None,
                  valid_file_check=lambda f: True):
         super(Monitor, self).__init__()
@@ -15,33 +56,72 @@ class Monitor(object):
         self._files = queue.Queue()
         self._filename_regex \
             = re.compile(filename_regex) if filename_regex else None
-        self._listing = set()
         self._valid_file_check = valid_file_check
+        # The files that have been queued
+        self._queued = set()
+        # The files the regex doesn't match
+        self._ignored = set()
+        # The (size, mtime) of files that failed validation, they are only
+        # checked again once they have changed.
+        self._invalid = {}
 
-    def _check(self):
+    def _matches(self, f):
+        if f in self._ignored:
+            return False
+
+        if self._filename_regex and not self._filename_regex.match(f):
+            self._ignored.add(f)
+            return False
+
+        return True
+
+    def _accept(self, f, stat=None):
+        """
+        Queues a file if it is valid.
+
+        :returns: True, if the file was queued.
+        """
+        absolute_path = os.path.join(self._path, f)
+        if self._valid_file_check \
+                and not self._valid_file_check(absolute_path):
+            try:
+                stat = stat or os.stat(absolute_path)
+                self._invalid[f] = (stat.st_size, stat.st_mtime)
+            except OSError:
+                pass
+            return False
+
+        self._invalid.pop(f, None)
+        self._queued.add(f)
+        self._files.put(absolute_path)
+
+        return True
+
+    def _scan(self):
+        """
+        Lists the directory for files that haven't been seen, or that have
+        changed since they failed validation, and queues them by mtime.
+        """
+        new_files = []
+        for f in os.listdir(self._path):
+            if f in self._queued or not self._matches(f):
+                continue
+
+            try:
+                stat = os.stat(os.path.join(self._path, f))
+            except OSError:
+                continue
+
+            if self._invalid.get(f) == (stat.st_size, stat.st_mtime):
+                continue
 
-        new_listing = os.listdir(self._path)
-        # If we have a regex filter use it
-        if self._filename_regex:
-            new_listing = filter(lambda f: self._filename_regex.match(f),
-                                 new_listing)
-
-        # if we have a valid_file_check use it
-        if self._valid_file_check:
-            new_listing = filter(lambda f: self._valid_file_check(
-                os.path.join(self._path, f)), new_listing)
-
-        # sort by m_time
-        new_listing = sorted(new_listing,
-                             key=lambda f: os.path.getmtime(
-                                 os.path.join(self._path, f)))
-
-        # enqueue an new files
-        for f in new_listing:
-            if f not in self._listing:
-                absolute_path = os.path.join(self._path, f)
-                self._files.put(absolute_path)
-        self._listing = set(new_listing)
+            new_files.append((stat.st_mtime, f, stat))
+
+        for (_, f, stat) in sorted(new_files, key=lambda x: x[0]):
+            self._accept(f, stat)
+
+    def _check(self):
+        raise NotImplementedError()
 
     def get(self):
         """
@@ -61,3 +141,99 @@ class Monitor(object):
             pass
 
         return None
+
+    def close(self):
+        pass
+
+
+class PollingMonitor(Monitor):
+    """
+    Lists the directory on each check. Only the files that are new, or that
+    have changed since they failed validation, are stat'ed and validated.
+    """
+    def _check(self):
+        self._scan()
+
+
+class InotifyMonitor(Monitor):
+    """
+    Watches the directory with inotify, for files closed after writing or
+    moved into it. The directory is only listed for the files that were
+    already there, and if the kernel's event queue overflows.
+    """
+    def __init__(self, path, filename_regex=None,
+                 valid_file_check=lambda f: True):
+        super(InotifyMonitor, self).__init__(path, filename_regex,
+                                             valid_file_check)
+        self._fd = _libc.inotify_init1(IN_NONBLOCK | IN_CLOEXEC)
+        if self._fd < 0:
+            err = ctypes.get_errno()
+            raise OSError(err, os.strerror(err))
+
+        watch = _libc.inotify_add_watch(self._fd, os.fsencode(path),
+                                        IN_CLOSE_WRITE | IN_MOVED_TO)
+        if watch < 0:
+            err = ctypes.get_errno()
+            os.close(self._fd)
+            raise OSError(err, os.strerror(err), path)
+
+        # Pick up the files written before the watch was added
+        self._rescan = True
+
+    def _read_events(self):
+        names = []
+        while True:
+            try:
+                buf = os.read(self._fd, _INOTIFY_READ_SIZE)
+            except OSError as err:
+                if err.errno in (errno.EAGAIN, errno.EWOULDBLOCK):
+                    break
+                raise
+
+            offset = 0
+            while offset + _INOTIFY_EVENT.size <= len(buf):
+                (_, mask, _, length) \
+                    = _INOTIFY_EVENT.unpack_from(buf, offset)
+                offset += _INOTIFY_EVENT.size
+                name = buf[offset:offset + length].rstrip(b'\0')
+                offset += length
+
+                if mask & IN_Q_OVERFLOW:
+                    self._rescan = True
+                elif name:
+                    names.append(os.fsdecode(name))
+
+        return names
+
+    def _check(self):
+        names = self._read_events()
+        # The listing covers the files of the events read before it
+        if self._rescan:
+            self._rescan = False
+            self._scan()
+            return
+
+        for f in names:
+            if f not in self._queued and self._matches(f):
+                self._accept(f)
+
+    def close(self):
+        if self._fd >= 0:
+            os.close(self._fd)
+            self._fd = -1
+
+
+def create_monitor(path, filename_regex=None,
+                   valid_file_check=lambda f: True):
+    """
+    Creates an inotify monitor where inotify is available, a polling one
+    otherwise.
+    """
+    if _libc is not None:
+        try:
+            return InotifyMonitor(path, filename_regex, valid_file_check)
+        except OSError as err:
+            logger.warning('Unable to watch %s with inotify, polling: %s',
+                           path, err)
+
+    return PollingMonitor(path, filename_regex, valid_file_check)
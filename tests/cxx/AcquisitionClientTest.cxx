@@ -6,6 +6,7 @@
 #include <QDebug>
 #include <QEventLoop>
 #include <QFile>
+#include <QHostAddress>
 #include <QIODevice>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -16,7 +17,10 @@
 #include <QProcessEnvironment>
 #include <QSignalSpy>
 #include <QString>
+#include <QTcpServer>
+#include <QTcpSocket>
 #include <QTest>
+#include <QtEndian>
 
 #include "AcquisitionClient.h"
 #include "TomvizTest.h"
@@ -257,6 +261,42 @@ private slots:
     QCOMPARE(testDescription.toObject(), testExpected);
   }
 
+  void streamInvalidFrameSizeTest()
+  {
+    for (auto size : { "-1", "1099511627776" }) {
+      // A stream of one frame header, with an invalid size
+      QByteArray header = QByteArray("{\"mimeType\": \"image/tiff\", ") +
+                          "\"size\": " + size + "}";
+      QByteArray body(4, '\0');
+      qToLittleEndian<quint32>(header.size(), body.data());
+      body += header;
+
+      QTcpServer tcpServer;
+      QVERIFY(tcpServer.listen(QHostAddress::LocalHost));
+      QObject::connect(&tcpServer, &QTcpServer::newConnection, [&]() {
+        auto* socket = tcpServer.nextPendingConnection();
+        QObject::connect(socket, &QTcpSocket::readyRead, [socket, body]() {
+          socket->readAll();
+          socket->write("HTTP/1.1 200 OK\r\n"
+                        "Content-Type: application/x-tomviz-frames\r\n"
+                        "Content-Length: " +
+                        QByteArray::number(body.size()) + "\r\n\r\n" + body);
+        });
+      });
+
+      QNetworkAccessManager manager;
+      QUrl streamUrl(
+        QString("http://127.0.0.1:%1/stream").arg(tcpServer.serverPort()));
+      AcquisitionClientStream stream(manager.get(QNetworkRequest(streamUrl)));
+      QSignalSpy error(&stream, &AcquisitionClientStream::error);
+      QSignalSpy frames(&stream, &AcquisitionClientStream::framesReceived);
+      QSignalSpy finished(&stream, &AcquisitionClientStream::finished);
+      QVERIFY(error.wait());
+      QVERIFY(frames.isEmpty());
+      QVERIFY(finished.isEmpty());
+    }
+  }
+
 private:
   QProcess* server;
   bool serverStarted = false;
@@ -0,0 +1,143 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "CrossCorrelationAlignOperator.h"
+#include "TranslateAlignOperator.h"
+
+#include <vtkDataArray.h>
+#include <vtkFieldData.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace tomviz;
+
+namespace {
+
+const int Width = 96;
+const int Height = 80;
+
+// Shifts, in pixels, of the projections of the tilt series
+const std::vector<vtkVector2i> Shifts = { { -3, 2 }, { 2, -1 }, { 4, 3 },
+                                          { 0, 0 },  { -2, -4 }, { 1, 2 },
+                                          { 3, -2 } };
+
+// A few Gaussian blobs away from the edges, shifted (with wrap around) by
+// each of the shifts.
+vtkSmartPointer<vtkImageData> tiltSeries()
+{
+  const double centers[][2] = { { 36, 30 }, { 58, 34 }, { 47, 50 },
+                                { 40, 44 }, { 62, 52 }, { 50, 28 } };
+  std::vector<float> blobs(Width * Height, 0.0f);
+  for (int y = 0; y < Height; ++y) {
+    for (int x = 0; x < Width; ++x) {
+      for (const auto& center : centers) {
+        double dx = x - center[0];
+        double dy = y - center[1];
+        blobs[y * Width + x] += std::exp(-(dx * dx + dy * dy) / 18.0);
+      }
+    }
+  }
+
+  const int count = static_cast<int>(Shifts.size());
+  auto image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(Width, Height, count);
+  image->AllocateScalars(VTK_FLOAT, 1);
+  auto* data = static_cast<float*>(image->GetScalarPointer());
+  for (int z = 0; z < count; ++z) {
+    for (int y = 0; y < Height; ++y) {
+      for (int x = 0; x < Width; ++x) {
+        int sx = (x - Shifts[z][0] + Width) % Width;
+        int sy = (y - Shifts[z][1] + Height) % Height;
+        data[(z * Height + y) * Width + x] = blobs[sy * Width + sx];
+      }
+    }
+  }
+  return image;
+}
+
+// The offsets should move every projection back onto the reference one.
+void checkOffsets(const QVector<vtkVector2d>& offsets, int reference)
+{
+  ASSERT_EQ(offsets.size(), static_cast<int>(Shifts.size()));
+  for (int i = 0; i < offsets.size(); ++i) {
+    EXPECT_NEAR(offsets[i][0], Shifts[reference][0] - Shifts[i][0], 0.25)
+      << "projection " << i;
+    EXPECT_NEAR(offsets[i][1], Shifts[reference][1] - Shifts[i][1], 0.25)
+      << "projection " << i;
+  }
+}
+} // namespace
+
+TEST(CrossCorrelationAlignTest, recovers_shifts)
+{
+  auto image = tiltSeries();
+  CrossCorrelationAlignOperator op(nullptr);
+
+  // Without tilt angles, the middle projection is the reference
+  checkOffsets(op.computeOffsets(image), 3);
+}
+
+TEST(CrossCorrelationAlignTest, zero_degree_reference)
+{
+  auto image = tiltSeries();
+  vtkNew<vtkFloatArray> angles;
+  angles->SetName("tilt_angles");
+  for (int i = 0; i < static_cast<int>(Shifts.size()); ++i) {
+    angles->InsertNextValue(10.0f * (i - 1));
+  }
+  image->GetFieldData()->AddArray(angles);
+
+  CrossCorrelationAlignOperator op(nullptr);
+  checkOffsets(op.computeOffsets(image), 1);
+}
+
+TEST(CrossCorrelationAlignTest, offsets_round_trip_through_translate)
+{
+  auto image = tiltSeries();
+  CrossCorrelationAlignOperator op(nullptr);
+  QVector<vtkVector2i> emitted;
+  QObject::connect(&op, &CrossCorrelationAlignOperator::alignOffsetsComputed,
+                   [&emitted](const QVector<vtkVector2i>& offsets) {
+                     emitted = offsets;
+                   });
+  ASSERT_EQ(op.transform(image), TransformResult::Complete);
+
+  auto offsets = op.integerAlignOffsets();
+  EXPECT_EQ(emitted, offsets);
+  ASSERT_EQ(offsets.size(), static_cast<int>(Shifts.size()));
+  for (int i = 0; i < offsets.size(); ++i) {
+    EXPECT_EQ(offsets[i], vtkVector2i(Shifts[3][0] - Shifts[i][0],
+                                      Shifts[3][1] - Shifts[i][1]))
+      << "projection " << i;
+  }
+
+  TranslateAlignOperator translate(nullptr);
+  translate.setAlignOffsets(offsets);
+  EXPECT_EQ(translate.getAlignOffsets(), offsets);
+
+  // Whole pixel shifts move every projection exactly onto the reference one,
+  // away from the zero filled edges.
+  auto aligned = tiltSeries();
+  aligned->GetPointData()->GetScalars()->SetName("scalars");
+  TranslateAlignOperator::applyAlignOffsets(aligned,
+                                            translate.getAlignOffsets());
+  const int margin = 8;
+  for (int z = 0; z < static_cast<int>(Shifts.size()); ++z) {
+    for (int y = margin; y < Height - margin; ++y) {
+      for (int x = margin; x < Width - margin; ++x) {
+        auto* value = static_cast<float*>(aligned->GetScalarPointer(x, y, z));
+        auto* reference =
+          static_cast<float*>(aligned->GetScalarPointer(x, y, 3));
+        ASSERT_EQ(*value, *reference)
+          << "projection " << z << " at " << x << ", " << y;
+      }
+    }
+  }
+}
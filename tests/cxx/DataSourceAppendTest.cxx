@@ -0,0 +1,127 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <QApplication>
+#include <QTest>
+
+#include <pqApplicationCore.h>
+#include <pqObjectBuilder.h>
+#include <pqPVApplicationCore.h>
+#include <pqServerResource.h>
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+#include "DataSource.h"
+
+using namespace tomviz;
+
+class DataSourceAppendTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  // A 4 x 3 image of depth slices, each value holding its z
+  vtkSmartPointer<vtkImageData> createSlices(int firstZ, int depth)
+  {
+    auto image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(4, 3, depth);
+    image->AllocateScalars(VTK_FLOAT, 1);
+    for (int z = 0; z < depth; ++z) {
+      for (int y = 0; y < 3; ++y) {
+        for (int x = 0; x < 4; ++x) {
+          image->SetScalarComponentFromDouble(x, y, z, 0, firstZ + z);
+        }
+      }
+    }
+    return image;
+  }
+
+  void verifyVolume(DataSource* dataSource, int depth)
+  {
+    auto* image = dataSource->imageData();
+    int extent[6];
+    image->GetExtent(extent);
+    QCOMPARE(extent[4], 0);
+    QCOMPARE(extent[5], depth - 1);
+    QCOMPARE(image->GetPointData()->GetScalars()->GetNumberOfTuples(),
+             static_cast<vtkIdType>(4 * 3 * depth));
+    for (int z = 0; z < depth; ++z) {
+      QCOMPARE(image->GetScalarComponentAsDouble(3, 2, z, 0),
+               static_cast<double>(z));
+    }
+  }
+
+private slots:
+  void appendSlices()
+  {
+    auto* dataSource = new DataSource(createSlices(0, 1));
+    for (int z = 1; z < 6; ++z) {
+      QVERIFY(dataSource->appendSlice(createSlices(z, 1), false));
+    }
+    // A stack of slices extends the volume by its depth
+    QVERIFY(dataSource->appendSlice(createSlices(6, 3), false));
+    verifyVolume(dataSource, 9);
+
+    // Slices of another shape or type are rejected
+    auto wrongShape = vtkSmartPointer<vtkImageData>::New();
+    wrongShape->SetDimensions(5, 3, 1);
+    wrongShape->AllocateScalars(VTK_FLOAT, 1);
+    QVERIFY(!dataSource->appendSlice(wrongShape, false));
+    auto wrongType = vtkSmartPointer<vtkImageData>::New();
+    wrongType->SetDimensions(4, 3, 1);
+    wrongType->AllocateScalars(VTK_DOUBLE, 1);
+    QVERIFY(!dataSource->appendSlice(wrongType, false));
+    verifyVolume(dataSource, 9);
+
+    delete dataSource;
+  }
+
+  void appendNotifiesReaders()
+  {
+    auto* dataSource = new DataSource(createSlices(0, 2));
+    int notified = 0;
+    vtkIdType tuplesWhenNotified = 0;
+    connect(dataSource, &DataSource::scalarsAboutToChange, [&]() {
+      ++notified;
+      tuplesWhenNotified =
+        dataSource->imageData()->GetPointData()->GetScalars()
+          ->GetNumberOfTuples();
+    });
+
+    // Readers are told before the scalars grow in place
+    vtkSmartPointer<vtkDataArray> scalars =
+      dataSource->imageData()->GetPointData()->GetScalars();
+    QVERIFY(dataSource->appendSlice(createSlices(2, 1), false));
+    QCOMPARE(notified, 1);
+    QCOMPARE(tuplesWhenNotified, static_cast<vtkIdType>(4 * 3 * 2));
+    QCOMPARE(dataSource->imageData()->GetPointData()->GetScalars(),
+             scalars.GetPointer());
+    verifyVolume(dataSource, 3);
+
+    // Rejected slices leave the scalars alone
+    auto wrongShape = vtkSmartPointer<vtkImageData>::New();
+    wrongShape->SetDimensions(5, 3, 1);
+    wrongShape->AllocateScalars(VTK_FLOAT, 1);
+    QVERIFY(!dataSource->appendSlice(wrongShape, false));
+    QCOMPARE(notified, 1);
+
+    delete dataSource;
+  }
+};
+
+int main(int argc, char** argv)
+{
+  QApplication app(argc, argv);
+  pqPVApplicationCore appCore(argc, argv);
+
+  auto* builder = pqApplicationCore::instance()->getObjectBuilder();
+  builder->createServer(pqServerResource("builtin:"));
+
+  DataSourceAppendTest tc;
+  return QTest::qExec(&tc, argc, argv);
+}
+
+#include "DataSourceAppendTest.moc"
@@ -0,0 +1,323 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "DmFormat.h"
+#include "MappedFile.h"
+#include "SerFormat.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace tomviz;
+
+namespace {
+
+using Bytes = std::vector<char>;
+
+void append(Bytes& bytes, const Bytes& other)
+{
+  bytes.insert(bytes.end(), other.begin(), other.end());
+}
+
+template <typename T>
+void appendLittle(Bytes& bytes, T value)
+{
+  auto* data = reinterpret_cast<const char*>(&value);
+  bytes.insert(bytes.end(), data, data + sizeof(T));
+}
+
+void appendBig(Bytes& bytes, uint64_t value, int size)
+{
+  for (int i = size - 1; i >= 0; --i) {
+    bytes.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+// Builds the tags of DM3 (32 bit) or DM4 (64 bit) files
+class DmBuilder
+{
+public:
+  explicit DmBuilder(int version) : m_version(version) {}
+
+  Bytes group(const std::string& label, const std::vector<Bytes>& entries)
+  {
+    Bytes body;
+    body.push_back(0);
+    body.push_back(1);
+    appendSize(body, entries.size());
+    for (const auto& entry : entries) {
+      append(body, entry);
+    }
+    return entry(20, label, body);
+  }
+
+  Bytes value(const std::string& label, const std::vector<uint64_t>& info,
+              const Bytes& data)
+  {
+    Bytes body = { '%', '%', '%', '%' };
+    appendSize(body, info.size());
+    for (auto i : info) {
+      appendSize(body, i);
+    }
+    append(body, data);
+    return entry(21, label, body);
+  }
+
+  template <typename T>
+  Bytes number(const std::string& label, uint64_t type, T value)
+  {
+    Bytes data;
+    appendLittle(data, value);
+    return this->value(label, std::vector<uint64_t>{ type }, data);
+  }
+
+  Bytes units(const std::string& text)
+  {
+    Bytes data;
+    for (char c : text) {
+      appendLittle(data, static_cast<uint16_t>(static_cast<uint8_t>(c)));
+    }
+    return value("Units", { 20, 4, text.size() }, data);
+  }
+
+  Bytes file(const std::vector<Bytes>& entries)
+  {
+    // The root group is an entry without a header
+    auto root = group("", entries);
+    root.erase(root.begin(), root.begin() + 3 + (m_version == 4 ? 8 : 0));
+
+    Bytes bytes;
+    appendBig(bytes, m_version, 4);
+    appendSize(bytes, root.size());
+    appendBig(bytes, 1, 4);
+    append(bytes, root);
+    bytes.resize(bytes.size() + 8, 0);
+    return bytes;
+  }
+
+private:
+  void appendSize(Bytes& bytes, uint64_t value)
+  {
+    appendBig(bytes, value, m_version == 4 ? 8 : 4);
+  }
+
+  Bytes entry(char kind, const std::string& label, const Bytes& body)
+  {
+    Bytes bytes = { kind };
+    appendBig(bytes, label.size(), 2);
+    bytes.insert(bytes.end(), label.begin(), label.end());
+    if (m_version == 4) {
+      appendSize(bytes, body.size());
+    }
+    append(bytes, body);
+    return bytes;
+  }
+
+  int m_version;
+};
+
+void writeFile(const std::string& fileName, const Bytes& bytes)
+{
+  std::ofstream file(fileName, std::ios::binary);
+  file.write(bytes.data(), bytes.size());
+}
+
+} // namespace
+
+class DmSerFormatTest : public ::testing::Test
+{
+protected:
+  void TearDown() override { std::remove(m_fileName.c_str()); }
+
+  // A DM file with a thumbnail, then a 5 x 4 x 3 float image whose values
+  // are their point ids. The padding shifts the data in the file.
+  Bytes dmFile(int version, const std::string& padding)
+  {
+    DmBuilder dm(version);
+
+    auto image = [&dm](int dataType, uint64_t encodedType,
+                       const std::vector<uint32_t>& dims, const Bytes& data,
+                       const std::vector<Bytes>& calibrations) {
+      std::vector<Bytes> dimensions;
+      uint64_t count = 1;
+      for (auto dim : dims) {
+        dimensions.push_back(dm.number("", 5, dim));
+        count *= dim;
+      }
+      return dm.group(
+        "", { dm.group("ImageData",
+                       { dm.group("Calibrations",
+                                  { dm.group("Dimension", calibrations) }),
+                         dm.value("Data", { 20, encodedType, count }, data),
+                         dm.number("DataType", 3, dataType),
+                         dm.group("Dimensions", dimensions) }) });
+    };
+
+    Bytes thumbnail(16, 0);
+    Bytes values;
+    for (int i = 0; i < 60; ++i) {
+      appendLittle(values, static_cast<float>(i));
+    }
+    std::vector<Bytes> calibrations = {
+      dm.group("", { dm.number("Scale", 6, 0.5f), dm.units("nm") }),
+      dm.group("", { dm.number("Scale", 6, 0.25f), dm.units("\xb5m") }),
+      dm.group("", { dm.number("Scale", 6, 2.0f), dm.units("") })
+    };
+
+    return dm.file(
+      { dm.number(padding, 3, 0),
+        dm.group("ImageList",
+                 { image(23, 5, { 2, 2 }, thumbnail, {}),
+                   image(2, 6, { 5, 4, 3 }, values, calibrations) }),
+        // A struct with an int and a float
+        dm.value("Point", { 15, 0, 2, 0, 3, 0, 6 }, Bytes(8, 0)) });
+  }
+
+  void expectImage(vtkImageData* image)
+  {
+    int dims[3];
+    image->GetDimensions(dims);
+    EXPECT_EQ(dims[0], 5);
+    EXPECT_EQ(dims[1], 4);
+    EXPECT_EQ(dims[2], 3);
+    EXPECT_DOUBLE_EQ(image->GetSpacing()[0], 0.5);
+    EXPECT_DOUBLE_EQ(image->GetSpacing()[1], 250.0);
+    EXPECT_DOUBLE_EQ(image->GetSpacing()[2], 2.0);
+
+    auto* scalars = image->GetPointData()->GetScalars();
+    ASSERT_EQ(scalars->GetDataType(), VTK_FLOAT);
+    for (vtkIdType i = 0; i < 60; ++i) {
+      ASSERT_EQ(scalars->GetComponent(i, 0), i);
+    }
+  }
+
+  std::string m_fileName = ::testing::TempDir() + "tomviz_dmser";
+};
+
+TEST_F(DmSerFormatTest, map_array)
+{
+  Bytes bytes(2, 0);
+  for (int i = 0; i < 10; ++i) {
+    appendLittle(bytes, static_cast<float>(i));
+  }
+  writeFile(m_fileName, bytes);
+
+  // Values that are not aligned, or past the end of the file, are not mapped
+  EXPECT_EQ(mapArray(m_fileName.c_str(), 2, VTK_FLOAT, 10), nullptr);
+  EXPECT_EQ(mapArray(m_fileName.c_str(), 4, VTK_FLOAT, 10), nullptr);
+  auto array = readArray(m_fileName.c_str(), 2, VTK_FLOAT, 10);
+  ASSERT_NE(array, nullptr);
+  EXPECT_EQ(array->GetComponent(9, 0), 9.0);
+
+  bytes.erase(bytes.begin(), bytes.begin() + 2);
+  writeFile(m_fileName, bytes);
+  array = mapArray(m_fileName.c_str(), 4, VTK_FLOAT, 9);
+  ASSERT_NE(array, nullptr);
+  EXPECT_EQ(array->GetNumberOfTuples(), 9);
+  EXPECT_EQ(array->GetComponent(0, 0), 1.0);
+
+  // The mapping is private
+  array->SetComponent(0, 0, 42.0);
+  EXPECT_EQ(readArray(m_fileName.c_str(), 4, VTK_FLOAT, 1)->GetComponent(0, 0),
+            1.0);
+}
+
+TEST_F(DmSerFormatTest, read_dm)
+{
+  for (int version : { 3, 4 }) {
+    // Aligned and unaligned data, mapped or read
+    for (std::string padding : { "a", "ab", "abc", "abcd" }) {
+      writeFile(m_fileName, dmFile(version, padding));
+      vtkNew<vtkImageData> image;
+      ASSERT_TRUE(DmFormat::read(m_fileName, image));
+      expectImage(image);
+    }
+  }
+
+  writeFile(m_fileName, Bytes(64, 0));
+  vtkNew<vtkImageData> image;
+  EXPECT_FALSE(DmFormat::read(m_fileName, image));
+}
+
+TEST_F(DmSerFormatTest, read_ser)
+{
+  // Three 4 x 2 uint16 images, whose values are their index in the file
+  const int frames = 3, width = 4, height = 2;
+  Bytes bytes;
+  appendLittle<uint16_t>(bytes, 0x4949);
+  appendLittle<uint16_t>(bytes, 0x0197);
+  appendLittle<uint16_t>(bytes, 0x0220);
+  appendLittle<int32_t>(bytes, 0x4122);
+  appendLittle<int32_t>(bytes, 0x4152);
+  appendLittle<int32_t>(bytes, frames);
+  appendLittle<int32_t>(bytes, frames);
+  auto offsetArrayOffset = bytes.size();
+  appendLittle<int64_t>(bytes, 0);
+  appendLittle<int32_t>(bytes, 1);
+  // The dimension of the series, without description or units
+  appendLittle<int32_t>(bytes, frames);
+  appendLittle<double>(bytes, 0.0);
+  appendLittle<double>(bytes, 1.0);
+  appendLittle<int32_t>(bytes, 0);
+  appendLittle<int32_t>(bytes, 0);
+  appendLittle<int32_t>(bytes, 0);
+
+  std::vector<int64_t> offsets;
+  uint16_t value = 0;
+  for (int f = 0; f < frames; ++f) {
+    offsets.push_back(bytes.size());
+    for (double delta : { 1e-9, 2e-9 }) {
+      appendLittle<double>(bytes, 0.0);
+      appendLittle<double>(bytes, delta);
+      appendLittle<int32_t>(bytes, 0);
+    }
+    appendLittle<int16_t>(bytes, 2);
+    appendLittle<int32_t>(bytes, width);
+    appendLittle<int32_t>(bytes, height);
+    for (int i = 0; i < width * height; ++i) {
+      appendLittle<uint16_t>(bytes, value++);
+    }
+  }
+
+  int64_t offset = bytes.size();
+  std::memcpy(bytes.data() + offsetArrayOffset, &offset, sizeof(offset));
+  for (auto o : offsets) {
+    appendLittle<int64_t>(bytes, o);
+  }
+  // The tag offsets
+  for (int f = 0; f < frames; ++f) {
+    appendLittle<int64_t>(bytes, 0);
+  }
+  writeFile(m_fileName, bytes);
+
+  vtkNew<vtkImageData> image;
+  ASSERT_TRUE(SerFormat::read(m_fileName, image));
+  int dims[3];
+  image->GetDimensions(dims);
+  EXPECT_EQ(dims[0], width);
+  EXPECT_EQ(dims[1], height);
+  EXPECT_EQ(dims[2], frames);
+  EXPECT_DOUBLE_EQ(image->GetSpacing()[0], 1.0);
+  EXPECT_DOUBLE_EQ(image->GetSpacing()[1], 2.0);
+
+  // The rows are flipped
+  for (int z = 0; z < frames; ++z) {
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        double expected = (z * height + (height - 1 - y)) * width + x;
+        ASSERT_EQ(image->GetScalarComponentAsDouble(x, y, z, 0), expected);
+      }
+    }
+  }
+}
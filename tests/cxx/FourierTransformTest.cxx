@@ -0,0 +1,108 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "FourierTransform.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace tomviz::FourierTransform;
+
+class FourierTransformTest : public ::testing::Test
+{
+};
+
+namespace {
+
+std::vector<Complex> testSignal(int n)
+{
+  std::vector<Complex> signal(n);
+  for (int i = 0; i < n; ++i) {
+    signal[i] = Complex(std::sin(0.3f * i) + 0.1f * i, std::cos(0.7f * i));
+  }
+  return signal;
+}
+} // namespace
+
+TEST_F(FourierTransformTest, matches_dft)
+{
+  // Powers of two and lengths going through Bluestein's algorithm.
+  for (int n : { 1, 2, 3, 7, 16, 60, 97, 128 }) {
+    auto signal = testSignal(n);
+    auto spectrum = signal;
+    Plan plan(n);
+    plan.forward(spectrum.data());
+    for (int k = 0; k < n; ++k) {
+      std::complex<double> expected = 0.0;
+      for (int j = 0; j < n; ++j) {
+        expected += std::complex<double>(signal[j]) *
+                    std::polar(1.0, -2.0 * M_PI * j * k / n);
+      }
+      ASSERT_NEAR(spectrum[k].real(), expected.real(), 1e-3 * n);
+      ASSERT_NEAR(spectrum[k].imag(), expected.imag(), 1e-3 * n);
+    }
+  }
+}
+
+TEST_F(FourierTransformTest, round_trip_2d)
+{
+  const int width = 24;
+  const int height = 17;
+  auto image = testSignal(width * height);
+  auto transformed = image;
+  Plan2D plan(width, height);
+  plan.forward(transformed.data());
+  plan.inverse(transformed.data());
+  for (size_t i = 0; i < image.size(); ++i) {
+    ASSERT_NEAR(transformed[i].real(), image[i].real(), 1e-3);
+    ASSERT_NEAR(transformed[i].imag(), image[i].imag(), 1e-3);
+  }
+}
+
+TEST_F(FourierTransformTest, cross_correlation_peak)
+{
+  // Correlating an image with a circularly shifted copy of itself must peak
+  // at the shift.
+  const int width = 20;
+  const int height = 12;
+  const int shiftX = 3;
+  const int shiftY = -5;
+  auto image = testSignal(width * height);
+  std::vector<Complex> shifted(image.size());
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      int sx = (x + shiftX + width) % width;
+      int sy = (y + shiftY + height) % height;
+      shifted[sy * width + sx] = image[y * width + x];
+    }
+  }
+
+  Plan2D plan(width, height);
+  plan.forward(image.data());
+  plan.forward(shifted.data());
+  std::vector<Complex> correlation(image.size());
+  for (size_t i = 0; i < image.size(); ++i) {
+    correlation[i] = std::conj(image[i]) * shifted[i];
+  }
+  plan.inverse(correlation.data());
+
+  size_t peak = 0;
+  for (size_t i = 0; i < correlation.size(); ++i) {
+    if (std::abs(correlation[i]) > std::abs(correlation[peak])) {
+      peak = i;
+    }
+  }
+  ASSERT_EQ(static_cast<int>(peak % width), shiftX);
+  ASSERT_EQ(static_cast<int>(peak / width), shiftY + height);
+}
+
+TEST_F(FourierTransformTest, frequency)
+{
+  ASSERT_FLOAT_EQ(frequency(0, 8), 0.0f);
+  ASSERT_FLOAT_EQ(frequency(3, 8), 0.375f);
+  ASSERT_FLOAT_EQ(frequency(4, 8), -0.5f);
+  ASSERT_FLOAT_EQ(frequency(2, 5), 0.4f);
+  ASSERT_FLOAT_EQ(frequency(3, 5), -0.4f);
+}
@@ -0,0 +1,171 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "FrameDecoder.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkTIFFReader.h>
+#include <vtkTIFFWriter.h>
+
+#include <QFile>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+using namespace tomviz;
+
+namespace {
+
+// A NumPy version 1.0 header, padded to a multiple of 64 bytes
+QByteArray npyHeader(const QByteArray& descr, bool fortran,
+                     const QByteArray& shape)
+{
+  QByteArray dict = "{'descr': '" + descr + "', 'fortran_order': " +
+                    (fortran ? "True" : "False") + ", 'shape': (" + shape +
+                    "), }";
+  int length = dict.size() + 1;
+  int padding = (64 - (10 + length) % 64) % 64;
+  dict += QByteArray(padding, ' ') + '\n';
+
+  QByteArray header("\x93NUMPY\x01\x00", 8);
+  header.append(static_cast<char>(dict.size() & 0xff));
+  header.append(static_cast<char>(dict.size() >> 8));
+  return header + dict;
+}
+
+QByteArray uint16Values(int count, bool bigEndian)
+{
+  QByteArray values;
+  for (int i = 0; i < count; ++i) {
+    char low = static_cast<char>(i & 0xff), high = static_cast<char>(i >> 8);
+    values.append(bigEndian ? high : low);
+    values.append(bigEndian ? low : high);
+  }
+  return values;
+}
+
+} // namespace
+
+TEST(FrameDecoderTest, tiff)
+{
+  // Decoded in memory as vtkTIFFReader reads the file
+  vtkNew<vtkImageData> image;
+  image->SetDimensions(5, 3, 1);
+  image->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+  auto scalars = image->GetPointData()->GetScalars();
+  for (vtkIdType i = 0; i < 15; ++i) {
+    scalars->SetComponent(i, 0, 100 * i);
+  }
+
+  std::string fileName = ::testing::TempDir() + "tomviz_frame.tiff";
+  vtkNew<vtkTIFFWriter> writer;
+  writer->SetInputData(image);
+  writer->SetFileName(fileName.c_str());
+  writer->Write();
+
+  vtkNew<vtkTIFFReader> reader;
+  reader->SetFileName(fileName.c_str());
+  reader->Update();
+  auto expected = reader->GetOutput()->GetPointData()->GetScalars();
+
+  QFile file(QString::fromStdString(fileName));
+  ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+  auto frame = FrameDecoder::decode("image/tiff", file.readAll());
+  file.close();
+  std::remove(fileName.c_str());
+
+  ASSERT_NE(frame, nullptr);
+  int dims[3];
+  frame->GetDimensions(dims);
+  EXPECT_EQ(dims[0], 5);
+  EXPECT_EQ(dims[1], 3);
+  EXPECT_EQ(dims[2], 1);
+  auto decoded = frame->GetPointData()->GetScalars();
+  ASSERT_EQ(decoded->GetDataType(), VTK_UNSIGNED_SHORT);
+  ASSERT_EQ(decoded->GetNumberOfTuples(), 15);
+  for (vtkIdType i = 0; i < 15; ++i) {
+    EXPECT_EQ(decoded->GetComponent(i, 0), expected->GetComponent(i, 0));
+  }
+
+  EXPECT_EQ(FrameDecoder::decode("image/tiff", QByteArray("not a tiff")),
+            nullptr);
+}
+
+TEST(FrameDecoderTest, npy)
+{
+  // 3 rows of 4 columns, the first row is at the top of the image
+  for (bool bigEndian : { false, true }) {
+    auto data = npyHeader(bigEndian ? ">u2" : "<u2", false, "3, 4") +
+                uint16Values(12, bigEndian);
+    auto frame =
+      FrameDecoder::decode("application/octet-stream; charset=binary", data);
+    ASSERT_NE(frame, nullptr);
+
+    int dims[3];
+    frame->GetDimensions(dims);
+    EXPECT_EQ(dims[0], 4);
+    EXPECT_EQ(dims[1], 3);
+    EXPECT_EQ(dims[2], 1);
+    ASSERT_EQ(frame->GetScalarType(), VTK_UNSIGNED_SHORT);
+    for (int y = 0; y < 3; ++y) {
+      for (int x = 0; x < 4; ++x) {
+        EXPECT_EQ(frame->GetScalarComponentAsDouble(x, 2 - y, 0, 0),
+                  y * 4 + x);
+      }
+    }
+  }
+
+  // Column major values of the same rows and columns
+  QByteArray values;
+  for (int x = 0; x < 4; ++x) {
+    for (int y = 0; y < 3; ++y) {
+      values.append(static_cast<char>(y * 4 + x));
+    }
+  }
+  auto frame = FrameDecoder::decode("application/octet-stream",
+                                    npyHeader("|u1", true, "3, 4") + values);
+  ASSERT_NE(frame, nullptr);
+  ASSERT_EQ(frame->GetScalarType(), VTK_UNSIGNED_CHAR);
+  for (int y = 0; y < 3; ++y) {
+    for (int x = 0; x < 4; ++x) {
+      EXPECT_EQ(frame->GetScalarComponentAsDouble(x, 2 - y, 0, 0), y * 4 + x);
+    }
+  }
+}
+
+TEST(FrameDecoderTest, invalid)
+{
+  // Fewer values than the shape
+  auto data = npyHeader("<u2", false, "3, 4") + uint16Values(11, false);
+  EXPECT_EQ(FrameDecoder::decode("application/octet-stream", data), nullptr);
+
+  // Unsupported types and shapes
+  data = npyHeader("<c8", false, "3, 4") + QByteArray(96, '\0');
+  EXPECT_EQ(FrameDecoder::decode("application/octet-stream", data), nullptr);
+  data = npyHeader("<u2", false, "12,") + uint16Values(12, false);
+  EXPECT_EQ(FrameDecoder::decode("application/octet-stream", data), nullptr);
+
+  // Negative, zero and unparsable dimensions
+  for (auto shape : { "-3, -4", "0, 4", "3, x" }) {
+    data = npyHeader("<u2", false, shape) + uint16Values(12, false);
+    EXPECT_EQ(FrameDecoder::decode("application/octet-stream", data), nullptr)
+      << shape;
+  }
+
+  // Dimensions too large for an image, and dimensions whose size in bytes
+  // overflows to zero
+  for (auto shape : { "4294967296, 4, 4", "2097152, 2097152, 2097152" }) {
+    data = npyHeader("<u2", false, shape) + uint16Values(12, false);
+    EXPECT_EQ(FrameDecoder::decode("application/octet-stream", data), nullptr)
+      << shape;
+  }
+
+  EXPECT_EQ(FrameDecoder::decode("application/octet-stream", "raw"), nullptr);
+  EXPECT_EQ(FrameDecoder::decode("image/png", "png"), nullptr);
+}
@@ -0,0 +1,395 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "h5cpp/h5readwrite.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using h5::H5ReadWrite;
+using h5::WriteOptions;
+using Compression = h5::WriteOptions::Compression;
+
+class H5ReadWriteTest : public ::testing::Test
+{
+protected:
+  void TearDown() override { std::remove(m_fileName.c_str()); }
+
+  std::string m_fileName = ::testing::TempDir() + "tomviz_h5readwrite.h5";
+};
+
+namespace {
+
+// A mostly empty label map, like the output of a segmentation.
+std::vector<unsigned short> labelVolume(int dim)
+{
+  std::vector<unsigned short> data(static_cast<size_t>(dim) * dim * dim, 0);
+  for (int z = 0; z < dim; ++z) {
+    for (int y = 0; y < dim; ++y) {
+      for (int x = 0; x < dim; ++x) {
+        int dx = x - dim / 2, dy = y - dim / 2, dz = z - dim / 2;
+        if (dx * dx + dy * dy + dz * dz < dim * dim / 16) {
+          data[(static_cast<size_t>(z) * dim + y) * dim + x] =
+            static_cast<unsigned short>(1 + (x / 8) % 3);
+        }
+      }
+    }
+  }
+  return data;
+}
+
+std::vector<float> noiseVolume(int dim)
+{
+  std::mt19937 generator(0);
+  std::normal_distribution<float> distribution(100.0f, 10.0f);
+  std::vector<float> data(static_cast<size_t>(dim) * dim * dim);
+  for (auto& value : data) {
+    value = distribution(generator);
+  }
+  return data;
+}
+
+long long fileSize(const std::string& fileName)
+{
+  std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+  return static_cast<long long>(file.tellg());
+}
+} // namespace
+
+TEST_F(H5ReadWriteTest, guess_chunk_dimensions)
+{
+  auto chunks = H5ReadWrite::guessChunkDimensions({ 512, 512, 512 }, 4);
+  ASSERT_EQ(chunks.size(), 3u);
+  size_t bytes = 4;
+  for (auto chunk : chunks) {
+    EXPECT_GE(chunk, 1);
+    EXPECT_LE(chunk, 512);
+    bytes *= chunk;
+  }
+  EXPECT_LE(bytes, 1u << 20);
+  EXPECT_GE(bytes, 1u << 18);
+
+  // Small data sets are a single chunk.
+  chunks = H5ReadWrite::guessChunkDimensions({ 4, 5, 6 }, 8);
+  EXPECT_EQ(chunks, std::vector<int>({ 4, 5, 6 }));
+}
+
+TEST_F(H5ReadWriteTest, default_write_options)
+{
+  auto options = H5ReadWrite::defaultWriteOptions(H5ReadWrite::DataType::Float,
+                                                  { 16, 16, 16 });
+  EXPECT_FALSE(options.isChunked());
+
+  options = H5ReadWrite::defaultWriteOptions(H5ReadWrite::DataType::UInt16,
+                                             { 256, 256, 256 });
+  EXPECT_EQ(options.compression, Compression::Deflate);
+  EXPECT_TRUE(options.shuffle);
+  EXPECT_EQ(options.chunkDimensions.size(), 3u);
+
+  auto floatOptions = H5ReadWrite::defaultWriteOptions(
+    H5ReadWrite::DataType::Float, { 256, 256, 256 });
+  EXPECT_FALSE(floatOptions.isChunked());
+
+  auto byteOptions = H5ReadWrite::defaultWriteOptions(
+    H5ReadWrite::DataType::UInt8, { 256, 256, 256 });
+  EXPECT_FALSE(byteOptions.shuffle);
+}
+
+TEST_F(H5ReadWriteTest, compression_strings)
+{
+  for (auto compression : { Compression::None, Compression::Deflate,
+                            Compression::Zstd, Compression::Blosc }) {
+    bool ok = false;
+    auto name = H5ReadWrite::compressionToString(compression);
+    EXPECT_EQ(H5ReadWrite::compressionFromString(name, &ok), compression);
+    EXPECT_TRUE(ok);
+  }
+  bool ok = true;
+  H5ReadWrite::compressionFromString("lzma", &ok);
+  EXPECT_FALSE(ok);
+}
+
+TEST_F(H5ReadWriteTest, chunked_round_trip)
+{
+  const int dim = 64;
+  auto data = labelVolume(dim);
+  std::vector<int> dims = { dim, dim, dim };
+
+  WriteOptions options;
+  options.chunkDimensions = { 16, 32, 64 };
+  options.compression = Compression::Deflate;
+  options.compressionLevel = 6;
+  options.shuffle = true;
+
+  {
+    H5ReadWrite writer(m_fileName, H5ReadWrite::OpenMode::WriteOnly);
+    ASSERT_TRUE(writer.writeData("/", "labels", dims, data, options));
+    ASSERT_TRUE(writer.writeData("/", "contiguous", dims, data));
+  }
+
+  H5ReadWrite reader(m_fileName);
+  std::vector<int> readDims;
+  auto readBack = reader.readData<unsigned short>("/labels", readDims);
+  EXPECT_EQ(readDims, dims);
+  EXPECT_EQ(readBack, data);
+
+  bool ok = false;
+  auto readOptions = reader.writeOptions("/labels", &ok);
+  ASSERT_TRUE(ok);
+  EXPECT_EQ(readOptions.chunkDimensions, options.chunkDimensions);
+  EXPECT_EQ(readOptions.compression, Compression::Deflate);
+  EXPECT_EQ(readOptions.compressionLevel, 6);
+  EXPECT_TRUE(readOptions.shuffle);
+
+  readOptions = reader.writeOptions("/contiguous", &ok);
+  ASSERT_TRUE(ok);
+  EXPECT_FALSE(readOptions.isChunked());
+}
+
+TEST_F(H5ReadWriteTest, plugin_filters_fall_back)
+{
+  // Zstd and Blosc are plugins that may not be installed, the data must
+  // be written either way.
+  const int dim = 32;
+  auto data = noiseVolume(dim);
+  std::vector<int> dims = { dim, dim, dim };
+
+  for (auto compression : { Compression::Zstd, Compression::Blosc }) {
+    WriteOptions options;
+    options.compression = compression;
+    options.compressionLevel = 3;
+    options.shuffle = true;
+    {
+      H5ReadWrite writer(m_fileName, H5ReadWrite::OpenMode::WriteOnly);
+      ASSERT_TRUE(writer.writeData("/", "data", dims, data, options));
+    }
+
+    H5ReadWrite reader(m_fileName);
+    std::vector<int> readDims;
+    EXPECT_EQ(reader.readData<float>("/data", readDims), data);
+    auto readOptions = reader.writeOptions("/data");
+    EXPECT_EQ(readOptions.chunkDimensions.size(), 3u);
+    EXPECT_NE(readOptions.compression, Compression::None);
+  }
+}
+
+TEST_F(H5ReadWriteTest, hyperslab_write)
+{
+  // Write a chunked data set a slab at a time, as it is streamed out.
+  const int dim = 40;
+  auto data = labelVolume(dim);
+  std::vector<int> dims = { dim, dim, dim };
+
+  WriteOptions options;
+  options.chunkDimensions = { 8, 40, 40 };
+  options.compression = Compression::Deflate;
+
+  {
+    H5ReadWrite writer(m_fileName, H5ReadWrite::OpenMode::WriteOnly);
+    ASSERT_TRUE(writer.createDataSet("/", "labels", dims,
+                                     H5ReadWrite::DataType::UInt16, options));
+    const size_t slab = 16;
+    for (size_t begin = 0; begin < static_cast<size_t>(dim); begin += slab) {
+      size_t start[3] = { begin, 0, 0 };
+      size_t counts[3] = { std::min(slab, dim - begin), dim, dim };
+      ASSERT_TRUE(writer.writeHyperslab(
+        "/labels", H5ReadWrite::DataType::UInt16,
+        data.data() + begin * dim * dim, start, counts));
+    }
+  }
+
+  H5ReadWrite reader(m_fileName);
+  std::vector<int> readDims;
+  EXPECT_EQ(reader.readData<unsigned short>("/labels", readDims), data);
+  EXPECT_EQ(readDims, dims);
+}
+
+TEST_F(H5ReadWriteTest, strided_chunk_read)
+{
+  // Strided and offset reads, a chunk at a time, with and without threads
+  // to decompress the chunks, point sampled and averaged.
+  const int dim = 64;
+  auto data = labelVolume(dim);
+  std::vector<int> dims = { dim, dim, dim };
+
+  WriteOptions options;
+  options.chunkDimensions = { 7, 16, 32 };
+  options.compression = Compression::Deflate;
+  options.shuffle = true;
+  {
+    H5ReadWrite writer(m_fileName, H5ReadWrite::OpenMode::WriteOnly);
+    ASSERT_TRUE(writer.writeData("/", "labels", dims, data, options));
+    ASSERT_TRUE(writer.writeData("/", "contiguous", dims, data));
+  }
+
+  struct Case
+  {
+    int strides[3];
+    size_t start[3];
+  };
+  std::vector<Case> cases = { { { 1, 1, 1 }, { 0, 0, 0 } },
+                              { { 2, 3, 1 }, { 5, 0, 17 } },
+                              { { 9, 1, 40 }, { 3, 33, 2 } } };
+
+  auto at = [&](size_t i, size_t j, size_t k) {
+    return data[(i * dim + j) * dim + k];
+  };
+
+  H5ReadWrite reader(m_fileName);
+  for (auto& c : cases) {
+    size_t counts[3];
+    for (int i = 0; i < 3; ++i)
+      counts[i] = (dim - c.start[i]) / c.strides[i];
+
+    for (bool average : { false, true }) {
+      std::vector<unsigned short> expected;
+      for (size_t i = 0; i < counts[0]; ++i) {
+        for (size_t j = 0; j < counts[1]; ++j) {
+          for (size_t k = 0; k < counts[2]; ++k) {
+            size_t i0 = c.start[0] + i * c.strides[0];
+            size_t j0 = c.start[1] + j * c.strides[1];
+            size_t k0 = c.start[2] + k * c.strides[2];
+            if (!average) {
+              expected.push_back(at(i0, j0, k0));
+              continue;
+            }
+            double sum = 0;
+            for (int di = 0; di < c.strides[0]; ++di)
+              for (int dj = 0; dj < c.strides[1]; ++dj)
+                for (int dk = 0; dk < c.strides[2]; ++dk)
+                  sum += at(i0 + di, j0 + dj, k0 + dk);
+            int n = c.strides[0] * c.strides[1] * c.strides[2];
+            expected.push_back(
+              static_cast<unsigned short>(std::round(sum / n)));
+          }
+        }
+      }
+
+      for (auto path : { "/labels", "/contiguous" }) {
+        for (int threads : { 1, 4 }) {
+          H5ReadWrite::setReadThreads(threads);
+          std::vector<unsigned short> values(expected.size());
+          ASSERT_TRUE(reader.readData(path, H5ReadWrite::DataType::UInt16,
+                                      values.data(), c.strides, c.start,
+                                      counts, average));
+          EXPECT_EQ(values, expected) << path << ", " << threads
+                                      << " threads, average " << average;
+        }
+      }
+    }
+  }
+  H5ReadWrite::setReadThreads(0);
+}
+
+// Reports the read throughput of a compressed data set with 1, 8, 16 and
+// 32 threads. Run it with
+// --gtest_also_run_disabled_tests --gtest_filter=H5ReadWriteTest.*benchmark
+TEST_F(H5ReadWriteTest, DISABLED_parallel_read_benchmark)
+{
+  const int dim = 512;
+  std::vector<int> dims = { dim, dim, dim };
+  auto labels = labelVolume(dim);
+  {
+    H5ReadWrite writer(m_fileName, H5ReadWrite::OpenMode::WriteOnly);
+    auto options =
+      H5ReadWrite::defaultWriteOptions(H5ReadWrite::DataType::UInt16, dims);
+    ASSERT_TRUE(writer.writeData("/", "labels", dims, labels, options));
+  }
+
+  std::vector<unsigned short> buffer(labels.size());
+  for (int threads : { 1, 8, 16, 32 }) {
+    H5ReadWrite::setReadThreads(threads);
+    for (int stride : { 1, 2 }) {
+      int strides[3] = { stride, stride, stride };
+      size_t start[3] = { 0, 0, 0 };
+      size_t counts[3];
+      for (auto& count : counts)
+        count = dim / stride;
+
+      using Clock = std::chrono::steady_clock;
+      auto begin = Clock::now();
+      H5ReadWrite reader(m_fileName);
+      ASSERT_TRUE(reader.readData("/labels", H5ReadWrite::DataType::UInt16,
+                                  buffer.data(), strides, start, counts));
+      double seconds =
+        std::chrono::duration<double>(Clock::now() - begin).count();
+      std::cout << threads << " threads, stride " << stride << ": "
+                << labels.size() * sizeof(labels[0]) / 1048576.0 / seconds
+                << " MiB/s of the full volume" << std::endl;
+    }
+  }
+  H5ReadWrite::setReadThreads(0);
+}
+
+// Reports the file size and the write and read throughput of a segmented
+// volume and of a noisy one with each compression. Run it with
+// --gtest_also_run_disabled_tests --gtest_filter=H5ReadWriteTest.*benchmark
+TEST_F(H5ReadWriteTest, DISABLED_write_benchmark)
+{
+  const int dim = 256;
+  std::vector<int> dims = { dim, dim, dim };
+  auto labels = labelVolume(dim);
+  auto noise = noiseVolume(dim);
+
+  struct Case
+  {
+    const char* name;
+    WriteOptions options;
+  };
+  std::vector<Case> cases = {
+    { "contiguous", WriteOptions() },
+    { "default", WriteOptions() },
+    { "deflate 1", { {}, Compression::Deflate, 1, true } },
+    { "deflate 6", { {}, Compression::Deflate, 6, true } },
+    { "zstd 3", { {}, Compression::Zstd, 3, true } },
+    { "blosc 5", { {}, Compression::Blosc, 5, true } },
+  };
+
+  auto run = [&](const char* volume, const void* data, size_t bytes,
+                 H5ReadWrite::DataType type) {
+    std::vector<char> buffer(bytes);
+    for (auto& c : cases) {
+      auto options = c.options;
+      if (std::string(c.name) == "default") {
+        options = H5ReadWrite::defaultWriteOptions(type, dims);
+      }
+
+      using Clock = std::chrono::steady_clock;
+      auto start = Clock::now();
+      {
+        H5ReadWrite writer(m_fileName, H5ReadWrite::OpenMode::WriteOnly);
+        ASSERT_TRUE(writer.writeData("/", "data", dims, type, data, options));
+      }
+      double writeSeconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+
+      start = Clock::now();
+      {
+        H5ReadWrite reader(m_fileName);
+        ASSERT_TRUE(reader.readData("/data", type, buffer.data()));
+      }
+      double readSeconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+
+      double megabytes = bytes / 1048576.0;
+      std::cout << volume << ", " << c.name << ": "
+                << fileSize(m_fileName) / 1048576.0 << " MiB on disk, write "
+                << megabytes / writeSeconds << " MiB/s, read "
+                << megabytes / readSeconds << " MiB/s" << std::endl;
+    }
+  };
+
+  run("labels (uint16)", labels.data(), labels.size() * sizeof(labels[0]),
+      H5ReadWrite::DataType::UInt16);
+  run("noise (float)", noise.data(), noise.size() * sizeof(noise[0]),
+      H5ReadWrite::DataType::Float);
+}
@@ -0,0 +1,88 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "ImageStackReader.h"
+
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkTIFFWriter.h>
+
+#include <QFile>
+#include <QString>
+
+using namespace tomviz;
+
+class ImageStackReaderTest : public ::testing::Test
+{
+protected:
+  void TearDown() override
+  {
+    for (const auto& fileName : m_fileNames) {
+      QFile::remove(fileName);
+    }
+  }
+
+  // Writes a width x height image whose values are value plus their index
+  void writeImage(int width, int height, unsigned short value)
+  {
+    vtkNew<vtkImageData> image;
+    image->SetDimensions(width, height, 1);
+    image->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+    auto* data = static_cast<unsigned short*>(image->GetScalarPointer());
+    for (int i = 0; i < width * height; ++i) {
+      data[i] = value + i;
+    }
+
+    auto fileName = QString::fromStdString(::testing::TempDir()) +
+                    QString("tomviz_stack_%1.tif").arg(m_fileNames.size());
+    vtkNew<vtkTIFFWriter> writer;
+    writer->SetInputData(image);
+    writer->SetFileName(fileName.toLocal8Bit().constData());
+    writer->Write();
+    m_fileNames << fileName;
+  }
+
+  QStringList m_fileNames;
+};
+
+TEST_F(ImageStackReaderTest, read)
+{
+  const int width = 5, height = 4, count = 6;
+  for (int z = 0; z < count; ++z) {
+    writeImage(width, height, z * 100);
+  }
+
+  vtkNew<vtkImageData> image;
+  ASSERT_TRUE(ImageStackReader::read(m_fileNames, image));
+  int dims[3];
+  image->GetDimensions(dims);
+  EXPECT_EQ(dims[0], width);
+  EXPECT_EQ(dims[1], height);
+  EXPECT_EQ(dims[2], count);
+  EXPECT_EQ(image->GetScalarType(), VTK_UNSIGNED_SHORT);
+
+  // The slices are in the order of the files
+  for (int z = 0; z < count; ++z) {
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        ASSERT_EQ(image->GetScalarComponentAsDouble(x, y, z, 0),
+                  z * 100 + y * width + x);
+      }
+    }
+  }
+}
+
+TEST_F(ImageStackReaderTest, mismatchedImages)
+{
+  writeImage(5, 4, 0);
+  writeImage(5, 4, 0);
+  writeImage(4, 4, 0);
+
+  vtkNew<vtkImageData> image;
+  EXPECT_FALSE(ImageStackReader::read(m_fileNames, image));
+
+  m_fileNames << "does_not_exist.tif";
+  EXPECT_FALSE(ImageStackReader::read(m_fileNames.mid(3), image));
+}
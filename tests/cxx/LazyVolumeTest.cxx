@@ -0,0 +1,164 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "LazyVolume.h"
+#include "h5cpp/h5readwrite.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using h5::H5ReadWrite;
+using tomviz::LazyVolume;
+
+class LazyVolumeTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // Every value is its own C ordered index
+    m_data.resize(static_cast<size_t>(D0) * D1 * D2);
+    for (size_t i = 0; i < m_data.size(); ++i) {
+      m_data[i] = static_cast<float>(i);
+    }
+
+    H5ReadWrite writer(m_fileName, H5ReadWrite::OpenMode::WriteOnly);
+    h5::WriteOptions options;
+    options.chunkDimensions = { 16, 8, 10 };
+    options.compression = h5::WriteOptions::Compression::Deflate;
+    writer.writeData("/", "chunked", { D0, D1, D2 }, m_data, options);
+    writer.writeData("/", "contiguous", { D0, D1, D2 }, m_data);
+  }
+
+  void TearDown() override { std::remove(m_fileName.c_str()); }
+
+  float at(int i0, int i1, int i2) const
+  {
+    return m_data[(static_cast<size_t>(i0) * D1 + i1) * D2 + i2];
+  }
+
+  // Check a region read from the volume bounds bs against the file data
+  void checkRegion(LazyVolume& volume, const int bs[6], const int extent[6])
+  {
+    vtkNew<vtkImageData> image;
+    ASSERT_TRUE(volume.readRegion(extent, image));
+    auto* values = static_cast<float*>(
+      image->GetPointData()->GetScalars()->GetVoidPointer(0));
+
+    size_t index = 0;
+    for (int z = extent[4]; z <= extent[5]; ++z) {
+      for (int y = extent[2]; y <= extent[3]; ++y) {
+        for (int x = extent[0]; x <= extent[1]; ++x) {
+          int i[3] = { x, y, z };
+          if (volume.reversedAxes()) {
+            std::swap(i[0], i[2]);
+          }
+          ASSERT_EQ(values[index++], at(i[0] + bs[0], i[1] + bs[2],
+                                        i[2] + bs[4]));
+        }
+      }
+    }
+  }
+
+  static const int D0 = 50;
+  static const int D1 = 37;
+  static const int D2 = 29;
+  std::vector<float> m_data;
+  std::string m_fileName = ::testing::TempDir() + "tomviz_lazyvolume.h5";
+};
+
+TEST_F(LazyVolumeTest, invalid)
+{
+  LazyVolume volume(m_fileName, "/missing");
+  EXPECT_FALSE(volume.isValid());
+}
+
+TEST_F(LazyVolumeTest, read_region)
+{
+  int bs[6] = { 3, 47, 0, 37, 5, 29 };
+  for (auto path : { "/chunked", "/contiguous" }) {
+    for (bool reversed : { false, true }) {
+      LazyVolume volume(m_fileName, path, bs, reversed);
+      ASSERT_TRUE(volume.isValid());
+
+      int dims[3];
+      volume.dimensions(dims);
+      EXPECT_EQ(dims[reversed ? 2 : 0], 44);
+      EXPECT_EQ(dims[1], 37);
+      EXPECT_EQ(dims[reversed ? 0 : 2], 24);
+
+      int extent[6] = { 1, dims[0] - 3, 2, dims[1] - 1, 0, dims[2] - 2 };
+      checkRegion(volume, bs, extent);
+
+      int slice[6] = { 0, dims[0] - 1, 5, 5, 0, dims[2] - 1 };
+      checkRegion(volume, bs, slice);
+    }
+  }
+}
+
+TEST_F(LazyVolumeTest, cache_size)
+{
+  LazyVolume volume(m_fileName, "/chunked");
+  // One 16 x 8 x 10 float chunk is 5 KiB
+  volume.setCacheSize(12 << 10);
+
+  vtkNew<vtkImageData> image;
+  int dims[3];
+  volume.dimensions(dims);
+  for (int i = 0; i < dims[0]; ++i) {
+    ASSERT_TRUE(volume.readSlice(0, i, image));
+    EXPECT_LE(volume.cachedBytes(), volume.cacheSize());
+  }
+
+  volume.clearCache();
+  EXPECT_EQ(volume.cachedBytes(), 0u);
+
+  // Out of bounds
+  int extent[6] = { 0, dims[0], 0, 0, 0, 0 };
+  EXPECT_FALSE(volume.readRegion(extent, image));
+}
+
+TEST_F(LazyVolumeTest, read_blocks)
+{
+  int bs[6] = { 3, 47, 0, 37, 5, 29 };
+  double expected = 0;
+  for (int i0 = bs[0]; i0 < bs[1]; ++i0) {
+    for (int i1 = bs[2]; i1 < bs[3]; ++i1) {
+      for (int i2 = bs[4]; i2 < bs[5]; ++i2) {
+        expected += at(i0, i1, i2);
+      }
+    }
+  }
+
+  for (auto path : { "/chunked", "/contiguous" }) {
+    LazyVolume volume(m_fileName, path, bs);
+    double sum = 0;
+    size_t count = 0;
+    ASSERT_TRUE(volume.readBlocks([&](vtkDataArray* block) {
+      for (vtkIdType i = 0; i < block->GetNumberOfTuples(); ++i) {
+        sum += block->GetTuple1(i);
+      }
+      count += block->GetNumberOfTuples();
+      return true;
+    }));
+    EXPECT_EQ(count, volume.size() / sizeof(float));
+    EXPECT_DOUBLE_EQ(sum, expected);
+    // The blocks don't go through the cache
+    EXPECT_EQ(volume.cachedBytes(), 0u);
+
+    int visited = 0;
+    EXPECT_FALSE(volume.readBlocks([&visited](vtkDataArray*) {
+      ++visited;
+      return false;
+    }));
+    EXPECT_EQ(visited, 1);
+  }
+}
@@ -0,0 +1,155 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "DataSource.h"
+#include "EmdFormat.h"
+#include "GenericHDF5Format.h"
+#include "h5cpp/h5readwrite.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace tomviz;
+
+class MultiscaleTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_image->SetDimensions(40, 34, 21);
+    m_image->AllocateScalars(VTK_FLOAT, 1);
+    m_image->GetPointData()->GetScalars()->SetName("values");
+    auto* values = static_cast<float*>(m_image->GetScalarPointer());
+    for (vtkIdType i = 0; i < m_image->GetNumberOfPoints(); ++i) {
+      values[i] = static_cast<float>(i % 97);
+    }
+  }
+
+  void TearDown() override { std::remove(m_fileName.c_str()); }
+
+  void expectEqual(vtkImageData* a, vtkImageData* b)
+  {
+    int dimsA[3], dimsB[3];
+    a->GetDimensions(dimsA);
+    b->GetDimensions(dimsB);
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_EQ(dimsA[i], dimsB[i]);
+    }
+    auto* valuesA = static_cast<float*>(a->GetScalarPointer());
+    auto* valuesB = static_cast<float*>(b->GetScalarPointer());
+    for (vtkIdType i = 0; i < a->GetNumberOfPoints(); ++i) {
+      ASSERT_EQ(valuesA[i], valuesB[i]);
+    }
+  }
+
+  vtkNew<vtkImageData> m_image;
+  std::string m_fileName = ::testing::TempDir() + "tomviz_multiscale.emd";
+};
+
+TEST_F(MultiscaleTest, multiscale_path)
+{
+  EXPECT_EQ(GenericHDF5Format::multiscalePath("/data/tomography/data", 4),
+            "/data/tomography/tomviz_multiscale/4");
+}
+
+TEST_F(MultiscaleTest, downsample)
+{
+  vtkNew<vtkImageData> level;
+  ASSERT_TRUE(GenericHDF5Format::downsample(m_image, level));
+
+  int dims[3];
+  level->GetDimensions(dims);
+  EXPECT_EQ(dims[0], 20);
+  EXPECT_EQ(dims[1], 17);
+  EXPECT_EQ(dims[2], 10);
+  EXPECT_DOUBLE_EQ(level->GetSpacing()[0], 2.0);
+
+  // Every voxel is the mean of a 2 x 2 x 2 block
+  double sum = 0.0;
+  for (int k = 0; k < 2; ++k) {
+    for (int j = 0; j < 2; ++j) {
+      for (int i = 0; i < 2; ++i) {
+        sum += m_image->GetScalarComponentAsDouble(2 + i, 4 + j, 6 + k, 0);
+      }
+    }
+  }
+  EXPECT_FLOAT_EQ(level->GetScalarComponentAsFloat(1, 2, 3, 0), sum / 8.0);
+
+  vtkNew<vtkImageData> flat;
+  flat->SetDimensions(4, 4, 1);
+  flat->AllocateScalars(VTK_FLOAT, 1);
+  EXPECT_FALSE(GenericHDF5Format::downsample(flat, level));
+}
+
+TEST_F(MultiscaleTest, read_levels)
+{
+  QVariantMap options = { { "multiscaleLevels", 2 } };
+  ASSERT_TRUE(EmdFormat::write(m_fileName, m_image, options));
+
+  {
+    h5::H5ReadWrite reader(m_fileName);
+    EXPECT_EQ(
+      GenericHDF5Format::multiscaleFactors(reader, "/data/tomography/data"),
+      std::vector<int>({ 2, 4 }));
+  }
+
+  vtkNew<vtkImageData> level2, level4;
+  GenericHDF5Format::downsample(m_image, level2);
+  GenericHDF5Format::downsample(level2, level4);
+
+  // Matching strides read the levels, whether averaging or not
+  for (bool average : { false, true }) {
+    for (int factor : { 2, 4 }) {
+      vtkNew<vtkImageData> image;
+      QVariantMap readOptions = {
+        { "askForSubsample", false },
+        { "subsampleAverage", average },
+        { "subsampleStrides", QVariantList({ factor, factor, factor }) }
+      };
+      ASSERT_TRUE(EmdFormat::read(m_fileName, image, readOptions));
+      expectEqual(image,
+                  factor == 2 ? level2.GetPointer() : level4.GetPointer());
+      EXPECT_TRUE(DataSource::wasSubsampled(image));
+    }
+  }
+
+  // The full resolution data is unchanged
+  vtkNew<vtkImageData> image;
+  ASSERT_TRUE(EmdFormat::read(m_fileName, image,
+                              QVariantMap({ { "askForSubsample", false } })));
+  expectEqual(image, m_image);
+}
+
+TEST_F(MultiscaleTest, read_progress)
+{
+  ASSERT_TRUE(EmdFormat::write(m_fileName, m_image));
+  QVariantMap options = { { "askForSubsample", false } };
+
+  // The read reports its start and its end
+  std::vector<double> fractions;
+  vtkNew<vtkImageData> image;
+  ASSERT_TRUE(GenericHDF5Format::read(m_fileName, image, options,
+                                      [&fractions](double fraction) {
+                                        fractions.push_back(fraction);
+                                        return true;
+                                      }));
+  ASSERT_FALSE(fractions.empty());
+  EXPECT_DOUBLE_EQ(fractions.front(), 0.0);
+  EXPECT_DOUBLE_EQ(fractions.back(), 1.0);
+  EXPECT_TRUE(std::is_sorted(fractions.begin(), fractions.end()));
+  expectEqual(image, m_image);
+
+  // Returning false cancels it
+  vtkNew<vtkImageData> canceled;
+  EXPECT_FALSE(GenericHDF5Format::read(m_fileName, canceled, options,
+                                       [](double) { return false; }));
+}
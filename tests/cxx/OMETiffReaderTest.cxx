@@ -0,0 +1,165 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "vtkOMETiffReader.h"
+
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "vtk_tiff.h"
+}
+
+using namespace tomviz;
+
+namespace {
+
+const int Width = 40;
+const int Height = 36;
+const int Depth = 5;
+
+unsigned short value(int x, int y, int z)
+{
+  return static_cast<unsigned short>(z * 1000 + y * 50 + x);
+}
+
+// Writes a compressed OME-TIFF of Width x Height x Depth values, in strips
+// of rowsPerStrip rows, or in tileSize x tileSize tiles if tileSize > 0.
+std::string writeOmeTiff(const std::string& name, int rowsPerStrip,
+                         int tileSize = 0)
+{
+  std::ostringstream xml;
+  xml << "<OME><Image ID=\"Image:0\"><Pixels ID=\"Pixels:0\" "
+      << "DimensionOrder=\"XYZCT\" Type=\"uint16\" SizeX=\"" << Width
+      << "\" SizeY=\"" << Height << "\" SizeZ=\"" << Depth
+      << "\" SizeC=\"1\" SizeT=\"1\"/></Image></OME>";
+
+  auto fileName = ::testing::TempDir() + name;
+  TIFF* tiff = TIFFOpen(fileName.c_str(), "w");
+  EXPECT_NE(tiff, nullptr);
+  if (!tiff) {
+    return fileName;
+  }
+  for (int z = 0; z < Depth; ++z) {
+    TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, Width);
+    TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, Height);
+    TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 16);
+    TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+    TIFFSetField(tiff, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+    TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tiff, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
+    TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+    if (z == 0) {
+      TIFFSetField(tiff, TIFFTAG_IMAGEDESCRIPTION, xml.str().c_str());
+    }
+
+    if (tileSize > 0) {
+      TIFFSetField(tiff, TIFFTAG_TILEWIDTH, tileSize);
+      TIFFSetField(tiff, TIFFTAG_TILELENGTH, tileSize);
+      // The edge tiles are padded
+      std::vector<unsigned short> tile(tileSize * tileSize);
+      for (int tileY = 0; tileY < Height; tileY += tileSize) {
+        for (int tileX = 0; tileX < Width; tileX += tileSize) {
+          for (int j = 0; j < tileSize; ++j) {
+            for (int i = 0; i < tileSize; ++i) {
+              int x = tileX + i;
+              int y = tileY + j;
+              tile[j * tileSize + i] =
+                x < Width && y < Height ? value(x, y, z) : 0;
+            }
+          }
+          TIFFWriteTile(tiff, tile.data(), tileX, tileY, 0, 0);
+        }
+      }
+    } else {
+      TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, rowsPerStrip);
+      std::vector<unsigned short> row(Width);
+      for (int y = 0; y < Height; ++y) {
+        for (int x = 0; x < Width; ++x) {
+          row[x] = value(x, y, z);
+        }
+        TIFFWriteScanline(tiff, row.data(), y, 0);
+      }
+    }
+    TIFFWriteDirectory(tiff);
+  }
+  TIFFClose(tiff);
+  return fileName;
+}
+
+// The number of values of the extent of the image that differ from value()
+int mismatches(vtkImageData* image, const int extent[6])
+{
+  int count = 0;
+  for (int z = extent[4]; z <= extent[5]; ++z) {
+    for (int y = extent[2]; y <= extent[3]; ++y) {
+      for (int x = extent[0]; x <= extent[1]; ++x) {
+        auto* scalar =
+          static_cast<unsigned short*>(image->GetScalarPointer(x, y, z));
+        if (*scalar != value(x, y, z)) {
+          ++count;
+        }
+      }
+    }
+  }
+  return count;
+}
+
+void checkRead(const std::string& fileName)
+{
+  vtkNew<vtkOMETiffReader> reader;
+  reader->SetFileName(fileName.c_str());
+  reader->Update();
+  auto* image = reader->GetOutput();
+  ASSERT_EQ(image->GetScalarType(), VTK_UNSIGNED_SHORT);
+  int dims[3];
+  image->GetDimensions(dims);
+  ASSERT_EQ(dims[0], Width);
+  ASSERT_EQ(dims[1], Height);
+  ASSERT_EQ(dims[2], Depth);
+  int whole[6] = { 0, Width - 1, 0, Height - 1, 0, Depth - 1 };
+  EXPECT_EQ(mismatches(image, whole), 0);
+
+  // Only the strips or tiles overlapping a region are decoded
+  vtkNew<vtkOMETiffReader> regionReader;
+  regionReader->SetFileName(fileName.c_str());
+  int extent[6] = { 5, 30, 7, 20, 1, 3 };
+  regionReader->UpdateExtent(extent);
+  image = regionReader->GetOutput();
+  int outExtent[6];
+  image->GetExtent(outExtent);
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_EQ(outExtent[i], extent[i]);
+  }
+  EXPECT_EQ(mismatches(image, extent), 0);
+}
+} // namespace
+
+TEST(OMETiffReaderTest, strips)
+{
+  auto fileName = writeOmeTiff("tomviz_ome_strips.ome.tif", 5);
+  checkRead(fileName);
+  std::remove(fileName.c_str());
+}
+
+TEST(OMETiffReaderTest, single_row_strips)
+{
+  auto fileName = writeOmeTiff("tomviz_ome_rows.ome.tif", 1);
+  checkRead(fileName);
+  std::remove(fileName.c_str());
+}
+
+TEST(OMETiffReaderTest, tiles)
+{
+  auto fileName = writeOmeTiff("tomviz_ome_tiles.ome.tif", 0, 16);
+  checkRead(fileName);
+  std::remove(fileName.c_str());
+}
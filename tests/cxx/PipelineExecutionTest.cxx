@@ -49,10 +49,58 @@ static vtkSmartPointer<vtkImageData> createImageData(int dim, double fill)
   return image;
 }
 
+static vtkSmartPointer<vtkImageData> createSlice(int dim, double fill)
+{
+  auto slice = vtkSmartPointer<vtkImageData>::New();
+  slice->SetDimensions(dim, dim, 1);
+  slice->AllocateScalars(VTK_DOUBLE, 1);
+  for (int y = 0; y < dim; ++y) {
+    for (int x = 0; x < dim; ++x) {
+      slice->SetScalarComponentFromDouble(x, y, 0, 0, fill);
+    }
+  }
+  return slice;
+}
+
 class PipelineExecutionTest : public QObject
 {
   Q_OBJECT
 
+private:
+  // A tilt series transformed by a slice local add_ten operator
+  DataSource* createSliceLocalPipeline(Pipeline** pipeline)
+  {
+    auto image = createImageData(2, 0.0);
+    auto* ds = new DataSource(image, DataSource::TiltSeries);
+    ds->setTiltAngles({ -10.0, 0.0 });
+
+    *pipeline = new Pipeline(ds);
+    (*pipeline)->pause();
+
+    auto* op = new OperatorPython(ds);
+    op->setJSONDescription(
+      "{\"label\": \"add_ten\", \"sliceLocal\": true}");
+    op->setScript(loadFixture("add_ten.py"));
+    ds->addOperator(op);
+
+    (*pipeline)->resume();
+    QSignalSpy finishedSpy(*pipeline, &Pipeline::finished);
+    auto* future = (*pipeline)->execute(ds, op);
+    finishedSpy.wait(10000);
+    delete future;
+
+    return ds;
+  }
+
+  void appendSlice(DataSource* ds, double fill, double angle)
+  {
+    ds->appendSlice(createSlice(2, fill));
+    auto angles = ds->getTiltAngles();
+    angles.resize(angles.size() - 1);
+    angles << angle;
+    ds->setTiltAngles(angles);
+  }
+
 private slots:
   void initTestCase()
   {
@@ -236,6 +284,65 @@ private slots:
       delete future;
     }
   }
+
+  void appendedSlicesAreTransformedAlone()
+  {
+    Pipeline* pipeline = nullptr;
+    auto* ds = createSliceLocalPipeline(&pipeline);
+    auto* output = pipeline->transformedDataSource(ds);
+    QVERIFY(output != nullptr && output != ds);
+    auto outputData = vtkImageData::SafeDownCast(output->dataObject());
+    QCOMPARE(outputData->GetDimensions()[2], 2);
+
+    // Only the new slice is transformed, the earlier ones are left as they
+    // were rather than transformed again.
+    outputData->SetScalarComponentFromDouble(0, 0, 0, 0, -1.0);
+    QSignalSpy finishedSpy(pipeline, &Pipeline::finished);
+    appendSlice(ds, 5.0, 10.0);
+    QVERIFY(finishedSpy.wait(10000));
+
+    QCOMPARE(pipeline->transformedDataSource(ds), output);
+    outputData = vtkImageData::SafeDownCast(output->dataObject());
+    QCOMPARE(outputData->GetDimensions()[2], 3);
+    QCOMPARE(outputData->GetScalarComponentAsDouble(0, 0, 0, 0), -1.0);
+    QCOMPARE(outputData->GetScalarComponentAsDouble(1, 1, 1, 0), 10.0);
+    QCOMPARE(outputData->GetScalarComponentAsDouble(1, 1, 2, 0), 15.0);
+    QCOMPARE(output->getTiltAngles(), QVector<double>({ -10.0, 0.0, 10.0 }));
+
+    delete pipeline;
+  }
+
+  void slicesAppendedWhileRunningAreQueued()
+  {
+    Pipeline* pipeline = nullptr;
+    auto* ds = createSliceLocalPipeline(&pipeline);
+    auto* op = ds->operators().first();
+
+    // Appending while the whole volume is transformed doesn't cancel it
+    QSignalSpy finishedSpy(pipeline, &Pipeline::finished);
+    auto* future = pipeline->execute(ds, op);
+    QVERIFY(pipeline->isRunning());
+    appendSlice(ds, 5.0, 10.0);
+    appendSlice(ds, 6.0, 20.0);
+    QVERIFY(finishedSpy.wait(10000));
+    delete future;
+    QVERIFY(op->isCompleted());
+
+    // The queued slices are then transformed together
+    while (finishedSpy.count() < 2) {
+      QVERIFY(finishedSpy.wait(10000));
+    }
+    auto* output = pipeline->transformedDataSource(ds);
+    auto outputData = vtkImageData::SafeDownCast(output->dataObject());
+    QCOMPARE(outputData->GetDimensions()[2], 4);
+    QCOMPARE(outputData->GetScalarComponentAsDouble(0, 0, 1, 0), 10.0);
+    QCOMPARE(outputData->GetScalarComponentAsDouble(0, 0, 2, 0), 15.0);
+    QCOMPARE(outputData->GetScalarComponentAsDouble(0, 0, 3, 0), 16.0);
+    QCOMPARE(output->getTiltAngles(),
+             QVector<double>({ -10.0, 0.0, 10.0, 20.0 }));
+
+    delete pipeline;
+  }
 };
 
 int main(int argc, char** argv)
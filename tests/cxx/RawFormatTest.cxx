@@ -0,0 +1,85 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "RawFormat.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+#include <QSysInfo>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace tomviz;
+
+class RawFormatTest : public ::testing::Test
+{
+protected:
+  void TearDown() override { std::remove(m_fileName.c_str()); }
+
+  // A header, then 4 x 3 x 2 two component values holding their index
+  void writeFile(bool bigEndian)
+  {
+    bool swap = bigEndian != (QSysInfo::ByteOrder == QSysInfo::BigEndian);
+    std::ofstream file(m_fileName, std::ios::binary);
+    file.write("header", 6);
+    for (uint16_t i = 0; i < 48; ++i) {
+      uint16_t value = swap ? static_cast<uint16_t>((i << 8) | (i >> 8)) : i;
+      file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+  }
+
+  std::string m_fileName = ::testing::TempDir() + "tomviz_raw";
+  int m_dims[3] = { 4, 3, 2 };
+};
+
+TEST_F(RawFormatTest, read)
+{
+  for (bool bigEndian : { false, true }) {
+    writeFile(bigEndian);
+    vtkNew<vtkImageData> image;
+    ASSERT_TRUE(
+      RawFormat::read(m_fileName, VTK_UNSIGNED_SHORT, 2, m_dims, bigEndian,
+                      image));
+
+    int dims[3];
+    image->GetDimensions(dims);
+    EXPECT_EQ(dims[0], 4);
+    EXPECT_EQ(dims[1], 3);
+    EXPECT_EQ(dims[2], 2);
+
+    auto* scalars = image->GetPointData()->GetScalars();
+    ASSERT_EQ(scalars->GetDataType(), VTK_UNSIGNED_SHORT);
+    ASSERT_EQ(scalars->GetNumberOfComponents(), 2);
+    ASSERT_EQ(scalars->GetNumberOfTuples(), 24);
+    for (vtkIdType i = 0; i < 24; ++i) {
+      ASSERT_EQ(scalars->GetComponent(i, 0), 2 * i);
+      ASSERT_EQ(scalars->GetComponent(i, 1), 2 * i + 1);
+    }
+
+    // The values can be modified, without modifying the file
+    scalars->SetComponent(0, 0, 42.0);
+    vtkNew<vtkImageData> again;
+    ASSERT_TRUE(RawFormat::read(m_fileName, VTK_UNSIGNED_SHORT, 2, m_dims,
+                                bigEndian, again));
+    EXPECT_EQ(again->GetPointData()->GetScalars()->GetComponent(0, 0), 0.0);
+  }
+}
+
+TEST_F(RawFormatTest, too_small)
+{
+  writeFile(false);
+  int dims[3] = { 4, 3, 3 };
+  vtkNew<vtkImageData> image;
+  EXPECT_FALSE(
+    RawFormat::read(m_fileName, VTK_UNSIGNED_SHORT, 2, dims, false, image));
+  EXPECT_FALSE(
+    RawFormat::read(m_fileName, VTK_UNSIGNED_SHORT, 0, m_dims, false, image));
+}
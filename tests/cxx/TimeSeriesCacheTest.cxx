@@ -0,0 +1,151 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "TimeSeriesCache.h"
+#include "TimeSeriesStep.h"
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <atomic>
+
+using namespace tomviz;
+
+class TimeSeriesCacheTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_reads = 0;
+    auto* reads = &m_reads;
+    TimeSeriesStep::Reader reader = [reads](const QString& fileName) {
+      ++*reads;
+      if (fileName == "missing") {
+        return vtkSmartPointer<vtkImageData>();
+      }
+      auto image = vtkSmartPointer<vtkImageData>::New();
+      image->SetDimensions(64, 64, 64);
+      image->AllocateScalars(VTK_FLOAT, 1);
+      return image;
+    };
+    for (int i = 0; i < 6; ++i) {
+      QString name = QString::number(i);
+      m_steps.append(TimeSeriesStep(name, name, reader, i));
+    }
+
+    // Room for three steps
+    auto image = reader("size");
+    m_stepBytes = static_cast<qint64>(image->GetActualMemorySize()) * 1024;
+    m_cache.setBudget(3 * m_stepBytes);
+    m_reads = 0;
+  }
+
+  TimeSeriesCache m_cache;
+  QList<TimeSeriesStep> m_steps;
+  qint64 m_stepBytes = 0;
+  std::atomic<int> m_reads;
+};
+
+TEST_F(TimeSeriesCacheTest, least_recently_used)
+{
+  EXPECT_TRUE(m_steps[0].isLazy());
+  auto first = m_cache.image(m_steps[0]);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(m_reads, 1);
+
+  // Resident steps are not read again
+  EXPECT_EQ(m_cache.image(m_steps[0]), first);
+  EXPECT_EQ(m_reads, 1);
+
+  for (int i = 1; i < 4; ++i) {
+    ASSERT_NE(m_cache.image(m_steps[i]), nullptr);
+  }
+  EXPECT_EQ(m_reads, 4);
+  EXPECT_LE(m_cache.residentBytes(), m_cache.budget());
+  EXPECT_FALSE(m_cache.isResident("0"));
+  EXPECT_TRUE(m_cache.isResident("3"));
+
+  // The current step is kept, even over the budget
+  m_cache.setBudget(0);
+  EXPECT_TRUE(m_cache.isResident("3"));
+  EXPECT_FALSE(m_cache.isResident("2"));
+
+  TimeSeriesStep missing("missing", "missing", m_steps[0].reader, 0);
+  EXPECT_EQ(m_cache.image(missing), nullptr);
+  EXPECT_TRUE(m_cache.isResident("3"));
+
+  m_cache.clear();
+  EXPECT_EQ(m_cache.residentBytes(), 0);
+}
+
+TEST_F(TimeSeriesCacheTest, prefetch)
+{
+  ASSERT_NE(m_cache.image(m_steps[0]), nullptr);
+
+  // Two more steps fit next to the current one
+  m_cache.prefetch(m_steps.mid(1), m_stepBytes);
+  EXPECT_TRUE(m_cache.isPending("1") || m_cache.isResident("1"));
+  EXPECT_TRUE(m_cache.isPending("2") || m_cache.isResident("2"));
+  EXPECT_FALSE(m_cache.isPending("3") || m_cache.isResident("3"));
+  QThreadPool::globalInstance()->waitForDone();
+  EXPECT_EQ(m_reads, 3);
+
+  // Prefetched steps are not read again
+  ASSERT_NE(m_cache.image(m_steps[1]), nullptr);
+  ASSERT_NE(m_cache.image(m_steps[2]), nullptr);
+  EXPECT_EQ(m_reads, 3);
+  EXPECT_LE(m_cache.residentBytes(), m_cache.budget());
+
+  // Prefetched steps push the oldest ones out
+  m_cache.prefetch(m_steps.mid(3), m_stepBytes);
+  QThreadPool::globalInstance()->waitForDone();
+  ASSERT_NE(m_cache.image(m_steps[3]), nullptr);
+  EXPECT_EQ(m_reads, 5);
+  EXPECT_TRUE(m_cache.isResident("4"));
+  EXPECT_FALSE(m_cache.isResident("0"));
+}
+
+TEST_F(TimeSeriesCacheTest, reentrant_wait)
+{
+  int argc = 1;
+  char name[] = "TimeSeriesCacheTest";
+  char* argv[] = { name, nullptr };
+  QCoreApplication app(argc, argv);
+
+  // The prefetched read only finishes once it is waited for
+  std::atomic<bool> release(false);
+  auto reader = m_steps[0].reader;
+  TimeSeriesStep slow(
+    "slow", "slow",
+    [&release, reader](const QString& fileName) {
+      while (!release) {
+        QThread::msleep(1);
+      }
+      return reader(fileName);
+    },
+    0);
+  m_cache.prefetch({ slow }, m_stepBytes);
+  ASSERT_TRUE(m_cache.isPending("slow"));
+
+  // Switching to the step again from the events processed while waiting
+  // for it waits for the same read
+  vtkSmartPointer<vtkImageData> nested;
+  QTimer::singleShot(0, [&]() {
+    EXPECT_TRUE(m_cache.isPending("slow"));
+    release = true;
+    nested = m_cache.image(slow);
+  });
+  auto image = m_cache.image(slow);
+  ASSERT_NE(image, nullptr);
+  EXPECT_EQ(image, nested);
+  EXPECT_EQ(m_reads, 1);
+  EXPECT_FALSE(m_cache.isPending("slow"));
+  EXPECT_TRUE(m_cache.isResident("slow"));
+}
@@ -0,0 +1,129 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "TomographyTiltSeries.h"
+
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+#include <vector>
+
+using namespace tomviz;
+
+class TomographyTiltSeriesTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // More slices and rays than the transposition's block size
+    m_tiltSeries->SetDimensions(m_dims);
+    m_tiltSeries->AllocateScalars(VTK_SHORT, 1);
+    auto* data = static_cast<short*>(m_tiltSeries->GetScalarPointer());
+    for (int z = 0; z < m_dims[2]; ++z) {
+      for (int y = 0; y < m_dims[1]; ++y) {
+        for (int x = 0; x < m_dims[0]; ++x) {
+          *data++ = static_cast<short>(x - 3 * y + 7 * z);
+        }
+      }
+    }
+
+    m_budget = TomographyTiltSeries::sinogramCacheBudget();
+    TomographyTiltSeries::releaseSinogramCache();
+  }
+
+  void TearDown() override
+  {
+    TomographyTiltSeries::setSinogramCacheBudget(m_budget);
+    TomographyTiltSeries::releaseSinogramCache();
+  }
+
+  // Every sinogram is [y, z], with the rays varying fastest
+  void checkSinograms()
+  {
+    std::vector<float> sinogram(m_dims[1] * m_dims[2]);
+    for (int x = 0; x < m_dims[0]; ++x) {
+      TomographyTiltSeries::getSinogram(m_tiltSeries, x, sinogram.data());
+      for (int z = 0; z < m_dims[2]; ++z) {
+        for (int y = 0; y < m_dims[1]; ++y) {
+          ASSERT_EQ(sinogram[z * m_dims[1] + y],
+                    static_cast<float>(x - 3 * y + 7 * z));
+        }
+      }
+    }
+  }
+
+  int m_dims[3] = { 37, 45, 5 };
+  size_t m_budget = 0;
+  vtkNew<vtkImageData> m_tiltSeries;
+};
+
+TEST_F(TomographyTiltSeriesTest, sinograms_are_cached)
+{
+  checkSinograms();
+
+  size_t size = sizeof(float) * m_dims[0] * m_dims[1] * m_dims[2];
+  EXPECT_EQ(TomographyTiltSeries::sinogramCacheMemoryUsage(), size);
+  auto stack = TomographyTiltSeries::sinogramStack(m_tiltSeries);
+  EXPECT_EQ(stack->numberOfSinograms(), m_dims[0]);
+  EXPECT_EQ(stack->numberOfRays(), m_dims[1]);
+  EXPECT_EQ(stack->numberOfTilts(), m_dims[2]);
+
+  // A modified tilt series is transposed again
+  auto* data = static_cast<short*>(m_tiltSeries->GetScalarPointer());
+  data[0] = 100;
+  m_tiltSeries->Modified();
+  EXPECT_NE(TomographyTiltSeries::sinogramStack(m_tiltSeries), stack);
+  EXPECT_EQ(TomographyTiltSeries::sinogramStack(m_tiltSeries)->sinogram(0)[0],
+            100);
+  data[0] = 0;
+  m_tiltSeries->Modified();
+
+  // Stacks still in use outlive their release
+  TomographyTiltSeries::releaseSinogramCache(m_tiltSeries);
+  EXPECT_EQ(TomographyTiltSeries::sinogramCacheMemoryUsage(), 0u);
+  EXPECT_EQ(stack->sinogram(1)[0], 1);
+}
+
+TEST_F(TomographyTiltSeriesTest, deleted_images_are_dropped)
+{
+  auto other = vtkSmartPointer<vtkImageData>::New();
+  other->DeepCopy(m_tiltSeries);
+  TomographyTiltSeries::sinogramStack(m_tiltSeries);
+  TomographyTiltSeries::sinogramStack(other);
+
+  // The stack of a deleted image is dropped right away, not on the next use
+  size_t size = sizeof(float) * m_dims[0] * m_dims[1] * m_dims[2];
+  EXPECT_EQ(TomographyTiltSeries::sinogramCacheMemoryUsage(), 2 * size);
+  other = nullptr;
+  EXPECT_EQ(TomographyTiltSeries::sinogramCacheMemoryUsage(), size);
+}
+
+TEST_F(TomographyTiltSeriesTest, over_budget_reads_slices)
+{
+  TomographyTiltSeries::setSinogramCacheBudget(1024);
+  checkSinograms();
+
+  EXPECT_EQ(TomographyTiltSeries::sinogramCacheMemoryUsage(), 0u);
+}
+
+TEST_F(TomographyTiltSeriesTest, budget_evicts_stacks)
+{
+  size_t size = sizeof(float) * m_dims[0] * m_dims[1] * m_dims[2];
+  TomographyTiltSeries::setSinogramCacheBudget(size);
+
+  vtkNew<vtkImageData> other;
+  other->DeepCopy(m_tiltSeries);
+  TomographyTiltSeries::sinogramStack(m_tiltSeries);
+  TomographyTiltSeries::sinogramStack(other);
+
+  // Only the most recently used one fits
+  EXPECT_EQ(TomographyTiltSeries::sinogramCacheMemoryUsage(), size);
+  TomographyTiltSeries::releaseSinogramCache(m_tiltSeries);
+  EXPECT_EQ(TomographyTiltSeries::sinogramCacheMemoryUsage(), size);
+  TomographyTiltSeries::releaseSinogramCache(other);
+  EXPECT_EQ(TomographyTiltSeries::sinogramCacheMemoryUsage(), 0u);
+}
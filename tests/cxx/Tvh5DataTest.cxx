@@ -23,6 +23,7 @@
 #include "Pipeline.h"
 #include "PipelineManager.h"
 #include "Tvh5Format.h"
+#include "h5cpp/h5readwrite.h"
 #include "modules/ModuleManager.h"
 
 using namespace tomviz;
@@ -206,6 +207,80 @@ private slots:
       }
     }
   }
+
+  void saveRewritesModifiedDataSources()
+  {
+    auto* first = setupDataSource(createTestImage(4, 1.0));
+    auto* second = setupDataSource(createTestImage(4, 2.0));
+    ActiveObjects::instance().setActiveDataSource(first);
+
+    auto fileName = tempFilePath();
+    QVERIFY(Tvh5Format::write(fileName.toStdString()));
+    QVERIFY(first->isSavedTo(fileName));
+    QVERIFY(second->isSavedTo(fileName));
+
+    second->imageData()->SetScalarComponentFromDouble(1, 2, 3, 0, 5.0);
+    second->imageData()->Modified();
+    QVERIFY(!second->isSavedTo(fileName));
+
+    QVERIFY(Tvh5Format::save(fileName.toStdString()));
+    QVERIFY(second->isSavedTo(fileName));
+
+    // Only the modified data source was replaced, in place
+    h5::H5ReadWrite reader(fileName.toStdString());
+    auto children = reader.children("/tomviz_datasources");
+    QCOMPARE(static_cast<int>(children.size()), 2);
+    QVERIFY(reader.isSoftLink("/tomviz_datasources/" +
+                              first->id().toStdString()));
+
+    auto readImage = vtkSmartPointer<vtkImageData>::New();
+    auto path = "/tomviz_datasources/" + second->id().toStdString();
+    QVERIFY(EmdFormat::readNode(reader, path, readImage));
+    QCOMPARE(readImage->GetScalarComponentAsDouble(1, 2, 3, 0), 5.0);
+    QCOMPARE(readImage->GetScalarComponentAsDouble(0, 0, 0, 0), 2.0);
+
+    readImage = vtkSmartPointer<vtkImageData>::New();
+    QVERIFY(EmdFormat::readNode(reader, "/data/tomography", readImage));
+    QCOMPARE(readImage->GetScalarComponentAsDouble(1, 2, 3, 0), 1.0);
+  }
+
+  void saveRewritesFilesWithUnusedSpace()
+  {
+    auto* ds = setupDataSource(createTestImage(4, 1.0));
+    auto fileName = tempFilePath();
+    QVERIFY(Tvh5Format::write(fileName.toStdString()));
+
+    ds->imageData()->SetScalarComponentFromDouble(0, 0, 0, 0, 3.0);
+    ds->imageData()->Modified();
+    QVERIFY(Tvh5Format::save(fileName.toStdString()));
+
+    // The space of the replaced data is counted
+    unsigned long long unused = 0;
+    {
+      h5::H5ReadWrite reader(fileName.toStdString());
+      QVERIFY(reader.hasAttribute("/", "tomviz_unused_bytes"));
+      unused = reader.attribute<unsigned long long>("/", "tomviz_unused_bytes");
+      QVERIFY(unused > 0);
+    }
+
+    // Once most of the file is unused, it is written again
+    {
+      h5::H5ReadWrite writer(fileName.toStdString(),
+                             h5::H5ReadWrite::OpenMode::ReadWrite);
+      QVERIFY(writer.setAttribute("/", "tomviz_unused_bytes",
+                                  unused * 1000000));
+    }
+    ds->imageData()->SetScalarComponentFromDouble(0, 0, 0, 0, 4.0);
+    ds->imageData()->Modified();
+    QVERIFY(Tvh5Format::save(fileName.toStdString()));
+    QVERIFY(!QFile::exists(fileName + ".saving"));
+
+    h5::H5ReadWrite reader(fileName.toStdString());
+    QVERIFY(!reader.hasAttribute("/", "tomviz_unused_bytes"));
+    auto readImage = vtkSmartPointer<vtkImageData>::New();
+    QVERIFY(EmdFormat::readNode(reader, "/data/tomography", readImage));
+    QCOMPARE(readImage->GetScalarComponentAsDouble(0, 0, 0, 0), 4.0);
+  }
 };
 
 int main(int argc, char** argv)
@@ -0,0 +1,121 @@
+"""Compares reading and writing Zarr stores with EMD files.
+
+Not collected as a test, run it directly with tomviz on the PYTHONPATH:
+
+    python zarr_emd.py --shape 512 512 512 --dtype float32
+
+The EMD files are written as tomviz writes them, contiguous, and also with
+gzip compressed chunks to compare with the compressed Zarr stores.
+"""
+import argparse
+import os
+import shutil
+import tempfile
+import time
+
+import h5py
+import numpy as np
+
+from tomviz.io import zarr as zarr_io
+
+
+def timed(function, *args, **kwargs):
+    start = time.perf_counter()
+    result = function(*args, **kwargs)
+    return time.perf_counter() - start, result
+
+
+def size_of(path):
+    if os.path.isfile(path):
+        return os.path.getsize(path)
+    return sum(os.path.getsize(os.path.join(root, name))
+               for root, _, names in os.walk(path) for name in names)
+
+
+def write_emd(path, data, chunks=None, compression=None):
+    with h5py.File(path, 'w') as f:
+        tomography = f.create_group('data').create_group('tomography')
+        tomography.create_dataset('data', data=data, chunks=chunks,
+                                  compression=compression)
+
+
+def read_emd(path, bounds=None, strides=None):
+    with h5py.File(path, 'r') as f:
+        dataset = f['data/tomography/data']
+        if bounds is None:
+            return dataset[:]
+        return dataset[tuple(slice(b[0], b[1], s)
+                             for b, s in zip(bounds, strides))]
+
+
+def volume(shape, dtype):
+    # Smooth data with some noise, so that it compresses like real data
+    rng = np.random.default_rng(0)
+    z, y, x = np.meshgrid(*[np.linspace(0, 8, s) for s in shape],
+                          indexing='ij', sparse=True)
+    data = 100 * (np.sin(x) * np.cos(y) + np.sin(z)) + 200
+    data = data + rng.normal(0, 5, shape)
+    return data.astype(dtype)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--shape', type=int, nargs=3, default=[256] * 3)
+    parser.add_argument('--dtype', default='uint16')
+    parser.add_argument('--chunk', type=int, default=128)
+    parser.add_argument('--workers', type=int, default=None)
+    args = parser.parse_args()
+
+    data = volume(args.shape, args.dtype)
+    chunks = (args.chunk,) * 3
+    bounds = [(s // 4, 3 * s // 4) for s in data.shape]
+    strides = [2, 2, 2]
+
+    directory = tempfile.mkdtemp()
+    try:
+        cases = [
+            ('EMD', 'contiguous.emd',
+             lambda p: write_emd(p, data),
+             read_emd),
+            ('EMD gzip', 'gzip.emd',
+             lambda p: write_emd(p, data, chunks, 'gzip'),
+             read_emd),
+        ]
+        compressors = [('Zarr', None), ('Zarr zlib', {'id': 'zlib',
+                                                      'level': 1})]
+        default = zarr_io.default_compressor()
+        if default['id'] != 'zlib':
+            compressors.append(('Zarr ' + default['id'], default))
+
+        for name, compressor in compressors:
+            def write(p, compressor=compressor):
+                zarr_io.write_array(p, data, chunks=chunks,
+                                    compressor=compressor, levels=1,
+                                    workers=args.workers)
+
+            def read(p, bounds=None, strides=None):
+                return zarr_io.read_array(p, bounds, strides,
+                                          workers=args.workers)[0]
+
+            cases.append((name, name.replace(' ', '_') + '.zarr', write,
+                          read))
+
+        print('%d x %d x %d %s, %.1f MB' % (*data.shape, data.dtype,
+                                             data.nbytes / 1e6))
+        print('%-12s %10s %10s %10s %10s' % ('', 'write (s)', 'read (s)',
+                                             'subset (s)', 'size (MB)'))
+        for name, file_name, write, read in cases:
+            path = os.path.join(directory, file_name)
+            write_time, _ = timed(write, path)
+            read_time, result = timed(read, path)
+            assert np.array_equal(result, data)
+            subset_time, _ = timed(read, path, bounds, strides)
+            print('%-12s %10.3f %10.3f %10.3f %10.1f' % (
+                name, write_time, read_time, subset_time,
+                size_of(path) / 1e6))
+    finally:
+        shutil.rmtree(directory)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,69 @@
+import numpy as np
+import pytest
+from scipy import ndimage
+
+from utils import load_operator_class, load_operator_module
+
+# The native searches are built with the application.
+_wrapping = pytest.importorskip('tomviz._wrapping')
+
+
+def synthetic_tilt_series(shift=0, rotation=0.0, nx=16, ny=32, seed=0):
+    # Project a few blobs per x slice, then misalign the tilt axis.
+    angles = np.linspace(-60, 60, 21)
+    random_state = np.random.RandomState(seed)
+    y, z = np.mgrid[0:ny, 0:ny] - ny // 2
+    tilt_series = np.zeros((nx, ny, angles.size), dtype=np.float32)
+    for x in range(nx):
+        obj = np.zeros((ny, ny))
+        for _ in range(3):
+            cy, cz = random_state.uniform(-ny / 5, ny / 5, 2)
+            obj += np.exp(-((y - cy)**2 + (z - cz)**2) / 8)
+        for i, angle in enumerate(angles):
+            projection = ndimage.rotate(obj, angle, reshape=False, order=1)
+            tilt_series[x, :, i] = projection.sum(axis=1)
+
+    tilt_series = np.roll(tilt_series, shift, axis=1)
+    if rotation:
+        tilt_series = ndimage.rotate(tilt_series, rotation, axes=(0, 1),
+                                     reshape=False, order=1)
+    return np.asfortranarray(tilt_series, dtype=np.float32), angles
+
+
+@pytest.mark.parametrize('rotation', [0.0, 7.0, -23.4])
+def test_rotation_search_matches_python(rotation):
+    tilt_series, _ = synthetic_tilt_series(rotation=rotation)
+
+    module = load_operator_module('AutoTiltAxisRotationAlignment')
+    operator = load_operator_class(module)
+    expected = operator.search(tilt_series)
+
+    best, candidates, scores = _wrapping.tilt_axis_rotation_search(
+        tilt_series)
+    # Coarse sweep of [-90, 90) every 2 degrees, then +/- 2 every 0.1.
+    assert len(candidates) == 90 + 41
+    assert len(scores) == len(candidates)
+    assert best == pytest.approx(expected, abs=1e-6)
+
+
+# Rays of a power of two length are filtered once, the others are padded and
+# filtered for every shift.
+@pytest.mark.parametrize('ny', [32, 48])
+@pytest.mark.parametrize('shift', [3, -5])
+def test_shift_search_matches_python(shift, ny):
+    tilt_series, angles = synthetic_tilt_series(shift=shift, ny=ny)
+    slices = np.array([2, 6, 9, 13])
+    aligned, _ = synthetic_tilt_series(ny=ny)
+
+    module = load_operator_module('AutoTiltAxisShiftAlignment')
+    operator = load_operator_class(module)
+    shifts = np.linspace(-20, 20, 41).astype('int')
+    expected = operator.search(tilt_series, angles, slices, shifts)
+
+    best, candidates, _ = _wrapping.tilt_axis_shift_search(
+        tilt_series, angles, slices)
+    assert candidates == list(shifts)
+    assert best == expected
+    # Shifts wrap around, so the misalignment is undone exactly.
+    reference = _wrapping.tilt_axis_shift_search(aligned, angles, slices)[0]
+    assert best == reference - shift
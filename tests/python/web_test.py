@@ -0,0 +1,95 @@
+import gzip
+import importlib
+import os
+import sys
+from unittest import mock
+
+import numpy as np
+import pytest
+
+
+def mock_missing_modules(*names):
+    for name in names:
+        try:
+            importlib.import_module(name)
+        except ImportError:
+            sys.modules[name] = mock.MagicMock()
+
+
+# The web export runs in the application, with ParaView, but the helpers
+# tested here only need numpy.
+mock_missing_modules('vtk', 'vtk.util', 'vtk.util.numpy_support', 'paraview',
+                     'paraview.simple', 'paraview.web',
+                     'paraview.web.dataset_builder')
+
+from tomviz import web  # noqa: E402
+
+
+@pytest.fixture
+def volume():
+    # Fortran ordered (x, y, z), as the export extracts it
+    data = np.arange(5 * 4 * 3, dtype=np.float32).reshape((5, 4, 3),
+                                                           order='F')
+    return np.asfortranarray(data * 0.5 - 7.0)
+
+
+@pytest.mark.parametrize('bits', [8, 16])
+def test_quantize_volume(volume, bits):
+    scale, offset = web.quantization(volume, bits)
+    assert offset == volume.min()
+    assert offset + scale * (2 ** bits - 1) == pytest.approx(volume.max())
+
+    quantized = web.quantize_volume(volume, bits, scale, offset)
+    assert quantized.dtype == (np.uint8 if bits == 8 else np.uint16)
+    assert quantized.shape == volume.shape
+    assert quantized.min() == 0
+    assert quantized.max() == 2 ** bits - 1
+
+    # Mapping back is within half a quantization step
+    restored = quantized * scale + offset
+    np.testing.assert_allclose(restored, volume, atol=scale / 2)
+
+
+def test_quantize_constant_volume():
+    volume = np.full((3, 3, 3), 4.0, dtype=np.float64, order='F')
+    scale, offset = web.quantization(volume, 8)
+    assert (scale, offset) == (1.0, 4.0)
+
+    quantized = web.quantize_volume(volume, 8, scale, offset)
+    assert not quantized.any()
+
+
+def test_write_data_file(tmp_path, volume):
+    path = str(tmp_path / 'fieldData')
+    web.write_data_file(path, volume, compress=False)
+
+    # X varies fastest
+    with open(path, 'rb') as f:
+        data = np.frombuffer(f.read(), dtype=volume.dtype)
+    np.testing.assert_array_equal(data, volume.ravel(order='F'))
+
+
+def test_write_compressed_data_file(tmp_path, monkeypatch):
+    volume = np.asfortranarray(
+        np.arange(40 * 30 * 20, dtype=np.uint16).reshape((40, 30, 20)))
+    # Several blocks, the last one partial
+    monkeypatch.setattr(web, 'BLOCK_SIZE', 10000)
+
+    path = str(tmp_path / 'fieldData')
+    web.write_data_file(path, volume, compress=True)
+    assert not os.path.exists(path)
+
+    files = sorted(os.listdir(str(tmp_path)))
+    count = -(-volume.nbytes // web.BLOCK_SIZE)
+    assert len(files) == count
+    for name in files:
+        assert web.BLOCK_PATTERN.match(name).group(1) == 'fieldData'
+
+    content = b''.join(
+        web.read_block('%s.%d.gz' % (path, i)) for i in range(count))
+    data = np.frombuffer(content, dtype=volume.dtype)
+    np.testing.assert_array_equal(data, volume.ravel(order='F'))
+
+    # Each block is a gzip stream of its own
+    with open('%s.0.gz' % path, 'rb') as f:
+        assert len(gzip.decompress(f.read())) == web.BLOCK_SIZE
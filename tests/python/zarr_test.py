@@ -0,0 +1,139 @@
+import json
+import os
+
+import numpy as np
+import pytest
+
+from tomviz.io import zarr as zarr_io
+
+
+@pytest.fixture
+def volume():
+    # Not a multiple of the chunks, so the edge chunks are padded
+    return np.arange(37 * 20 * 11, dtype=np.uint16).reshape((37, 20, 11))
+
+
+@pytest.mark.parametrize('version', [2, 3])
+@pytest.mark.parametrize('compressor', [None, {'id': 'zlib', 'level': 1},
+                                        {'id': 'gzip', 'level': 1}])
+def test_round_trip(tmp_path, volume, version, compressor):
+    path = str(tmp_path / 'volume.zarr')
+    zarr_io.write_array(path, volume, spacing=[3.0, 2.0, 1.0],
+                        chunks=(8, 8, 8), compressor=compressor,
+                        version=version)
+
+    data, scale = zarr_io.read_array(path)
+    assert data.dtype == volume.dtype
+    np.testing.assert_array_equal(data, volume)
+    assert scale == [3.0, 2.0, 1.0]
+
+    # Halved until the largest axis fits in a chunk
+    levels = sorted(int(name) for name in os.listdir(path)
+                    if name.isdigit())
+    assert levels == [0, 1, 2, 3]
+    level, scale = zarr_io.read_array(os.path.join(path, '1'))
+    assert level.shape == (18, 10, 5)
+    assert level[0, 0, 0] == round(volume[:2, :2, :2].mean())
+
+    # Overwriting a store replaces it
+    zarr_io.write_array(path, volume[:4], version=version)
+    assert zarr_io.read_array(path)[0].shape == (4, 20, 11)
+
+
+@pytest.mark.parametrize('version', [2, 3])
+def test_subsample(tmp_path, volume, version):
+    path = str(tmp_path / 'volume.zarr')
+    zarr_io.write_array(path, volume, chunks=(8, 8, 8), version=version)
+
+    bounds = [(3, 30), (0, 20), (5, 11)]
+    for strides in ([1, 1, 1], [2, 3, 4], [7, 1, 5]):
+        data, _ = zarr_io.read_array(path, bounds, strides, workers=3)
+        expected = volume[3:30:strides[0], 0:20:strides[1], 5:11:strides[2]]
+        np.testing.assert_array_equal(data, expected)
+
+    data, scale = zarr_io.read_array(path, strides=[2, 2, 2])
+    np.testing.assert_array_equal(data, volume[::2, ::2, ::2])
+    assert scale == [2.0, 2.0, 2.0]
+
+    with pytest.raises(zarr_io.ZarrError):
+        zarr_io.read_array(path, [(5, 5), None, None])
+
+
+def test_foreign_v2_array(tmp_path):
+    # A Fortran ordered array with a missing chunk and "." separated keys
+    path = tmp_path / 'array.zarr'
+    path.mkdir()
+    meta = {
+        'zarr_format': 2,
+        'shape': [4, 3],
+        'chunks': [2, 3],
+        'dtype': '>f4',
+        'compressor': None,
+        'fill_value': -1.0,
+        'order': 'F',
+        'filters': None,
+    }
+    (path / '.zarray').write_text(json.dumps(meta))
+    chunk = np.arange(6, dtype='>f4').reshape((2, 3))
+    (path / '0.0').write_bytes(chunk.tobytes(order='F'))
+
+    # Opened from its metadata
+    data, scale = zarr_io.read_array(str(path / '.zarray'))
+    assert scale is None
+    np.testing.assert_array_equal(data[:2], chunk)
+    np.testing.assert_array_equal(data[2:], -1.0)
+
+
+def test_unsupported(tmp_path):
+    path = tmp_path / 'array.zarr'
+    path.mkdir()
+    (path / 'zarr.json').write_text(json.dumps({
+        'zarr_format': 3,
+        'node_type': 'array',
+        'shape': [4],
+        'data_type': 'uint8',
+        'chunk_grid': {'name': 'regular',
+                       'configuration': {'chunk_shape': [4]}},
+        'codecs': [{'name': 'sharding_indexed', 'configuration': {}}],
+    }))
+    with pytest.raises(zarr_io.ZarrError):
+        zarr_io.read_array(str(path))
+
+    with pytest.raises(zarr_io.ZarrError):
+        zarr_io.write_array(str(tmp_path), np.zeros(4))
+
+
+@pytest.mark.parametrize('average', [False, True])
+def test_reader_subsample(tmp_path, volume, average):
+    # The reader creates VTK image data
+    pytest.importorskip('vtk')
+    from tomviz.io.formats.zarr import ZarrReader
+
+    path = str(tmp_path / 'volume.zarr')
+    zarr_io.write_array(path, volume, spacing=[3.0, 2.0, 1.0],
+                        chunks=(8, 8, 8))
+
+    reader = ZarrReader()
+    # (x, y, z) dimensions, then the value size
+    assert reader.volume_info(path) == [11, 20, 37, 2]
+
+    # The settings are in (x, y, z) order, as saved in the state
+    options = {'subsampleSettings': {'strides': [2, 3, 4],
+                                     'volumeBounds': [1, 11, 0, 20, 3, 30],
+                                     'average': average}}
+    image = reader.read(path, options)
+
+    data = volume[3:30, 0:20, 1:11]
+    if average:
+        # Partial blocks at the ends are dropped
+        data = data[:24, :18, :10].reshape((6, 4, 6, 3, 5, 2))
+        expected = np.rint(data.mean(axis=(1, 3, 5))).astype(volume.dtype)
+    else:
+        expected = data[::4, ::3, ::2]
+
+    assert image.GetDimensions() == expected.shape[::-1]
+    assert image.GetSpacing() == (2.0, 6.0, 12.0)
+    scalars = image.GetPointData().GetScalars()
+    values = np.array([scalars.GetValue(i)
+                       for i in range(scalars.GetNumberOfTuples())])
+    np.testing.assert_array_equal(values, expected.ravel())
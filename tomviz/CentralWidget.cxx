@@ -32,6 +32,7 @@
 #include "HistogramWidget.h"
 #include "DataSource.h"
 #include "HistogramManager.h"
+#include "LazyVolume.h"
 #include "Module.h"
 #include "ModuleManager.h"
 #include "ModuleSlice.h"
@@ -272,8 +273,15 @@ void CentralWidget::setColorMapDataSource(DataSource* source)
   }
   m_ui->histogram2DWidget->updateTransfer2D();
 
+  // The volume of a lazily loaded data source is only read for its own
+  // scalars, the histogram of the others comes from the proxy.
+  std::shared_ptr<LazyVolume> lazy;
+  if (source->activeScalars() == source->scalarsName(0)) {
+    lazy = source->lazyVolume();
+  }
+
   vtkSmartPointer<vtkImageData> const imageSP = image;
-  auto histogram = HistogramManager::instance().getHistogram(imageSP);
+  auto histogram = HistogramManager::instance().getHistogram(imageSP, lazy);
   auto histogram2D = HistogramManager::instance().getHistogram2D(imageSP);
 
   if (histogram) {
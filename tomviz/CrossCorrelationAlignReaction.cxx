@@ -0,0 +1,39 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "CrossCorrelationAlignReaction.h"
+
+#include "ActiveObjects.h"
+#include "CrossCorrelationAlignOperator.h"
+#include "DataSource.h"
+#include "EditOperatorDialog.h"
+#include "Utilities.h"
+
+#include <QDebug>
+
+namespace tomviz {
+
+CrossCorrelationAlignReaction::CrossCorrelationAlignReaction(
+  QAction* parentObject)
+  : Reaction(parentObject)
+{
+}
+
+void CrossCorrelationAlignReaction::align(DataSource* input)
+{
+  input = input ? input : ActiveObjects::instance().activeParentDataSource();
+  if (!input) {
+    qDebug() << "Exiting early - no data found.";
+    return;
+  }
+
+  Operator* op = new CrossCorrelationAlignOperator(input);
+
+  // Choose the band pass cutoff before the operator is added
+  auto* dialog = new EditOperatorDialog(op, input, true, tomviz::mainWidget());
+  dialog->setAttribute(Qt::WA_DeleteOnClose);
+  dialog->setWindowTitle("Cross Correlation Align");
+  dialog->show();
+  connect(op, &QObject::destroyed, dialog, &QDialog::reject);
+}
+} // namespace tomviz
@@ -0,0 +1,29 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizCrossCorrelationAlignReaction_h
+#define tomvizCrossCorrelationAlignReaction_h
+
+#include <Reaction.h>
+
+namespace tomviz {
+class DataSource;
+
+class CrossCorrelationAlignReaction : public Reaction
+{
+  Q_OBJECT
+
+public:
+  CrossCorrelationAlignReaction(QAction* parent);
+
+  void align(DataSource* input = nullptr);
+
+protected:
+  void onTriggered() override { align(); }
+
+private:
+  Q_DISABLE_COPY(CrossCorrelationAlignReaction)
+};
+} // namespace tomviz
+
+#endif
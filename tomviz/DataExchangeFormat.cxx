@@ -140,20 +140,19 @@ namespace {
 
 bool writeData(h5::H5ReadWrite& writer, vtkImageData* image)
 {
+  // No deep copies of data needed. Tilt series just have their axes
+  // re-labeled, anything else is re-ordered to C while it is written.
   vtkNew<vtkImageData> permutedImage;
+  permutedImage->ShallowCopy(image);
+  auto reorder = ReorderMode::FortranToC;
   if (DataSource::hasTiltAngles(image)) {
-    // No deep copies of data needed. Just re-label the axes.
-    permutedImage->ShallowCopy(image);
     relabelXAndZAxes(permutedImage);
-  } else {
-    // Need to re-order to C ordering before writing
-    GenericHDF5Format::reorderData(image, permutedImage,
-                                   ReorderMode::FortranToC);
+    reorder = ReorderMode::None;
   }
 
   // Assume /exchange already exists
   return GenericHDF5Format::writeVolume(writer, "/exchange", "data",
-                                        permutedImage);
+                                        permutedImage, QVariantMap(), reorder);
 }
 
 bool writeExtraData(h5::H5ReadWrite& writer, vtkImageData* image,
@@ -161,17 +160,17 @@ bool writeExtraData(h5::H5ReadWrite& writer, vtkImageData* image,
                     bool isTiltSeries = false)
 {
   vtkNew<vtkImageData> permutedImage;
+  permutedImage->ShallowCopy(image);
+  auto reorder = ReorderMode::FortranToC;
   if (isTiltSeries) {
     // No deep copying needed. Just re-label the axes.
-    permutedImage->ShallowCopy(image);
     relabelXAndZAxes(permutedImage);
-  } else {
-    GenericHDF5Format::reorderData(image, permutedImage,
-                                   ReorderMode::FortranToC);
+    reorder = ReorderMode::None;
   }
 
   // Assume /exchange already exists
-  return GenericHDF5Format::writeVolume(writer, path, name, permutedImage);
+  return GenericHDF5Format::writeVolume(writer, path, name, permutedImage,
+                                        QVariantMap(), reorder);
 }
 
 bool writeDark(h5::H5ReadWrite& writer, vtkImageData* image,
@@ -200,7 +199,8 @@ bool writeTheta(h5::H5ReadWrite& writer, vtkImageData* image)
 
 } // namespace
 
-bool DataExchangeFormat::write(const std::string& fileName, DataSource* source)
+bool DataExchangeFormat::write(const std::string& fileName, DataSource* source,
+                               vtkImageData* image)
 {
   using h5::H5ReadWrite;
   H5ReadWrite::OpenMode mode = H5ReadWrite::OpenMode::WriteOnly;
@@ -209,8 +209,10 @@ bool DataExchangeFormat::write(const std::string& fileName, DataSource* source)
   // Create a "/exchange" group
   writer.createGroup("/exchange");
 
-  auto t = source->producer();
-  auto image = vtkImageData::SafeDownCast(t->GetOutputDataObject(0));
+  if (!image) {
+    auto t = source->producer();
+    image = vtkImageData::SafeDownCast(t->GetOutputDataObject(0));
+  }
   if (!writeData(writer, image))
     return false;
 
@@ -10,16 +10,19 @@
 #include "DataExchangeFormat.h"
 #include "EmdFormat.h"
 #include "GenericHDF5Format.h"
+#include "LazyVolume.h"
 #include "ModuleFactory.h"
 #include "ModuleManager.h"
 #include "Operator.h"
 #include "OperatorFactory.h"
 #include "Pipeline.h"
+#include "TimeSeriesCache.h"
 #include "TimeSeriesStep.h"
 #include "Utilities.h"
 
 #include <iostream>
 
+#include <vtkAOSDataArrayTemplate.h>
 #include <vtkDataObject.h>
 #include <vtkDoubleArray.h>
 #include <vtkFieldData.h>
@@ -51,6 +54,7 @@
 
 #include <QCheckBox>
 #include <QDebug>
+#include <QFileInfo>
 #include <QJsonArray>
 #include <QMap>
 #include <QMessageBox>
@@ -86,6 +90,15 @@ void createOrResizeTiltAnglesArray(vtkDataObject* data)
     }
   }
 }
+
+// The memory that the lazily loaded time series steps may use
+qint64 timeSeriesBudget()
+{
+  auto settings = pqApplicationCore::instance()->settings();
+  qint64 megabytes =
+    settings->value("TimeSeries/ResidencyBudgetMB", 2048).toLongLong();
+  return megabytes * 1024 * 1024;
+}
 } // namespace
 
 namespace tomviz {
@@ -113,6 +126,12 @@ public:
   QMap<QString, QString> CurrentToOriginal;
   QList<TimeSeriesStep> timeSeriesSteps;
   int currentTimeStep = 0;
+  // The images of the lazily loaded time series steps that are in memory
+  TimeSeriesCache timeSeriesCache;
+  std::shared_ptr<LazyVolume> Lazy;
+  // The Tvh5 file the data was last saved in, and its MTime at the time
+  QString SavedFile;
+  vtkMTimeType SavedMTime = 0;
 
   // Checks if the tilt angles data array exists on the given VTK data
   // and creates it if it does not exist.
@@ -194,44 +213,32 @@ DataSource::~DataSource()
   delete m_pythonProxy;
 }
 
-// Simple templated function to extend the image data.
+// Append the values of a slice to the scalars of the image data. The array
+// grows geometrically, so that most appends only copy the new slice rather
+// than the whole volume.
 template <typename T>
-void appendImageData(vtkImageData* data, vtkImageData* slice, T* originalPtr)
-{
-  auto dataArray = data->GetPointData()->GetScalars();
-  int extents[6];
-  data->GetExtent(extents);
-
-  // Figure out the number of bytes in the original data, and allocate a buffer.
-  int bufferSize = dataArray->GetNumberOfTuples() *
-                   dataArray->GetNumberOfComponents() * sizeof(T);
-  unsigned char* buffer = new unsigned char[bufferSize];
-  // Copy the original image data, as the allocate scalars will erase it.
-  std::memcpy(buffer, originalPtr, bufferSize);
-  // Now increment the z extent, and reallocate the scalar array (destructive).
-  ++extents[5];
-  data->SetExtent(extents);
-  data->AllocateScalars(data->GetScalarType(),
-                        data->GetNumberOfScalarComponents());
-  // Copy the old data back into the new memory location, delete the buffer.
-  auto ptr = data->GetScalarPointer();
-  std::memcpy(ptr, buffer, bufferSize);
-  delete[] buffer;
-  buffer = 0;
-
-  // Now copy the new slice into the array.
-  void* imagePtr = data->GetScalarPointer(0, 0, extents[5]);
-  auto sliceArray = slice->GetPointData()->GetScalars();
-  void* slicePtr = sliceArray->GetVoidPointer(0);
-  int sliceSize = sliceArray->GetNumberOfTuples() *
-                  sliceArray->GetNumberOfComponents() * sizeof(T);
-  std::memcpy(imagePtr, slicePtr, sliceSize);
-
-  // Let everyone know the data has changed, then re-execute the pipeline.
-  data->Modified();
-}
-
-bool DataSource::appendSlice(vtkImageData* slice)
+bool appendImageData(vtkDataArray* scalars, vtkDataArray* sliceScalars)
+{
+  vtkIdType start = scalars->GetNumberOfTuples();
+  vtkIdType count = sliceScalars->GetNumberOfTuples();
+  auto array = vtkArrayDownCast<vtkAOSDataArrayTemplate<T>>(scalars);
+  auto sliceArray = vtkArrayDownCast<vtkAOSDataArrayTemplate<T>>(sliceScalars);
+  if (!array || !sliceArray) {
+    scalars->InsertTuples(start, count, 0, sliceScalars);
+    return scalars->GetNumberOfTuples() == start + count;
+  }
+
+  // Resizes to more than double the capacity when the slice doesn't fit
+  if (!array->EnsureAccessToTuple(start + count - 1)) {
+    return false;
+  }
+  vtkIdType components = array->GetNumberOfComponents();
+  std::memcpy(array->GetPointer(start * components), sliceArray->GetPointer(0),
+              static_cast<size_t>(count * components) * sizeof(T));
+  return true;
+}
+
+bool DataSource::appendSlice(vtkImageData* slice, bool executePipeline)
 {
   if (!slice) {
     return false;
@@ -245,27 +252,53 @@ bool DataSource::appendSlice(vtkImageData* slice)
     if (data) {
       int extents[6];
       data->GetExtent(extents);
-      std::cout << "The data is ";
-      for (int i = 0; i < 6; ++i)
-        std::cout << extents[i] << ", ";
-      std::cout << std::endl;
       for (int i = 0; i < 4; ++i) {
         if (extents[i] != sliceExtents[i]) {
-          std::cout << "Mismatch: " << extents[i] << " != " << sliceExtents[i]
-               << std::endl;
+          qWarning() << "Cannot append a slice of extent"
+                     << QVector<int>(sliceExtents, sliceExtents + 6)
+                     << "to data of extent"
+                     << QVector<int>(extents, extents + 6);
           return false;
         }
       }
 
+      auto scalars = data->GetPointData()->GetScalars();
+      auto sliceScalars = slice->GetPointData()->GetScalars();
+      if (!scalars || !sliceScalars ||
+          scalars->GetDataType() != sliceScalars->GetDataType() ||
+          scalars->GetNumberOfComponents() !=
+            sliceScalars->GetNumberOfComponents()) {
+        qWarning() << "Cannot append a slice whose scalars differ from those "
+                      "of the data";
+        return false;
+      }
+
+      // Growing the scalars may reallocate them, make sure nothing is
+      // reading them in the background.
+      emit scalarsAboutToChange();
+
       // Now to append the slice onto our image data.
-      switch (data->GetScalarType()) {
-        vtkTemplateMacro(appendImageData(
-          data, slice, static_cast<VTK_TT*>(data->GetScalarPointer())));
+      bool appended = false;
+      switch (scalars->GetDataType()) {
+        vtkTemplateMacro(appended =
+                           appendImageData<VTK_TT>(scalars, sliceScalars));
+      }
+      if (!appended) {
+        qCritical() << "Failed to append the slice to" << label();
+        return false;
       }
+      extents[5] += sliceExtents[5] - sliceExtents[4] + 1;
+      data->SetExtent(extents);
+
+      // Let everyone know the data has changed, then re-execute the pipeline.
+      scalars->Modified();
+      data->Modified();
 
       emit dataChanged();
       emit dataPropertiesChanged();
-      pipeline()->execute()->deleteWhenFinished();
+      if (executePipeline && pipeline()) {
+        pipeline()->executeAppended(this, slice)->deleteWhenFinished();
+      }
     }
   }
   return true;
@@ -318,6 +351,20 @@ QString DataSource::tvh5NodePath() const
   return m_json.value("reader").toObject().value("tvh5NodePath").toString();
 }
 
+void DataSource::setSavedTo(const QString& fileName, vtkMTimeType mtime)
+{
+  Internals->SavedFile = QFileInfo(fileName).absoluteFilePath();
+  Internals->SavedMTime = mtime;
+}
+
+bool DataSource::isSavedTo(const QString& fileName) const
+{
+  auto* image = imageData();
+  return image && !Internals->SavedFile.isEmpty() &&
+         Internals->SavedFile == QFileInfo(fileName).absoluteFilePath() &&
+         image->GetMTime() == Internals->SavedMTime;
+}
+
 QStringList DataSource::fileNames() const
 {
   auto reader = m_json.value("reader").toObject(QJsonObject());
@@ -369,6 +416,12 @@ bool DataSource::canReloadAndResample() const
 
   const auto& file = files[0];
 
+  // Nodes of a Tvh5 file are EMD nodes
+  if (file.endsWith("tvh5", Qt::CaseInsensitive) &&
+      !tvh5NodePath().isEmpty()) {
+    return true;
+  }
+
   static const QStringList h5Extensions = { "emd", "h5", "he5", "hdf5" };
 
   // If it looks like an HDF5 type (based on its extension), it can be
@@ -378,7 +431,35 @@ bool DataSource::canReloadAndResample() const
     [&file](const QString& x) { return file.endsWith(x, Qt::CaseInsensitive); });
 }
 
-bool DataSource::reloadAndResample()
+namespace {
+
+// Read an HDF5 based file, or a node of a Tvh5 file, into image
+bool readHDF5File(const QString& file, const QString& tvh5NodePath,
+                  vtkImageData* image, const QVariantMap& options)
+{
+  bool success = false;
+  runWithHDF5Lock([&]() {
+    if (file.endsWith("tvh5", Qt::CaseInsensitive)) {
+      success = EmdFormat::readNode(file.toStdString(),
+                                    tvh5NodePath.toStdString(), image,
+                                    options);
+    } else if (file.endsWith("emd", Qt::CaseInsensitive)) {
+      EmdFormat format;
+      success = format.read(file.toLatin1().data(), image, options);
+    } else if (GenericHDF5Format::isDataExchange(file.toStdString())) {
+      DataExchangeFormat format;
+      success = format.read(file.toLatin1().data(), image, options);
+    } else {
+      success =
+        GenericHDF5Format::read(file.toLatin1().data(), image, options);
+    }
+  });
+  return success;
+}
+
+} // namespace
+
+bool DataSource::reload(const QVariantMap& options)
 {
   const auto& files = fileNames();
 
@@ -393,26 +474,158 @@ bool DataSource::reloadAndResample()
   auto data = algo->GetOutputDataObject(0);
   auto image = vtkImageData::SafeDownCast(data);
 
-  bool success;
-  QVariantMap options{ { "askForSubsample", true } };
-  if (file.endsWith("emd", Qt::CaseInsensitive)) {
-    EmdFormat format;
-    success = format.read(file.toLatin1().data(), image, options);
-  } else if (GenericHDF5Format::isDataExchange(file.toStdString())) {
-    DataExchangeFormat format;
-    success = format.read(file.toLatin1().data(), image, options);
-  } else {
-    success = GenericHDF5Format::read(file.toLatin1().data(), image, options);
-  }
+  bool success = readHDF5File(file, tvh5NodePath(), image, options);
+
+  // The lazy volume is opened again if it is still needed
+  this->Internals->Lazy.reset();
+
+  dataModified();
+  emit activeScalarsChanged();
+  emit dataPropertiesChanged();
+  return success;
+}
+
+bool DataSource::reloadAndResample()
+{
+  bool success = reload({ { "askForSubsample", true } });
 
   // If there are operators, re-run the pipeline
   if (!operators().empty())
     pipeline()->execute(this, operators().first())->deleteWhenFinished();
 
+  return success;
+}
+
+bool DataSource::resample(const int strides[3])
+{
+  auto reader = resampleReader(strides);
+  if (!reader) {
+    return false;
+  }
+
+  vtkNew<vtkImageData> image;
+  if (!reader(image)) {
+    return false;
+  }
+  setResampledData(image, strides);
+  return true;
+}
+
+std::function<bool(vtkImageData*)> DataSource::resampleReader(
+  const int strides[3]) const
+{
+  if (!canReloadAndResample()) {
+    return nullptr;
+  }
+
+  int bs[6];
+  subsampleVolumeBounds(bs);
+  QVariantMap options;
+  options["askForSubsample"] = false;
+  options["subsampleStrides"] =
+    QVariantList({ strides[0], strides[1], strides[2] });
+  if (wasSubsampled() && bs[0] >= 0) {
+    options["subsampleVolumeBounds"] = QVariantList(bs, bs + 6);
+  }
+  if (isLazy()) {
+    options["lazy"] = true;
+  }
+  if (subsampleAverage()) {
+    options["subsampleAverage"] = true;
+  }
+
+  // Start from the metadata of the current data, as a reload would
+  auto current = vtkSmartPointer<vtkImageData>::New();
+  current->CopyStructure(imageData());
+  current->GetFieldData()->DeepCopy(imageData()->GetFieldData());
+
+  auto file = fileNames()[0];
+  auto nodePath = tvh5NodePath();
+  return [file, nodePath, options, current](vtkImageData* image) {
+    image->CopyStructure(current);
+    image->GetFieldData()->DeepCopy(current->GetFieldData());
+    return readHDF5File(file, nodePath, image, options);
+  };
+}
+
+void DataSource::setResampledData(vtkImageData* image, const int strides[3])
+{
+  int oldStrides[3];
+  subsampleStrides(oldStrides);
+  double spacing[3];
+  getSpacing(spacing);
+
+  imageData()->ShallowCopy(image);
+
+  // The lazy volume is opened again if it is still needed
+  this->Internals->Lazy.reset();
+
   dataModified();
   emit activeScalarsChanged();
   emit dataPropertiesChanged();
-  return success;
+
+  // Keep the physical size, the file may not know the (modified) spacing
+  for (int i = 0; i < 3; ++i) {
+    spacing[i] *= static_cast<double>(strides[i]) / oldStrides[i];
+  }
+  setSpacing(spacing, false);
+}
+
+bool DataSource::isLazy() const
+{
+  return canReloadAndResample() && !lazyDataSetPath(dataObject()).isEmpty();
+}
+
+std::shared_ptr<LazyVolume> DataSource::lazyVolume() const
+{
+  if (!isLazy()) {
+    return nullptr;
+  }
+
+  auto path = lazyDataSetPath(dataObject()).toStdString();
+  auto& lazy = this->Internals->Lazy;
+  if (!lazy || lazy->dataSetPath() != path) {
+    int bs[6];
+    subsampleVolumeBounds(bs);
+    // Tilt series are stored with their X and Z axes swapped
+    runWithHDF5Lock([&]() {
+      lazy = std::make_shared<LazyVolume>(fileNames()[0].toStdString(), path,
+                                          bs, type() == TiltSeries);
+    });
+    if (!lazy->isValid()) {
+      lazy.reset();
+    }
+  }
+  return lazy;
+}
+
+std::function<bool(vtkImageData*)> DataSource::fullResolutionReader() const
+{
+  if (!isLazy()) {
+    return nullptr;
+  }
+
+  // Read the same volume bounds, without strides
+  int bs[6];
+  subsampleVolumeBounds(bs);
+  QVariantMap options;
+  options["askForSubsample"] = false;
+  options["subsampleVolumeBounds"] = QVariantList(bs, bs + 6);
+  options["subsampleStrides"] = QVariantList({ 1, 1, 1 });
+
+  // Start from the metadata of the subsample, which the file may not have,
+  // such as a modified spacing, as a reload would.
+  auto subsample = vtkSmartPointer<vtkImageData>::New();
+  subsample->CopyStructure(imageData());
+  subsample->GetFieldData()->DeepCopy(imageData()->GetFieldData());
+
+  auto file = fileNames()[0];
+  auto nodePath = tvh5NodePath();
+  return [file, nodePath, options, subsample](vtkImageData* image) {
+    image->CopyStructure(subsample);
+    image->GetFieldData()->DeepCopy(subsample->GetFieldData());
+    return readHDF5File(file, nodePath, image, options);
+  };
 }
 
 bool DataSource::isImageStack() const
@@ -483,6 +696,12 @@ QJsonObject DataSource::serialize() const
     int bs[6];
     subsampleVolumeBounds(bs);
     settings["volumeBounds"] = toJsonArray(bs, 6);
+    if (isLazy()) {
+      settings["lazy"] = true;
+    }
+    if (subsampleAverage()) {
+      settings["average"] = true;
+    }
     json["subsampleSettings"] = settings;
   }
 
@@ -1333,13 +1552,46 @@ void DataSource::switchTimeSeriesStep(int i)
     return;
   }
 
+  auto& step = this->Internals->timeSeriesSteps[i];
+  vtkSmartPointer<vtkImageData> image = step.image;
+  if (!image) {
+    auto& cache = this->Internals->timeSeriesCache;
+    cache.setBudget(timeSeriesBudget());
+    image = cache.image(step);
+  }
+  if (!image) {
+    qCritical() << "Failed to read time series step" << step.fileName;
+    return;
+  }
+
   m_changingTimeStep = true;
   this->Internals->currentTimeStep = i;
-  producer()->SetOutput(this->Internals->timeSeriesSteps[i].image);
+  producer()->SetOutput(image);
   dataModified();
   m_changingTimeStep = false;
 
   emit timeStepChanged();
+
+  prefetchTimeSeriesSteps();
+}
+
+void DataSource::prefetchTimeSeriesSteps()
+{
+  // Read the steps that follow the current one, while it is shown, so that
+  // switching to them does not wait for a read. Animations loop around.
+  auto& steps = this->Internals->timeSeriesSteps;
+  auto current = this->Internals->currentTimeStep;
+  QList<TimeSeriesStep> next;
+  for (int i = 1; i < steps.size(); ++i) {
+    next.append(steps[(current + i) % steps.size()]);
+  }
+
+  auto* image = imageData();
+  if (next.isEmpty() || !image) {
+    return;
+  }
+  qint64 stepBytes = static_cast<qint64>(image->GetActualMemorySize()) * 1024;
+  this->Internals->timeSeriesCache.prefetch(next, stepBytes);
 }
 
 int DataSource::numTimeSeriesSteps() const
@@ -1402,6 +1654,7 @@ QList<TimeSeriesStep> DataSource::timeSeriesSteps() const
 void DataSource::clearTimeSeriesSteps()
 {
   this->Internals->timeSeriesSteps.clear();
+  this->Internals->timeSeriesCache.clear();
   this->Internals->currentTimeStep = 0;
   emit timeStepsModified();
   emit timeStepChanged();
@@ -1951,4 +2204,62 @@ void DataSource::setSubsampleVolumeBounds(vtkDataObject* image, int bs[6])
   setFieldDataArray<ArrayType>(fd, arrayName, 6, bs);
 }
 
+bool DataSource::subsampleAverage(vtkDataObject* image)
+{
+  bool ret = false;
+
+  if (!image)
+    return ret;
+
+  const char* arrayName = "subsample_average";
+  using ArrayType = vtkTypeInt8Array;
+
+  vtkFieldData* fd = image->GetFieldData();
+  getFieldDataArray<ArrayType>(fd, arrayName, 1, &ret);
+  return ret;
+}
+
+void DataSource::setSubsampleAverage(vtkDataObject* image, bool b)
+{
+  if (!image)
+    return;
+
+  const char* arrayName = "subsample_average";
+  using ArrayType = vtkTypeInt8Array;
+
+  vtkFieldData* fd = image->GetFieldData();
+  setFieldDataArray<ArrayType>(fd, arrayName, 1, &b);
+}
+
+QString DataSource::lazyDataSetPath(vtkDataObject* image)
+{
+  if (!image)
+    return QString();
+
+  auto array = vtkStringArray::SafeDownCast(
+    image->GetFieldData()->GetAbstractArray("lazy_data_set_path"));
+  if (!array || array->GetNumberOfValues() < 1)
+    return QString();
+
+  return QString::fromStdString(array->GetValue(0));
+}
+
+void DataSource::setLazyDataSetPath(vtkDataObject* image, const QString& path)
+{
+  if (!image)
+    return;
+
+  const char* arrayName = "lazy_data_set_path";
+  vtkFieldData* fd = image->GetFieldData();
+  if (path.isEmpty()) {
+    fd->RemoveArray(arrayName);
+    return;
+  }
+
+  vtkNew<vtkStringArray> array;
+  array->SetName(arrayName);
+  array->InsertNextValue(path.toStdString());
+  fd->AddArray(array);
+}
+
 } // namespace tomviz
@@ -13,6 +13,10 @@
 
 #include <vtkRect.h>
 #include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#include <functional>
+#include <memory>
 
 #include "core/Variant.h"
 
@@ -27,6 +31,7 @@ class vtkTrivialProducer;
 
 namespace tomviz {
 class DataSourceBase;
+class LazyVolume;
 class Operator;
 class Pipeline;
 struct TimeSeriesStep;
@@ -74,8 +79,9 @@ public:
   ~DataSource() override;
 
   /// Append a slice to the data source, this must be of the same x and y
-  /// dimension as the existing slices in order to be appended.
-  bool appendSlice(vtkImageData* slice);
+  /// dimension as the existing slices in order to be appended. The pipeline
+  /// is then executed for the new slice, see Pipeline::executeAppended().
+  bool appendSlice(vtkImageData* slice, bool executePipeline = true);
 
   /// Returns the proxy that can be inserted in ParaView pipelines.
   /// This proxy instance doesn't change over the lifetime of a DataSource even
@@ -144,6 +150,14 @@ public:
   /// For a Tvh5 file, get the path to the node to read for this data source
   QString tvh5NodePath() const;
 
+  /// Record that the data is saved in a Tvh5 file, as it was when the image
+  /// data had the modification time mtime.
+  void setSavedTo(const QString& fileName, vtkMTimeType mtime);
+
+  /// True if the data is saved in the Tvh5 file and was not modified since,
+  /// so saving to that file again can skip it.
+  bool isSavedTo(const QString& fileName) const;
+
   /// Return true is data source is an image stack, false otherwise.
   bool isImageStack() const;
 
@@ -193,12 +207,49 @@ public:
   /// Set the volume bounds used to generate the subsample
   void setSubsampleVolumeBounds(int bs[6]);
 
+  /// Were the voxels of each stride block averaged (binned) to generate
+  /// the subsample, rather than point sampled?
+  bool subsampleAverage() const;
+
+  /// Set whether the subsample averaged the voxels of each stride block
+  void setSubsampleAverage(bool b);
+
   /// Can we reload and resample the original dataset?
   bool canReloadAndResample() const;
 
   // Reload and resample the original dataset
   bool reloadAndResample();
 
+  /// Read the original dataset again with other strides, keeping the volume
+  /// bounds, without asking. Strides matching a level of a multiscale
+  /// pyramid read that level. The spacing is scaled to keep the physical
+  /// size, and operators are not re-run.
+  bool resample(const int strides[3]);
+
+  /// A function reading the original dataset with other strides into an
+  /// image, as resample() does, but from any thread. Empty if the dataset
+  /// can't be resampled.
+  std::function<bool(vtkImageData*)> resampleReader(
+    const int strides[3]) const;
+
+  /// Swap in an image read by resampleReader() with the same strides,
+  /// sharing its arrays. The spacing is scaled to keep the physical size.
+  void setResampledData(vtkImageData* image, const int strides[3]);
+
+  /// Was the data loaded lazily? The image data is then a subsampled proxy
+  /// of the volume in the file, and full resolution regions are read on
+  /// demand with lazyVolume().
+  bool isLazy() const;
+
+  /// The volume the proxy was subsampled from, or nullptr if the data was
+  /// not loaded lazily.
+  std::shared_ptr<LazyVolume> lazyVolume() const;
+
+  /// A function reading the whole volume at full resolution into an image,
+  /// from any thread, e.g. for operators, since none of them stream. The
+  /// proxy is left as it is. Empty if the data was not loaded lazily.
+  std::function<bool(vtkImageData*)> fullResolutionReader() const;
+
   /// Set the label for the data source.
   void setLabel(const QString& label);
 
@@ -219,7 +270,10 @@ public:
   /// The index of the time series we are currently using
   int currentTimeSeriesIndex() const;
 
-  /// Switch to a different time series step
+  /// Switch to a different time series step. Lazily loaded steps are read
+  /// unless they are in memory, then the steps that follow are prefetched.
+  /// The memory they use is bounded by the "TimeSeries/ResidencyBudgetMB"
+  /// setting.
   void switchTimeSeriesStep(int i);
 
   /// Set the time series steps
@@ -407,6 +461,19 @@ public:
   /// Set the volume bounds used to generate the subsample
   static void setSubsampleVolumeBounds(vtkDataObject* image, int bs[6]);
 
+  /// Check whether the subsample averaged the voxels of each stride block
+  static bool subsampleAverage(vtkDataObject* image);
+
+  /// Set whether the subsample averaged the voxels of each stride block
+  static void setSubsampleAverage(vtkDataObject* image, bool b);
+
+  /// Get the path of the HDF5 data set that was loaded lazily, empty if it
+  /// was not
+  static QString lazyDataSetPath(vtkDataObject* image);
+
+  /// Set the path of the HDF5 data set that was loaded lazily
+  static void setLazyDataSetPath(vtkDataObject* image, const QString& path);
+
   /// Get a simple proxy for the data source to simplify Python wrapping.
   DataSourceBase* pythonProxy() const { return m_pythonProxy; }
 
@@ -422,6 +489,11 @@ signals:
   /// Fired when active scalars change
   void activeScalarsChanged();
 
+  /// Fired before the scalars are modified in place, such as when a slice
+  /// is appended. Anything reading them on another thread must be done with
+  /// them when this returns.
+  void scalarsAboutToChange();
+
   /// This signal is fired every time a new operator is added to this
   /// DataSource.
   void operatorAdded(Operator*);
@@ -467,6 +539,12 @@ private:
 
   vtkAlgorithm* algorithm() const;
 
+  /// Read the file again into the current image data.
+  bool reload(const QVariantMap& options);
+
+  /// Start reading the time series steps after the current one.
+  void prefetchTimeSeriesSteps();
+
   Q_DISABLE_COPY(DataSource)
 
   class DSInternals;
@@ -517,6 +595,16 @@ inline void DataSource::setSubsampleVolumeBounds(int bs[6])
   setSubsampleVolumeBounds(dataObject(), bs);
 }
 
+inline bool DataSource::subsampleAverage() const
+{
+  return subsampleAverage(dataObject());
+}
+
+inline void DataSource::setSubsampleAverage(bool b)
+{
+  setSubsampleAverage(dataObject(), b);
+}
+
 inline bool DataSource::volumeModuleAutoAdded() const
 {
   return m_volumeModuleAutoAdded;
@@ -0,0 +1,490 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "DmFormat.h"
+
+#include "MappedFile.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+
+namespace {
+
+// Encoded types of the tag values
+enum EncodedType : uint64_t
+{
+  Struct = 15,
+  String = 18,
+  Array = 20
+};
+
+// The size of the simple encoded types, 0 for the others
+size_t encodedTypeSize(uint64_t type)
+{
+  switch (type) {
+    case 2: // int16
+    case 4: // uint16
+      return 2;
+    case 3: // int32
+    case 5: // uint32
+    case 6: // float
+      return 4;
+    case 7:  // double
+    case 11: // int64
+    case 12: // uint64
+      return 8;
+    case 8:  // bool
+    case 9:  // char
+    case 10: // octet
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+// A tag value, whose data is at offset in the file
+struct Tag
+{
+  // Of the value, or of the elements of arrays
+  uint64_t type = 0;
+  uint64_t count = 1;
+  qint64 offset = 0;
+  uint64_t size = 0;
+};
+
+// Parse the tags of a DM3 or DM4 file into a map. The tags are named after
+// their path, the labels of the groups and of the tag joined by dots.
+// Unlabeled ones are named after their (0 based) index in their group. The
+// structure of the tags is big endian, the values little endian.
+class TagParser
+{
+public:
+  TagParser(const uchar* data, qint64 size) : m_data(data), m_size(size) {}
+
+  bool parse()
+  {
+    uint32_t version = 0;
+    if (!read(version)) {
+      return false;
+    }
+    if (version != 3 && version != 4) {
+      cerr << "Not a DM3 or DM4 file" << endl;
+      return false;
+    }
+    m_wide = version == 4;
+
+    // The size of the root group, then the byte order of the values
+    uint64_t rootSize = 0;
+    uint32_t littleEndian = 0;
+    if (!readSize(rootSize) || !read(littleEndian)) {
+      return false;
+    }
+    if (littleEndian != 1) {
+      cerr << "Only little endian DM files are supported" << endl;
+      return false;
+    }
+
+    return parseGroup(std::string(), 0);
+  }
+
+  const std::map<std::string, Tag>& tags() const { return m_tags; }
+
+private:
+  template <typename T>
+  bool read(T& value)
+  {
+    if (m_pos + static_cast<qint64>(sizeof(T)) > m_size) {
+      cerr << "Unexpected end of the DM file" << endl;
+      return false;
+    }
+    value = qFromBigEndian<T>(m_data + m_pos);
+    m_pos += sizeof(T);
+    return true;
+  }
+
+  // Sizes, counts and encoded types are 32 bits in DM3, 64 bits in DM4
+  bool readSize(uint64_t& value)
+  {
+    if (m_wide) {
+      return read(value);
+    }
+    uint32_t value32 = 0;
+    if (!read(value32)) {
+      return false;
+    }
+    value = value32;
+    return true;
+  }
+
+  bool skip(uint64_t bytes)
+  {
+    if (bytes > static_cast<uint64_t>(m_size - m_pos)) {
+      cerr << "Unexpected end of the DM file" << endl;
+      return false;
+    }
+    m_pos += static_cast<qint64>(bytes);
+    return true;
+  }
+
+  bool parseGroup(const std::string& path, int depth)
+  {
+    // Deeper groups are most likely a corrupt file
+    if (depth > 64) {
+      cerr << "The tags of the DM file are nested too deep" << endl;
+      return false;
+    }
+
+    uint8_t sorted = 0, open = 0;
+    uint64_t count = 0;
+    if (!read(sorted) || !read(open) || !readSize(count)) {
+      return false;
+    }
+
+    for (uint64_t i = 0; i < count; ++i) {
+      if (!parseEntry(path, i, depth)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool parseEntry(const std::string& path, uint64_t index, int depth)
+  {
+    uint8_t kind = 0;
+    uint16_t labelLength = 0;
+    if (!read(kind) || !read(labelLength)) {
+      return false;
+    }
+
+    auto* labelData = reinterpret_cast<const char*>(m_data + m_pos);
+    if (!skip(labelLength)) {
+      return false;
+    }
+    std::string label(labelData, labelLength);
+    if (label.empty()) {
+      label = std::to_string(index);
+    }
+    auto name = path.empty() ? label : path + "." + label;
+
+    // DM4 has the size of the rest of the entry here
+    uint64_t entrySize = 0;
+    if (m_wide && !read(entrySize)) {
+      return false;
+    }
+    qint64 entryEnd = -1;
+    if (m_wide && entrySize <= static_cast<uint64_t>(m_size)) {
+      entryEnd = m_pos + static_cast<qint64>(entrySize);
+    }
+
+    if (kind == 20) {
+      return parseGroup(name, depth + 1);
+    } else if (kind == 21) {
+      return parseValue(name, entryEnd);
+    }
+    cerr << "Unknown kind of DM tag: " << static_cast<int>(kind) << endl;
+    return false;
+  }
+
+  // The size of the value of type info[pos], described by the entries that
+  // follow it, which are consumed. False if the type is not supported.
+  bool valueSize(const std::vector<uint64_t>& info, size_t& pos,
+                 uint64_t& size)
+  {
+    if (pos >= info.size()) {
+      return false;
+    }
+    auto type = info[pos++];
+    if (encodedTypeSize(type) > 0) {
+      size = encodedTypeSize(type);
+      return true;
+    } else if (type == String && pos < info.size()) {
+      // The length of the string
+      size = info[pos++];
+      return true;
+    } else if (type == Struct && pos + 1 < info.size()) {
+      // The length of the struct name and the number of fields, then the
+      // length of the name and the type of each field
+      uint64_t fields = info[pos + 1];
+      pos += 2;
+      size = 0;
+      for (uint64_t i = 0; i < fields; ++i) {
+        ++pos;
+        uint64_t fieldSize = 0;
+        if (!valueSize(info, pos, fieldSize)) {
+          return false;
+        }
+        size += fieldSize;
+      }
+      return true;
+    } else if (type == Array) {
+      // The type of the elements, then their count
+      uint64_t elementSize = 0;
+      if (!valueSize(info, pos, elementSize) || pos >= info.size()) {
+        return false;
+      }
+      size = elementSize * info[pos++];
+      return true;
+    }
+    return false;
+  }
+
+  // entryEnd is the end of the entry in DM4 files, -1 in DM3 files
+  bool parseValue(const std::string& name, qint64 entryEnd)
+  {
+    if (m_pos + 4 > m_size || std::memcmp(m_data + m_pos, "%%%%", 4) != 0) {
+      cerr << "Missing delimiter of DM tag " << name << endl;
+      return false;
+    }
+    m_pos += 4;
+
+    // The encoded type of the value, followed by what describes it
+    uint64_t infoSize = 0;
+    if (!readSize(infoSize) || infoSize == 0 || infoSize > 1024) {
+      cerr << "Invalid DM tag " << name << endl;
+      return false;
+    }
+    std::vector<uint64_t> info(infoSize);
+    for (auto& value : info) {
+      if (!readSize(value)) {
+        return false;
+      }
+    }
+
+    Tag tag;
+    tag.offset = m_pos;
+    size_t pos = 0;
+    if (!valueSize(info, pos, tag.size)) {
+      // Only DM4 files tell where to skip to
+      if (entryEnd < 0 || entryEnd < m_pos || entryEnd > m_size) {
+        cerr << "Unsupported DM tag " << name << endl;
+        return false;
+      }
+      m_pos = entryEnd;
+      return true;
+    }
+
+    // Arrays of simple types, such as the image data, are kept with the
+    // type and number of their elements
+    tag.type = info[0];
+    if (tag.type == Array && info.size() == 3) {
+      tag.type = info[1];
+      tag.count = info[2];
+    }
+    m_tags[name] = tag;
+    return skip(tag.size);
+  }
+
+  const uchar* m_data;
+  qint64 m_size;
+  qint64 m_pos = 0;
+  bool m_wide = false;
+  std::map<std::string, Tag> m_tags;
+};
+
+// A value of one of the simple encoded types
+double number(const uchar* data, const Tag& tag)
+{
+  const uchar* value = data + tag.offset;
+  switch (tag.type) {
+    case 2:
+      return qFromLittleEndian<int16_t>(value);
+    case 3:
+      return qFromLittleEndian<int32_t>(value);
+    case 4:
+      return qFromLittleEndian<uint16_t>(value);
+    case 5:
+      return qFromLittleEndian<uint32_t>(value);
+    case 6:
+      return qFromLittleEndian<float>(value);
+    case 7:
+      return qFromLittleEndian<double>(value);
+    case 8:
+    case 9:
+    case 10:
+      return *value;
+    case 11:
+      return static_cast<double>(qFromLittleEndian<int64_t>(value));
+    case 12:
+      return static_cast<double>(qFromLittleEndian<uint64_t>(value));
+    default:
+      return 0.0;
+  }
+}
+
+// Units are arrays of 16 bit characters
+std::string text(const uchar* data, const Tag& tag)
+{
+  std::string result;
+  if (tag.type != 4) {
+    return result;
+  }
+  for (uint64_t i = 0; i < tag.count; ++i) {
+    auto c = qFromLittleEndian<uint16_t>(data + tag.offset + 2 * i);
+    // Micro sign
+    result += c == 0xb5 ? 'u' : static_cast<char>(c);
+  }
+  return result;
+}
+
+// The factor converting a length in units to nanometers, 0 if unknown
+double nanometers(const std::string& units)
+{
+  if (units == "nm") {
+    return 1.0;
+  } else if (units == "um") {
+    return 1e3;
+  } else if (units == "mm") {
+    return 1e6;
+  } else if (units == "pm") {
+    return 1e-3;
+  } else if (units == "A" || units == "\xc5") {
+    return 0.1;
+  } else if (units == "m") {
+    return 1e9;
+  }
+  return 0.0;
+}
+
+// The VTK type of the image data types, -1 for unsupported ones
+int vtkType(int dataType)
+{
+  switch (dataType) {
+    case 1:
+      return VTK_SHORT;
+    case 2:
+      return VTK_FLOAT;
+    case 6:
+      return VTK_UNSIGNED_CHAR;
+    case 7:
+      return VTK_INT;
+    case 9:
+      return VTK_SIGNED_CHAR;
+    case 10:
+      return VTK_UNSIGNED_SHORT;
+    case 11:
+      return VTK_UNSIGNED_INT;
+    case 12:
+      return VTK_DOUBLE;
+    default:
+      return -1;
+  }
+}
+
+const int ThumbnailDataType = 23;
+
+} // namespace
+
+namespace tomviz {
+
+bool DmFormat::read(const std::string& fileName, vtkImageData* image)
+{
+  MappedFile file(fileName.c_str());
+  if (!file.isValid()) {
+    cerr << "Failed to read " << fileName << endl;
+    return false;
+  }
+
+  TagParser parser(file.data(), file.size());
+  if (!parser.parse()) {
+    cerr << "Failed to parse the tags of " << fileName << endl;
+    return false;
+  }
+  const auto& tags = parser.tags();
+
+  // The first image that is not a thumbnail
+  std::string prefix;
+  int dataType = 0;
+  for (int i = 0;; ++i) {
+    auto imageData = "ImageList." + std::to_string(i) + ".ImageData.";
+    auto typeTag = tags.find(imageData + "DataType");
+    if (typeTag == tags.end()) {
+      break;
+    }
+    dataType = static_cast<int>(number(file.data(), typeTag->second));
+    if (dataType != ThumbnailDataType && tags.count(imageData + "Data")) {
+      prefix = imageData;
+      break;
+    }
+  }
+  if (prefix.empty()) {
+    cerr << "No image found in " << fileName << endl;
+    return false;
+  }
+
+  int type = vtkType(dataType);
+  if (type < 0) {
+    cerr << "Unsupported DM data type: " << dataType << endl;
+    return false;
+  }
+
+  // Up to four dimensions, X first. The fourth one is stacked along Z.
+  int dims[3] = { 1, 1, 1 };
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  for (int i = 0; i < 4; ++i) {
+    auto dimension = tags.find(prefix + "Dimensions." + std::to_string(i));
+    if (dimension == tags.end()) {
+      break;
+    }
+    int size = static_cast<int>(number(file.data(), dimension->second));
+    if (size < 1) {
+      cerr << "Invalid dimensions in " << fileName << endl;
+      return false;
+    }
+    dims[std::min(i, 2)] *= size;
+
+    // The scale of the dimension, in nanometers when the units are known
+    auto calibration =
+      prefix + "Calibrations.Dimension." + std::to_string(i) + ".";
+    auto scale = tags.find(calibration + "Scale");
+    auto units = tags.find(calibration + "Units");
+    if (i < 3 && scale != tags.end()) {
+      double value = number(file.data(), scale->second);
+      double factor =
+        units != tags.end() ? nanometers(text(file.data(), units->second)) : 0;
+      if (value > 0.0) {
+        spacing[i] = factor > 0.0 ? value * factor : value;
+      }
+    }
+  }
+
+  const auto& data = tags.at(prefix + "Data");
+  vtkIdType values = static_cast<vtkIdType>(dims[0]) * dims[1] * dims[2];
+  auto scalars = vtkSmartPointer<vtkDataArray>::Take(
+    vtkDataArray::CreateDataArray(type));
+  if (data.size != static_cast<uint64_t>(values) * scalars->GetDataTypeSize()) {
+    cerr << "The size of the data does not match its dimensions in "
+         << fileName << endl;
+    return false;
+  }
+
+  // The data is in the order of the VTK point ids already, map it
+  scalars = mapArray(fileName.c_str(), data.offset, type, values);
+  if (!scalars) {
+    scalars = readArray(fileName.c_str(), data.offset, type, values);
+  }
+  if (!scalars) {
+    return false;
+  }
+  scalars->SetName("ImageScalars");
+
+  image->SetDimensions(dims);
+  image->SetSpacing(spacing);
+  image->GetPointData()->SetScalars(scalars);
+  return true;
+}
+
+} // namespace tomviz
@@ -0,0 +1,29 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizDmFormat_h
+#define tomvizDmFormat_h
+
+#include <string>
+
+class vtkImageData;
+
+namespace tomviz {
+
+/**
+ * Gatan DigitalMicrograph DM3 and DM4 files. The tags are parsed from the
+ * memory mapped file, and the image data is mapped into the scalars rather
+ * than read, see mapArray().
+ *
+ * The first image that is not a thumbnail is read, in the same order as
+ * tomviz.io.dm: X varies fastest and rows are not flipped. 4D data sets
+ * (4D-STEM) are read as a stack of their diffraction patterns.
+ */
+class DmFormat
+{
+public:
+  static bool read(const std::string& fileName, vtkImageData* image);
+};
+} // namespace tomviz
+
+#endif // tomvizDmFormat_h
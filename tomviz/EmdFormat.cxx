@@ -11,7 +11,9 @@
 
 #include <vtkDataArray.h>
 #include <vtkImageData.h>
+#include <vtkNew.h>
 #include <vtkPointData.h>
+#include <vtkSmartPointer.h>
 
 #include <string>
 #include <vector>
@@ -24,12 +26,20 @@ using std::endl;
 
 namespace tomviz {
 
+// Volumes from this size get a multiscale pyramid by default
+static const size_t MultiscaleSize = 256 << 20;
+static const int DefaultMultiscaleLevels = 3;
+
 // Forward declarations
 static bool writeExtraScalars(h5::H5ReadWrite& writer,
                               const std::string& groupPath,
-                              vtkImageData* image);
+                              vtkImageData* image, const QVariantMap& options,
+                              ReorderMode reorder);
+static void writeMultiscale(h5::H5ReadWrite& writer, const std::string& path,
+                            vtkImageData* image, const QVariantMap& options);
 static void readExtraScalars(h5::H5ReadWrite& reader,
-                             const std::string& emdNode, vtkImageData* image);
+                             const std::string& emdNode, vtkImageData* image,
+                             ReorderMode reorder);
 
 std::string firstEmdNode(h5::H5ReadWrite& reader)
 {
@@ -55,7 +65,8 @@ std::string firstEmdNode(h5::H5ReadWrite& reader)
 }
 
 bool EmdFormat::read(const std::string& fileName, vtkImageData* image,
-                     const QVariantMap& options)
+                     const QVariantMap& options,
+                     const GenericHDF5Format::ReadProgress& progress)
 {
   using h5::H5ReadWrite;
   H5ReadWrite::OpenMode mode = H5ReadWrite::OpenMode::ReadOnly;
@@ -79,7 +90,24 @@ bool EmdFormat::read(const std::string& fileName, vtkImageData* image,
     return false;
   }
 
-  return readNode(reader, emdNode, image, options);
+  return readNode(reader, emdNode, image, options, progress);
+}
+
+bool EmdFormat::askForSubsample(const std::string& fileName,
+                                QVariantMap& options)
+{
+  using h5::H5ReadWrite;
+  H5ReadWrite::OpenMode mode = H5ReadWrite::OpenMode::ReadOnly;
+  H5ReadWrite reader(fileName.c_str(), mode);
+
+  std::string emdNode = firstEmdNode(reader);
+  if (emdNode.length() == 0) {
+    // read() will report it
+    return true;
+  }
+
+  return GenericHDF5Format::askForSubsample(reader, emdNode + "/data",
+                                            options);
 }
 
 bool EmdFormat::readNode(const std::string& fileName,
@@ -94,7 +122,8 @@ bool EmdFormat::readNode(const std::string& fileName,
 }
 
 bool EmdFormat::readNode(h5::H5ReadWrite& reader, const std::string& emdNode,
-                         vtkImageData* image, const QVariantMap& options)
+                         vtkImageData* image, const QVariantMap& options,
+                         const GenericHDF5Format::ReadProgress& progress)
 {
   bool ok;
   std::string emdDataNode = emdNode + "/data";
@@ -102,7 +131,34 @@ bool EmdFormat::readNode(h5::H5ReadWrite& reader, const std::string& emdNode,
   if (!reader.isDataSet(emdDataNode))
     return false;
 
-  if (!GenericHDF5Format::readVolume(reader, emdDataNode, image, options)) {
+  // Now to read in the dimensions...
+  auto dim1 = reader.readData<float>(emdNode + "/dim1");
+  auto dim2 = reader.readData<float>(emdNode + "/dim2");
+  auto dim3 = reader.readData<float>(emdNode + "/dim3");
+
+  // If there are angles, read them in
+  QVector<double> angles;
+  auto units = reader.attribute<std::string>(emdNode + "/dim1", "units", &ok);
+  if (ok) {
+    if (units == "[deg]") {
+      for (unsigned i = 0; i < dim1.size(); ++i) {
+        angles.push_back(dim1[i]);
+      }
+    } else if (units == "[rad]") {
+      for (unsigned i = 0; i < dim1.size(); ++i) {
+        // Convert radians to degrees since tomviz assumes degrees everywhere.
+        angles.push_back(dim1[i] * 180.0 / vtkMath::Pi());
+      }
+    }
+  }
+
+  // Tilt series keep the C ordering, their X and Z axes are relabeled
+  // instead. Anything else is re-ordered to Fortran while it is read.
+  auto reorder =
+    angles.isEmpty() ? ReorderMode::CToFortran : ReorderMode::None;
+
+  if (!GenericHDF5Format::readVolume(reader, emdDataNode, image, options,
+                                     reorder, progress)) {
     cerr << "Failed to read the volume at " << emdDataNode << "\n";
     return false;
   }
@@ -116,11 +172,6 @@ bool EmdFormat::readNode(h5::H5ReadWrite& reader, const std::string& emdNode,
     }
   }
 
-  // Now to read in the dimensions...
-  auto dim1 = reader.readData<float>(emdNode + "/dim1");
-  auto dim2 = reader.readData<float>(emdNode + "/dim2");
-  auto dim3 = reader.readData<float>(emdNode + "/dim3");
-
   // Set the spacing
   if (dim1.size() > 1 && dim2.size() > 1 && dim3.size() > 1) {
     double spacing[3];
@@ -130,29 +181,10 @@ bool EmdFormat::readNode(h5::H5ReadWrite& reader, const std::string& emdNode,
     image->SetSpacing(spacing);
   }
 
-  // If there are angles, read them in
-  QVector<double> angles;
-  auto units = reader.attribute<std::string>(emdNode + "/dim1", "units", &ok);
-  if (ok) {
-    if (units == "[deg]") {
-      for (unsigned i = 0; i < dim1.size(); ++i) {
-        angles.push_back(dim1[i]);
-      }
-    } else if (units == "[rad]") {
-      for (unsigned i = 0; i < dim1.size(); ++i) {
-        // Convert radians to degrees since tomviz assumes degrees everywhere.
-        angles.push_back(dim1[i] * 180.0 / vtkMath::Pi());
-      }
-    }
-  }
-
   // Now read in any extra scalars
-  readExtraScalars(reader, emdNode, image);
+  readExtraScalars(reader, emdNode, image, reorder);
 
-  if (angles.isEmpty()) {
-    // The data has not been re-ordered. Re-order to Fortran.
-    GenericHDF5Format::reorderData(image, ReorderMode::CToFortran);
-  } else {
+  if (!angles.isEmpty()) {
     // No deep copying of the data needed. Just relabel the X and Z axes.
     relabelXAndZAxes(image);
     DataSource::setTiltAngles(image, angles);
@@ -176,12 +208,14 @@ bool EmdFormat::readNode(h5::H5ReadWrite& reader, const std::string& emdNode,
   return true;
 }
 
-bool EmdFormat::write(const std::string& fileName, DataSource* source)
+bool EmdFormat::write(const std::string& fileName, DataSource* source,
+                      const QVariantMap& options)
 {
-  return write(fileName, source->imageData());
+  return write(fileName, source->imageData(), options);
 }
 
-bool EmdFormat::write(const std::string& fileName, vtkImageData* image)
+bool EmdFormat::write(const std::string& fileName, vtkImageData* image,
+                      const QVariantMap& options)
 {
   using h5::H5ReadWrite;
   H5ReadWrite::OpenMode mode = H5ReadWrite::OpenMode::WriteOnly;
@@ -195,11 +229,11 @@ bool EmdFormat::write(const std::string& fileName, vtkImageData* image)
   writer.createGroup("/data");
   writer.createGroup("/data/tomography");
 
-  return writeNode(writer, "/data/tomography", image);
+  return writeNode(writer, "/data/tomography", image, options);
 }
 
 bool EmdFormat::writeNode(h5::H5ReadWrite& writer, const std::string& path,
-                          vtkImageData* image)
+                          vtkImageData* image, const QVariantMap& options)
 {
   // Create the emd_group_type attribute.
   writer.setAttribute(path, "emd_group_type", 1u);
@@ -207,18 +241,24 @@ bool EmdFormat::writeNode(h5::H5ReadWrite& writer, const std::string& path,
   // See if we have tilt angles
   auto hasTiltAngles = DataSource::hasTiltAngles(image);
 
+  // No deep copies of data needed. Tilt series just have their axes
+  // re-labeled, anything else is re-ordered to C while it is written.
   vtkNew<vtkImageData> permutedImage;
-  if (DataSource::hasTiltAngles(image)) {
-    // No deep copies of data needed. Just re-label the axes.
-    permutedImage->ShallowCopy(image);
+  permutedImage->ShallowCopy(image);
+  auto reorder = ReorderMode::FortranToC;
+  if (hasTiltAngles) {
     relabelXAndZAxes(permutedImage);
-  } else {
-    // Need to re-order to C ordering before writing
-    GenericHDF5Format::reorderData(image, permutedImage,
-                                   ReorderMode::FortranToC);
+    reorder = ReorderMode::None;
   }
 
-  GenericHDF5Format::writeVolume(writer, path, "data", permutedImage);
+  GenericHDF5Format::writeVolume(writer, path, "data", permutedImage, options,
+                                 reorder);
+
+  // Downsampled levels of the volume, to quickly display it. The levels of
+  // a tilt series would mix up its projections.
+  if (!hasTiltAngles) {
+    writeMultiscale(writer, path, image, options);
+  }
 
   // Set a "name" attribute on the data so we can remember the
   // scalar name that the user gave it.
@@ -282,7 +322,7 @@ bool EmdFormat::writeNode(h5::H5ReadWrite& writer, const std::string& path,
   }
 
   // Write any extra scalars we might have
-  writeExtraScalars(writer, path, permutedImage);
+  writeExtraScalars(writer, path, permutedImage, options, reorder);
 
   // Write scan IDs if present
   if (DataSource::hasScanIDs(image)) {
@@ -295,8 +335,46 @@ bool EmdFormat::writeNode(h5::H5ReadWrite& writer, const std::string& path,
   return true;
 }
 
+static void writeMultiscale(h5::H5ReadWrite& writer, const std::string& path,
+                            vtkImageData* image, const QVariantMap& options)
+{
+  // By default, only large volumes get a pyramid
+  int levels = options.value("multiscaleLevels", -1).toInt();
+  if (levels < 0) {
+    auto scalars = image->GetPointData()->GetScalars();
+    size_t size = static_cast<size_t>(scalars->GetNumberOfValues()) *
+                  scalars->GetDataTypeSize();
+    levels = size >= MultiscaleSize ? DefaultMultiscaleLevels : 0;
+  }
+  if (levels == 0) {
+    return;
+  }
+
+  // The chunks of the full resolution volume may not fit in the levels
+  QVariantMap levelOptions = options;
+  levelOptions.remove("chunkDimensions");
+
+  auto group = GenericHDF5Format::multiscalePath(path + "/data", 2);
+  writer.createGroup(group.substr(0, group.find_last_of('/')));
+
+  vtkSmartPointer<vtkImageData> level = image;
+  for (int i = 1, factor = 2; i <= levels; ++i, factor *= 2) {
+    vtkNew<vtkImageData> next;
+    if (!GenericHDF5Format::downsample(level, next)) {
+      break;
+    }
+    auto levelPath = GenericHDF5Format::multiscalePath(path + "/data", factor);
+    auto slash = levelPath.find_last_of('/');
+    GenericHDF5Format::writeVolume(
+      writer, levelPath.substr(0, slash), levelPath.substr(slash + 1), next,
+      levelOptions, ReorderMode::FortranToC);
+    level = next;
+  }
+}
+
 static void readExtraScalars(h5::H5ReadWrite& reader,
-                             const std::string& emdNode, vtkImageData* image)
+                             const std::string& emdNode, vtkImageData* image,
+                             ReorderMode reorder)
 {
   std::string scalarsPath = emdNode + "/tomviz_scalars";
   if (!reader.isGroup(scalarsPath)) {
@@ -315,13 +393,14 @@ static void readExtraScalars(h5::H5ReadWrite& reader,
       continue;
     }
 
-    GenericHDF5Format::addScalarArray(reader, path, image, name);
+    GenericHDF5Format::addScalarArray(reader, path, image, name, reorder);
   }
 }
 
 static bool writeExtraScalars(h5::H5ReadWrite& writer,
                               const std::string& groupPath,
-                              vtkImageData* image)
+                              vtkImageData* image, const QVariantMap& options,
+                              ReorderMode reorder)
 {
   std::string path = groupPath + "/tomviz_scalars";
   writer.createGroup(path);
@@ -343,7 +422,8 @@ static bool writeExtraScalars(h5::H5ReadWrite& writer,
 
     // Make it active and write it
     pointData->SetActiveScalars(arrayName);
-    GenericHDF5Format::writeVolume(writer, path, arrayName, image);
+    GenericHDF5Format::writeVolume(writer, path, arrayName, image, options,
+                                   reorder);
   }
 
   // Make the original one active again
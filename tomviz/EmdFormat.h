@@ -4,6 +4,8 @@
 #ifndef tomvizEmdFormat_h
 #define tomvizEmdFormat_h
 
+#include "GenericHDF5Format.h"
+
 #include <string>
 
 #include <QVariantMap>
@@ -21,10 +23,21 @@ class DataSource;
 class EmdFormat
 {
 public:
+  // The progress, of the read of the volume, can cancel the read.
   static bool read(const std::string& fileName, vtkImageData* data,
-                   const QVariantMap& options = QVariantMap());
-  static bool write(const std::string& fileName, DataSource* source);
-  static bool write(const std::string& fileName, vtkImageData* image);
+                   const QVariantMap& options = QVariantMap(),
+                   const GenericHDF5Format::ReadProgress& progress =
+                     GenericHDF5Format::ReadProgress());
+  // Ask for the subsample settings before read() is called where there is no
+  // GUI, see GenericHDF5Format::askForSubsample(). False if canceled.
+  static bool askForSubsample(const std::string& fileName,
+                              QVariantMap& options);
+  // The write options select the chunking and compression of the volumes,
+  // see GenericHDF5Format::writeVolume().
+  static bool write(const std::string& fileName, DataSource* source,
+                    const QVariantMap& options = QVariantMap());
+  static bool write(const std::string& fileName, vtkImageData* image,
+                    const QVariantMap& options = QVariantMap());
 
   // Read EMD data from a specified node in the HDF5 file
   static bool readNode(const std::string& fileName, const std::string& path,
@@ -32,10 +45,13 @@ public:
                        const QVariantMap& options = QVariantMap());
   static bool readNode(h5::H5ReadWrite& reader, const std::string& path,
                        vtkImageData* image,
-                       const QVariantMap& options = QVariantMap());
+                       const QVariantMap& options = QVariantMap(),
+                       const GenericHDF5Format::ReadProgress& progress =
+                         GenericHDF5Format::ReadProgress());
   // Write EMD data to a specified node in the HDF5 file
   static bool writeNode(h5::H5ReadWrite& writer, const std::string& path,
-                        vtkImageData* image);
+                        vtkImageData* image,
+                        const QVariantMap& options = QVariantMap());
 };
 } // namespace tomviz
 
@@ -0,0 +1,167 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "FourierTransform.h"
+
+#include <cmath>
+
+namespace {
+
+const double Pi = 3.14159265358979323846;
+
+bool isPowerOfTwo(int n)
+{
+  return n > 0 && (n & (n - 1)) == 0;
+}
+} // namespace
+
+namespace tomviz {
+
+namespace FourierTransform {
+
+Plan::Plan(int n) : m_size(n)
+{
+  if (isPowerOfTwo(n)) {
+    m_paddedSize = n;
+  } else {
+    // Bluestein needs a linear convolution of length 2n - 1.
+    m_paddedSize = 1;
+    while (m_paddedSize < 2 * n - 1) {
+      m_paddedSize <<= 1;
+    }
+  }
+
+  int bits = 0;
+  while ((1 << bits) < m_paddedSize) {
+    ++bits;
+  }
+  m_bitReversal.resize(m_paddedSize);
+  for (int i = 0; i < m_paddedSize; ++i) {
+    int reversed = 0;
+    for (int b = 0; b < bits; ++b) {
+      reversed |= ((i >> b) & 1) << (bits - 1 - b);
+    }
+    m_bitReversal[i] = reversed;
+  }
+  m_twiddles.resize(m_paddedSize / 2);
+  for (int i = 0; i < m_paddedSize / 2; ++i) {
+    m_twiddles[i] = std::polar(1.0, -2.0 * Pi * i / m_paddedSize);
+  }
+
+  if (m_paddedSize != n) {
+    m_chirp.resize(n);
+    for (int k = 0; k < n; ++k) {
+      // Reduce k^2 modulo 2n first to keep the phase accurate for large k.
+      long long k2 = (static_cast<long long>(k) * k) % (2 * n);
+      m_chirp[k] = std::polar(1.0, -Pi * k2 / n);
+    }
+    m_chirpSpectrum.assign(m_paddedSize, 0.0);
+    m_chirpSpectrum[0] = std::conj(m_chirp[0]);
+    for (int k = 1; k < n; ++k) {
+      m_chirpSpectrum[k] = std::conj(m_chirp[k]);
+      m_chirpSpectrum[m_paddedSize - k] = std::conj(m_chirp[k]);
+    }
+    radix2(m_chirpSpectrum.data(), false);
+  }
+}
+
+void Plan::forward(Complex* data, int stride) const
+{
+  transform(data, stride, false);
+}
+
+void Plan::inverse(Complex* data, int stride) const
+{
+  transform(data, stride, true);
+}
+
+void Plan::transform(Complex* data, int stride, bool inverse) const
+{
+  // Work in double precision on a private buffer, so a plan can be used from
+  // several threads at once. The inverse is computed as conj(F(conj(x))) / n.
+  std::vector<std::complex<double>> buffer(m_paddedSize, 0.0);
+  for (int i = 0; i < m_size; ++i) {
+    std::complex<double> value = data[static_cast<size_t>(i) * stride];
+    buffer[i] = inverse ? std::conj(value) : value;
+  }
+
+  if (m_paddedSize == m_size) {
+    radix2(buffer.data(), false);
+  } else {
+    for (int i = 0; i < m_size; ++i) {
+      buffer[i] *= m_chirp[i];
+    }
+    radix2(buffer.data(), false);
+    for (int i = 0; i < m_paddedSize; ++i) {
+      buffer[i] *= m_chirpSpectrum[i];
+    }
+    radix2(buffer.data(), true);
+    for (int i = 0; i < m_size; ++i) {
+      buffer[i] *= m_chirp[i];
+    }
+  }
+
+  for (int i = 0; i < m_size; ++i) {
+    auto value = inverse ? std::conj(buffer[i]) / double(m_size) : buffer[i];
+    data[static_cast<size_t>(i) * stride] = Complex(value);
+  }
+}
+
+void Plan::radix2(std::complex<double>* data, bool inverse) const
+{
+  const int n = m_paddedSize;
+  for (int i = 0; i < n; ++i) {
+    if (i < m_bitReversal[i]) {
+      std::swap(data[i], data[m_bitReversal[i]]);
+    }
+  }
+  for (int length = 2; length <= n; length <<= 1) {
+    const int half = length / 2;
+    const int step = n / length;
+    for (int start = 0; start < n; start += length) {
+      for (int j = 0; j < half; ++j) {
+        auto twiddle = m_twiddles[j * step];
+        if (inverse) {
+          twiddle = std::conj(twiddle);
+        }
+        auto odd = data[start + j + half] * twiddle;
+        data[start + j + half] = data[start + j] - odd;
+        data[start + j] += odd;
+      }
+    }
+  }
+  if (inverse) {
+    for (int i = 0; i < n; ++i) {
+      data[i] /= n;
+    }
+  }
+}
+
+Plan2D::Plan2D(int width, int height) : m_rows(width), m_columns(height) {}
+
+void Plan2D::forward(Complex* data) const
+{
+  const int w = width();
+  const int h = height();
+  for (int y = 0; y < h; ++y) {
+    m_rows.forward(data + static_cast<size_t>(y) * w);
+  }
+  for (int x = 0; x < w; ++x) {
+    m_columns.forward(data + x, w);
+  }
+}
+
+void Plan2D::inverse(Complex* data) const
+{
+  const int w = width();
+  const int h = height();
+  for (int y = 0; y < h; ++y) {
+    m_rows.inverse(data + static_cast<size_t>(y) * w);
+  }
+  for (int x = 0; x < w; ++x) {
+    m_columns.inverse(data + x, w);
+  }
+}
+
+} // namespace FourierTransform
+} // namespace tomviz
@@ -0,0 +1,74 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizFourierTransform_h
+#define tomvizFourierTransform_h
+
+#include <complex>
+#include <vector>
+
+namespace tomviz {
+
+namespace FourierTransform {
+
+using Complex = std::complex<float>;
+
+/// A plan for complex 1D transforms of a fixed length. Powers of two use an
+/// iterative radix-2 transform, any other length goes through Bluestein's
+/// algorithm. A plan is immutable once built, so a single plan can be shared
+/// by any number of threads.
+class Plan
+{
+public:
+  explicit Plan(int size);
+
+  int size() const { return m_size; }
+
+  /// In place forward transform of size() values spaced by stride.
+  void forward(Complex* data, int stride = 1) const;
+
+  /// In place inverse transform, normalized by 1 / size().
+  void inverse(Complex* data, int stride = 1) const;
+
+private:
+  void transform(Complex* data, int stride, bool inverse) const;
+  void radix2(std::complex<double>* data, bool inverse) const;
+
+  int m_size;
+  // Length of the power of two transform doing the actual work.
+  int m_paddedSize;
+  std::vector<int> m_bitReversal;
+  std::vector<std::complex<double>> m_twiddles;
+  // Bluestein chirp and the transformed, padded conjugate chirp.
+  std::vector<std::complex<double>> m_chirp;
+  std::vector<std::complex<double>> m_chirpSpectrum;
+};
+
+/// A plan for 2D transforms of row-major images with width columns and
+/// height rows. Like Plan, it is safe to share between threads.
+class Plan2D
+{
+public:
+  Plan2D(int width, int height);
+
+  int width() const { return m_rows.size(); }
+  int height() const { return m_columns.size(); }
+
+  void forward(Complex* data) const;
+  void inverse(Complex* data) const;
+
+private:
+  Plan m_rows;
+  Plan m_columns;
+};
+
+/// Signed frequency, in cycles per sample, of index i of a transform of
+/// length n (the equivalent of numpy.fft.fftfreq).
+inline float frequency(int i, int n)
+{
+  return static_cast<float>(i < (n + 1) / 2 ? i : i - n) / n;
+}
+} // namespace FourierTransform
+} // namespace tomviz
+
+#endif
@@ -23,7 +23,12 @@
 #include <vtkImageData.h>
 #include <vtkImagePermute.h>
 #include <vtkPointData.h>
+#include <vtkSMPTools.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -36,30 +41,349 @@ using std::endl;
 
 namespace tomviz {
 
+namespace {
+
+// Side of the square tiles the transposes work on, so that both the reads
+// and the writes of a tile stay in cache.
+const int TransposeTile = 32;
+
+// Approximate size of the slabs of a volume held in memory while it is
+// streamed to or from a file in C order.
+const size_t SlabSize = 64 << 20;
+
+// Name of the group, next to a volume, holding its multiscale pyramid
+const char* MultiscaleGroup = "tomviz_multiscale";
+
+// Average blocks of 2 x 2 x 2 voxels of in into out, of dimensions outDim.
 template <typename T>
-void ReorderArrayC(T* in, T* out, int dim[3])
+void Downsample(const T* in, T* out, const int inDim[3], const int outDim[3])
 {
-  for (int i = 0; i < dim[0]; ++i) {
-    for (int j = 0; j < dim[1]; ++j) {
-      for (int k = 0; k < dim[2]; ++k) {
-        out[static_cast<size_t>(i * dim[1] + j) * dim[2] + k] =
-          in[static_cast<size_t>(k * dim[1] + j) * dim[0] + i];
+  const size_t nx = inDim[0], nxy = nx * inDim[1];
+  vtkSMPTools::For(0, outDim[2], [&](vtkIdType first, vtkIdType last) {
+    for (vtkIdType k = first; k < last; ++k) {
+      for (int j = 0; j < outDim[1]; ++j) {
+        T* o = out + (k * outDim[1] + j) * static_cast<size_t>(outDim[0]);
+        const T* p = in + 2 * k * nxy + 2 * j * nx;
+        for (int i = 0; i < outDim[0]; ++i, p += 2) {
+          double sum = 0.0;
+          for (int dk = 0; dk < 2; ++dk) {
+            for (int dj = 0; dj < 2; ++dj) {
+              const T* q = p + dk * nxy + dj * nx;
+              sum += static_cast<double>(q[0]) + static_cast<double>(q[1]);
+            }
+          }
+          // Round integers to the nearest value
+          double mean = sum / 8.0;
+          o[i] = std::numeric_limits<T>::is_integer
+                   ? static_cast<T>(std::floor(mean + 0.5))
+                   : static_cast<T>(mean);
+        }
       }
     }
-  }
+  });
 }
 
+// Rows [begin, end) of the first dimension of a C ordered volume of
+// dimensions dim are in slab, copy them to the Fortran ordered volume out.
 template <typename T>
-void ReorderArrayF(T* in, T* out, int dim[3])
+void SlabCToFortran(const T* slab, T* out, const int dim[3], int begin,
+                    int end)
+{
+  const size_t d0 = dim[0], d1 = dim[1], d2 = dim[2];
+  const int rows = end - begin;
+  // For every j, this transposes a rows x d2 matrix.
+  vtkSMPTools::For(0, dim[1], [&](vtkIdType first, vtkIdType last) {
+    for (vtkIdType j = first; j < last; ++j) {
+      for (int i0 = 0; i0 < rows; i0 += TransposeTile) {
+        int i1 = std::min(i0 + TransposeTile, rows);
+        for (int k0 = 0; k0 < dim[2]; k0 += TransposeTile) {
+          int k1 = std::min(k0 + TransposeTile, dim[2]);
+          for (int k = k0; k < k1; ++k) {
+            T* o = out + (k * d1 + j) * d0 + begin;
+            const T* s = slab + j * d2 + k;
+            for (int i = i0; i < i1; ++i) {
+              o[i] = s[i * d1 * d2];
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+// The reverse of SlabCToFortran(): copy rows [begin, end) of the first
+// dimension of the Fortran ordered volume in to the C ordered slab.
+template <typename T>
+void SlabFortranToC(const T* in, T* slab, const int dim[3], int begin,
+                    int end)
 {
-  for (int i = 0; i < dim[0]; ++i) {
-    for (int j = 0; j < dim[1]; ++j) {
-      for (int k = 0; k < dim[2]; ++k) {
-        out[static_cast<size_t>(k * dim[1] + j) * dim[0] + i] =
-          in[static_cast<size_t>(i * dim[1] + j) * dim[2] + k];
+  const size_t d0 = dim[0], d1 = dim[1], d2 = dim[2];
+  const int rows = end - begin;
+  vtkSMPTools::For(0, dim[1], [&](vtkIdType first, vtkIdType last) {
+    for (vtkIdType j = first; j < last; ++j) {
+      for (int i0 = 0; i0 < rows; i0 += TransposeTile) {
+        int i1 = std::min(i0 + TransposeTile, rows);
+        for (int k0 = 0; k0 < dim[2]; k0 += TransposeTile) {
+          int k1 = std::min(k0 + TransposeTile, dim[2]);
+          for (int i = i0; i < i1; ++i) {
+            T* s = slab + (i * d1 + j) * d2;
+            const T* o = in + j * d0 + begin + i;
+            for (int k = k0; k < k1; ++k) {
+              s[k] = o[k * d1 * d0];
+            }
+          }
+        }
       }
     }
+  });
+}
+
+// Number of rows of the first dimension in a slab
+size_t slabRows(size_t rowSize, size_t rows, size_t multiple = 1)
+{
+  size_t slab = std::max<size_t>(1, SlabSize / std::max<size_t>(1, rowSize));
+  slab = std::max(multiple, slab - slab % multiple);
+  return std::min(slab, rows);
+}
+
+// Read a 3D data set in slabs along its first dimension, and report the
+// progress between them. With ReorderMode::CToFortran it is read straight
+// into Fortran order, so only a slab of the C ordered data is in memory at
+// any time, rather than a whole second copy of the volume. Otherwise the
+// slabs are read in place, in one go if there is no progress to report.
+// The slabs span whole chunks, so strided reads do not decompress a chunk
+// twice.
+bool readSlabs(h5::H5ReadWrite& reader, const std::string& path,
+               h5::H5ReadWrite::DataType type, vtkDataArray* array,
+               int strides[3], size_t start[3], size_t counts[3],
+               bool average, ReorderMode reorder,
+               const GenericHDF5Format::ReadProgress& progress)
+{
+  bool transpose = reorder == ReorderMode::CToFortran;
+  int dim[3] = { static_cast<int>(counts[0]), static_cast<int>(counts[1]),
+                 static_cast<int>(counts[2]) };
+  size_t rowLength = counts[1] * counts[2];
+  size_t rows = counts[0];
+  if (transpose || progress) {
+    size_t multiple = 1;
+    auto chunks = reader.writeOptions(path).chunkDimensions;
+    if (chunks.size() == 3) {
+      multiple = chunks[0] / std::gcd(chunks[0], strides[0]);
+    }
+    rows = slabRows(rowLength * array->GetDataTypeSize(), counts[0], multiple);
+  }
+
+  vtkSmartPointer<vtkDataArray> slab;
+  if (transpose) {
+    slab = vtkSmartPointer<vtkDataArray>::Take(
+      vtkDataArray::CreateDataArray(array->GetDataType()));
+    slab->SetNumberOfTuples(rows * rowLength);
+  }
+
+  for (size_t begin = 0; begin < counts[0]; begin += rows) {
+    if (progress && !progress(static_cast<double>(begin) / counts[0])) {
+      // Canceled
+      return false;
+    }
+
+    size_t end = std::min(begin + rows, counts[0]);
+    size_t slabStart[3] = { start[0] + begin * strides[0], start[1],
+                            start[2] };
+    size_t slabCounts[3] = { end - begin, counts[1], counts[2] };
+    void* out = transpose ? slab->GetVoidPointer(0)
+                          : array->GetVoidPointer(begin * rowLength);
+    if (!reader.readData(path, type, out, strides, slabStart, slabCounts,
+                         average)) {
+      cerr << "Failed to read the data\n";
+      return false;
+    }
+
+    if (!transpose) {
+      continue;
+    }
+    switch (array->GetDataType()) {
+      vtkTemplateMacro(SlabCToFortran(
+        static_cast<const VTK_TT*>(slab->GetVoidPointer(0)),
+        static_cast<VTK_TT*>(array->GetVoidPointer(0)), dim,
+        static_cast<int>(begin), static_cast<int>(end)));
+      default:
+        cout << "Generic HDF5 Format: Unknown data type" << endl;
+        return false;
+    }
+  }
+
+  if (progress) {
+    progress(1.0);
+  }
+  return true;
+}
+
+// Write the Fortran ordered array as a C ordered 3D data set, a slab at a
+// time. The slabs are aligned with the chunks, so every chunk is written
+// (and compressed) only once.
+bool writeCOrdered(h5::H5ReadWrite& writer, const std::string& path,
+                   const std::string& name, vtkDataArray* array,
+                   const int dim[3], h5::H5ReadWrite::DataType type,
+                   const h5::WriteOptions& options)
+{
+  std::vector<int> dims({ dim[0], dim[1], dim[2] });
+  if (!writer.createDataSet(path, name, dims, type, options)) {
+    return false;
+  }
+
+  std::string dataSetPath = path;
+  if (dataSetPath.empty() || dataSetPath.back() != '/') {
+    dataSetPath += "/";
+  }
+  dataSetPath += name;
+
+  size_t rowLength = static_cast<size_t>(dim[1]) * dim[2];
+  size_t chunkRows =
+    options.chunkDimensions.empty() ? 1 : options.chunkDimensions[0];
+  size_t rows = slabRows(rowLength * array->GetDataTypeSize(), dim[0],
+                         std::max<size_t>(1, chunkRows));
+
+  auto slab = vtkSmartPointer<vtkDataArray>::Take(
+    vtkDataArray::CreateDataArray(array->GetDataType()));
+  slab->SetNumberOfTuples(rows * rowLength);
+
+  for (size_t begin = 0; begin < static_cast<size_t>(dim[0]);
+       begin += rows) {
+    size_t end = std::min(begin + rows, static_cast<size_t>(dim[0]));
+    switch (array->GetDataType()) {
+      vtkTemplateMacro(
+        SlabFortranToC(static_cast<const VTK_TT*>(array->GetVoidPointer(0)),
+                       static_cast<VTK_TT*>(slab->GetVoidPointer(0)), dim,
+                       static_cast<int>(begin), static_cast<int>(end)));
+      default:
+        cout << "Generic HDF5 Format: Unknown data type" << endl;
+        return false;
+    }
+
+    size_t start[3] = { begin, 0, 0 };
+    size_t counts[3] = { end - begin, static_cast<size_t>(dim[1]),
+                         static_cast<size_t>(dim[2]) };
+    if (!writer.writeHyperslab(dataSetPath, type, slab->GetVoidPointer(0),
+                               start, counts)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Whether readVolume() asks for a subsample of a volume of these dimensions
+bool shouldAskForSubsample(const std::vector<int>& dims,
+                           const QVariantMap& options)
+{
+  if (options.contains("askForSubsample")) {
+    // If the options specify whether to ask for a subsample, use that
+    return options["askForSubsample"].toBool();
+  }
+
+  // Otherwise, only ask for a subsample if the data looks large
+  int subsampleDimOverride = 1200;
+  if (options.contains("subsampleDimOverride"))
+    subsampleDimOverride = options["subsampleDimOverride"].toInt();
+
+  return std::any_of(dims.cbegin(), dims.cend(), [subsampleDimOverride](int i) {
+    return i >= subsampleDimOverride;
+  });
+}
+
+// Let the user pick the subsample, starting from the given values when
+// previous is true. Returns false if the user cancels.
+bool execSubsampleDialog(int dimensions[3], int size, bool previous,
+                         int strides[3], int bs[6], bool& lazy, bool& average,
+                         bool lazyAvailable)
+{
+  QDialog dialog;
+  dialog.setWindowTitle("Pick Subsample");
+  QVBoxLayout layout;
+  dialog.setLayout(&layout);
+
+  Hdf5SubsampleWidget widget(dimensions, size);
+  layout.addWidget(&widget);
+
+  if (previous) {
+    // If it was previously subsampled, start with the previous values
+    widget.setStrides(strides);
+    widget.setBounds(bs);
   }
+  widget.setLazy(lazy);
+  widget.setLazyAvailable(lazyAvailable);
+  widget.setAverage(average);
+
+  QDialogButtonBox buttons(QDialogButtonBox::Ok | QDialogButtonBox::Cancel |
+                           QDialogButtonBox::Help);
+  layout.addWidget(&buttons);
+  QObject::connect(&buttons, &QDialogButtonBox::accepted, &dialog,
+                   &QDialog::accept);
+  QObject::connect(&buttons, &QDialogButtonBox::rejected, &dialog,
+                   &QDialog::reject);
+  QObject::connect(&buttons, &QDialogButtonBox::helpRequested,
+                   []() { openHelpUrl("data/#hdf5-subsampling"); });
+
+  // Check if the user cancels
+  if (!dialog.exec())
+    return false;
+
+  widget.bounds(bs);
+  widget.strides(strides);
+  lazy = widget.lazy();
+  average = widget.average();
+  return true;
+}
+
+// Let the user pick the subsample of a volume if readVolume() would, see
+// GenericHDF5Format::askForSubsample()
+bool askForSubsampleSettings(const std::vector<int>& dims, int dataTypeSize,
+                             QVariantMap& options, bool lazyAvailable)
+{
+  if (dims.size() == 3 && shouldAskForSubsample(dims, options)) {
+    int dimensions[3] = { dims[0], dims[1], dims[2] };
+    int strides[3] = { 1, 1, 1 };
+    int bs[6] = { 0, dims[0], 0, dims[1], 0, dims[2] };
+
+    // Start from the settings in the options, if there are any
+    bool previous = options.contains("subsampleStrides") ||
+                    options.contains("subsampleVolumeBounds");
+    QVariantList list = options.value("subsampleStrides").toList();
+    for (int i = 0; i < list.size() && i < 3; ++i)
+      strides[i] = std::max(list[i].toInt(), 1);
+    list = options.value("subsampleVolumeBounds").toList();
+    for (int i = 0; i < list.size() && i < 6; ++i)
+      bs[i] = list[i].toInt();
+    bool lazy = lazyAvailable && options.value("lazy", false).toBool();
+    bool average = options.value("subsampleAverage", false).toBool();
+
+    if (!execSubsampleDialog(dimensions, dataTypeSize, previous, strides, bs,
+                             lazy, average, lazyAvailable))
+      return false;
+
+    options["subsampleStrides"] =
+      QVariantList({ strides[0], strides[1], strides[2] });
+    options["subsampleVolumeBounds"] =
+      QVariantList({ bs[0], bs[1], bs[2], bs[3], bs[4], bs[5] });
+    options["lazy"] = lazy;
+    options["subsampleAverage"] = average;
+  }
+
+  // The volume can now be read without a GUI
+  options["askForSubsample"] = false;
+  return true;
+}
+} // namespace
+
+template <typename T>
+void ReorderArrayC(T* in, T* out, int dim[3])
+{
+  SlabFortranToC(in, out, dim, 0, dim[0]);
+}
+
+template <typename T>
+void ReorderArrayF(T* in, T* out, int dim[3])
+{
+  SlabCToFortran(in, out, dim, 0, dim[0]);
 }
 
 void GenericHDF5Format::reorderDataArray(vtkDataArray* in, vtkDataArray* out,
@@ -82,7 +406,7 @@ void GenericHDF5Format::reorderDataArray(vtkDataArray* in, vtkDataArray* out,
 
 void GenericHDF5Format::reorderData(vtkImageData* image, ReorderMode mode)
 {
-  if (!image)
+  if (!image || mode == ReorderMode::None)
     return;
 
   // We want the preserve the field data
@@ -104,6 +428,11 @@ void GenericHDF5Format::reorderData(vtkImageData* in, vtkImageData* out,
   if (!in || !out)
     return;
 
+  if (mode == ReorderMode::None) {
+    out->ShallowCopy(in);
+    return;
+  }
+
   auto* inPd = in->GetPointData();
   auto* outPd = out->GetPointData();
 
@@ -228,7 +557,9 @@ void GenericHDF5Format::swapXAndZAxes(vtkImageData* image)
 bool GenericHDF5Format::addScalarArray(h5::H5ReadWrite& reader,
                                        const std::string& path,
                                        vtkImageData* image,
-                                       const std::string& name)
+                                       const std::string& name,
+                                       ReorderMode reorder,
+                                       const ReadProgress& progress)
 {
   // Get the type of the data
   h5::H5ReadWrite::DataType type = reader.dataType(path);
@@ -282,20 +613,20 @@ bool GenericHDF5Format::addScalarArray(h5::H5ReadWrite& reader,
 
       std::cerr << "Error in GenericHDF5Format::addScalarArray():\n"
                 << ss.str() << std::endl;
-      QMessageBox::critical(nullptr, "Dimensions do not match",
-                            ss.str().c_str());
       return false;
     }
   }
 
-  vtkSmartPointer<vtkAbstractArray> array =
-    vtkAbstractArray::CreateArray(vtkDataType);
+  vtkSmartPointer<vtkDataArray> array =
+    vtkDataArray::CreateDataArray(vtkDataType);
   array->SetNumberOfTuples(counts[0] * counts[1] * counts[2]);
   array->SetName(name.c_str());
 
-  if (!reader.readData(path, type, array->GetVoidPointer(0), strides, start,
-                       counts)) {
-    std::cerr << "Failed to read the data\n";
+  // Bin the array in the same way as the main image
+  bool average = DataSource::subsampleAverage(image);
+
+  if (!readSlabs(reader, path, type, array, strides, start, counts, average,
+                 reorder, progress)) {
     return false;
   }
 
@@ -325,9 +656,27 @@ bool GenericHDF5Format::isFxi(const std::string& fileName)
   return reader.isDataSet("/img_tomo") && reader.isDataSet("/img_bkg");
 }
 
+bool GenericHDF5Format::askForSubsample(h5::H5ReadWrite& reader,
+                                        const std::string& path,
+                                        QVariantMap& options)
+{
+  std::vector<int> dims = reader.getDimensions(path);
+  int vtkDataType = h5::H5VtkTypeMaps::dataTypeToVtk(reader.dataType(path));
+  int size = vtkDataArray::GetDataTypeSize(vtkDataType);
+  return askForSubsampleSettings(dims, size, options, true);
+}
+
+bool GenericHDF5Format::askForSubsample(const std::vector<int>& dims,
+                                        int dataTypeSize, QVariantMap& options)
+{
+  return askForSubsampleSettings(dims, dataTypeSize, options, false);
+}
+
 bool GenericHDF5Format::readVolume(h5::H5ReadWrite& reader,
                                    const std::string& path, vtkImageData* image,
-                                   const QVariantMap& options)
+                                   const QVariantMap& options,
+                                   ReorderMode reorder,
+                                   const ReadProgress& progress)
 {
   // Get the type of the data
   h5::H5ReadWrite::DataType type = reader.dataType(path);
@@ -375,58 +724,30 @@ bool GenericHDF5Format::readVolume(h5::H5ReadWrite& reader,
     DataSource::setSubsampleStrides(image, strides);
   }
 
-  bool askForSubsample = false;
-  if (options.contains("askForSubsample")) {
-    // If the options specify whether to ask for a subsample, use that
-    askForSubsample = options["askForSubsample"].toBool();
-  } else {
-    // Otherwise, only ask for a subsample if the data looks large
-    int subsampleDimOverride = 1200;
-    if (options.contains("subsampleDimOverride"))
-      subsampleDimOverride = options["subsampleDimOverride"].toInt();
+  bool askForSubsample = shouldAskForSubsample(dims, options);
 
-    askForSubsample =
-      std::any_of(dims.cbegin(), dims.cend(), [subsampleDimOverride](int i) {
-        return i >= subsampleDimOverride;
-      });
-  }
+  // Keep the subsample as a proxy, and read full resolution regions on
+  // demand, rather than reading the whole volume.
+  bool lazy = options.value("lazy", false).toBool();
+
+  // Average the voxels of each stride block (binning), rather than taking
+  // the first one.
+  bool average = options.value("subsampleAverage", false).toBool();
 
   if (askForSubsample) {
     int dimensions[3] = { dims[0], dims[1], dims[2] };
-    QDialog dialog;
-    dialog.setWindowTitle("Pick Subsample");
-    QVBoxLayout layout;
-    dialog.setLayout(&layout);
-
-    Hdf5SubsampleWidget widget(dimensions, size);
-    layout.addWidget(&widget);
-
-    if (DataSource::wasSubsampled(image)) {
-      // If it was previously subsampled, start with the previous values
+    bool previous = DataSource::wasSubsampled(image);
+    if (previous) {
       DataSource::subsampleStrides(image, strides);
-      widget.setStrides(strides);
-
       DataSource::subsampleVolumeBounds(image, bs);
-      widget.setBounds(bs);
     }
+    lazy = lazy || !DataSource::lazyDataSetPath(image).isEmpty();
+    average = average || DataSource::subsampleAverage(image);
 
-    QDialogButtonBox buttons(QDialogButtonBox::Ok | QDialogButtonBox::Cancel |
-                             QDialogButtonBox::Help);
-    layout.addWidget(&buttons);
-    QObject::connect(&buttons, &QDialogButtonBox::accepted, &dialog,
-                     &QDialog::accept);
-    QObject::connect(&buttons, &QDialogButtonBox::rejected, &dialog,
-                     &QDialog::reject);
-    QObject::connect(&buttons, &QDialogButtonBox::helpRequested,
-                     []() { openHelpUrl("data/#hdf5-subsampling"); });
-
-    // Check if the user cancels
-    if (!dialog.exec())
+    if (!execSubsampleDialog(dimensions, size, previous, strides, bs, lazy,
+                             average, true))
       return false;
 
-    widget.bounds(bs);
-    widget.strides(strides);
-
     DataSource::setWasSubsampled(image, true);
     DataSource::setSubsampleStrides(image, strides);
     DataSource::setSubsampleVolumeBounds(image, bs);
@@ -452,6 +773,14 @@ bool GenericHDF5Format::readVolume(h5::H5ReadWrite& reader,
     DataSource::setSubsampleVolumeBounds(image, bs);
   }
 
+  // Only a strided read is a proxy of the volume, or can be binned
+  bool strided = std::any_of(strides, strides + 3, [](int s) { return s > 1; });
+  lazy = lazy && strided;
+  DataSource::setLazyDataSetPath(image,
+                                 lazy ? QString::fromStdString(path) : "");
+  average = average && strided;
+  DataSource::setSubsampleAverage(image, average);
+
   // Set up the strides and counts
   size_t start[3] = { static_cast<size_t>(bs[0]), static_cast<size_t>(bs[2]),
                       static_cast<size_t>(bs[4]) };
@@ -467,9 +796,27 @@ bool GenericHDF5Format::readVolume(h5::H5ReadWrite& reader,
   image->SetDimensions(&vtkCounts[0]);
   image->AllocateScalars(vtkDataType, 1);
 
-  if (!reader.readData(path, type, image->GetScalarPointer(), strides, start,
-                       counts)) {
-    std::cerr << "Failed to read the data\n";
+  // Read a matching level of a multiscale pyramid, if there is one, rather
+  // than sampling or binning the full resolution data.
+  std::string readPath = path;
+  int factor = strides[0];
+  if (factor > 1 && strides[1] == factor && strides[2] == factor &&
+      bs[0] % factor == 0 && bs[2] % factor == 0 && bs[4] % factor == 0) {
+    auto levelPath = multiscalePath(path, factor);
+    if (reader.isDataSet(levelPath) && reader.dataType(levelPath) == type &&
+        reader.getDimensions(levelPath) ==
+          std::vector<int>({ dims[0] / factor, dims[1] / factor,
+                             dims[2] / factor })) {
+      readPath = levelPath;
+      for (int i = 0; i < 3; ++i) {
+        start[i] /= factor;
+        strides[i] = 1;
+      }
+    }
+  }
+
+  if (!readSlabs(reader, readPath, type, image->GetPointData()->GetScalars(),
+                 strides, start, counts, average, reorder, progress)) {
     return false;
   }
 
@@ -478,48 +825,39 @@ bool GenericHDF5Format::readVolume(h5::H5ReadWrite& reader,
   return true;
 }
 
-bool GenericHDF5Format::read(const std::string& fileName, vtkImageData* image,
-                             const QVariantMap& options)
+// The 3D datasets of a file, other than the levels of multiscale pyramids
+static std::vector<std::string> volumes(h5::H5ReadWrite& reader)
 {
-  Q_UNUSED(options)
-
-  using h5::H5ReadWrite;
-  H5ReadWrite::OpenMode mode = H5ReadWrite::OpenMode::ReadOnly;
-  H5ReadWrite reader(fileName.c_str(), mode);
-
-  // Find all 3D datasets. If there is more than one, have the user choose.
   std::vector<std::string> datasets = reader.allDataSets();
   for (auto it = datasets.begin(); it != datasets.end();) {
-    // Remove all non-3D datasets
     std::vector<int> dims = reader.getDimensions(*it);
-    if (dims.size() != 3)
-      datasets.erase(it);
+    if (dims.size() != 3 || it->find(MultiscaleGroup) != std::string::npos)
+      it = datasets.erase(it);
     else
       ++it;
   }
+  return datasets;
+}
 
-  if (datasets.empty()) {
-    std::cerr << "No 3D datasets found in " << fileName.c_str() << "\n";
-    return false;
-  }
-
-  std::string dataNode = datasets[0];
-
-  if (datasets.size() == 1) {
-    // Only one volume. Load and return.
-    if (readVolume(reader, dataNode, image)) {
-      GenericHDF5Format::reorderData(image, ReorderMode::CToFortran);
-      return true;
-    } else {
-      return false;
-    }
+// If there is more than one volume, have the user choose the ones to read,
+// unless the options already hold the choice. The chosen volumes are added
+// to the options as "dataSets". Returns false if the user cancels.
+static bool chooseVolumes(const std::vector<std::string>& datasets,
+                          QVariantMap& options)
+{
+  if (options.contains("dataSets")) {
+    return true;
   }
 
-  // If there is more than one volume, have the user choose.
   QStringList items;
   for (auto& d : datasets)
     items.append(QString::fromStdString(d));
 
+  if (items.size() <= 1) {
+    options["dataSets"] = items;
+    return true;
+  }
+
   // Choose the volumes to load
   QDialog dialog;
   dialog.setWindowTitle("Choose volumes");
@@ -561,47 +899,76 @@ bool GenericHDF5Format::read(const std::string& fileName, vtkImageData* image,
   }
 
   // Find the checked checkboxes
-  std::vector<std::string> selectedDatasets;
-  for (int i = 0; i < checkboxes.size(); ++i) {
-    if (checkboxes[i]->isChecked()) {
-      // Take advantage of the fact that the ordering is the same
-      selectedDatasets.push_back(datasets[i]);
+  QStringList selected;
+  for (auto* checkbox : checkboxes) {
+    if (checkbox->isChecked()) {
+      selected.append(checkbox->text());
     }
   }
 
-  if (selectedDatasets.empty()) {
+  if (selected.empty()) {
     QString msg = "At least one volume must be selected";
     std::cerr << msg.toStdString() << std::endl;
     QMessageBox::critical(nullptr, "Invalid Selection", msg);
     return false;
   }
 
-  // Read the first dataset with readVolume(). This might ask for
-  // subsampling options, which will be applied to the rest of the
-  // datasets.
-  if (!readVolume(reader, selectedDatasets[0], image)) {
-    auto msg =
-      QString("Failed to read the data at: ") + selectedDatasets[0].c_str();
-    std::cerr << msg.toStdString() << std::endl;
-    QMessageBox::critical(nullptr, "Read Failed", msg);
+  options["dataSets"] = selected;
+  return true;
+}
+
+bool GenericHDF5Format::askForReadOptions(const std::string& fileName,
+                                          QVariantMap& options)
+{
+  using h5::H5ReadWrite;
+  H5ReadWrite::OpenMode mode = H5ReadWrite::OpenMode::ReadOnly;
+  H5ReadWrite reader(fileName.c_str(), mode);
+
+  if (!chooseVolumes(volumes(reader), options)) {
     return false;
   }
 
-  // Set the name of the first array
-  auto activeName = selectedDatasets[0];
-  image->GetPointData()->GetScalars()->SetName(activeName.c_str());
+  QStringList selected = options["dataSets"].toStringList();
+  if (selected.empty()) {
+    // read() will report it
+    return true;
+  }
 
-  // Add any more datasets with addScalarArray()
-  for (size_t i = 1; i < selectedDatasets.size(); ++i) {
-    const auto& path = selectedDatasets[i];
-    if (!addScalarArray(reader, path, image, path)) {
-      auto msg = QString("Failed to read or add the data of: ") + path.c_str();
-      std::cerr << msg.toStdString() << std::endl;
-      QMessageBox::critical(nullptr, "Failure", msg);
-      return false;
-    }
+  // The subsample of the first volume applies to the rest of them
+  return askForSubsample(reader, selected[0].toStdString(), options);
+}
+
+bool GenericHDF5Format::read(const std::string& fileName, vtkImageData* image,
+                             const QVariantMap& options,
+                             const ReadProgress& progress)
+{
+  using h5::H5ReadWrite;
+  H5ReadWrite::OpenMode mode = H5ReadWrite::OpenMode::ReadOnly;
+  H5ReadWrite reader(fileName.c_str(), mode);
+
+  std::vector<std::string> datasets = volumes(reader);
+  if (datasets.empty()) {
+    std::cerr << "No 3D datasets found in " << fileName.c_str() << "\n";
+    return false;
   }
 
+  if (datasets.size() == 1) {
+    // Only one volume. Load it, re-ordered to Fortran, and return.
+    return readVolume(reader, datasets[0], image, options,
+                      ReorderMode::CToFortran, progress);
+  }
+
+  // If there is more than one volume, have the user choose, unless
+  // askForReadOptions() already did.
+  QVariantMap readOptions = options;
+  if (!chooseVolumes(datasets, readOptions)) {
+    return false;
+  }
+
+  std::vector<std::string> selectedDatasets;
+  for (const auto& path : readOptions["dataSets"].toStringList())
+    selectedDatasets.push_back(path.toStdString());
+
   // Look for some common places where there are angles, and
   // load in the angles if we find them.
   QVector<double> angles;
@@ -613,10 +980,49 @@ bool GenericHDF5Format::read(const std::string& fileName, vtkImageData* image,
     }
   }
 
-  if (angles.isEmpty()) {
-    // The data has not been re-ordered. Re-order to Fortran.
-    GenericHDF5Format::reorderData(image, ReorderMode::CToFortran);
-  } else {
+  // Tilt series keep the C ordering, their X and Z axes are relabeled
+  // instead. Anything else is re-ordered to Fortran while it is read.
+  auto reorder =
+    angles.isEmpty() ? ReorderMode::CToFortran : ReorderMode::None;
+
+  // Each volume is an equal share of the progress of the read
+  auto volumeProgress = [&progress, &selectedDatasets](size_t i) {
+    ReadProgress volume;
+    if (progress) {
+      double count = static_cast<double>(selectedDatasets.size());
+      volume = [&progress, i, count](double fraction) {
+        return progress((i + fraction) / count);
+      };
+    }
+    return volume;
+  };
+
+  // Read the first dataset with readVolume(). This might ask for
+  // subsampling options, which will be applied to the rest of the
+  // datasets.
+  if (!readVolume(reader, selectedDatasets[0], image, readOptions, reorder,
+                  volumeProgress(0))) {
+    std::cerr << "Failed to read the data at: " << selectedDatasets[0]
+              << std::endl;
+    return false;
+  }
+
+  // Set the name of the first array
+  auto activeName = selectedDatasets[0];
+  image->GetPointData()->GetScalars()->SetName(activeName.c_str());
+
+  // Add any more datasets with addScalarArray()
+  for (size_t i = 1; i < selectedDatasets.size(); ++i) {
+    const auto& path = selectedDatasets[i];
+    if (!addScalarArray(reader, path, image, path, reorder,
+                        volumeProgress(i))) {
+      std::cerr << "Failed to read or add the data of: " << path
+                << std::endl;
+      return false;
+    }
+  }
+
+  if (!angles.isEmpty()) {
     // No deep copying of the data needed. Just relabel the X and Z axes.
     relabelXAndZAxes(image);
     DataSource::setTiltAngles(image, angles);
@@ -627,10 +1033,51 @@ bool GenericHDF5Format::read(const std::string& fileName, vtkImageData* image,
   return true;
 }
 
+static h5::WriteOptions writeOptions(const QVariantMap& options,
+                                     h5::H5ReadWrite::DataType type,
+                                     const std::vector<int>& dims)
+{
+  using h5::H5ReadWrite;
+  auto writeOptions = H5ReadWrite::defaultWriteOptions(type, dims);
+
+  if (options.contains("compression")) {
+    bool ok;
+    auto name = options["compression"].toString().toStdString();
+    auto compression = H5ReadWrite::compressionFromString(name, &ok);
+    if (ok) {
+      writeOptions.compression = compression;
+    } else {
+      cerr << "Unknown compression: " << name << endl;
+    }
+  }
+  if (options.contains("compressionLevel")) {
+    writeOptions.compressionLevel = options["compressionLevel"].toInt();
+  }
+  if (options.contains("shuffle")) {
+    writeOptions.shuffle = options["shuffle"].toBool();
+  }
+  if (options.contains("chunkDimensions")) {
+    writeOptions.chunkDimensions.clear();
+    for (const auto& dim : options["chunkDimensions"].toList()) {
+      writeOptions.chunkDimensions.push_back(dim.toInt());
+    }
+  }
+
+  // Without compression, keep the default chunks only if asked to.
+  if (writeOptions.compression == h5::WriteOptions::Compression::None &&
+      !writeOptions.shuffle && !options.contains("chunkDimensions")) {
+    writeOptions.chunkDimensions.clear();
+  }
+
+  return writeOptions;
+}
+
 bool GenericHDF5Format::writeVolume(h5::H5ReadWrite& writer,
                                     const std::string& path,
                                     const std::string& name,
-                                    vtkImageData* image)
+                                    vtkImageData* image,
+                                    const QVariantMap& options,
+                                    ReorderMode reorder)
 {
   int dim[3];
   image->GetDimensions(dim);
@@ -640,7 +1087,70 @@ bool GenericHDF5Format::writeVolume(h5::H5ReadWrite& writer,
   h5::H5ReadWrite::DataType type =
     h5::H5VtkTypeMaps::VtkToDataType(arrayPtr->GetDataType());
 
-  return writer.writeData(path, name, dims, type, arrayPtr->GetVoidPointer(0));
+  auto h5Options = writeOptions(options, type, dims);
+  if (reorder == ReorderMode::FortranToC) {
+    // Settle the chunks now, so the slabs can be aligned with them
+    if (h5Options.isChunked() && h5Options.chunkDimensions.empty()) {
+      h5Options.chunkDimensions = h5::H5ReadWrite::guessChunkDimensions(
+        dims, h5::H5ReadWrite::dataTypeSize(type));
+    }
+    return writeCOrdered(writer, path, name, arrayPtr, dim, type, h5Options);
+  }
+
+  return writer.writeData(path, name, dims, type, arrayPtr->GetVoidPointer(0),
+                          h5Options);
+}
+
+std::string GenericHDF5Format::multiscalePath(const std::string& path,
+                                              int factor)
+{
+  auto slash = path.find_last_of('/');
+  auto parent = slash == std::string::npos ? "" : path.substr(0, slash);
+  return parent + "/" + MultiscaleGroup + "/" + std::to_string(factor);
+}
+
+std::vector<int> GenericHDF5Format::multiscaleFactors(h5::H5ReadWrite& reader,
+                                                      const std::string& path)
+{
+  std::vector<int> factors;
+  for (int factor = 2; reader.isDataSet(multiscalePath(path, factor));
+       factor *= 2) {
+    factors.push_back(factor);
+  }
+  return factors;
+}
+
+bool GenericHDF5Format::downsample(vtkImageData* in, vtkImageData* out)
+{
+  auto scalars = in->GetPointData()->GetScalars();
+  int inDim[3], outDim[3];
+  in->GetDimensions(inDim);
+  for (int i = 0; i < 3; ++i) {
+    outDim[i] = inDim[i] / 2;
+    if (outDim[i] < 1) {
+      return false;
+    }
+  }
+  if (!scalars || scalars->GetNumberOfComponents() != 1) {
+    return false;
+  }
+
+  double spacing[3];
+  in->GetSpacing(spacing);
+  out->SetDimensions(outDim);
+  out->SetOrigin(in->GetOrigin());
+  out->SetSpacing(2 * spacing[0], 2 * spacing[1], 2 * spacing[2]);
+  out->AllocateScalars(scalars->GetDataType(), 1);
+  out->GetPointData()->GetScalars()->SetName(scalars->GetName());
+
+  switch (scalars->GetDataType()) {
+    vtkTemplateMacro(
+      Downsample(static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)),
+                 static_cast<VTK_TT*>(out->GetScalarPointer()), inDim, outDim));
+    default:
+      return false;
+  }
+  return true;
 }
 
 } // namespace tomviz
@@ -4,7 +4,9 @@
 #ifndef tomvizGenericHDF5Format_h
 #define tomvizGenericHDF5Format_h
 
+#include <functional>
 #include <string>
+#include <vector>
 
 #include <QVariantMap>
 #include <QVector>
@@ -20,6 +22,7 @@ namespace tomviz {
 
 enum class ReorderMode
 {
+  None,
   FortranToC,
   CToFortran
 };
@@ -27,14 +30,44 @@ enum class ReorderMode
 class GenericHDF5Format
 {
 public:
+  /**
+   * Called while a volume is read with the fraction of it that has been
+   * read so far. Returning false cancels the read. It is called on the
+   * thread doing the read.
+   */
+  using ReadProgress = std::function<bool(double)>;
+
   // Check to see if the file looks like a data exchange file
   static bool isDataExchange(const std::string& fileName);
 
   // Check if the file looks like an FXI data set
   static bool isFxi(const std::string& fileName);
 
+  /**
+   * Read the 3D datasets of a file. If it has more than one, the user
+   * chooses the ones to read, unless askForReadOptions() already did.
+   *
+   * @param fileName The name of the file.
+   * @param data The vtkImageData where the volumes will be written.
+   * @param options The options for reading the volumes.
+   * @param progress Reports the progress of the read, and can cancel it.
+   * @return True on success, false on failure or if canceled.
+   */
   static bool read(const std::string& fileName, vtkImageData* data,
-                   const QVariantMap& options = QVariantMap());
+                   const QVariantMap& options = QVariantMap(),
+                   const ReadProgress& progress = ReadProgress());
+
+  /**
+   * Show the dialogs read() would, for the choice of volumes and of their
+   * subsample, so that the file can then be read without a GUI, such as
+   * on a worker thread. The choices are added to the options.
+   *
+   * @param fileName The name of the file.
+   * @param options The options for reading the file, updated in place.
+   * @return False if the user canceled, true otherwise.
+   */
+  static bool askForReadOptions(const std::string& fileName,
+                                QVariantMap& options);
 
   /**
    * Read angles from a path and return the angles. The dataset to be
@@ -50,18 +83,56 @@ public:
                                     const QVariantMap& options = QVariantMap());
 
   /**
-   * Read a volume and write it to a vtkImageData object. This function
-   * does not perform any memory re-ordering on the data.
+   * Show the subsample dialog for the volume at path if readVolume() would,
+   * so that the volume can then be read where there is no GUI, such as on a
+   * worker thread. The choices are added to the options, with
+   * "askForSubsample" set to false.
+   *
+   * @param reader A reader that has already opened the file of interest.
+   * @param path The path to the volume in the HDF5 file.
+   * @param options The options for reading the volume, updated in place.
+   * @return False if the user canceled, true otherwise.
+   */
+  static bool askForSubsample(h5::H5ReadWrite& reader, const std::string& path,
+                              QVariantMap& options);
+
+  /**
+   * Show the subsample dialog for a volume that isn't in an HDF5 file, such
+   * as a Zarr array, if readVolume() would for one of these dimensions. The
+   * options are the same, but such volumes can't be read lazily.
+   *
+   * @param dims The (x, y, z) dimensions of the volume.
+   * @param dataTypeSize The size in bytes of the values of the volume.
+   * @param options The options for reading the volume, updated in place.
+   * @return False if the user canceled, true otherwise.
+   */
+  static bool askForSubsample(const std::vector<int>& dims, int dataTypeSize,
+                              QVariantMap& options);
+
+  /**
+   * Read a volume and write it to a vtkImageData object. With
+   * ReorderMode::CToFortran the volume is re-ordered while it is read, a
+   * slab at a time, without a second copy of the whole volume.
+   *
+   * The "subsampleStrides" and "subsampleVolumeBounds" options select a
+   * subsample. Strided subsamples of chunked volumes are read a chunk at a
+   * time, with "subsampleAverage" each voxel is the mean of its stride
+   * block (binning) rather than the first voxel of it. Equal strides
+   * matching a level of a multiscale pyramid read that level instead.
    *
    * @param reader A reader that has already opened the file of interest.
    * @param path The path to the volume in the HDF5 file.
    * @param data The vtkImageData where the volume will be written.
    * @param options The options for reading the image data.
-   * @return True on success, false on failure.
+   * @param reorder ReorderMode::None or ReorderMode::CToFortran.
+   * @param progress Reports the progress of the read, and can cancel it.
+   * @return True on success, false on failure or if canceled.
    */
   static bool readVolume(h5::H5ReadWrite& reader, const std::string& path,
                          vtkImageData* data,
-                         const QVariantMap& options = QVariantMap());
+                         const QVariantMap& options = QVariantMap(),
+                         ReorderMode reorder = ReorderMode::None,
+                         const ReadProgress& progress = ReadProgress());
 
   /**
    * Add a dataset as a scalar array to pre-existing image data.
@@ -69,29 +140,69 @@ public:
    * image data. No memory re-ordering is performed on the data.
    *
    * If the original image was read using subsampling, the dataset to
-   * be added will be read using the same subsampling.
+   * be added will be read using the same subsampling. It is re-ordered
+   * the same way as readVolume() does.
    *
    * @param reader A reader that has already opened the file of interest.
    * @param path The path to the dataset to add as a scalar array.
    * @param image The vtkImageData where the scalar array will be added.
    * @param name The name to give to the scalar array.
-   * @return True on success, false on failure.
+   * @param reorder ReorderMode::None or ReorderMode::CToFortran.
+   * @param progress Reports the progress of the read, and can cancel it.
+   * @return True on success, false on failure or if canceled.
    */
   static bool addScalarArray(h5::H5ReadWrite& reader, const std::string& path,
-                             vtkImageData* image, const std::string& name);
+                             vtkImageData* image, const std::string& name,
+                             ReorderMode reorder = ReorderMode::None,
+                             const ReadProgress& progress = ReadProgress());
 
   /**
-   * Write a volume from a vtkImageData object to a path. No memory
-   * re-ordering is performed on the data.
+   * Write a volume from a vtkImageData object to a path. With
+   * ReorderMode::FortranToC the volume is re-ordered while it is written,
+   * a slab at a time, without a second copy of the whole volume.
+   *
+   * The dataset is chunked and compressed according to @p options:
+   * "compression" is one of "None", "Deflate", "Zstd" or "Blosc",
+   * "compressionLevel" an int, "shuffle" a bool and "chunkDimensions" a
+   * list of ints in the order of the dataset dimensions. Options that are
+   * not set are chosen from the type and size of the volume, see
+   * h5::H5ReadWrite::defaultWriteOptions().
    *
    * @param writer The writer that has already opened the file of interest.
    * @param path The path to the group where the data will be written.
    * @param name The name that the dataset will be given.
    * @param image The vtkImageData from which the volume will be written.
+   * @param options The storage options of the dataset.
+   * @param reorder ReorderMode::None or ReorderMode::FortranToC.
    * @return True on success, false on failure.
    */
   static bool writeVolume(h5::H5ReadWrite& writer, const std::string& path,
-                          const std::string& name, vtkImageData* image);
+                          const std::string& name, vtkImageData* image,
+                          const QVariantMap& options = QVariantMap(),
+                          ReorderMode reorder = ReorderMode::None);
+
+  /**
+   * The path of the level of the multiscale pyramid of a volume that is
+   * downsampled by factor. The levels are kept in a group next to the
+   * volume, and are read instead of the volume by readVolume() when the
+   * strides match one of them and the subsample is averaged.
+   */
+  static std::string multiscalePath(const std::string& path, int factor);
+
+  /**
+   * The downsampling factors (2, 4, ...) of the levels of the multiscale
+   * pyramid of the volume at path, empty if it has none.
+   */
+  static std::vector<int> multiscaleFactors(h5::H5ReadWrite& reader,
+                                            const std::string& path);
+
+  /**
+   * Downsample the active scalars of a volume by 2 along every axis,
+   * averaging blocks of 2 x 2 x 2 voxels.
+   *
+   * @return False if a dimension is smaller than 2.
+   */
+  static bool downsample(vtkImageData* in, vtkImageData* out);
 
   /**
    * Swap the X and Z axes for all scalars in the vtkImageData.
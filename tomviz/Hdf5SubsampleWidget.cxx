@@ -239,4 +239,32 @@ void Hdf5SubsampleWidget::strides(int s[3]) const
   m_internals->strides(s);
 }
 
+void Hdf5SubsampleWidget::setLazy(bool lazy)
+{
+  m_internals->ui.lazy->setChecked(lazy);
+}
+
+bool Hdf5SubsampleWidget::lazy() const
+{
+  return m_internals->ui.lazy->isChecked();
+}
+
+void Hdf5SubsampleWidget::setLazyAvailable(bool available)
+{
+  if (!available) {
+    m_internals->ui.lazy->setChecked(false);
+  }
+  m_internals->ui.lazy->setVisible(available);
+}
+
+void Hdf5SubsampleWidget::setAverage(bool average)
+{
+  m_internals->ui.average->setChecked(average);
+}
+
+bool Hdf5SubsampleWidget::average() const
+{
+  return m_internals->ui.average->isChecked();
+}
+
 } // namespace tomviz
@@ -26,6 +26,17 @@ public:
   void bounds(int bs[6]) const;
   void strides(int s[3]) const;
 
+  // Keep the subsample as a proxy, reading full resolution regions on demand
+  void setLazy(bool lazy);
+  bool lazy() const;
+
+  // Hide the lazy option, for volumes that can't be read lazily
+  void setLazyAvailable(bool available);
+
+  // Average the voxels of each stride block (binning) instead of sampling
+  void setAverage(bool average);
+  bool average() const;
+
 private slots:
   void valueChanged();
 
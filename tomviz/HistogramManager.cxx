@@ -3,6 +3,7 @@
 
 #include "HistogramManager.h"
 
+#include <vtkDataArray.h>
 #include <vtkFloatArray.h>
 #include <vtkImageData.h>
 #include <vtkPointData.h>
@@ -10,7 +11,9 @@
 #include <vtkUnsignedLongLongArray.h>
 
 #include "ComputeHistogram.h"
+#include "LazyVolume.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include <QCoreApplication>
@@ -18,11 +21,13 @@
 
 Q_DECLARE_METATYPE(vtkSmartPointer<vtkImageData>)
 Q_DECLARE_METATYPE(vtkSmartPointer<vtkTable>)
+Q_DECLARE_METATYPE(std::shared_ptr<tomviz::LazyVolume>)
 
 namespace {
 
 // This is just here for now - quick and dirty historgram calculations...
-void PopulateHistogram(vtkImageData* input, vtkTable* output)
+void PopulateHistogram(vtkImageData* input, vtkTable* output,
+                       tomviz::LazyVolume* lazy)
 {
   // The output table will have the twice the number of columns, they will be
   // the x and y for input column. This is the bin centers, and the population.
@@ -40,7 +45,24 @@ void PopulateHistogram(vtkImageData* input, vtkTable* output)
   }
 
   // The bin values are the centers, extending +/- half an inc either side
-  arrayPtr->GetFiniteRange(minmax, -1);
+  if (lazy) {
+    // The range of the full resolution volume, which the proxy may not reach
+    minmax[0] = VTK_DOUBLE_MAX;
+    minmax[1] = VTK_DOUBLE_MIN;
+    bool read = lazy->readBlocks([&minmax](vtkDataArray* block) {
+      double range[2];
+      block->GetFiniteRange(range, -1);
+      minmax[0] = std::min(minmax[0], range[0]);
+      minmax[1] = std::max(minmax[1], range[1]);
+      return true;
+    });
+    if (!read || minmax[0] > minmax[1]) {
+      lazy = nullptr;
+    }
+  }
+  if (!lazy) {
+    arrayPtr->GetFiniteRange(minmax, -1);
+  }
   if (minmax[0] == minmax[1]) {
     minmax[1] = minmax[0] + 1.0;
   }
@@ -71,21 +93,34 @@ void PopulateHistogram(vtkImageData* input, vtkTable* output)
     pops[k] = 0;
   }
   int invalid = 0;
-
-  switch (arrayPtr->GetDataType()) {
-    vtkTemplateMacro(tomviz::CalculateHistogram(
-      reinterpret_cast<VTK_TT*>(arrayPtr->GetVoidPointer(0)),
-      arrayPtr->GetNumberOfTuples(), arrayPtr->GetNumberOfComponents(),
-      minmax[0], minmax[1], pops, 1.0 / inc, invalid));
-    default:
-      std::cout << "UpdateFromFile: Unknown data type" << std::endl;
+  vtkIdType counted = 0;
+
+  auto count = [&](vtkDataArray* array) {
+    switch (array->GetDataType()) {
+      vtkTemplateMacro(tomviz::CalculateHistogram(
+        reinterpret_cast<VTK_TT*>(array->GetVoidPointer(0)),
+        array->GetNumberOfTuples(), array->GetNumberOfComponents(),
+        minmax[0], minmax[1], pops, 1.0 / inc, invalid));
+      default:
+        std::cout << "UpdateFromFile: Unknown data type" << std::endl;
+    }
+    counted += array->GetNumberOfTuples();
+    return true;
+  };
+
+  if (!lazy || !lazy->readBlocks(count)) {
+    // Start over from the proxy, whose values are in the range
+    std::fill(pops, pops + numberOfBins, 0);
+    invalid = 0;
+    counted = 0;
+    count(arrayPtr);
   }
 
 #ifndef NDEBUG
   vtkIdType total = invalid;
   for (int i = 0; i < numberOfBins; ++i)
     total += pops[i];
-  assert(total == arrayPtr->GetNumberOfTuples());
+  assert(total == counted);
 #endif
   if (invalid) {
     std::cout << "Warning: NaN or infinite value in dataset" << std::endl;
@@ -155,7 +190,8 @@ public:
 
 public slots:
   void makeHistogram(vtkSmartPointer<vtkImageData> input,
-                     vtkSmartPointer<vtkTable> output);
+                     vtkSmartPointer<vtkTable> output,
+                     std::shared_ptr<tomviz::LazyVolume> lazy);
 
   void makeHistogram2D(vtkSmartPointer<vtkImageData> input,
                        vtkSmartPointer<vtkImageData> output);
@@ -169,12 +205,13 @@ signals:
 };
 
 void HistogramMaker::makeHistogram(vtkSmartPointer<vtkImageData> input,
-                                   vtkSmartPointer<vtkTable> output)
+                                   vtkSmartPointer<vtkTable> output,
+                                   std::shared_ptr<LazyVolume> lazy)
 {
   // make the histogram and notify observers (the main thread) that it
   // is done.
   if (input && output) {
-    PopulateHistogram(input, output);
+    PopulateHistogram(input, output, lazy.get());
   }
   emit histogramDone(input, output);
 }
@@ -193,6 +230,7 @@ HistogramManager::HistogramManager()
 {
   qRegisterMetaType<vtkSmartPointer<vtkImageData>>();
   qRegisterMetaType<vtkSmartPointer<vtkTable>>();
+  qRegisterMetaType<std::shared_ptr<tomviz::LazyVolume>>();
 
   // Start the worker thread and give it ownership of the HistogramMaker
   // object. Also connect the HistogramMaker's signal to the histogramReady
@@ -238,7 +276,7 @@ HistogramManager& HistogramManager::instance()
 }
 
 vtkSmartPointer<vtkTable> HistogramManager::getHistogram(
-  vtkSmartPointer<vtkImageData> image)
+  vtkSmartPointer<vtkImageData> image, std::shared_ptr<LazyVolume> lazy)
 {
   if (m_histogramCache.contains(image)) {
     auto cachedTable = m_histogramCache[image];
@@ -263,7 +301,8 @@ vtkSmartPointer<vtkTable> HistogramManager::getHistogram(
   // gave here.
   QMetaObject::invokeMethod(m_histogramGen, "makeHistogram",
                             Q_ARG(vtkSmartPointer<vtkImageData>, imageSP),
-                            Q_ARG(vtkSmartPointer<vtkTable>, table));
+                            Q_ARG(vtkSmartPointer<vtkTable>, table),
+                            Q_ARG(std::shared_ptr<tomviz::LazyVolume>, lazy));
 
   // The histogram cannot be returned for use while the background thread is
   // populating it.
@@ -9,6 +9,8 @@
 
 #include <QMap>
 
+#include <memory>
+
 class QThread;
 
 class vtkImageData;
@@ -16,6 +18,7 @@ class vtkTable;
 
 namespace tomviz {
 class HistogramMaker;
+class LazyVolume;
 
 class HistogramManager : public QObject
 {
@@ -28,7 +31,12 @@ public:
 
   void finalize();
 
-  vtkSmartPointer<vtkTable> getHistogram(vtkSmartPointer<vtkImageData> image);
+  /// If image is the proxy of a lazily loaded volume, the histogram is
+  /// computed from the full resolution volume instead, in two passes over
+  /// the file: one for the range, and one for the counts.
+  vtkSmartPointer<vtkTable> getHistogram(
+    vtkSmartPointer<vtkImageData> image,
+    std::shared_ptr<LazyVolume> lazy = nullptr);
   vtkSmartPointer<vtkImageData> getHistogram2D(
     vtkSmartPointer<vtkImageData> image);
 
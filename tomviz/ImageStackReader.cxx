@@ -0,0 +1,126 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "ImageStackReader.h"
+
+#include "Utilities.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTIFFReader.h>
+
+#include <QApplication>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QProgressDialog>
+#include <QtConcurrent>
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+
+namespace tomviz {
+
+bool ImageStackReader::read(const QStringList& fileNames, vtkImageData* image)
+{
+  if (fileNames.isEmpty()) {
+    return false;
+  }
+
+  // The first file sets the dimensions and type of the stack
+  vtkNew<vtkTIFFReader> first;
+  first->SetFileName(fileNames[0].toLocal8Bit().constData());
+  first->Update();
+  auto* firstScalars = first->GetOutput()->GetPointData()->GetScalars();
+  if (!firstScalars) {
+    cerr << "Failed to read " << fileNames[0].toStdString() << endl;
+    return false;
+  }
+
+  int dims[3];
+  first->GetOutput()->GetDimensions(dims);
+  const int type = firstScalars->GetDataType();
+  const int components = firstScalars->GetNumberOfComponents();
+  const vtkIdType sliceTuples = firstScalars->GetNumberOfTuples();
+  const size_t sliceSize = static_cast<size_t>(sliceTuples) * components *
+                           firstScalars->GetDataTypeSize();
+  const int count = fileNames.size();
+
+  auto scalars = vtkSmartPointer<vtkDataArray>::Take(
+    vtkDataArray::CreateDataArray(type));
+  scalars->SetName(firstScalars->GetName());
+  scalars->SetNumberOfComponents(components);
+  scalars->SetNumberOfTuples(sliceTuples * count);
+  auto* out = static_cast<char*>(scalars->GetVoidPointer(0));
+  std::memcpy(out, firstScalars->GetVoidPointer(0), sliceSize);
+
+  // Each file is decoded by its own reader, then copied into its slices
+  std::atomic<bool> failed(false);
+  auto readFile = [&](int i) {
+    if (failed) {
+      return;
+    }
+    vtkNew<vtkTIFFReader> reader;
+    reader->SetFileName(fileNames[i].toLocal8Bit().constData());
+    reader->Update();
+    auto* output = reader->GetOutput();
+    auto* fileScalars = output->GetPointData()->GetScalars();
+    int fileDims[3];
+    output->GetDimensions(fileDims);
+    if (!fileScalars || fileScalars->GetDataType() != type ||
+        fileScalars->GetNumberOfComponents() != components ||
+        fileDims[0] != dims[0] || fileDims[1] != dims[1] ||
+        fileDims[2] != dims[2]) {
+      cerr << fileNames[i].toStdString()
+           << " does not match the first image of the stack" << endl;
+      failed = true;
+      return;
+    }
+    std::memcpy(out + i * sliceSize, fileScalars->GetVoidPointer(0),
+                sliceSize);
+  };
+
+  std::vector<int> indices(count - 1);
+  std::iota(indices.begin(), indices.end(), 1);
+  bool canceled = false;
+  if (!qobject_cast<QApplication*>(QCoreApplication::instance())) {
+    QtConcurrent::blockingMap(indices, readFile);
+  } else {
+    QProgressDialog dialog("Loading image stack...", "Cancel", 0, count - 1,
+                           tomviz::mainWidget());
+    dialog.setWindowModality(Qt::WindowModal);
+    dialog.setMinimumDuration(500);
+    dialog.setValue(0);
+
+    QEventLoop loop;
+    QFutureWatcher<void> watcher;
+    QObject::connect(&watcher, &QFutureWatcher<void>::progressValueChanged,
+                     &dialog, &QProgressDialog::setValue);
+    QObject::connect(&dialog, &QProgressDialog::canceled, &watcher,
+                     &QFutureWatcher<void>::cancel);
+    QObject::connect(&watcher, &QFutureWatcher<void>::finished, &loop,
+                     &QEventLoop::quit);
+    watcher.setFuture(QtConcurrent::map(indices, readFile));
+    loop.exec();
+    canceled = watcher.isCanceled();
+  }
+  if (failed || canceled) {
+    return false;
+  }
+
+  image->SetOrigin(first->GetOutput()->GetOrigin());
+  image->SetSpacing(first->GetOutput()->GetSpacing());
+  image->SetDimensions(dims[0], dims[1], dims[2] * count);
+  image->GetPointData()->SetScalars(scalars);
+  return true;
+}
+
+} // namespace tomviz
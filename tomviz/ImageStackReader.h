@@ -0,0 +1,28 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizImageStackReader_h
+#define tomvizImageStackReader_h
+
+#include <QStringList>
+
+class vtkImageData;
+
+namespace tomviz {
+
+/**
+ * Reads a stack of TIFF files into one image, in the order of the file names.
+ *
+ * The first file is read to size the image, then the others are decoded
+ * concurrently on the global thread pool and copied into their slices. Every
+ * file must have the same dimensions and type as the first one. With a GUI,
+ * progress is shown in a dialog that can cancel the read.
+ */
+class ImageStackReader
+{
+public:
+  static bool read(const QStringList& fileNames, vtkImageData* image);
+};
+} // namespace tomviz
+
+#endif // tomvizImageStackReader_h
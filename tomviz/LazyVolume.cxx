@@ -0,0 +1,399 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "LazyVolume.h"
+
+#include <h5cpp/h5readwrite.h>
+#include <h5cpp/h5vtktypemaps.h>
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Size of the blocks of contiguous data sets.
+const size_t BlockSize = 4 << 20;
+
+// Copy the part of a C ordered block that is inside the extent to the
+// Fortran ordered region. Everything is relative to the volume bounds, and
+// in tomviz order except blockStart/blockStrides.
+template <typename T>
+void copyBlock(const T* block, const int blockStart[3],
+               const size_t blockStrides[3], const int blockCounts[3],
+               T* region, const int extent[6])
+{
+  int lower[3], upper[3];
+  for (int i = 0; i < 3; ++i) {
+    lower[i] = std::max(extent[2 * i], blockStart[i]);
+    upper[i] = std::min(extent[2 * i + 1], blockStart[i] + blockCounts[i] - 1);
+    if (lower[i] > upper[i]) {
+      return;
+    }
+  }
+
+  const size_t nx = extent[1] - extent[0] + 1;
+  const size_t ny = extent[3] - extent[2] + 1;
+  for (int z = lower[2]; z <= upper[2]; ++z) {
+    for (int y = lower[1]; y <= upper[1]; ++y) {
+      T* out = region + ((z - extent[4]) * ny + (y - extent[2])) * nx +
+               (lower[0] - extent[0]);
+      const T* in = block + (z - blockStart[2]) * blockStrides[2] +
+                    (y - blockStart[1]) * blockStrides[1] +
+                    (lower[0] - blockStart[0]) * blockStrides[0];
+      if (blockStrides[0] == 1) {
+        std::copy(in, in + (upper[0] - lower[0] + 1), out);
+      } else {
+        for (int x = lower[0]; x <= upper[0]; ++x) {
+          *out++ = *in;
+          in += blockStrides[0];
+        }
+      }
+    }
+  }
+}
+} // namespace
+
+namespace tomviz {
+
+class LazyVolume::Internals
+{
+public:
+  Internals(const std::string& file, const std::string& path)
+    : reader(file), fileName(file), dataSetPath(path)
+  {
+  }
+
+  using Block = std::vector<char>;
+
+  // The file axis of the tomviz axis
+  int fileAxis(int axis) const { return reversedAxes ? 2 - axis : axis; }
+
+  const Block* block(const int index[3], int counts[3])
+  {
+    uint64_t key = 0;
+    for (int i = 0; i < 3; ++i) {
+      key = key * numberOfBlocks[i] + index[i];
+    }
+
+    size_t start[3], blockCounts[3];
+    for (int i = 0; i < 3; ++i) {
+      int first = index[i] * blockDims[i];
+      counts[i] = std::min(blockDims[i], dims[i] - first);
+      start[i] = static_cast<size_t>(offset[i] + first);
+      blockCounts[i] = static_cast<size_t>(counts[i]);
+    }
+
+    auto it = blocks.find(key);
+    if (it != blocks.end()) {
+      // Most recently used
+      lru.splice(lru.begin(), lru, it->second.first);
+      return &it->second.second;
+    }
+
+    Block data(blockCounts[0] * blockCounts[1] * blockCounts[2] *
+               elementSize);
+    if (!reader.readData(dataSetPath, type, data.data(), nullptr, start,
+                         blockCounts)) {
+      return nullptr;
+    }
+
+    lru.push_front(key);
+    cachedBytes += data.size();
+    auto& entry = blocks[key];
+    entry.first = lru.begin();
+    entry.second.swap(data);
+    evict();
+    return &entry.second;
+  }
+
+  void evict()
+  {
+    while (cachedBytes > cacheSize && lru.size() > 1) {
+      auto it = blocks.find(lru.back());
+      cachedBytes -= it->second.second.size();
+      blocks.erase(it);
+      lru.pop_back();
+    }
+  }
+
+  h5::H5ReadWrite reader;
+  std::string fileName;
+  std::string dataSetPath;
+  bool reversedAxes = false;
+  bool valid = false;
+  h5::H5ReadWrite::DataType type;
+  int vtkType = -1;
+  size_t elementSize = 0;
+
+  // In file dimension order
+  int offset[3] = { 0, 0, 0 };
+  int dims[3] = { 0, 0, 0 };
+  int blockDims[3] = { 1, 1, 1 };
+  int numberOfBlocks[3] = { 0, 0, 0 };
+
+  size_t cacheSize = size_t(1) << 30;
+  size_t cachedBytes = 0;
+  std::list<uint64_t> lru;
+  std::unordered_map<uint64_t, std::pair<std::list<uint64_t>::iterator, Block>>
+    blocks;
+  std::mutex mutex;
+};
+
+LazyVolume::LazyVolume(const std::string& fileName,
+                       const std::string& dataSetPath,
+                       const int volumeBounds[6], bool reversedAxes)
+  : m_internals(new Internals(fileName, dataSetPath))
+{
+  auto& d = *m_internals;
+  d.reversedAxes = reversedAxes;
+  if (!d.reader.isDataSet(dataSetPath)) {
+    std::cerr << "LazyVolume: " << dataSetPath << " is not a data set\n";
+    return;
+  }
+
+  auto fileDims = d.reader.getDimensions(dataSetPath);
+  if (fileDims.size() != 3) {
+    std::cerr << "LazyVolume: " << dataSetPath
+              << " does not have three dimensions\n";
+    return;
+  }
+
+  d.type = d.reader.dataType(dataSetPath);
+  d.vtkType = h5::H5VtkTypeMaps::dataTypeToVtk(d.type);
+  d.elementSize = h5::H5ReadWrite::dataTypeSize(d.type);
+  if (d.vtkType < 0 || d.elementSize == 0) {
+    return;
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    int begin = 0, end = fileDims[i];
+    if (volumeBounds && volumeBounds[2 * i] >= 0 &&
+        volumeBounds[2 * i + 1] > volumeBounds[2 * i]) {
+      begin = std::min(volumeBounds[2 * i], fileDims[i]);
+      end = std::min(volumeBounds[2 * i + 1], fileDims[i]);
+    }
+    d.offset[i] = begin;
+    d.dims[i] = std::max(0, end - begin);
+  }
+
+  // Use the chunks of the data set, so every chunk is only decompressed
+  // once, or blocks of about the same size otherwise.
+  std::vector<int> dims(d.dims, d.dims + 3);
+  auto chunks = d.reader.writeOptions(dataSetPath).chunkDimensions;
+  if (chunks.size() != 3) {
+    chunks = h5::H5ReadWrite::guessChunkDimensions(dims, d.elementSize,
+                                                    BlockSize);
+  }
+  for (int i = 0; i < 3; ++i) {
+    d.blockDims[i] = std::max(1, std::min(chunks[i], std::max(1, d.dims[i])));
+    d.numberOfBlocks[i] = (d.dims[i] + d.blockDims[i] - 1) / d.blockDims[i];
+  }
+
+  d.valid = true;
+}
+
+LazyVolume::~LazyVolume() = default;
+
+bool LazyVolume::isValid() const
+{
+  return m_internals->valid;
+}
+
+const std::string& LazyVolume::fileName() const
+{
+  return m_internals->fileName;
+}
+
+const std::string& LazyVolume::dataSetPath() const
+{
+  return m_internals->dataSetPath;
+}
+
+bool LazyVolume::reversedAxes() const
+{
+  return m_internals->reversedAxes;
+}
+
+void LazyVolume::dimensions(int dims[3]) const
+{
+  for (int i = 0; i < 3; ++i) {
+    dims[i] = m_internals->dims[m_internals->fileAxis(i)];
+  }
+}
+
+int LazyVolume::dataType() const
+{
+  return m_internals->vtkType;
+}
+
+size_t LazyVolume::size() const
+{
+  auto& d = *m_internals;
+  return static_cast<size_t>(d.dims[0]) * d.dims[1] * d.dims[2] *
+         d.elementSize;
+}
+
+void LazyVolume::setCacheSize(size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(m_internals->mutex);
+  m_internals->cacheSize = bytes;
+  m_internals->evict();
+}
+
+size_t LazyVolume::cacheSize() const
+{
+  std::lock_guard<std::mutex> lock(m_internals->mutex);
+  return m_internals->cacheSize;
+}
+
+size_t LazyVolume::cachedBytes() const
+{
+  std::lock_guard<std::mutex> lock(m_internals->mutex);
+  return m_internals->cachedBytes;
+}
+
+void LazyVolume::clearCache()
+{
+  std::lock_guard<std::mutex> lock(m_internals->mutex);
+  m_internals->blocks.clear();
+  m_internals->lru.clear();
+  m_internals->cachedBytes = 0;
+}
+
+bool LazyVolume::readRegion(const int extent[6], vtkImageData* image)
+{
+  auto& d = *m_internals;
+  if (!d.valid || !image) {
+    return false;
+  }
+
+  int dims[3];
+  dimensions(dims);
+  for (int i = 0; i < 3; ++i) {
+    if (extent[2 * i] < 0 || extent[2 * i + 1] >= dims[i] ||
+        extent[2 * i] > extent[2 * i + 1]) {
+      std::cerr << "LazyVolume: the extent is outside of the volume\n";
+      return false;
+    }
+  }
+
+  image->SetExtent(const_cast<int*>(extent));
+  auto scalars = vtkSmartPointer<vtkDataArray>::Take(
+    vtkDataArray::CreateDataArray(d.vtkType));
+  scalars->SetName("ImageScalars");
+  scalars->SetNumberOfTuples(static_cast<vtkIdType>(extent[1] - extent[0] + 1) *
+                             (extent[3] - extent[2] + 1) *
+                             (extent[5] - extent[4] + 1));
+  image->GetPointData()->SetScalars(scalars);
+
+  // The range of blocks covering the extent, in file dimension order
+  int firstBlock[3], lastBlock[3];
+  for (int i = 0; i < 3; ++i) {
+    int axis = d.fileAxis(i);
+    firstBlock[i] = extent[2 * axis] / d.blockDims[i];
+    lastBlock[i] = extent[2 * axis + 1] / d.blockDims[i];
+  }
+
+  std::lock_guard<std::mutex> lock(d.mutex);
+  int index[3];
+  for (index[0] = firstBlock[0]; index[0] <= lastBlock[0]; ++index[0]) {
+    for (index[1] = firstBlock[1]; index[1] <= lastBlock[1]; ++index[1]) {
+      for (index[2] = firstBlock[2]; index[2] <= lastBlock[2]; ++index[2]) {
+        int counts[3];
+        auto block = d.block(index, counts);
+        if (!block) {
+          std::cerr << "LazyVolume: failed to read from " << d.dataSetPath
+                    << "\n";
+          return false;
+        }
+
+        // Map the C ordered block to tomviz order
+        const size_t fileStrides[3] = { static_cast<size_t>(counts[1]) *
+                                          counts[2],
+                                        static_cast<size_t>(counts[2]), 1 };
+        int blockStart[3], blockCounts[3];
+        size_t blockStrides[3];
+        for (int i = 0; i < 3; ++i) {
+          int axis = d.fileAxis(i);
+          blockStart[i] = index[axis] * d.blockDims[axis];
+          blockCounts[i] = counts[axis];
+          blockStrides[i] = fileStrides[axis];
+        }
+
+        switch (d.vtkType) {
+          vtkTemplateMacro(
+            copyBlock(reinterpret_cast<const VTK_TT*>(block->data()),
+                      blockStart, blockStrides, blockCounts,
+                      static_cast<VTK_TT*>(scalars->GetVoidPointer(0)),
+                      extent));
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool LazyVolume::readSlice(int axis, int index, vtkImageData* image)
+{
+  if (axis < 0 || axis > 2) {
+    return false;
+  }
+
+  int dims[3];
+  dimensions(dims);
+  int extent[6] = { 0, dims[0] - 1, 0, dims[1] - 1, 0, dims[2] - 1 };
+  extent[2 * axis] = index;
+  extent[2 * axis + 1] = index;
+  return readRegion(extent, image);
+}
+
+bool LazyVolume::readBlocks(const std::function<bool(vtkDataArray*)>& visit)
+{
+  auto& d = *m_internals;
+  if (!d.valid) {
+    return false;
+  }
+
+  auto block = vtkSmartPointer<vtkDataArray>::Take(
+    vtkDataArray::CreateDataArray(d.vtkType));
+  int index[3];
+  for (index[0] = 0; index[0] < d.numberOfBlocks[0]; ++index[0]) {
+    for (index[1] = 0; index[1] < d.numberOfBlocks[1]; ++index[1]) {
+      for (index[2] = 0; index[2] < d.numberOfBlocks[2]; ++index[2]) {
+        size_t start[3], counts[3];
+        for (int i = 0; i < 3; ++i) {
+          int first = index[i] * d.blockDims[i];
+          start[i] = static_cast<size_t>(d.offset[i] + first);
+          counts[i] =
+            static_cast<size_t>(std::min(d.blockDims[i], d.dims[i] - first));
+        }
+
+        block->SetNumberOfTuples(
+          static_cast<vtkIdType>(counts[0] * counts[1] * counts[2]));
+        if (!d.reader.readData(d.dataSetPath, d.type,
+                               block->GetVoidPointer(0), nullptr, start,
+                               counts)) {
+          std::cerr << "LazyVolume: failed to read from " << d.dataSetPath
+                    << "\n";
+          return false;
+        }
+        if (!visit(block)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace tomviz
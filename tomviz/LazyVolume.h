@@ -0,0 +1,83 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizLazyVolume_h
+#define tomvizLazyVolume_h
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+class vtkDataArray;
+class vtkImageData;
+
+namespace tomviz {
+
+/// A 3D data set of an HDF5 file that is only read on demand, so volumes
+/// larger than memory can be browsed. Regions are assembled from blocks
+/// (the chunks of the data set, or blocks of a similar size if it is
+/// contiguous) kept in a least recently used cache of bounded size.
+///
+/// Indices and extents are in tomviz order, relative to the start of the
+/// volume bounds. The data set is C ordered on disk: for volumes the tomviz
+/// axes are the file dimensions in the same order, for tilt series (whose X
+/// and Z axes are relabeled on read) they are in the reverse order.
+class LazyVolume
+{
+public:
+  /// volumeBounds are [start, end) pairs in file dimension order, as in the
+  /// HDF5 subsample settings. nullptr, or negative values, select the whole
+  /// data set.
+  LazyVolume(const std::string& fileName, const std::string& dataSetPath,
+             const int volumeBounds[6] = nullptr, bool reversedAxes = false);
+  ~LazyVolume();
+
+  LazyVolume(const LazyVolume&) = delete;
+  LazyVolume& operator=(const LazyVolume&) = delete;
+
+  /// False if the data set could not be opened, or is not 3D.
+  bool isValid() const;
+
+  const std::string& fileName() const;
+  const std::string& dataSetPath() const;
+  bool reversedAxes() const;
+
+  /// Full resolution dimensions, in tomviz order.
+  void dimensions(int dims[3]) const;
+
+  /// The VTK type of the data set.
+  int dataType() const;
+
+  /// Size in bytes of the full resolution volume.
+  size_t size() const;
+
+  /// Upper limit of the memory used by the cached blocks, 1 GiB by default.
+  /// At least one block is always kept.
+  void setCacheSize(size_t bytes);
+  size_t cacheSize() const;
+  size_t cachedBytes() const;
+  void clearCache();
+
+  /// Read the region of the (inclusive) extent at full resolution. image is
+  /// given the extent and single component scalars named "ImageScalars".
+  /// Safe to call from any thread.
+  bool readRegion(const int extent[6], vtkImageData* image);
+
+  /// Read a whole slice, normal to axis, at full resolution.
+  bool readSlice(int axis, int index, vtkImageData* image);
+
+  /// Call visit with each block of the volume in turn, e.g. to compute
+  /// statistics of the whole volume. The blocks are read without going
+  /// through the cache, and their values are in file order. Returns false if
+  /// a read fails, or visit returns false to stop. Safe to call from any
+  /// thread.
+  bool readBlocks(const std::function<bool(vtkDataArray*)>& visit);
+
+private:
+  class Internals;
+  std::unique_ptr<Internals> m_internals;
+};
+} // namespace tomviz
+
+#endif
@@ -6,12 +6,14 @@
 #include "ActiveObjects.h"
 #include "DataExchangeFormat.h"
 #include "DataSource.h"
+#include "DmFormat.h"
 #include "EmdFormat.h"
 #include "FileFormatManager.h"
 #include "FxiFormat.h"
 #include "GenericHDF5Format.h"
 #include "ImageStackDialog.h"
 #include "ImageStackModel.h"
+#include "ImageStackReader.h"
 #include "LoadStackReaction.h"
 #include "ModuleManager.h"
 #include "MoleculeSource.h"
@@ -20,7 +22,9 @@
 #include "PythonReader.h"
 #include "PythonUtilities.h"
 #include "RAWFileReaderDialog.h"
+#include "RawFormat.h"
 #include "RecentFilesMenu.h"
+#include "SerFormat.h"
 #include "TimeSeriesStep.h"
 #include "Utilities.h"
 #include "vtkOMETiffReader.h"
@@ -40,7 +44,9 @@
 #include <vtkSMStringVectorProperty.h>
 #include <vtkSMViewProxy.h>
 
+#include <vtkDataArray.h>
 #include <vtkImageData.h>
+#include <vtkImageReader2.h>
 #include <vtkMolecule.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
@@ -53,9 +59,14 @@
 #include <QDebug>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QFutureWatcher>
 #include <QJsonArray>
 #include <QMessageBox>
+#include <QProgressDialog>
+#include <QPromise>
+#include <QtConcurrent>
 
+#include <algorithm>
 #include <sstream>
 
 namespace {
@@ -96,6 +107,131 @@ bool hasData(vtkSMProxy* reader)
   }
   return true;
 }
+
+// The volume of a raw image reader, with its values mapped from the file.
+// nullptr if the reader is configured in a way that needs it to read them.
+vtkSmartPointer<vtkImageData> mapRawImage(vtkSMProxy* reader)
+{
+  if (QString(reader->GetXMLName()) != "TVRawImageReader" ||
+      vtkSMPropertyHelper(reader, "FileDimensionality").GetAsInt() != 3 ||
+      vtkSMPropertyHelper(reader, "FileLowerLeft").GetAsInt() == 0) {
+    return nullptr;
+  }
+
+  int extent[6];
+  vtkSMPropertyHelper(reader, "DataExtent").Get(extent, 6);
+  if (extent[0] != 0 || extent[2] != 0 || extent[4] != 0) {
+    return nullptr;
+  }
+
+  int dims[3] = { extent[1] + 1, extent[3] + 1, extent[5] + 1 };
+  int type = vtkSMPropertyHelper(reader, "DataScalarType").GetAsInt();
+  int components =
+    vtkSMPropertyHelper(reader, "NumberOfScalarComponents").GetAsInt();
+  bool bigEndian = vtkSMPropertyHelper(reader, "DataByteOrder").GetAsInt() ==
+                   VTK_FILE_BYTE_ORDER_BIG_ENDIAN;
+  std::string fileName =
+    vtkSMPropertyHelper(reader, "FilePrefix").GetAsString();
+
+  auto image = vtkSmartPointer<vtkImageData>::New();
+  if (!tomviz::RawFormat::read(fileName, type, components, dims, bigEndian,
+                               image)) {
+    return nullptr;
+  }
+
+  double origin[3], spacing[3];
+  vtkSMPropertyHelper(reader, "DataOrigin").Get(origin, 3);
+  vtkSMPropertyHelper(reader, "DataSpacing").Get(spacing, 3);
+  image->SetOrigin(origin);
+  image->SetSpacing(spacing);
+  image->GetPointData()->GetScalars()->SetName(
+    vtkSMPropertyHelper(reader, "ScalarArrayName").GetAsString());
+  return image;
+}
+
+bool isOmeTiff(const QFileInfo& info)
+{
+  return info.completeSuffix().endsWith("ome.tif");
+}
+
+// Zarr stores are directories, they can also be opened from their metadata
+bool isZarr(const QFileInfo& info)
+{
+  static const QStringList metadata = { "zarr.json", ".zarray", ".zgroup",
+                                        ".zattrs" };
+  if (info.suffix().toLower() == "zarr" ||
+      metadata.contains(info.fileName())) {
+    return true;
+  }
+
+  return info.isDir() &&
+         std::any_of(metadata.cbegin(), metadata.cend(),
+                     [&info](const QString& name) {
+                       return QFileInfo::exists(info.filePath() + "/" + name);
+                     });
+}
+
+// Whether readImage() can read the file
+bool canReadImage(const QFileInfo& info)
+{
+  return QStringList({ "emd", "dm3", "dm4", "ser" })
+           .contains(info.suffix().toLower()) ||
+         isOmeTiff(info);
+}
+
+// Whether the file is an HDF5 file that GenericHDF5Format reads, rather
+// than one of the HDF5 formats that are read into a data source.
+bool isGenericHDF5(const QFileInfo& info)
+{
+  if (info.suffix().toLower() != "h5") {
+    return false;
+  }
+
+  bool generic = false;
+  tomviz::runWithHDF5Lock([&]() {
+    auto fileName = info.filePath().toStdString();
+    generic = !tomviz::GenericHDF5Format::isDataExchange(fileName) &&
+              !tomviz::GenericHDF5Format::isFxi(fileName);
+  });
+  return generic;
+}
+
+// Read the formats that need no GUI, on any thread. nullptr on failure.
+// Generic HDF5 files also need the options chosen by
+// GenericHDF5Format::askForReadOptions(). The EMD and HDF5 reads report
+// their progress, and stop if it returns false.
+vtkSmartPointer<vtkImageData> readImage(
+  const QString& fileName, const QVariantMap& options,
+  const tomviz::GenericHDF5Format::ReadProgress& progress =
+    tomviz::GenericHDF5Format::ReadProgress())
+{
+  QFileInfo info(fileName);
+  auto suffix = info.suffix().toLower();
+  auto image = vtkSmartPointer<vtkImageData>::New();
+  bool success = false;
+  if (suffix == "emd") {
+    tomviz::runWithHDF5Lock([&]() {
+      success = tomviz::EmdFormat::read(fileName.toStdString(), image, options,
+                                        progress);
+    });
+  } else if (suffix == "h5") {
+    tomviz::runWithHDF5Lock([&]() {
+      success = tomviz::GenericHDF5Format::read(fileName.toStdString(), image,
+                                                options, progress);
+    });
+  } else if (suffix == "ser") {
+    success = tomviz::SerFormat::read(fileName.toStdString(), image);
+  } else if (suffix == "dm3" || suffix == "dm4") {
+    success = tomviz::DmFormat::read(fileName.toStdString(), image);
+  } else if (isOmeTiff(info)) {
+    vtkNew<tomviz::vtkOMETiffReader> reader;
+    reader->SetFileName(fileName.toLocal8Bit().constData());
+    reader->Update();
+    image->ShallowCopy(reader->GetOutput());
+    success = image->GetPointData()->GetScalars() != nullptr;
+  }
+  return success ? image : nullptr;
+}
 } // namespace
 
 namespace tomviz {
@@ -116,7 +252,7 @@ QList<DataSource*> LoadDataReaction::loadData(bool isTimeSeries)
   QStringList filters;
   filters << "Common file types (*.emd *.jpg *.jpeg *.png *.tiff *.tif *.h5 "
              "*.raw *.dat *.bin *.txt *.mhd *.mha *.vti *.mrc *.st *.rec *.ali "
-             "*.xmf *.xdmf)"
+             "*.xmf *.xdmf *.dm3 *.dm4 *.ser *.zarr zarr.json .zarray .zattrs)"
           << "EMD (*.emd)"
           << "JPeg Image files (*.jpg *.jpeg)"
           << "PNG Image files (*.png)"
@@ -128,6 +264,7 @@ QList<DataSource*> LoadDataReaction::loadData(bool isTimeSeries)
           << "VTK ImageData Files (*.vti)"
           << "MRC files (*.mrc *.st *.rec *.ali)"
           << "XDMF files (*.xmf *.xdmf)"
+          << "Zarr stores (*.zarr zarr.json .zarray .zgroup .zattrs)"
           << "Molecule files (*.xyz)"
           << "Text files (*.txt)";
 
@@ -164,6 +301,20 @@ QList<DataSource*> LoadDataReaction::loadData(bool isTimeSeries)
     loadMolecule(filenames);
   } else {
     for (auto f : filenames) {
+      // Formats that allow it are read concurrently, in the background
+      if (!isTimeSeries && canLoadDataAsync(f, options)) {
+        if (auto* dataSource = loadDataAsync(f, options)) {
+          dataSources << dataSource;
+        }
+        continue;
+      }
+      // The steps of a time series after the first are read when they are
+      // shown, if their format can be read without a GUI
+      if (isTimeSeries && !dataSources.isEmpty() && dataSources[0] &&
+          canReadImage(QFileInfo(f))) {
+        dataSources << nullptr;
+        continue;
+      }
       dataSources << loadData(f, options);
       if (isTimeSeries) {
         // After loading the first data source in a time series, don't
@@ -178,12 +329,36 @@ QList<DataSource*> LoadDataReaction::loadData(bool isTimeSeries)
     std::vector<double> times;
     QList<TimeSeriesStep> timeSteps;
 
+    // Read the steps with the subsample of the first one, so that they all
+    // have the same dimensions.
+    QVariantMap stepOptions = { { "askForSubsample", false } };
+    if (!dataSources.isEmpty() && dataSources[0] &&
+        dataSources[0]->wasSubsampled()) {
+      int strides[3];
+      int bs[6];
+      dataSources[0]->subsampleStrides(strides);
+      dataSources[0]->subsampleVolumeBounds(bs);
+      stepOptions["subsampleStrides"] =
+        QVariantList({ strides[0], strides[1], strides[2] });
+      stepOptions["subsampleVolumeBounds"] =
+        QVariantList({ bs[0], bs[1], bs[2], bs[3], bs[4], bs[5] });
+      stepOptions["subsampleAverage"] = dataSources[0]->subsampleAverage();
+    }
+    TimeSeriesStep::Reader reader = [stepOptions](const QString& f) {
+      return readImage(f, stepOptions);
+    };
     for (auto i = 0; i < dataSources.size(); ++i) {
-      QString label = dataSources[i]->label();
-      auto* image = dataSources[i]->imageData();
       double time = i;
-
       times.push_back(time);
+
+      if (!dataSources[i]) {
+        QString label = QFileInfo(filenames[i]).baseName();
+        timeSteps.append(TimeSeriesStep(label, filenames[i], reader, time));
+        continue;
+      }
+
+      QString label = dataSources[i]->label();
+      auto* image = dataSources[i]->imageData();
       timeSteps.append(TimeSeriesStep(label, image, time));
 
       if (i != 0) {
@@ -231,9 +406,6 @@ DataSource* LoadDataReaction::loadData(const QStringList& fileNames,
                                        const QJsonObject& options)
 {
   bool defaultModules = options["defaultModules"].toBool(true);
-  bool addToRecent = options["addToRecent"].toBool(true);
-  bool addToPipeline = options["addToPipeline"].toBool(true);
-  bool createCameraOrbit = options["createCameraOrbit"].toBool(true);
   bool child = options["child"].toBool(false);
   bool loadWithParaview = true;
   bool loadWithPython = false;
@@ -244,6 +416,11 @@ DataSource* LoadDataReaction::loadData(const QStringList& fileNames,
     fileName = fileNames[0];
   }
   QFileInfo info(fileName);
+  if (info.fileName() == "zarr.json") {
+    // Zarr v3 stores are read from their directory, e.g. "image.zarr"
+    fileName = info.absolutePath();
+    info.setFile(fileName);
+  }
   if (info.suffix().toLower() == "tvh5") {
     // Need to specify a path inside the tvh5 file to load
     QString path = options["tvh5NodePath"].toString();
@@ -256,8 +433,12 @@ DataSource* LoadDataReaction::loadData(const QStringList& fileNames,
     // Do not prompt the user for subsample settings
     QVariantMap emdOptions = { { "askForSubsample", false } };
     vtkNew<vtkImageData> image;
-    if (EmdFormat::readNode(fileName.toStdString(), path.toStdString(), image,
-                            emdOptions)) {
+    bool success = false;
+    runWithHDF5Lock([&]() {
+      success = EmdFormat::readNode(fileName.toStdString(),
+                                    path.toStdString(), image, emdOptions);
+    });
+    if (success) {
       DataSource::DataSourceType type = DataSource::hasTiltAngles(image)
                                           ? DataSource::TiltSeries
                                           : DataSource::Volume;
@@ -276,9 +457,18 @@ DataSource* LoadDataReaction::loadData(const QStringList& fileNames,
         options["subsampleSettings"].toObject()["strides"].toVariant();
       emdOptions["subsampleVolumeBounds"] =
         options["subsampleSettings"].toObject()["volumeBounds"].toVariant();
+      emdOptions["lazy"] =
+        options["subsampleSettings"].toObject()["lazy"].toBool(false);
+      emdOptions["subsampleAverage"] =
+        options["subsampleSettings"].toObject()["average"].toBool(false);
       emdOptions["askForSubsample"] = false;
     }
-    if (EmdFormat::read(fileName.toLatin1().data(), imageData, emdOptions)) {
+    bool success = false;
+    runWithHDF5Lock([&]() {
+      success =
+        EmdFormat::read(fileName.toLatin1().data(), imageData, emdOptions);
+    });
+    if (success) {
       DataSource::DataSourceType type = DataSource::hasTiltAngles(imageData)
                                           ? DataSource::TiltSeries
                                           : DataSource::Volume;
@@ -293,34 +483,113 @@ DataSource* LoadDataReaction::loadData(const QStringList& fileNames,
         options["subsampleSettings"].toObject()["strides"].toVariant();
       hdf5Options["subsampleVolumeBounds"] =
         options["subsampleSettings"].toObject()["volumeBounds"].toVariant();
+      hdf5Options["lazy"] =
+        options["subsampleSettings"].toObject()["lazy"].toBool(false);
+      hdf5Options["subsampleAverage"] =
+        options["subsampleSettings"].toObject()["average"].toBool(false);
       hdf5Options["askForSubsample"] = false;
     }
-    // Check if it looks like data exchange
-    if (GenericHDF5Format::isDataExchange(fileName.toStdString())) {
-      dataSource = new DataSource(info.completeBaseName());
-      DataExchangeFormat format;
-      if (!format.read(fileName.toLatin1().data(), dataSource, hdf5Options)) {
-        delete dataSource;
-        return nullptr;
+    bool failed = false;
+    runWithHDF5Lock([&]() {
+      // Check if it looks like data exchange
+      if (GenericHDF5Format::isDataExchange(fileName.toStdString())) {
+        dataSource = new DataSource(info.completeBaseName());
+        DataExchangeFormat format;
+        if (!format.read(fileName.toLatin1().data(), dataSource,
+                         hdf5Options)) {
+          delete dataSource;
+          dataSource = nullptr;
+        }
+      } else if (GenericHDF5Format::isFxi(fileName.toStdString())) {
+        dataSource = new DataSource(info.completeBaseName());
+        FxiFormat format;
+        if (!format.read(fileName.toLatin1().data(), dataSource,
+                         hdf5Options)) {
+          delete dataSource;
+          dataSource = nullptr;
+        }
+      } else if (GenericHDF5Format::askForReadOptions(fileName.toStdString(),
+                                                      hdf5Options)) {
+        vtkNew<vtkImageData> imageData;
+        if (GenericHDF5Format::read(fileName.toStdString(), imageData,
+                                    hdf5Options)) {
+          DataSource::DataSourceType type =
+            DataSource::hasTiltAngles(imageData) ? DataSource::TiltSeries
+                                                 : DataSource::Volume;
+          dataSource = new DataSource(imageData, type);
+        } else {
+          failed = true;
+        }
       }
-    } else if (GenericHDF5Format::isFxi(fileName.toStdString())) {
-      dataSource = new DataSource(info.completeBaseName());
-      FxiFormat format;
-      if (!format.read(fileName.toLatin1().data(), dataSource, hdf5Options)) {
-        delete dataSource;
-        return nullptr;
+    });
+    if (failed) {
+      QMessageBox::critical(tomviz::mainWidget(), "Read Failed",
+                            QString("Failed to read %1").arg(fileName));
+    }
+    if (!dataSource) {
+      return nullptr;
+    }
+  } else if (isZarr(info)) {
+    loadWithParaview = false;
+    auto factory = FileFormatManager::instance().pythonReaderFactory("zarr");
+    if (factory == nullptr) {
+      qCritical() << "The Zarr reader isn't available";
+      return nullptr;
+    }
+    auto reader = factory->createReader();
+
+    QVariantMap zarrOptions;
+    if (options.contains("subsampleSettings")) {
+      zarrOptions["subsampleStrides"] =
+        options["subsampleSettings"].toObject()["strides"].toVariant();
+      zarrOptions["subsampleVolumeBounds"] =
+        options["subsampleSettings"].toObject()["volumeBounds"].toVariant();
+      zarrOptions["subsampleAverage"] =
+        options["subsampleSettings"].toObject()["average"].toBool(false);
+      zarrOptions["askForSubsample"] = false;
+    }
+    int dims[3];
+    int size;
+    if (reader.volumeInfo(fileName, dims, size) &&
+        !GenericHDF5Format::askForSubsample({ dims[0], dims[1], dims[2] },
+                                            size, zarrOptions)) {
+      return nullptr;
+    }
+
+    // The Python reader takes the settings as they are saved in the state
+    QVariantMap readOptions;
+    if (zarrOptions.contains("subsampleStrides")) {
+      QVariantMap settings;
+      settings["strides"] = zarrOptions["subsampleStrides"];
+      settings["volumeBounds"] = zarrOptions["subsampleVolumeBounds"];
+      settings["average"] = zarrOptions["subsampleAverage"];
+      readOptions["subsampleSettings"] = settings;
+    }
+    auto imageData = reader.read(fileName, readOptions);
+    if (imageData == nullptr) {
+      return nullptr;
+    }
+
+    if (readOptions.contains("subsampleSettings")) {
+      // Keep the settings, so that they are saved with the state
+      int strides[3];
+      int bs[6];
+      auto list = zarrOptions["subsampleStrides"].toList();
+      for (int i = 0; i < 3; ++i) {
+        strides[i] = i < list.size() ? std::max(list[i].toInt(), 1) : 1;
       }
-    } else {
-      vtkNew<vtkImageData> imageData;
-      GenericHDF5Format hdf5Format;
-      if (!hdf5Format.read(fileName.toLatin1().data(), imageData, hdf5Options))
-        return nullptr;
-      DataSource::DataSourceType type = DataSource::hasTiltAngles(imageData)
-                                          ? DataSource::TiltSeries
-                                          : DataSource::Volume;
-      dataSource = new DataSource(imageData, type);
+      list = zarrOptions["subsampleVolumeBounds"].toList();
+      for (int i = 0; i < 6; ++i) {
+        bs[i] = i < list.size() ? list[i].toInt() : -1;
+      }
+      DataSource::setWasSubsampled(imageData, true);
+      DataSource::setSubsampleStrides(imageData, strides);
+      DataSource::setSubsampleVolumeBounds(imageData, bs);
+      DataSource::setSubsampleAverage(
+        imageData, zarrOptions["subsampleAverage"].toBool());
     }
-  } else if (info.completeSuffix().endsWith("ome.tif")) {
+    dataSource = new DataSource(imageData);
+  } else if (isOmeTiff(info)) {
     loadWithParaview = false;
     vtkNew<vtkOMETiffReader> reader;
     reader->SetFileName(fileName.toLocal8Bit().constData());
@@ -331,6 +600,34 @@ DataSource* LoadDataReaction::loadData(const QStringList& fileNames,
     QJsonObject readerProperties;
     readerProperties["name"] = "OMETIFFReader";
     dataSource->setReaderProperties(readerProperties.toVariantMap());
+  } else if (fileNames.size() > 1 &&
+             QStringList({ "tif", "tiff" }).contains(info.suffix().toLower()) &&
+             options["reader"].toObject()["name"].toString(
+               "TIFFSeriesReader") == "TIFFSeriesReader") {
+    // Read stacks of TIFF files in parallel rather than with ParaView
+    loadWithParaview = false;
+    vtkNew<vtkImageData> imageData;
+    if (!ImageStackReader::read(fileNames, imageData)) {
+      return nullptr;
+    }
+    dataSource = new DataSource(imageData);
+    QJsonObject readerProperties = options["reader"].toObject();
+    readerProperties["name"] = "TIFFSeriesReader";
+    dataSource->setReaderProperties(readerProperties.toVariantMap());
+  } else if (QStringList({ "dm3", "dm4", "ser" })
+               .contains(info.suffix().toLower())) {
+    // Read with the native readers, or the Python ones if they fail
+    loadWithParaview = false;
+    vtkNew<vtkImageData> imageData;
+    bool success = info.suffix().toLower() == "ser"
+                     ? SerFormat::read(fileName.toStdString(), imageData)
+                     : DmFormat::read(fileName.toStdString(), imageData);
+    if (success) {
+      dataSource = new DataSource(imageData);
+    } else if (FileFormatManager::instance().pythonReaderFactory(
+                 info.suffix().toLower()) != nullptr) {
+      loadWithPython = true;
+    }
   } else if (FileFormatManager::instance().pythonReaderFactory(
                info.suffix().toLower()) != nullptr) {
     loadWithParaview = false;
@@ -389,7 +686,7 @@ DataSource* LoadDataReaction::loadData(const QStringList& fileNames,
     auto factory = FileFormatManager::instance().pythonReaderFactory(ext);
     Q_ASSERT(factory != nullptr);
     auto reader = factory->createReader();
-    auto imageData = reader.read(fileNames[0]);
+    auto imageData = reader.read(fileName);
     if (imageData == nullptr) {
       return nullptr;
     }
@@ -402,6 +699,118 @@ DataSource* LoadDataReaction::loadData(const QStringList& fileNames,
     return nullptr;
   }
 
+  addLoadedData(dataSource, fileNames, options);
+  return dataSource;
+}
+
+bool LoadDataReaction::canLoadDataAsync(const QString& fileName,
+                                        const QJsonObject& options)
+{
+  QFileInfo info(fileName);
+  return !options.contains("subsampleSettings") &&
+         (canReadImage(info) || isGenericHDF5(info));
+}
+
+DataSource* LoadDataReaction::loadDataAsync(const QString& fileName,
+                                            const QJsonObject& options)
+{
+  QFileInfo info(fileName);
+  auto suffix = info.suffix().toLower();
+
+  // Any dialogs are shown now, so the read itself needs no GUI
+  QVariantMap readOptions;
+  bool accepted = true;
+  if (suffix == "emd") {
+    runWithHDF5Lock([&]() {
+      accepted =
+        EmdFormat::askForSubsample(fileName.toStdString(), readOptions);
+    });
+  } else if (suffix == "h5") {
+    runWithHDF5Lock([&]() {
+      accepted = GenericHDF5Format::askForReadOptions(fileName.toStdString(),
+                                                      readOptions);
+    });
+  }
+  if (!accepted) {
+    return nullptr;
+  }
+
+  // The data source gets its data, and is added to the pipeline, when the
+  // read finishes. It is deleted if the read fails or is canceled.
+  auto* dataSource = new DataSource();
+  dataSource->setFileNames({ fileName });
+
+  // The HDF5 reads report their progress and stop when canceled. The other
+  // readers can't, a canceled read finishes in the background and its data
+  // is dropped.
+  bool hasProgress = suffix == "emd" || suffix == "h5";
+  auto* dialog = new QProgressDialog(
+    QString("Loading %1...").arg(info.fileName()), "Cancel", 0,
+    hasProgress ? 100 : 0, tomviz::mainWidget());
+  dialog->setWindowModality(Qt::NonModal);
+  dialog->setMinimumDuration(500);
+
+  using Image = vtkSmartPointer<vtkImageData>;
+  using ImageWatcher = QFutureWatcher<Image>;
+  auto* watcher = new ImageWatcher(dialog);
+  connect(watcher, &ImageWatcher::progressValueChanged, dialog,
+          &QProgressDialog::setValue);
+  connect(dialog, &QProgressDialog::canceled, watcher, &ImageWatcher::cancel);
+  connect(watcher, &ImageWatcher::finished, dialog, [=]() {
+    dialog->deleteLater();
+    if (watcher->isCanceled()) {
+      dataSource->deleteLater();
+      return;
+    }
+
+    Image image = watcher->result();
+    if (!image) {
+      dataSource->deleteLater();
+      if (!hasProgress && !isOmeTiff(info)) {
+        // The Python readers may still read it
+        loadData(fileName, options);
+      } else {
+        QMessageBox::critical(tomviz::mainWidget(), "Read Failed",
+                              QString("Failed to read %1").arg(fileName));
+      }
+      return;
+    }
+
+    DataSource::DataSourceType type = DataSource::hasTiltAngles(image)
+                                        ? DataSource::TiltSeries
+                                        : DataSource::Volume;
+    dataSource->setData(image);
+    dataSource->ensureActiveArray();
+    dataSource->setType(type);
+    if (isOmeTiff(info)) {
+      QJsonObject readerProperties;
+      readerProperties["name"] = "OMETIFFReader";
+      dataSource->setReaderProperties(readerProperties.toVariantMap());
+    }
+    addLoadedData(dataSource, { fileName }, options);
+  });
+  watcher->setFuture(
+    QtConcurrent::run([fileName, readOptions](QPromise<Image>& promise) {
+      promise.setProgressRange(0, 100);
+      auto progress = [&promise](double fraction) {
+        promise.setProgressValue(static_cast<int>(100 * fraction));
+        return !promise.isCanceled();
+      };
+      promise.addResult(readImage(fileName, readOptions, progress));
+    }));
+  return dataSource;
+}
+
+void LoadDataReaction::addLoadedData(DataSource* dataSource,
+                                     const QStringList& fileNames,
+                                     const QJsonObject& options)
+{
+  bool defaultModules = options["defaultModules"].toBool(true);
+  bool addToRecent = options["addToRecent"].toBool(true);
+  bool addToPipeline = options["addToPipeline"].toBool(true);
+  bool createCameraOrbit = options["createCameraOrbit"].toBool(true);
+  bool child = options["child"].toBool(false);
+
   if (addToPipeline) {
     // Add to the pipeline if needed...
     LoadDataReaction::dataSourceAdded(dataSource, defaultModules, child,
@@ -415,7 +824,6 @@ DataSource* LoadDataReaction::loadData(const QStringList& fileNames,
   if (addToRecent && dataSource) {
     RecentFilesMenu::pushDataReader(dataSource);
   }
-  return dataSource;
 }
 
 DataSource* LoadDataReaction::createDataSource(vtkSMProxy* reader,
@@ -441,16 +849,20 @@ DataSource* LoadDataReaction::createDataSource(vtkSMProxy* reader,
   if (QString(reader->GetXMLName()) == "TIFFSeriesReader" ||
       hasVisibleWidgets == false || dialog->exec() == QDialog::Accepted) {
 
-    if (!hasData(reader)) {
-      qCritical() << "Error: failed to load file!";
-      return nullptr;
-    }
+    // Raw volumes are mapped into memory rather than read, when possible
+    vtkSmartPointer<vtkImageData> image = mapRawImage(reader);
+    if (!image) {
+      if (!hasData(reader)) {
+        qCritical() << "Error: failed to load file!";
+        return nullptr;
+      }
 
-    auto source = vtkSMSourceProxy::SafeDownCast(reader);
-    source->UpdatePipeline();
-    auto algo = vtkAlgorithm::SafeDownCast(source->GetClientSideObject());
-    auto data = algo->GetOutputDataObject(0);
-    auto image = vtkImageData::SafeDownCast(data);
+      auto source = vtkSMSourceProxy::SafeDownCast(reader);
+      source->UpdatePipeline();
+      auto algo = vtkAlgorithm::SafeDownCast(source->GetClientSideObject());
+      auto data = algo->GetOutputDataObject(0);
+      image = vtkImageData::SafeDownCast(data);
+    }
     DataSource::DataSourceType type = DataSource::hasTiltAngles(image)
                                         ? DataSource::TiltSeries
                                         : DataSource::Volume;
@@ -31,6 +31,8 @@ public:
   LoadDataReaction(QAction* parentAction);
   ~LoadDataReaction() override;
 
+  /// Ask for files to load. Files that are loaded asynchronously are not in
+  /// the returned list, their data sources are added when they are read.
   static QList<DataSource*> loadData(bool isTimeSeries = false);
 
   /// Convenience method, adds defaultModules, addToRecent, and child to the
@@ -51,6 +53,21 @@ public:
   static DataSource* loadData(const QStringList& fileNames,
                               const QJsonObject& options = QJsonObject());
 
+  /// Whether loadDataAsync() can load a data file: its format can be read
+  /// without a GUI (EMD, generic HDF5, DM3/DM4, SER and OME-TIFF) and no
+  /// subsample is given in the options.
+  static bool canLoadDataAsync(const QString& fileName,
+                               const QJsonObject& options = QJsonObject());
+
+  /// Load a data file on a worker thread, so the application stays
+  /// responsive and several files can load at once. Any dialogs, such as
+  /// the subsample one, are shown first. A progress dialog can cancel the
+  /// load. The returned data source gets its data, and is added with its
+  /// default modules, when the read finishes, it is deleted if the read
+  /// fails or is canceled. Returns nullptr if a dialog was canceled.
+  static DataSource* loadDataAsync(const QString& fileName,
+                                   const QJsonObject& options = QJsonObject());
+
   static QList<MoleculeSource*> loadMolecule(
     const QStringList& fileNames, const QJsonObject& options = QJsonObject());
   static MoleculeSource* loadMolecule(
@@ -75,6 +92,9 @@ private:
   Q_DISABLE_COPY(LoadDataReaction)
 
   static void addDefaultModules(DataSource* dataSource);
+  static void addLoadedData(DataSource* dataSource,
+                            const QStringList& fileNames,
+                            const QJsonObject& options);
   static QJsonObject readerProperties(vtkSMProxy* reader);
   static void setFileNameProperties(const QJsonObject& props,
                                     vtkSMProxy* reader);
@@ -60,6 +60,9 @@ DataSource* LoadStackReaction::execStackDialog(ImageStackDialog& dialog)
       return nullptr;
     }
     DataSource* dataSource = LoadDataReaction::loadData(fNames);
+    if (!dataSource) {
+      return nullptr;
+    }
     DataSource::DataSourceType stackType = dialog.getStackType();
     bool imageViewerMode = dialog.getImageViewerMode();
     if (stackType == DataSource::DataSourceType::TiltSeries) {
@@ -115,8 +118,12 @@ QList<ImageInfo> LoadStackReaction::loadTiffStack(const QStringList& fileNames)
     i++;
     consistent = true;
     reader->SetFileName(file.toLatin1().data());
-    reader->Update();
-    reader->GetOutput()->GetDimensions(dims);
+    // Only the header is needed for the dimensions
+    reader->UpdateInformation();
+    int* extent = reader->GetDataExtent();
+    for (int j = 0; j < 3; ++j) {
+      dims[j] = extent[2 * j + 1] - extent[2 * j] + 1;
+    }
     if (n == -1 && m == -1) {
       n = dims[0];
       m = dims[1];
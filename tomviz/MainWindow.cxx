@@ -27,6 +27,7 @@
 #include "Behaviors.h"
 #include "CameraReaction.h"
 #include "Connection.h"
+#include "CrossCorrelationAlignReaction.h"
 #include "DataBroker.h"
 #include "DataBrokerLoadReaction.h"
 #include "DataBrokerSaveReaction.h"
@@ -316,6 +317,8 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
   alignmentLabel->setEnabled(false);
   QAction* autoAlignCCAction = m_ui->menuTomography->addAction(
     "Image Alignment (Auto: Cross Correlation)");
+  QAction* autoAlignCC_CAction = m_ui->menuTomography->addAction(
+    "Image Alignment (Auto: Cross Correlation, C++)");
   QAction* autoAlignCOMAction =
     m_ui->menuTomography->addAction("Image Alignment (Auto: Center of Mass)");
   QAction* autoAlignPyStackRegAction =
@@ -421,6 +424,7 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
     autoAlignCCAction, "Auto Tilt Image Align (XCORR)",
     readInPythonScript("AutoCrossCorrelationTiltImageAlignment"), false, false,
     false, readInJSONDescription("AutoCrossCorrelationTiltImageAlignment"));
+  new CrossCorrelationAlignReaction(autoAlignCC_CAction);
   new AddPythonTransformReaction(
     autoAlignCOMAction, "Auto Tilt Image Align (CoM)",
     readInPythonScript("AutoCenterOfMassTiltImageAlignment"), false, false,
@@ -951,9 +955,12 @@ void MainWindow::saveState()
   }
 
   // Write to a temporary file, or directly to the recent state
-  // file if it does not exist for some reason.
+  // file if it does not exist for some reason. Tvh5 files are saved in
+  // place: their modified data sources are written next to the ones they
+  // replace and linked in with moves that are undone if one fails. A full
+  // rewrite goes through a temporary file.
   QString writeFile = mostRecentFile;
-  if (QFile::exists(writeFile)) {
+  if (QFile::exists(writeFile) && QFileInfo(writeFile).suffix() != "tvh5") {
     // This will almost certainly be true
     // We need to keep the extension
     QFileInfo info(writeFile);
@@ -964,8 +971,8 @@ void MainWindow::saveState()
 
   // Write the state file
   if (!SaveLoadStateReaction::saveState(writeFile, false)) {
-    // Clean-up and return
-    if (QFile::exists(writeFile))
+    // Clean-up and return, the original file is left as it is
+    if (writeFile != mostRecentFile && QFile::exists(writeFile))
       QFile::remove(writeFile);
 
     QString msg = "Failed to save the state file";
@@ -0,0 +1,137 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "MappedFile.h"
+
+#include <vtkAbstractArray.h>
+#include <vtkDataArray.h>
+
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// The files of the arrays mapped by mapArray(), by the address of the values
+std::mutex MappingsMutex;
+
+std::unordered_map<void*, std::unique_ptr<QFile>>& mappings()
+{
+  static std::unordered_map<void*, std::unique_ptr<QFile>> files;
+  return files;
+}
+
+// The free function of the mapped arrays
+void unmap(void* address)
+{
+  std::unique_ptr<QFile> file;
+  {
+    std::lock_guard<std::mutex> lock(MappingsMutex);
+    auto it = mappings().find(address);
+    if (it == mappings().end()) {
+      return;
+    }
+    file = std::move(it->second);
+    mappings().erase(it);
+  }
+  file->unmap(static_cast<uchar*>(address));
+}
+
+} // namespace
+
+namespace tomviz {
+
+MappedFile::MappedFile(const QString& fileName) : m_file(fileName)
+{
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    std::cerr << "Failed to open " << fileName.toStdString() << std::endl;
+    return;
+  }
+
+  m_size = m_file.size();
+  if (m_size == 0) {
+    return;
+  }
+
+  m_mapped = m_file.map(0, m_size);
+  if (m_mapped) {
+    m_data = m_mapped;
+    return;
+  }
+
+  // Some file systems can not be mapped
+  m_buffer = m_file.readAll();
+  if (m_buffer.size() == m_size) {
+    m_data = reinterpret_cast<const uchar*>(m_buffer.constData());
+  }
+}
+
+MappedFile::~MappedFile()
+{
+  if (m_mapped) {
+    m_file.unmap(m_mapped);
+  }
+}
+
+vtkSmartPointer<vtkDataArray> mapArray(const QString& fileName, qint64 offset,
+                                       int vtkType, vtkIdType numberOfValues)
+{
+  auto array = vtkSmartPointer<vtkDataArray>::Take(
+    vtkDataArray::CreateDataArray(vtkType));
+  if (!array || numberOfValues <= 0) {
+    return nullptr;
+  }
+
+  auto valueSize = array->GetDataTypeSize();
+  if (offset < 0 || offset % valueSize != 0) {
+    return nullptr;
+  }
+
+  auto file = std::make_unique<QFile>(fileName);
+  qint64 bytes = numberOfValues * valueSize;
+  if (!file->open(QIODevice::ReadOnly) || offset + bytes > file->size()) {
+    return nullptr;
+  }
+
+  auto* values = file->map(offset, bytes, QFileDevice::MapPrivateOption);
+  if (!values) {
+    return nullptr;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(MappingsMutex);
+    mappings()[values] = std::move(file);
+  }
+  array->SetVoidArray(values, numberOfValues, 0,
+                      vtkAbstractArray::VTK_DATA_ARRAY_USER_DEFINED);
+  array->SetArrayFreeFunction(unmap);
+  return array;
+}
+
+vtkSmartPointer<vtkDataArray> readArray(const QString& fileName, qint64 offset,
+                                        int vtkType, vtkIdType numberOfValues)
+{
+  auto array = vtkSmartPointer<vtkDataArray>::Take(
+    vtkDataArray::CreateDataArray(vtkType));
+  if (!array || numberOfValues <= 0) {
+    return nullptr;
+  }
+
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly) || !file.seek(offset)) {
+    std::cerr << "Failed to open " << fileName.toStdString() << std::endl;
+    return nullptr;
+  }
+
+  array->SetNumberOfValues(numberOfValues);
+  qint64 bytes = numberOfValues * array->GetDataTypeSize();
+  if (file.read(static_cast<char*>(array->GetVoidPointer(0)), bytes) !=
+      bytes) {
+    std::cerr << "Failed to read " << fileName.toStdString() << std::endl;
+    return nullptr;
+  }
+  return array;
+}
+
+} // namespace tomviz
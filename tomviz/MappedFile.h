@@ -0,0 +1,56 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizMappedFile_h
+#define tomvizMappedFile_h
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+class vtkDataArray;
+
+namespace tomviz {
+
+/// A read only view of a whole file, memory mapped if possible and read into
+/// memory otherwise. Used to parse file headers without copying them.
+class MappedFile
+{
+public:
+  explicit MappedFile(const QString& fileName);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool isValid() const { return m_data != nullptr; }
+  const uchar* data() const { return m_data; }
+  qint64 size() const { return m_size; }
+
+private:
+  QFile m_file;
+  QByteArray m_buffer;
+  uchar* m_mapped = nullptr;
+  const uchar* m_data = nullptr;
+  qint64 m_size = 0;
+};
+
+/// Map numberOfValues values of vtkType, stored in native byte order at
+/// offset in a file, into a new single component array without reading them.
+/// The mapping is private, copy on write, so the array can be modified like
+/// any other, and pages of the file are only read when they are accessed.
+/// The mapping is released with the array. Returns nullptr if the file can
+/// not be mapped or the values are not aligned in it.
+vtkSmartPointer<vtkDataArray> mapArray(const QString& fileName, qint64 offset,
+                                       int vtkType, vtkIdType numberOfValues);
+
+/// Read the values into a new array instead, for when mapArray() fails.
+vtkSmartPointer<vtkDataArray> readArray(const QString& fileName, qint64 offset,
+                                        int vtkType, vtkIdType numberOfValues);
+
+} // namespace tomviz
+
+#endif
@@ -15,15 +15,42 @@
 #include "Utilities.h"
 
 #include <QMetaEnum>
+#include <QPointer>
 
 #include <pqApplicationCore.h>
 #include <pqSettings.h>
 #include <pqView.h>
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
 #include <vtkSMViewProxy.h>
 #include <vtkTrivialProducer.h>
 
 namespace tomviz {
 
+namespace {
+
+// Stacks slices of the same shape and type along z
+vtkSmartPointer<vtkImageData> stackSlices(
+  const QList<vtkSmartPointer<vtkImageData>>& slices)
+{
+  auto stack = vtkSmartPointer<vtkImageData>::New();
+  stack->DeepCopy(slices.first());
+  int extent[6];
+  stack->GetExtent(extent);
+  auto scalars = stack->GetPointData()->GetScalars();
+  for (int i = 1; i < slices.size(); ++i) {
+    auto sliceScalars = slices[i]->GetPointData()->GetScalars();
+    scalars->InsertTuples(scalars->GetNumberOfTuples(),
+                          sliceScalars->GetNumberOfTuples(), 0, sliceScalars);
+    extent[5] += slices[i]->GetDimensions()[2];
+  }
+  stack->SetExtent(extent);
+
+  return stack;
+}
+
+} // namespace
+
 PipelineSettings::PipelineSettings()
 {
   m_settings = pqApplicationCore::instance()->settings();
@@ -102,6 +129,11 @@ Pipeline::Pipeline(DataSource* dataSource, QObject* parent) : QObject(parent)
   PipelineSettings settings;
   auto executor = settings.executionMode();
   setExecutionMode(executor);
+
+  // Queued, so that the finished job's results are in place and the executor
+  // is idle.
+  connect(this, &Pipeline::finished, this, &Pipeline::executeQueuedAppended,
+          Qt::QueuedConnection);
 }
 
 Pipeline::~Pipeline() = default;
@@ -321,6 +353,8 @@ Pipeline::Future* Pipeline::executeRange(DataSource* ds, Operator* start,
     }
   }
 
+  // If only a subsample of the volume was loaded, the executor reads the
+  // whole volume for the operators, on a worker thread.
   auto branchFuture =
     m_executor->execute(ds->dataObject(), operators, startIndex, endIndex);
   connect(branchFuture, &Pipeline::Future::finished, this,
@@ -339,6 +373,145 @@ Pipeline::Future* Pipeline::executeRange(DataSource* ds, Operator* start,
   return pipelineFuture;
 }
 
+Pipeline::Future* Pipeline::executeAppended(DataSource* ds,
+                                            vtkImageData* slices)
+{
+  if (paused()) {
+    return emptyFuture();
+  }
+
+  if (ds == nullptr) {
+    ds = m_data;
+  }
+
+  auto operators = ds->operators();
+  if (operators.isEmpty() || slices == nullptr) {
+    return emptyFuture();
+  }
+
+  // Cancelling the current job to run the slices would transform the whole
+  // volume again, they are transformed once it has finished instead.
+  if (isRunning()) {
+    m_appendedSlices.append(qMakePair(QPointer<DataSource>(ds),
+                                      vtkSmartPointer<vtkImageData>(slices)));
+    return emptyFuture();
+  }
+
+  int dims[3];
+  slices->GetDimensions(dims);
+  if (!canExecuteAppended(ds, dims[2])) {
+    // Some operator needs the whole volume
+    return executeRange(ds, operators.first(), nullptr, true);
+  }
+
+  emit started();
+
+  QPointer<DataSource> input = ds;
+  QPointer<DataSource> output = operators.last()->childDataSource();
+  auto future = m_executor->execute(slices, operators);
+  connect(
+    future, &Pipeline::Future::finished, this,
+    [this, future, input, output]() {
+      auto ops = future->operators();
+      bool appended = !ops.isEmpty() && ops.last()->isCompleted() && output &&
+                      output->appendSlice(future->result(), false);
+      // Slice local operators keep the angle of each slice
+      if (appended && input && input->hasTiltAngles()) {
+        output->setTiltAngles(input->getTiltAngles());
+      }
+      emit finished();
+
+      // The transformed slices didn't fit, transform the whole volume instead
+      if (!appended && input && !input->operators().isEmpty()) {
+        executeRange(input, input->operators().first(), nullptr, true)
+          ->deleteWhenFinished();
+      }
+    });
+
+  return future;
+}
+
+void Pipeline::executeQueuedAppended()
+{
+  if (m_appendedSlices.isEmpty() || isRunning()) {
+    return;
+  }
+
+  // The slices queued for the first data source are transformed together, any
+  // others wait for the next job to finish.
+  auto ds = m_appendedSlices.first().first;
+  QList<vtkSmartPointer<vtkImageData>> queued;
+  for (auto itr = m_appendedSlices.begin(); itr != m_appendedSlices.end();) {
+    if (itr->first == ds) {
+      queued.append(itr->second);
+      itr = m_appendedSlices.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+  if (ds == nullptr || ds->operators().isEmpty()) {
+    executeQueuedAppended();
+    return;
+  }
+
+  // The job that just finished may have transformed some of the slices
+  // already, only those the output is missing are transformed.
+  auto output = ds->operators().last()->childDataSource();
+  auto inputData = vtkImageData::SafeDownCast(ds->dataObject());
+  auto outputData =
+    output ? vtkImageData::SafeDownCast(output->dataObject()) : nullptr;
+  if (inputData && outputData) {
+    int missing =
+      inputData->GetDimensions()[2] - outputData->GetDimensions()[2];
+    int depth = 0;
+    for (auto& slices : queued) {
+      depth += slices->GetDimensions()[2];
+    }
+    while (!queued.isEmpty() &&
+           depth - queued.first()->GetDimensions()[2] >= missing) {
+      depth -= queued.takeFirst()->GetDimensions()[2];
+    }
+  }
+  if (queued.isEmpty()) {
+    executeQueuedAppended();
+    return;
+  }
+
+  executeAppended(ds, stackSlices(queued))->deleteWhenFinished();
+}
+
+bool Pipeline::canExecuteAppended(DataSource* ds, int appendedSlices)
+{
+  if (m_operatorsDeleted || beingEdited(ds)) {
+    return false;
+  }
+
+  auto operators = ds->operators();
+  for (auto op : operators) {
+    if (!op->isSliceLocal() || !op->isCompleted() || op->isModified() ||
+        op->hasBreakpoint() || op->hasChildDataSource()) {
+      return false;
+    }
+  }
+
+  // The transformed data must be the end of the pipeline, and hold every
+  // slice from before the append.
+  auto output = operators.last()->childDataSource();
+  if (output == nullptr || !output->operators().isEmpty()) {
+    return false;
+  }
+  auto inputData = vtkImageData::SafeDownCast(ds->dataObject());
+  auto outputData = vtkImageData::SafeDownCast(output->dataObject());
+  if (inputData == nullptr || outputData == nullptr) {
+    return false;
+  }
+  int inputDims[3], outputDims[3];
+  inputData->GetDimensions(inputDims);
+  outputData->GetDimensions(outputDims);
+
+  return outputDims[2] + appendedSlices == inputDims[2];
+}
+
 void Pipeline::startedEditingOp(Operator* op)
 {
   ++m_editingOperators;
@@ -12,6 +12,8 @@
 #include <QFileSystemWatcher>
 #include <QLocalServer>
 #include <QLocalSocket>
+#include <QPair>
+#include <QPointer>
 #include <QProcess>
 #include <QScopedPointer>
 #include <QSettings>
@@ -110,6 +112,13 @@ public slots:
   /// returned Future instance needs to be cleaned up. deleteWhenFinished() can
   /// be called to ensure its cleanup when the pipeline execution is finished.
   Future* execute(DataSource* dataSource, Operator* start, Operator* end);
+  /// Execute the pipeline for slices that have been appended to the given
+  /// data source. If every operator is slice local only the new slices are
+  /// transformed, and appended to the transformed data source, otherwise the
+  /// whole pipeline is executed. Slices appended while the pipeline is running
+  /// are queued, and executed together once it has finished. Note the returned
+  /// Future instance needs to be cleaned up, as with execute().
+  Future* executeAppended(DataSource* dataSource, vtkImageData* slices);
 
   /// The user has started/finished editing an operator
   void startedEditingOp(Operator* op);
@@ -132,6 +141,7 @@ signals:
 
 private slots:
   void branchFinished();
+  void executeQueuedAppended();
 
 private:
   DataSource* findTransformedDataSource(DataSource* dataSource);
@@ -141,6 +151,7 @@ private:
   void addDataSource(DataSource* dataSource);
   bool beingEdited(DataSource* dataSource) const;
   bool isModified(DataSource* dataSource, Operator** firstModified) const;
+  bool canExecuteAppended(DataSource* dataSource, int appendedSlices);
   Future* executeRange(DataSource* ds, Operator* start, Operator* end,
                        bool checkBreakpoints);
 
@@ -150,6 +161,9 @@ private:
   QScopedPointer<PipelineExecutor> m_executor;
   ExecutionMode m_executionMode = Threaded;
   int m_editingOperators = 0;
+  // Slices appended while the pipeline was running
+  QList<QPair<QPointer<DataSource>, vtkSmartPointer<vtkImageData>>>
+    m_appendedSlices;
 };
 
 /// Return from getCopyOfImagePriorTo for caller to track async operation.
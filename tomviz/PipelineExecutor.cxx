@@ -17,14 +17,18 @@
 #include "Utilities.h"
 
 #include <QDir>
+#include <QEventLoop>
 #include <QFile>
 #include <QFileInfo>
+#include <QFutureWatcher>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMessageBox>
 #include <QMetaEnum>
+#include <QProgressDialog>
 #include <QTimer>
+#include <QtConcurrent>
 
 #include <pqApplicationCore.h>
 #include <pqSettings.h>
@@ -53,6 +57,37 @@ bool PipelineExecutor::cancel(Operator* op)
   return false;
 }
 
+namespace {
+
+// Read the full resolution volume of a lazily loaded data source on the
+// thread pool, while a progress dialog blocks the input.
+vtkSmartPointer<vtkImageData> readFullResolution(
+  const std::function<bool(vtkImageData*)>& reader)
+{
+  auto image = vtkSmartPointer<vtkImageData>::New();
+  QProgressDialog dialog("Reading the full resolution volume...", QString(),
+                         0, 0, tomviz::mainWidget());
+  dialog.setWindowTitle("Tomviz");
+  dialog.setWindowModality(Qt::ApplicationModal);
+  dialog.setMinimumDuration(0);
+  dialog.show();
+
+  QEventLoop loop;
+  QFutureWatcher<bool> watcher;
+  QObject::connect(&watcher, &QFutureWatcher<bool>::finished, &loop,
+                   &QEventLoop::quit);
+  watcher.setFuture(
+    QtConcurrent::run([&reader, image]() { return reader(image); }));
+  loop.exec();
+
+  if (!watcher.result()) {
+    return nullptr;
+  }
+  return image;
+}
+
+} // namespace
+
 class ExternalPipelineFuture : public Pipeline::Future
 {
 public:
@@ -114,19 +149,49 @@ Pipeline::Future* ExternalPipelineExecutor::execute(vtkDataObject* data,
   stateFile.write(QJsonDocument(state).toJson());
   stateFile.close();
 
+  // Only a subsample of a lazily loaded volume is in memory, the operators
+  // run on the full resolution volume instead.
+  vtkSmartPointer<vtkImageData> fullResolution;
+  auto root = pipeline()->dataSource();
+  if (root && data == root->dataObject()) {
+    auto reader = root->fullResolutionReader();
+    if (reader) {
+      fullResolution = readFullResolution(reader);
+      if (!fullResolution) {
+        displayError("Read Error",
+                     "Unable to read the full resolution volume.");
+        return Pipeline::emptyFuture();
+      }
+      data = fullResolution;
+    }
+  }
+
   // Write data to EMD or DataExchange
   auto dataFilePath = QDir(workingDir()).filePath(origFileName);
   if (origFileName.endsWith("emd")) {
     auto imageData = vtkImageData::SafeDownCast(data);
-    if (!EmdFormat::write(dataFilePath.toLatin1().data(), imageData)) {
+    // The file is read right back by the external pipeline, compressing it
+    // or adding a multiscale pyramid would only slow down the exchange.
+    QVariantMap options = { { "compression", "None" },
+                            { "multiscaleLevels", 0 } };
+    bool written = false;
+    runWithHDF5Lock([&]() {
+      written =
+        EmdFormat::write(dataFilePath.toLatin1().data(), imageData, options);
+    });
+    if (!written) {
       displayError("Write Error",
                    QString("Unable to write data at: %1").arg(dataFilePath));
       return Pipeline::emptyFuture();
     }
   } else {
     DataExchangeFormat dxfFile;
-    if (!dxfFile.write(dataFilePath.toLatin1().data(),
-        pipeline()->dataSource())) {
+    bool written = false;
+    runWithHDF5Lock([&]() {
+      written = dxfFile.write(dataFilePath.toLatin1().data(),
+                              pipeline()->dataSource(), fullResolution);
+    });
+    if (!written) {
       displayError("Write Error",
                    QString("Unable to write data at: %1").arg(dataFilePath));
       return Pipeline::emptyFuture();
@@ -177,8 +242,12 @@ Pipeline::Future* ExternalPipelineExecutor::execute(vtkDataObject* data,
               vtkImageData::SafeDownCast(transformedData.Get());
             // Make sure we don't ask the user about subsampling
             QVariantMap options = { { "askForSubsample", false } };
-            if (EmdFormat::read(transformedFilePath.toLatin1().data(),
-                                transformedImageData, options)) {
+            bool read = false;
+            runWithHDF5Lock([&]() {
+              read = EmdFormat::read(transformedFilePath.toLatin1().data(),
+                                     transformedImageData, options);
+            });
+            if (read) {
               future->setResult(transformedImageData);
             } else {
               displayError("Read Error",
@@ -279,8 +348,12 @@ void ExternalPipelineExecutor::operatorFinished(Operator* op)
       vtkNew<vtkImageData> childData;
       // Make sure we don't ask the user about subsampling
       QVariantMap options = { { "askForSubsample", false } };
-      if (EmdFormat::read(fileInfo.filePath().toLatin1().data(), childData,
-                          options)) {
+      bool read = false;
+      runWithHDF5Lock([&]() {
+        read = EmdFormat::read(fileInfo.filePath().toLatin1().data(),
+                               childData, options);
+      });
+      if (read) {
         childOutput[name] = childData;
         emit pipeline()->finished();
       } else {
@@ -426,7 +499,11 @@ vtkSmartPointer<vtkDataObject> ProgressReader::readProgressData(
 
   // Make sure we don't ask the user about subsampling
   QVariantMap options = { { "askForSubsample", false } };
-  if (!EmdFormat::read(hostPath.toLatin1().data(), data, options)) {
+  bool read = false;
+  runWithHDF5Lock([&]() {
+    read = EmdFormat::read(hostPath.toLatin1().data(), data, options);
+  });
+  if (!read) {
     qCritical() << QString("Unable to load progress data at: %1").arg(path);
   }
 
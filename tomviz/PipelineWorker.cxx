@@ -4,13 +4,17 @@
 #include "PipelineWorker.h"
 #include "Operator.h"
 
+#include <QDebug>
+#include <QFutureWatcher>
 #include <QObject>
 #include <QQueue>
 #include <QRunnable>
 #include <QThreadPool>
 #include <QTimer>
+#include <QtConcurrent>
 
 #include <vtkDataObject.h>
+#include <vtkSmartPointer.h>
 
 namespace tomviz {
 
@@ -51,7 +55,8 @@ class PipelineWorker::Run : public QObject
   };
 
 public:
-  Run(vtkDataObject* data, QList<Operator*> operators);
+  Run(vtkDataObject* data, QList<Operator*> operators,
+      std::function<bool(vtkDataObject*)> read = nullptr);
 
   /// Clear all Operators from the queue and attempts to cancel the
   /// running Operator.
@@ -81,11 +86,17 @@ public slots:
   // Start the next operator in the queue
   void startNextOperator();
 
+  // Read the data in, then start the operators
+  void startRead();
+
 signals:
   void finished(bool result);
   void canceled();
+  void progressRangeChanged(int minimum, int maximum);
+  void progressValueChanged(int progressValue);
 
 private:
+  std::function<bool(vtkDataObject*)> m_read;
   RunnableOperator* m_running = nullptr;
   vtkSmartPointer<vtkDataObject> m_data;
   QQueue<RunnableOperator*> m_runnableOperators;
@@ -135,8 +146,9 @@ PipelineWorker::ConfigureThreadPool::ConfigureThreadPool()
   QThreadPool::globalInstance()->setMaxThreadCount(threads);
 }
 
-PipelineWorker::Run::Run(vtkDataObject* data, QList<Operator*> operators)
-  : m_data(data)
+PipelineWorker::Run::Run(vtkDataObject* data, QList<Operator*> operators,
+                         std::function<bool(vtkDataObject*)> read)
+  : m_read(read), m_data(data)
 {
   m_operators = operators;
   foreach (auto op, operators) {
@@ -151,8 +163,16 @@ PipelineWorker::Future* PipelineWorker::Run::start()
           &PipelineWorker::Future::finished);
   connect(this, &PipelineWorker::Run::canceled, future,
           &PipelineWorker::Future::canceled);
+  connect(this, &PipelineWorker::Run::progressRangeChanged, future,
+          &PipelineWorker::Future::progressRangeChanged);
+  connect(this, &PipelineWorker::Run::progressValueChanged, future,
+          &PipelineWorker::Future::progressValueChanged);
 
-  QTimer::singleShot(0, this, &PipelineWorker::Run::startNextOperator);
+  if (m_read) {
+    QTimer::singleShot(0, this, &PipelineWorker::Run::startRead);
+  } else {
+    QTimer::singleShot(0, this, &PipelineWorker::Run::startNextOperator);
+  }
 
   m_state = State::RUNNING;
 
@@ -170,6 +190,45 @@ void PipelineWorker::Run::startNextOperator()
   }
 }
 
+void PipelineWorker::Run::startRead()
+{
+  if (m_state == State::CANCELED) {
+    return;
+  }
+
+  // The progress is unknown until the data has been read
+  emit progressRangeChanged(0, 0);
+
+  auto watcher = new QFutureWatcher<bool>(this);
+  connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher]() {
+    watcher->deleteLater();
+    emit progressRangeChanged(0, 1);
+    emit progressValueChanged(1);
+
+    // canceled() was emitted when the run was canceled
+    if (m_state == State::CANCELED) {
+      return;
+    }
+
+    if (!watcher->result()) {
+      qCritical() << "Failed to read the data to run the operators on";
+      if (!m_operators.isEmpty()) {
+        m_operators.first()->setState(OperatorState::Error);
+      }
+      m_state = State::COMPLETE;
+      emit finished(false);
+      return;
+    }
+    startNextOperator();
+  });
+
+  // The data is kept alive until the read returns, even if the run is
+  // canceled and deleted meanwhile.
+  vtkSmartPointer<vtkDataObject> data = m_data;
+  auto read = m_read;
+  watcher->setFuture(QtConcurrent::run([read, data]() { return read(data); }));
+}
+
 void PipelineWorker::Run::operatorComplete(TransformResult transformResult)
 {
   auto runnableOperator = qobject_cast<RunnableOperator*>(sender());
@@ -220,7 +279,7 @@ bool PipelineWorker::Run::cancel(Operator* op)
 
   // If the operator is currently running we just have to cancel the execution
   // of the whole pipeline.
-  if (m_running->op() == op) {
+  if (m_running != nullptr && m_running->op() == op) {
     cancel();
     return false;
   }
@@ -264,15 +323,16 @@ PipelineWorker::Future* PipelineWorker::run(vtkDataObject* data, Operator* op)
   return run(data, ops);
 }
 
-PipelineWorker::Future* PipelineWorker::run(vtkDataObject* data,
-                                            QList<Operator*> operators)
+PipelineWorker::Future* PipelineWorker::run(
+  vtkDataObject* data, QList<Operator*> operators,
+  std::function<bool(vtkDataObject*)> read)
 {
   // Set all the operators in the queued state
   foreach (Operator* op, operators) {
     op->resetState();
   }
 
-  Run* run = new Run(data, operators);
+  Run* run = new Run(data, operators, read);
 
   return run->start();
 }
@@ -8,6 +8,8 @@
 #include <QObject>
 #include <QRunnable>
 
+#include <functional>
+
 class vtkDataObject;
 
 namespace tomviz {
@@ -24,7 +26,10 @@ public:
   class Future;
   PipelineWorker(QObject* parent = nullptr);
   Future* run(vtkDataObject* data, Operator* op);
-  Future* run(vtkDataObject* data, QList<Operator*> ops);
+  /// read, if given, reads the data in on the thread pool before the
+  /// operators are run, the progress of the future covers it.
+  Future* run(vtkDataObject* data, QList<Operator*> ops,
+              std::function<bool(vtkDataObject*)> read = nullptr);
 
 private:
   class RunnableOperator;
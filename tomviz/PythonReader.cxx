@@ -4,6 +4,7 @@
 #include "PythonReader.h"
 
 #include "DataSource.h"
+#include "Utilities.h"
 
 #include <vtkImageData.h>
 
@@ -19,7 +20,8 @@ PythonReader::PythonReader()
 {
 }
 
-vtkSmartPointer<vtkImageData> PythonReader::read(QString fileName)
+vtkSmartPointer<vtkImageData> PythonReader::read(QString fileName,
+                                                 const QVariantMap& options)
 {
   if (!m_instance.isValid()) {
     qWarning() << "The Python reader for this file type hasn't loaded yet. "
@@ -39,11 +41,15 @@ vtkSmartPointer<vtkImageData> PythonReader::read(QString fileName)
     return nullptr;
   }
 
-  Python::Tuple args(2);
+  // Only the readers that take options are given them
+  Python::Tuple args(options.isEmpty() ? 2 : 3);
   Python::Object argInstance = m_instance;
   args.set(0, argInstance);
   Python::Object fileArg(fileName);
   args.set(1, fileArg);
+  if (!options.isEmpty()) {
+    args.set(2, toVariant(options));
+  }
   auto res = readerFunction.call(args);
 
   if (!res.isValid()) {
@@ -68,6 +74,52 @@ vtkSmartPointer<vtkImageData> PythonReader::read(QString fileName)
   return imageData;
 }
 
+bool PythonReader::volumeInfo(QString fileName, int dims[3],
+                              int& dataTypeSize)
+{
+  if (!m_instance.isValid()) {
+    return false;
+  }
+
+  Python python;
+  auto module = python.import("tomviz.io._internal");
+  if (!module.isValid()) {
+    qCritical() << "Failed to import tomviz.io._internal module.";
+    return false;
+  }
+  auto infoFunction = module.findFunction("reader_volume_info");
+  if (!infoFunction.isValid()) {
+    qCritical() << "Failed to import tomviz.io._internal.reader_volume_info";
+    return false;
+  }
+
+  Python::Tuple args(2);
+  Python::Object argInstance = m_instance;
+  args.set(0, argInstance);
+  Python::Object fileArg(fileName);
+  args.set(1, fileArg);
+  auto res = infoFunction.call(args);
+
+  if (!res.isValid()) {
+    qCritical("Error calling reader_volume_info");
+    return false;
+  }
+
+  // A list of the dimensions, then the size of the values
+  if (!res.isList()) {
+    return false;
+  }
+  auto info = res.toList();
+  if (info.length() != 4) {
+    return false;
+  }
+  for (int i = 0; i < 3; ++i) {
+    dims[i] = static_cast<int>(info[i].toLong());
+  }
+  dataTypeSize = static_cast<int>(info[3].toLong());
+  return true;
+}
+
 PythonReaderFactory::PythonReaderFactory(QString description,
                                          QStringList extensions,
                                          Python::Object cls)
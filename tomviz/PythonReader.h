@@ -10,6 +10,7 @@
 
 #include <QString>
 #include <QStringList>
+#include <QVariantMap>
 
 class vtkImageData;
 
@@ -19,7 +20,13 @@ class PythonReader
 public:
   PythonReader(Python::Object);
   PythonReader();
-  vtkSmartPointer<vtkImageData> read(QString);
+  vtkSmartPointer<vtkImageData> read(
+    QString, const QVariantMap& options = QVariantMap());
+
+  /// The (x, y, z) dimensions and the size in bytes of the values of the
+  /// volume in a file, for the readers that can subsample it. Returns false
+  /// for the other readers.
+  bool volumeInfo(QString fileName, int dims[3], int& dataTypeSize);
 
 private:
   Python::Object m_instance;
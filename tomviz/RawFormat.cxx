@@ -0,0 +1,76 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "RawFormat.h"
+
+#include "MappedFile.h"
+
+#include <vtkByteSwap.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+#include <QFileInfo>
+#include <QSysInfo>
+
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+
+namespace tomviz {
+
+bool RawFormat::read(const std::string& fileName, int vtkType, int components,
+                     const int dims[3], bool bigEndian, vtkImageData* image)
+{
+  if (components < 1 || dims[0] < 1 || dims[1] < 1 || dims[2] < 1) {
+    cerr << "Invalid dimensions for " << fileName << endl;
+    return false;
+  }
+
+  auto probe = vtkSmartPointer<vtkDataArray>::Take(
+    vtkDataArray::CreateDataArray(vtkType));
+  if (!probe) {
+    cerr << "Unsupported data type: " << vtkType << endl;
+    return false;
+  }
+
+  QString name = QString::fromStdString(fileName);
+  vtkIdType count =
+    static_cast<vtkIdType>(dims[0]) * dims[1] * dims[2] * components;
+  qint64 valueSize = probe->GetDataTypeSize();
+  qint64 header = QFileInfo(name).size() - count * valueSize;
+  if (header < 0) {
+    cerr << fileName << " is too small for the dimensions" << endl;
+    return false;
+  }
+
+  bool swap = bigEndian != (QSysInfo::ByteOrder == QSysInfo::BigEndian);
+  vtkSmartPointer<vtkDataArray> scalars;
+  if (!swap) {
+    scalars = mapArray(name, header, vtkType, count);
+  }
+  if (!scalars) {
+    scalars = readArray(name, header, vtkType, count);
+  }
+  if (!scalars) {
+    return false;
+  }
+
+  if (swap && valueSize > 1) {
+    auto* values = static_cast<char*>(scalars->GetVoidPointer(0));
+    vtkSMPTools::For(0, count, [&](vtkIdType begin, vtkIdType end) {
+      vtkByteSwap::SwapVoidRange(values + begin * valueSize, end - begin,
+                                 valueSize);
+    });
+  }
+
+  scalars->SetNumberOfComponents(components);
+  scalars->SetName("ImageFile");
+  image->SetDimensions(dims[0], dims[1], dims[2]);
+  image->GetPointData()->SetScalars(scalars);
+  return true;
+}
+
+} // namespace tomviz
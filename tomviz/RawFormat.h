@@ -0,0 +1,31 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizRawFormat_h
+#define tomvizRawFormat_h
+
+#include <string>
+
+class vtkImageData;
+
+namespace tomviz {
+
+/**
+ * Raw binary volumes, as configured in the RAWFileReaderDialog. Values in the
+ * native byte order are mapped into the scalars rather than read, see
+ * mapArray(), so even very large files open instantly and their pages are
+ * only read when they are accessed. Values in the other byte order are read
+ * and swapped in parallel.
+ *
+ * As with vtkImageReader, the values are at the end of the file, after any
+ * header, with X varying fastest.
+ */
+class RawFormat
+{
+public:
+  static bool read(const std::string& fileName, int vtkType, int components,
+                   const int dims[3], bool bigEndian, vtkImageData* image);
+};
+} // namespace tomviz
+
+#endif // tomvizRawFormat_h
@@ -217,7 +217,7 @@ bool SaveLoadStateReaction::saveTvsm(const QString& fileName, bool interactive)
 
 bool SaveLoadStateReaction::saveTvh5(const QString& fileName)
 {
-  return Tvh5Format::write(fileName.toStdString());
+  return Tvh5Format::save(fileName.toStdString());
 }
 
 QString SaveLoadStateReaction::extractLegacyStateFileVersion(
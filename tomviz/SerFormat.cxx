@@ -0,0 +1,294 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "SerFormat.h"
+
+#include "MappedFile.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+#include <QtEndian>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+
+namespace {
+
+const uint16_t LittleEndian = 0x4949;
+const uint16_t SeriesId = 0x0197;
+const uint16_t Version64 = 0x0220;
+const int32_t Spectra = 0x4120;
+const int32_t Images = 0x4122;
+
+// Everything in SER files is little endian
+class Reader
+{
+public:
+  Reader(const uchar* data, qint64 size) : m_data(data), m_size(size) {}
+
+  template <typename T>
+  bool read(T& value)
+  {
+    if (m_pos < 0 || m_pos + static_cast<qint64>(sizeof(T)) > m_size) {
+      cerr << "Unexpected end of the SER file" << endl;
+      return false;
+    }
+    value = qFromLittleEndian<T>(m_data + m_pos);
+    m_pos += sizeof(T);
+    return true;
+  }
+
+  // Offsets are 32 bits before TIA 4.7.3, 64 bits since
+  bool readOffset(qint64& value, bool wide)
+  {
+    if (wide) {
+      int64_t value64 = 0;
+      bool ok = read(value64);
+      value = value64;
+      return ok;
+    }
+    int32_t value32 = 0;
+    bool ok = read(value32);
+    value = value32;
+    return ok;
+  }
+
+  bool skip(qint64 bytes)
+  {
+    if (bytes < 0 || m_pos + bytes > m_size) {
+      cerr << "Unexpected end of the SER file" << endl;
+      return false;
+    }
+    m_pos += bytes;
+    return true;
+  }
+
+  void seek(qint64 pos) { m_pos = pos; }
+  qint64 pos() const { return m_pos; }
+
+private:
+  const uchar* m_data;
+  qint64 m_size;
+  qint64 m_pos = 0;
+};
+
+// The VTK type of the element data types, -1 for unsupported ones
+int vtkType(int16_t dataType)
+{
+  switch (dataType) {
+    case 1:
+      return VTK_UNSIGNED_CHAR;
+    case 2:
+      return VTK_UNSIGNED_SHORT;
+    case 3:
+      return VTK_UNSIGNED_INT;
+    case 4:
+      return VTK_SIGNED_CHAR;
+    case 5:
+      return VTK_SHORT;
+    case 6:
+      return VTK_INT;
+    case 7:
+      return VTK_FLOAT;
+    case 8:
+      return VTK_DOUBLE;
+    default:
+      return -1;
+  }
+}
+
+// The calibration of an element axis
+struct Calibration
+{
+  double offset = 0.0;
+  double delta = 0.0;
+  int32_t element = 0;
+};
+
+// What precedes the data of every element
+struct Element
+{
+  Calibration calibrations[2];
+  int16_t dataType = 0;
+  int32_t shape[2] = { 1, 1 };
+  qint64 dataOffset = 0;
+};
+
+bool readElement(Reader& reader, qint64 offset, bool images, Element& element)
+{
+  reader.seek(offset);
+  int axes = images ? 2 : 1;
+  for (int i = 0; i < axes; ++i) {
+    auto& calibration = element.calibrations[i];
+    if (!reader.read(calibration.offset) || !reader.read(calibration.delta) ||
+        !reader.read(calibration.element)) {
+      return false;
+    }
+  }
+  if (!reader.read(element.dataType)) {
+    return false;
+  }
+  for (int i = 0; i < axes; ++i) {
+    if (!reader.read(element.shape[i]) || element.shape[i] < 1) {
+      return false;
+    }
+  }
+  element.dataOffset = reader.pos();
+  return true;
+}
+
+} // namespace
+
+namespace tomviz {
+
+bool SerFormat::read(const std::string& fileName, vtkImageData* image)
+{
+  MappedFile file(fileName.c_str());
+  if (!file.isValid()) {
+    cerr << "Failed to read " << fileName << endl;
+    return false;
+  }
+
+  Reader reader(file.data(), file.size());
+  uint16_t byteOrder = 0, seriesId = 0, version = 0;
+  if (!reader.read(byteOrder) || !reader.read(seriesId) ||
+      !reader.read(version)) {
+    return false;
+  }
+  if (byteOrder != LittleEndian || seriesId != SeriesId) {
+    cerr << fileName << " is not a little endian SER file" << endl;
+    return false;
+  }
+  bool wide = version >= Version64;
+
+  int32_t dataTypeId = 0, tagTypeId = 0, totalElements = 0, validElements = 0;
+  qint64 offsetArrayOffset = 0;
+  int32_t numberOfDimensions = 0;
+  if (!reader.read(dataTypeId) || !reader.read(tagTypeId) ||
+      !reader.read(totalElements) || !reader.read(validElements) ||
+      !reader.readOffset(offsetArrayOffset, wide) ||
+      !reader.read(numberOfDimensions)) {
+    return false;
+  }
+  if (dataTypeId != Spectra && dataTypeId != Images) {
+    cerr << "Unknown SER data type id: " << dataTypeId << endl;
+    return false;
+  }
+  if (validElements < 1) {
+    cerr << "No data found in " << fileName << endl;
+    return false;
+  }
+
+  // The sizes of the dimensions the elements are arranged in
+  std::vector<int32_t> dimensionSizes;
+  for (int32_t i = 0; i < numberOfDimensions; ++i) {
+    int32_t size = 0, element = 0, length = 0;
+    double offset = 0.0, delta = 0.0;
+    if (!reader.read(size) || !reader.read(offset) || !reader.read(delta) ||
+        !reader.read(element) || !reader.read(length) ||
+        !reader.skip(length) || !reader.read(length) ||
+        !reader.skip(length)) {
+      return false;
+    }
+    dimensionSizes.push_back(size);
+  }
+
+  std::vector<qint64> offsets(validElements);
+  reader.seek(offsetArrayOffset);
+  for (auto& offset : offsets) {
+    if (!reader.readOffset(offset, wide)) {
+      return false;
+    }
+  }
+
+  // Every element has the same type and shape
+  bool images = dataTypeId == Images;
+  Element first;
+  if (!readElement(reader, offsets[0], images, first)) {
+    cerr << "Failed to read the first element of " << fileName << endl;
+    return false;
+  }
+  int type = vtkType(first.dataType);
+  if (type < 0) {
+    cerr << "Unsupported SER data type: " << first.dataType << endl;
+    return false;
+  }
+
+  auto scalars = vtkSmartPointer<vtkDataArray>::Take(
+    vtkDataArray::CreateDataArray(type));
+  const size_t valueSize = scalars->GetDataTypeSize();
+  const size_t elementSize =
+    static_cast<size_t>(first.shape[0]) * first.shape[1] * valueSize;
+  std::vector<qint64> dataOffsets(validElements);
+  for (int32_t i = 0; i < validElements; ++i) {
+    Element element;
+    if (!readElement(reader, offsets[i], images, element) ||
+        element.dataType != first.dataType ||
+        element.shape[0] != first.shape[0] ||
+        element.shape[1] != first.shape[1] ||
+        element.dataOffset + static_cast<qint64>(elementSize) > file.size()) {
+      cerr << "Invalid element " << i << " in " << fileName << endl;
+      return false;
+    }
+    dataOffsets[i] = element.dataOffset;
+  }
+
+  int dims[3] = { first.shape[0], first.shape[1], validElements };
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  if (images) {
+    // The calibrations are in meters
+    for (int i = 0; i < 2; ++i) {
+      if (first.calibrations[i].delta > 0.0) {
+        spacing[i] = first.calibrations[i].delta * 1e9;
+      }
+    }
+  } else if (dimensionSizes.size() > 1 &&
+             static_cast<qint64>(dimensionSizes[0]) * dimensionSizes[1] ==
+               validElements) {
+    // A spectrum image, the energy along X and the scan along Y and Z
+    dims[1] = dimensionSizes[0];
+    dims[2] = dimensionSizes[1];
+  } else {
+    dims[1] = validElements;
+    dims[2] = 1;
+  }
+
+  scalars->SetNumberOfTuples(static_cast<vtkIdType>(elementSize / valueSize) *
+                             validElements);
+  scalars->SetName("ImageScalars");
+
+  // Copy the elements in parallel, flipping the rows of images
+  auto* out = static_cast<uchar*>(scalars->GetVoidPointer(0));
+  const uchar* in = file.data();
+  const size_t rowSize = first.shape[0] * valueSize;
+  const int rows = first.shape[1];
+  vtkSMPTools::For(0, validElements, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i) {
+      const uchar* element = in + dataOffsets[i];
+      uchar* slice = out + i * elementSize;
+      if (!images) {
+        std::memcpy(slice, element, elementSize);
+        continue;
+      }
+      for (int row = 0; row < rows; ++row) {
+        std::memcpy(slice + (rows - 1 - row) * rowSize, element + row * rowSize,
+                    rowSize);
+      }
+    }
+  });
+
+  image->SetDimensions(dims);
+  image->SetSpacing(spacing);
+  image->GetPointData()->SetScalars(scalars);
+  return true;
+}
+
+} // namespace tomviz
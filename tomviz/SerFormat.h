@@ -0,0 +1,28 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizSerFormat_h
+#define tomvizSerFormat_h
+
+#include <string>
+
+class vtkImageData;
+
+namespace tomviz {
+
+/**
+ * FEI TIA series (SER) files. The elements are copied, in parallel, straight
+ * from the memory mapped file into the scalars.
+ *
+ * Image series are read as a stack of the images, with their rows flipped as
+ * in tomviz.io.ser. Spectra are read as a volume with the energy along X and
+ * the scan positions along Y and Z.
+ */
+class SerFormat
+{
+public:
+  static bool read(const std::string& fileName, vtkImageData* image);
+};
+} // namespace tomviz
+
+#endif // tomvizSerFormat_h
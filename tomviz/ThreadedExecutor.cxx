@@ -3,6 +3,11 @@
 
 #include "ThreadedExecutor.h"
 
+#include "DataSource.h"
+#include "Utilities.h"
+
+#include <QProgressDialog>
+
 namespace tomviz {
 
 class PipelineFutureThreadedInternal : public Pipeline::Future
@@ -55,8 +60,23 @@ Pipeline::Future* ThreadPipelineExecutor::execute(vtkDataObject* data,
     m_future->cancel();
   }
 
+  // Only a subsample of a lazily loaded volume is in memory. The operators
+  // run on the full resolution volume instead, read on the thread pool.
+  std::function<bool(vtkDataObject*)> read;
+  auto root = pipeline()->dataSource();
+  if (!operators.isEmpty() && root && data == root->dataObject()) {
+    auto reader = root->fullResolutionReader();
+    if (reader) {
+      read = [reader](vtkDataObject* image) {
+        return reader(vtkImageData::SafeDownCast(image));
+      };
+    }
+  }
+
   auto copy = data->NewInstance();
-  copy->DeepCopy(data);
+  if (!read) {
+    copy->DeepCopy(data);
+  }
 
   if (operators.isEmpty()) {
     emit pipeline()->finished();
@@ -67,11 +87,28 @@ Pipeline::Future* ThreadPipelineExecutor::execute(vtkDataObject* data,
     return future;
   }
 
-  m_future = m_worker->run(copy, operators);
+  m_future = m_worker->run(copy, operators, read);
   auto future = new PipelineFutureThreadedInternal(
     vtkImageData::SafeDownCast(copy), operators, m_future.data(), this);
   copy->FastDelete();
 
+  if (read) {
+    auto dialog = new QProgressDialog("Reading the full resolution volume...",
+                                      "Cancel", 0, 0, tomviz::mainWidget());
+    dialog->setWindowTitle("Tomviz");
+    dialog->setMinimumDuration(500);
+    connect(m_future, &PipelineWorker::Future::progressRangeChanged, dialog,
+            &QProgressDialog::setRange);
+    connect(m_future, &PipelineWorker::Future::progressValueChanged, dialog,
+            &QProgressDialog::setValue);
+    connect(dialog, &QProgressDialog::canceled, m_future.data(),
+            QOverload<>::of(&PipelineWorker::Future::cancel));
+    connect(future, &Pipeline::Future::finished, dialog,
+            &QObject::deleteLater);
+    connect(future, &Pipeline::Future::canceled, dialog,
+            &QObject::deleteLater);
+  }
+
   return future;
 }
 
@@ -0,0 +1,192 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "TimeSeriesCache.h"
+
+#include "TimeSeriesStep.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+namespace tomviz {
+
+namespace {
+
+using ImageFuture = QFuture<vtkSmartPointer<vtkImageData>>;
+
+// The reads take the HDF5 lock, behind other reads of any file. On the GUI
+// thread the events other than user input are processed meanwhile, rather
+// than waiting for them.
+vtkSmartPointer<vtkImageData> waitFor(ImageFuture future)
+{
+  auto* app = QCoreApplication::instance();
+  if (!future.isFinished() && app &&
+      QThread::currentThread() == app->thread()) {
+    QEventLoop loop;
+    QFutureWatcher<vtkSmartPointer<vtkImageData>> watcher;
+    QObject::connect(&watcher, &QFutureWatcherBase::finished, &loop,
+                     &QEventLoop::quit);
+    watcher.setFuture(future);
+    if (!future.isFinished()) {
+      loop.exec(QEventLoop::ExcludeUserInputEvents);
+    }
+  }
+  return future.result();
+}
+
+} // namespace
+
+void TimeSeriesCache::setBudget(qint64 bytes)
+{
+  m_budget = std::max<qint64>(bytes, 0);
+  evict();
+}
+
+bool TimeSeriesCache::isResident(const QString& fileName) const
+{
+  return m_resident.contains(fileName);
+}
+
+bool TimeSeriesCache::isPending(const QString& fileName) const
+{
+  return m_pending.contains(fileName);
+}
+
+vtkSmartPointer<vtkImageData> TimeSeriesCache::image(
+  const TimeSeriesStep& step)
+{
+  collect();
+
+  vtkSmartPointer<vtkImageData> result;
+  auto it = m_resident.find(step.fileName);
+  if (it != m_resident.end()) {
+    result = it->image;
+    touch(step.fileName);
+  } else {
+    if (m_pending.contains(step.fileName)) {
+      // The read stays pending while waiting for it, so that a switch to
+      // the same step from the events processed meanwhile waits for it too,
+      // rather than reading it again.
+      result = waitFor(m_pending.value(step.fileName));
+      m_pending.remove(step.fileName);
+    } else if (step.reader) {
+      result = step.reader(step.fileName);
+    }
+    if (result) {
+      insert(step.fileName, result);
+    }
+  }
+
+  if (result) {
+    m_current = step.fileName;
+    evict();
+  }
+  return result;
+}
+
+void TimeSeriesCache::prefetch(const QList<TimeSeriesStep>& steps,
+                               qint64 stepBytes)
+{
+  collect();
+
+  // The current step is kept too
+  QList<const TimeSeriesStep*> wanted;
+  qint64 needed = stepBytes;
+  for (auto& step : steps) {
+    if (!step.isLazy() || step.fileName == m_current) {
+      continue;
+    }
+    needed += stepBytes;
+    if (needed > m_budget) {
+      break;
+    }
+    wanted.append(&step);
+  }
+
+  // The nearest steps end up the most recently used
+  for (auto it = wanted.rbegin(); it != wanted.rend(); ++it) {
+    auto* step = *it;
+    if (m_resident.contains(step->fileName)) {
+      touch(step->fileName);
+    } else if (!m_pending.contains(step->fileName)) {
+      auto reader = step->reader;
+      auto fileName = step->fileName;
+      m_pending[fileName] =
+        QtConcurrent::run([reader, fileName]() { return reader(fileName); });
+    }
+  }
+  if (m_resident.contains(m_current)) {
+    touch(m_current);
+  }
+}
+
+void TimeSeriesCache::clear()
+{
+  m_resident.clear();
+  m_lru.clear();
+  m_pending.clear();
+  m_current.clear();
+  m_residentBytes = 0;
+}
+
+void TimeSeriesCache::collect()
+{
+  for (auto it = m_pending.begin(); it != m_pending.end();) {
+    if (!it->isFinished()) {
+      ++it;
+      continue;
+    }
+    auto image = it->result();
+    if (image) {
+      insert(it.key(), image);
+    }
+    it = m_pending.erase(it);
+  }
+  evict();
+}
+
+void TimeSeriesCache::insert(const QString& fileName,
+                             vtkSmartPointer<vtkImageData> image)
+{
+  if (m_resident.contains(fileName)) {
+    touch(fileName);
+    return;
+  }
+
+  m_lru.push_front(fileName);
+  Entry entry;
+  entry.image = image;
+  entry.size = static_cast<qint64>(image->GetActualMemorySize()) * 1024;
+  entry.position = m_lru.begin();
+  m_residentBytes += entry.size;
+  m_resident[fileName] = entry;
+}
+
+void TimeSeriesCache::touch(const QString& fileName)
+{
+  auto it = m_resident.find(fileName);
+  if (it != m_resident.end()) {
+    m_lru.splice(m_lru.begin(), m_lru, it->position);
+  }
+}
+
+void TimeSeriesCache::evict()
+{
+  auto it = m_lru.end();
+  while (m_residentBytes > m_budget && it != m_lru.begin()) {
+    --it;
+    if (*it == m_current) {
+      continue;
+    }
+    auto entry = m_resident.take(*it);
+    m_residentBytes -= entry.size;
+    it = m_lru.erase(it);
+  }
+}
+
+} // namespace tomviz
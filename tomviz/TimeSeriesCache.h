@@ -0,0 +1,83 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizTimeSeriesCache_h
+#define tomvizTimeSeriesCache_h
+
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <list>
+
+namespace tomviz {
+
+struct TimeSeriesStep;
+
+/// The images of lazily loaded time series steps that are in memory. Steps
+/// are read when they are shown, or ahead of time by prefetch(), and the
+/// least recently used images are dropped once they exceed the budget. The
+/// image of the current step, the last one returned by image(), is always
+/// kept.
+///
+/// Only to be used from one thread, the steps are read on the global thread
+/// pool. Steps are identified by their file name.
+class TimeSeriesCache
+{
+public:
+  TimeSeriesCache() = default;
+
+  TimeSeriesCache(const TimeSeriesCache&) = delete;
+  TimeSeriesCache& operator=(const TimeSeriesCache&) = delete;
+
+  /// The memory the images may use, 2 GiB by default.
+  void setBudget(qint64 bytes);
+  qint64 budget() const { return m_budget; }
+  qint64 residentBytes() const { return m_residentBytes; }
+
+  bool isResident(const QString& fileName) const;
+  bool isPending(const QString& fileName) const;
+
+  /// The image of a step, which becomes the current one. It is read now,
+  /// unless it is resident or being prefetched, in which case this waits
+  /// for it, processing the events other than user input on the GUI thread.
+  /// nullptr if it could not be read.
+  vtkSmartPointer<vtkImageData> image(const TimeSeriesStep& step);
+
+  /// Start reading the steps, in order, while they are expected to fit in
+  /// the budget next to the current step. stepBytes is the expected size of
+  /// a step. Resident steps among them are kept over older ones.
+  void prefetch(const QList<TimeSeriesStep>& steps, qint64 stepBytes);
+
+  /// Drop every image, reads in progress finish in the background.
+  void clear();
+
+private:
+  // Move the finished reads to the resident images
+  void collect();
+  void insert(const QString& fileName, vtkSmartPointer<vtkImageData> image);
+  void touch(const QString& fileName);
+  void evict();
+
+  struct Entry
+  {
+    vtkSmartPointer<vtkImageData> image;
+    qint64 size = 0;
+    std::list<QString>::iterator position;
+  };
+
+  QHash<QString, Entry> m_resident;
+  // The most recently used first
+  std::list<QString> m_lru;
+  QHash<QString, QFuture<vtkSmartPointer<vtkImageData>>> m_pending;
+  QString m_current;
+  qint64 m_budget = qint64(2) << 30;
+  qint64 m_residentBytes = 0;
+};
+} // namespace tomviz
+
+#endif
@@ -9,18 +9,37 @@
 #include <vtkImageData.h>
 #include <vtkSmartPointer.h>
 
+#include <functional>
+
 namespace tomviz {
 
 struct TimeSeriesStep
 {
+  /// Reads the image of a lazily loaded step from its file, on any thread.
+  /// Returns nullptr on failure.
+  using Reader = std::function<vtkSmartPointer<vtkImageData>(const QString&)>;
+
   TimeSeriesStep() {}
   TimeSeriesStep(QString l, vtkImageData* img, double t)
     : label(l), image(img), time(t)
   {
   }
 
+  /// A step that is only read when it is needed, see TimeSeriesCache
+  TimeSeriesStep(QString l, QString file, Reader r, double t)
+    : label(l), fileName(file), reader(r), time(t)
+  {
+  }
+
+  bool isLazy() const { return !image && reader; }
+
   TimeSeriesStep clone()
   {
+    // Lazily loaded steps are read again from their file
+    if (isLazy()) {
+      return *this;
+    }
+
     // Return an identical time series step with a deep copy of the data
     auto* copy = image->NewInstance();
     copy->DeepCopy(image);
@@ -30,6 +49,8 @@ struct TimeSeriesStep
 
   QString label;
   vtkSmartPointer<vtkImageData> image;
+  QString fileName;
+  Reader reader;
   double time = 0;
 };
 
@@ -81,7 +81,7 @@ void weightedBackProjection3(vtkImageData* tiltSeries, vtkImageData* recon)
 }
 
 // 2D WBP recon
-void unweightedBackProjection2(float* sinogram, double* tiltAngles,
+void unweightedBackProjection2(const float* sinogram, double* tiltAngles,
                                float* image, int numOfTilts, int numOfRays)
 {
   for (int i = 0; i < numOfRays * numOfRays; ++i) {
@@ -2,17 +2,27 @@
    It is released under the 3-Clause BSD License, see "LICENSE". */
 
 #include "TomographyTiltSeries.h"
+#include "vtkCallbackCommand.h"
+#include "vtkCommand.h"
 #include "vtkDataArray.h"
 #include "vtkFieldData.h"
 #include "vtkImageData.h"
 #include <math.h>
 #define PI 3.14159265359
 #include "vtkFloatArray.h"
+#include "vtkNew.h"
 #include "vtkPointData.h"
+#include "vtkSMPTools.h"
 #include "vtkSmartPointer.h"
+#include "vtkWeakPointer.h"
 
 #include <QDebug>
 
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <mutex>
+
 namespace {
 
 // conversion code
@@ -39,6 +49,117 @@ vtkSmartPointer<vtkFloatArray> convertToFloat(vtkImageData* image)
   }
   return array;
 }
+
+// Edge length of the square tiles used when transposing. A source and a
+// destination tile of this size fit comfortably in L1.
+const int TransposeBlockSize = 32;
+
+// Convert to float and transpose the tilt series from [z][y][x] into
+// [x][z][y], i.e. sinogram-major order. The work is split into one block of
+// rays of one tilt per item, so no two items ever write the same memory.
+template <typename T>
+void transposeToSinograms(const T* data, int xDim, int yDim, int zDim,
+                          float* out)
+{
+  const vtkIdType yBlocks =
+    (yDim + TransposeBlockSize - 1) / TransposeBlockSize;
+  const size_t planeSize = static_cast<size_t>(xDim) * yDim;
+  const size_t sinogramSize = static_cast<size_t>(yDim) * zDim;
+  vtkSMPTools::For(
+    0, static_cast<vtkIdType>(zDim) * yBlocks,
+    [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType item = begin; item < end; ++item) {
+        const int z = static_cast<int>(item / yBlocks);
+        const int y0 = static_cast<int>(item % yBlocks) * TransposeBlockSize;
+        const int y1 = std::min(y0 + TransposeBlockSize, yDim);
+        const T* plane = data + z * planeSize;
+        float* tilt = out + static_cast<size_t>(z) * yDim;
+        for (int x0 = 0; x0 < xDim; x0 += TransposeBlockSize) {
+          const int x1 = std::min(x0 + TransposeBlockSize, xDim);
+          for (int x = x0; x < x1; ++x) {
+            float* sinogram = tilt + x * sinogramSize;
+            for (int y = y0; y < y1; ++y) {
+              sinogram[y] =
+                static_cast<float>(plane[static_cast<size_t>(y) * xDim + x]);
+            }
+          }
+        }
+      }
+    });
+}
+
+// Convert to float and gather the sinogram of one slice of a tilt series,
+// in the layout of transposeToSinograms().
+template <typename T>
+void extractSinogram(const T* data, int xDim, int yDim, int zDim, int slice,
+                     float* out)
+{
+  const size_t planeSize = static_cast<size_t>(xDim) * yDim;
+  for (int z = 0; z < zDim; ++z) {
+    const T* plane = data + z * planeSize;
+    float* tilt = out + static_cast<size_t>(z) * yDim;
+    for (int y = 0; y < yDim; ++y) {
+      tilt[y] =
+        static_cast<float>(plane[static_cast<size_t>(y) * xDim + slice]);
+    }
+  }
+}
+
+struct SinogramCacheEntry
+{
+  vtkWeakPointer<vtkImageData> image;
+  // Only used to detect a change of active scalars, never dereferenced.
+  vtkDataArray* scalars;
+  vtkMTimeType mtime;
+  std::shared_ptr<const tomviz::TomographyTiltSeries::SinogramStack> stack;
+  // Drops the entry as soon as the image is deleted
+  unsigned long deleteObserver;
+};
+
+struct SinogramCache
+{
+  std::mutex mutex;
+  // Most recently used entries are at the front.
+  std::list<SinogramCacheEntry> entries;
+  size_t memoryUsage = 0;
+  size_t budget = size_t(2) << 30;
+
+  bool isCurrent(const SinogramCacheEntry& entry) const
+  {
+    return entry.image && entry.mtime == entry.image->GetMTime() &&
+           entry.scalars == entry.image->GetPointData()->GetScalars();
+  }
+
+  void erase(std::list<SinogramCacheEntry>::iterator it)
+  {
+    if (it->image) {
+      it->image->RemoveObserver(it->deleteObserver);
+    }
+    memoryUsage -= it->stack->memorySize();
+    entries.erase(it);
+  }
+
+  // Drop stale entries, then evict least recently used ones until "incoming"
+  // more bytes fit in the budget.
+  void prune(size_t incoming = 0)
+  {
+    for (auto it = entries.begin(); it != entries.end();) {
+      auto current = it++;
+      if (!isCurrent(*current)) {
+        erase(current);
+      }
+    }
+    while (!entries.empty() && memoryUsage + incoming > budget) {
+      erase(std::prev(entries.end()));
+    }
+  }
+};
+
+SinogramCache& sinogramCache()
+{
+  static SinogramCache cache;
+  return cache;
+}
 } // end of namespace
 
 namespace tomviz {
@@ -53,19 +174,22 @@ void getSinogram(vtkImageData* tiltSeries, int sliceNumber, float* sinogram)
   int yDim = extents[3] - extents[2] + 1; // Number of rays
   int zDim = extents[5] - extents[4] + 1; // Number of tilts
 
-  // Convert tiltSeries type to float
-  vtkSmartPointer<vtkFloatArray> dataAsFloats = convertToFloat(tiltSeries);
-  float* dataPtr = static_cast<float*>(dataAsFloats->GetVoidPointer(
-    0)); // Get pointer to tilt series (of type float)
+  // Served from the (cached) transposed tilt series, so extracting every
+  // slice in turn only converts and transposes the data once. A tilt series
+  // too large to cache is not transposed, only the slice is gathered.
+  size_t stackSize = static_cast<size_t>(xDim) * yDim * zDim * sizeof(float);
+  if (stackSize <= sinogramCacheBudget()) {
+    auto stack = sinogramStack(tiltSeries);
+    std::memcpy(sinogram, stack->sinogram(sliceNumber),
+                stack->sinogramSize() * sizeof(float));
+    return;
+  }
 
-  // Extract sinograms from tilt series. Make a deep copy
-  for (int t = 0; t < zDim; ++t) // Loop through tilts (z-direction)
-  {
-    for (int r = 0; r < yDim; ++r) // Loop through rays (y-direction)
-    {
-      sinogram[t * yDim + r] =
-        dataPtr[t * xDim * yDim + r * xDim + sliceNumber];
-    }
+  vtkDataArray* scalars = tiltSeries->GetPointData()->GetScalars();
+  switch (scalars->GetDataType()) {
+    vtkTemplateMacro(extractSinogram(
+      static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)), xDim, yDim,
+      zDim, sliceNumber, sinogram));
   }
 }
 
@@ -159,5 +283,99 @@ void averageTiltSeries(vtkImageData* tiltSeries, float* average)
   }
 }
 
+SinogramStack::SinogramStack(int numberOfSinograms, int numberOfRays,
+                             int numberOfTilts)
+  : m_numberOfSinograms(numberOfSinograms), m_numberOfRays(numberOfRays),
+    m_numberOfTilts(numberOfTilts),
+    m_data(static_cast<size_t>(numberOfSinograms) * numberOfRays *
+           numberOfTilts)
+{
+}
+
+std::shared_ptr<const SinogramStack> sinogramStack(vtkImageData* tiltSeries)
+{
+  auto& cache = sinogramCache();
+  vtkDataArray* scalars = tiltSeries->GetPointData()->GetScalars();
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.prune();
+    for (auto it = cache.entries.begin(); it != cache.entries.end(); ++it) {
+      if (it->image == tiltSeries) {
+        cache.entries.splice(cache.entries.begin(), cache.entries, it);
+        return it->stack;
+      }
+    }
+  }
+
+  // Transpose outside of the lock, so other tilt series can still be served.
+  int extents[6];
+  tiltSeries->GetExtent(extents);
+  int xDim = extents[1] - extents[0] + 1; // Number of slices
+  int yDim = extents[3] - extents[2] + 1; // Number of rays
+  int zDim = extents[5] - extents[4] + 1; // Number of tilts
+  vtkMTimeType mtime = tiltSeries->GetMTime();
+  auto stack = std::make_shared<SinogramStack>(xDim, yDim, zDim);
+  switch (scalars->GetDataType()) {
+    vtkTemplateMacro(transposeToSinograms(
+      static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)), xDim, yDim,
+      zDim, stack->sinogram(0)));
+  }
+
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  if (stack->memorySize() > cache.budget) {
+    return stack;
+  }
+  for (auto it = cache.entries.begin(); it != cache.entries.end(); ++it) {
+    if (it->image == tiltSeries) {
+      // Another thread beat us to it, keep a single copy.
+      cache.erase(it);
+      break;
+    }
+  }
+  cache.prune(stack->memorySize());
+  vtkNew<vtkCallbackCommand> onDelete;
+  onDelete->SetCallback([](vtkObject* caller, unsigned long, void*, void*) {
+    releaseSinogramCache(static_cast<vtkImageData*>(caller));
+  });
+  auto observer = tiltSeries->AddObserver(vtkCommand::DeleteEvent, onDelete);
+  cache.entries.push_front({ tiltSeries, scalars, mtime, stack, observer });
+  cache.memoryUsage += stack->memorySize();
+  return stack;
+}
+
+void releaseSinogramCache(vtkImageData* tiltSeries)
+{
+  auto& cache = sinogramCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  for (auto it = cache.entries.begin(); it != cache.entries.end();) {
+    auto current = it++;
+    if (!tiltSeries || current->image == tiltSeries) {
+      cache.erase(current);
+    }
+  }
+}
+
+size_t sinogramCacheMemoryUsage()
+{
+  auto& cache = sinogramCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  return cache.memoryUsage;
+}
+
+size_t sinogramCacheBudget()
+{
+  auto& cache = sinogramCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  return cache.budget;
+}
+
+void setSinogramCacheBudget(size_t bytes)
+{
+  auto& cache = sinogramCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.budget = bytes;
+  cache.prune();
+}
+
 } // end of namespace TomographyTiltSeries
 } // end of namespace tomviz
@@ -7,6 +7,9 @@
 #include "pqReaction.h"
 #include "vtkImageData.h"
 
+#include <memory>
+#include <vector>
+
 namespace tomviz {
 
 class DataSource;
@@ -17,7 +20,9 @@ namespace TomographyTiltSeries {
 /// number.  If the input image has dimensions [x, y, z] the slice number must
 /// be in the interval [0,y-1].  The output is stored in the sinogram pointer,
 /// which should be a pointer to an array with dimensions [y, z, 1].
-/// Simply takes a y-z slice of the input image. Useful for reconstruction
+/// Simply takes a y-z slice of the input image. Useful for reconstruction.
+/// The slices come from sinogramStack() when the tilt series fits in the
+/// sinogram cache budget, otherwise only the requested slice is read.
 void getSinogram(vtkImageData* tiltSeries, int, float* sinogram);
 
 /// Interpolate a sinogram of given size and rotation axis. Useful for axis
@@ -34,6 +39,64 @@ void getSinogram(vtkImageData* tiltSeries, int, float* sinogram, int Nray,
 
 void averageTiltSeries(vtkImageData* tiltSeries,
                        float* average); // Average all tilts
+
+/// A tilt series converted to float and transposed into sinogram-major order.
+/// For a tilt series with dimensions [x, y, z] every one of the x sinograms is
+/// stored as a contiguous [y, z] block, in the same layout getSinogram()
+/// produces, so a reconstruction can walk the slices without strided reads.
+class SinogramStack
+{
+public:
+  SinogramStack(int numberOfSinograms, int numberOfRays, int numberOfTilts);
+
+  int numberOfSinograms() const { return m_numberOfSinograms; }
+  int numberOfRays() const { return m_numberOfRays; }
+  int numberOfTilts() const { return m_numberOfTilts; }
+
+  /// Pointer to the numberOfRays * numberOfTilts floats of sinogram "slice".
+  const float* sinogram(int slice) const
+  {
+    return m_data.data() + static_cast<size_t>(slice) * sinogramSize();
+  }
+  float* sinogram(int slice)
+  {
+    return m_data.data() + static_cast<size_t>(slice) * sinogramSize();
+  }
+
+  size_t sinogramSize() const
+  {
+    return static_cast<size_t>(m_numberOfRays) * m_numberOfTilts;
+  }
+
+  /// Size of the transposed data in bytes.
+  size_t memorySize() const { return m_data.size() * sizeof(float); }
+
+private:
+  int m_numberOfSinograms;
+  int m_numberOfRays;
+  int m_numberOfTilts;
+  std::vector<float> m_data;
+};
+
+/// Return all the sinograms of the tilt series in sinogram-major order. The
+/// transposition is done once, in parallel, and cached so that subsequent
+/// calls for the same image are free, including those of other
+/// reconstructions of the same tilt series. The cached copy is invalidated
+/// when the image's MTime changes, and dropped when the image is deleted.
+std::shared_ptr<const SinogramStack> sinogramStack(vtkImageData* tiltSeries);
+
+/// Drop the cached sinograms of tiltSeries, or of every image if nullptr is
+/// passed. Stacks still referenced by a caller stay alive until released.
+void releaseSinogramCache(vtkImageData* tiltSeries = nullptr);
+
+/// Number of bytes currently held by the sinogram cache.
+size_t sinogramCacheMemoryUsage();
+
+/// Maximum number of bytes the sinogram cache may retain. Least recently used
+/// stacks are evicted to honor it; a stack larger than the budget is still
+/// computed for the caller, but it is not retained.
+size_t sinogramCacheBudget();
+void setSinogramCacheBudget(size_t bytes);
 } // namespace TomographyTiltSeries
 } // namespace tomviz
 
@@ -6,42 +6,384 @@
 #include "ActiveObjects.h"
 #include "DataSource.h"
 #include "EmdFormat.h"
+#include "GenericHDF5Format.h"
 #include "LoadDataReaction.h"
 #include "ModuleManager.h"
 #include "Pipeline.h"
+#include "Utilities.h"
 
 #include <h5cpp/h5readwrite.h>
 
 #include <vtkImageData.h>
 #include <vtkNew.h>
+#include <vtkSmartPointer.h>
 
+#include <QApplication>
 #include <QDir>
+#include <QEventLoop>
+#include <QFile>
 #include <QFileInfo>
+#include <QFutureWatcher>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QProgressDialog>
+#include <QtConcurrent>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 using std::cerr;
 using std::endl;
 
 namespace tomviz {
 
-bool Tvh5Format::write(const std::string& fileName)
+QList<QPair<QPointer<DataSource>, int>> Tvh5Format::m_refinements;
+
+namespace {
+
+// A data source to write, with a snapshot of its data
+struct Node
+{
+  QPointer<DataSource> source;
+  std::string path;
+  vtkSmartPointer<vtkImageData> image;
+  vtkMTimeType mtime = 0;
+};
+
+// Appended to the nodes, or the file, being written until a save completes
+const std::string SavingSuffix = ".saving";
+
+// Appended to the nodes replaced by a save until it completes
+const std::string ReplacedSuffix = ".replaced";
+
+const std::string ActivePath = "/data/tomography";
+
+const std::string StatePath = "/tomviz_state";
+
+// The bytes of the nodes removed from the file. HDF5 does not reuse them,
+// so a save writes the whole file again once they are most of it.
+const char* UnusedBytesAttribute = "tomviz_unused_bytes";
+
+std::string dataSourcePath(const std::string& id)
+{
+  return "/tomviz_datasources/" + id;
+}
+
+// Called after each node is written, returns false to cancel the save
+using Progress = std::function<bool(int)>;
+
+bool writeState(h5::H5ReadWrite& writer, const QByteArray& state,
+                const std::string& suffix = std::string())
+{
+  if (!writer.writeData("/", StatePath.substr(1) + suffix,
+                        { static_cast<int>(state.size()) }, state.data())) {
+    cerr << "Failed to write tomviz_state" << endl;
+    return false;
+  }
+  return true;
+}
+
+// The link changes of an update. If one of them fails, those made before it
+// are undone in reverse order, so that the file is left as it was.
+class LinkJournal
+{
+public:
+  explicit LinkJournal(h5::H5ReadWrite& writer) : m_writer(writer) {}
+
+  bool move(const std::string& source, const std::string& destination)
+  {
+    if (!m_writer.moveLink(source, destination)) {
+      return false;
+    }
+    m_undo.push_back([this, source, destination]() {
+      return m_writer.moveLink(destination, source);
+    });
+    return true;
+  }
+
+  bool createSoftLink(const std::string& target, const std::string& path)
+  {
+    if (!m_writer.createSoftLink(target, path)) {
+      cerr << "Failed to link " << path << " to " << target << endl;
+      return false;
+    }
+    m_undo.push_back([this, path]() { return m_writer.removeLink(path); });
+    return true;
+  }
+
+  bool removeSoftLink(const std::string& path, const std::string& target)
+  {
+    if (!m_writer.removeLink(path)) {
+      return false;
+    }
+    m_undo.push_back([this, target, path]() {
+      return m_writer.createSoftLink(target, path);
+    });
+    return true;
+  }
+
+  // Returns false if the file could not be restored
+  bool undo()
+  {
+    bool restored = true;
+    for (auto it = m_undo.rbegin(); it != m_undo.rend(); ++it) {
+      restored = (*it)() && restored;
+    }
+    m_undo.clear();
+    return restored;
+  }
+
+private:
+  h5::H5ReadWrite& m_writer;
+  std::vector<std::function<bool()>> m_undo;
+};
+
+bool writeNodes(h5::H5ReadWrite& writer, const std::vector<Node>& nodes,
+                const std::string& suffix, const QVariantMap& options,
+                const Progress& progress)
+{
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    auto path = nodes[i].path + suffix;
+    if (writer.isGroup(path)) {
+      // Left over by a save that did not complete
+      writer.removeLink(path);
+    }
+    writer.createGroup(path);
+    if (!EmdFormat::writeNode(writer, path, nodes[i].image, options)) {
+      cerr << "Failed to write data source: " << nodes[i].path << endl;
+      return false;
+    }
+    if (progress && !progress(static_cast<int>(i) + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Write every data source and the state to a new file
+bool writeFile(const std::string& fileName, const std::string& activeId,
+               const QByteArray& state, const std::vector<Node>& nodes,
+               const QVariantMap& options, const Progress& progress)
+{
+  using h5::H5ReadWrite;
+  H5ReadWrite writer(fileName, H5ReadWrite::OpenMode::WriteOnly);
+  writer.setAttribute("/", "version_major", 0u);
+  writer.setAttribute("/", "version_minor", 2u);
+  writer.createGroup("/data");
+  writer.createGroup("/tomviz_datasources");
+
+  if (!writeNodes(writer, nodes, "", options, progress)) {
+    return false;
+  }
+
+  // The active data source is the standard EMD node, make a soft link
+  // rather than writing the data again
+  writer.createSoftLink(ActivePath, dataSourcePath(activeId));
+  return writeState(writer, state);
+}
+
+// The id of the data source linked to the standard EMD node of a file
+std::string linkedId(h5::H5ReadWrite& reader)
+{
+  for (const auto& id : reader.children("/tomviz_datasources")) {
+    if (reader.isSoftLink(dataSourcePath(id))) {
+      return id;
+    }
+  }
+  return std::string();
+}
+
+// Write the modified data sources and the state to a file written by a
+// previous save. The nodes and the state are written next to the ones they
+// replace. Those are then moved aside and the new ones moved in their place,
+// which is undone if a move fails, so the file is left as it was if the save
+// is canceled or fails. The replaced nodes are only removed at the end.
+bool updateFile(const std::string& fileName, const std::string& activeId,
+                const std::vector<std::string>& ids, const QByteArray& state,
+                const std::vector<Node>& nodes, const QVariantMap& options,
+                const Progress& progress)
+{
+  using h5::H5ReadWrite;
+  H5ReadWrite writer(fileName, H5ReadWrite::OpenMode::ReadWrite);
+
+  // The data sources that no longer exist, and the nodes left over by saves
+  // that did not complete
+  std::vector<std::string> removed;
+  for (const auto& id : writer.children("/tomviz_datasources")) {
+    if (std::find(ids.begin(), ids.end(), id) == ids.end()) {
+      removed.push_back(id);
+    }
+  }
+
+  auto discard = [&]() {
+    for (const auto& node : nodes) {
+      if (writer.isGroup(node.path + SavingSuffix)) {
+        writer.removeLink(node.path + SavingSuffix);
+      }
+    }
+    if (writer.isDataSet(StatePath + SavingSuffix)) {
+      writer.removeLink(StatePath + SavingSuffix);
+    }
+  };
+  if (writer.isDataSet(StatePath + SavingSuffix)) {
+    writer.removeLink(StatePath + SavingSuffix);
+  }
+  if (!writeNodes(writer, nodes, SavingSuffix, options, progress) ||
+      !writeState(writer, state, SavingSuffix)) {
+    discard();
+    return false;
+  }
+
+  LinkJournal journal(writer);
+  std::vector<std::string> replaced;
+  auto moveAside = [&](const std::string& path) {
+    // A path may be replaced twice, when the active data source changes
+    auto aside = path + ReplacedSuffix + std::to_string(replaced.size());
+    if (!journal.move(path, aside)) {
+      return false;
+    }
+    replaced.push_back(aside);
+    return true;
+  };
+
+  auto swap = [&]() {
+    // The active data source may have changed, only links are moved
+    auto previousId = linkedId(writer);
+    if (previousId != activeId) {
+      if (!previousId.empty() &&
+          !journal.removeSoftLink(dataSourcePath(previousId), ActivePath)) {
+        return false;
+      }
+      if (writer.isGroup(ActivePath)) {
+        bool kept = std::find(ids.begin(), ids.end(), previousId) != ids.end();
+        if (kept ? !journal.move(ActivePath, dataSourcePath(previousId))
+                 : !moveAside(ActivePath)) {
+          return false;
+        }
+      }
+      if (writer.isGroup(dataSourcePath(activeId)) &&
+          !journal.move(dataSourcePath(activeId), ActivePath)) {
+        return false;
+      }
+      if (!journal.createSoftLink(ActivePath, dataSourcePath(activeId))) {
+        return false;
+      }
+    }
+
+    for (const auto& node : nodes) {
+      if (writer.isGroup(node.path) && !moveAside(node.path)) {
+        return false;
+      }
+      if (!journal.move(node.path + SavingSuffix, node.path)) {
+        cerr << "Failed to replace data source: " << node.path << endl;
+        return false;
+      }
+    }
+
+    for (const auto& id : removed) {
+      // Skip the links removed or moved above, such as the link of a
+      // previous active data source, or a node left over by a save that did
+      // not complete and written again by this one.
+      auto path = dataSourcePath(id);
+      if (!writer.isSoftLink(path) && !writer.isGroup(path)) {
+        continue;
+      }
+      if (writer.isSoftLink(path)) {
+        // Linked to the active node, which was moved aside if need be
+        if (!journal.removeSoftLink(path, ActivePath)) {
+          return false;
+        }
+      } else if (!moveAside(path)) {
+        return false;
+      }
+    }
+
+    return moveAside(StatePath) &&
+           journal.move(StatePath + SavingSuffix, StatePath);
+  };
+
+  if (!swap()) {
+    if (!journal.undo()) {
+      cerr << "Failed to restore " << fileName << endl;
+    }
+    discard();
+    return false;
+  }
+
+  // The update is complete, the space of the replaced nodes is not reused
+  unsigned long long unused = 0;
+  if (writer.hasAttribute("/", UnusedBytesAttribute)) {
+    unused = writer.attribute<unsigned long long>("/", UnusedBytesAttribute);
+  }
+  for (const auto& path : replaced) {
+    unused += writer.storageSize(path);
+    writer.removeLink(path);
+  }
+  writer.setAttribute("/", UnusedBytesAttribute, unused);
+  return true;
+}
+
+// A file that can be updated, rather than written again, by a save. Once
+// half of it is the space of removed nodes, it is written again to reclaim
+// it.
+bool canUpdate(const std::string& fileName)
 {
-  // First, write the standard EMD file
-  DataSource* source = ActiveObjects::instance().activeDataSource();
+  QFileInfo info(fileName.c_str());
+  if (!info.exists() || info.size() == 0) {
+    return false;
+  }
+
+  using h5::H5ReadWrite;
+  H5ReadWrite reader(fileName, H5ReadWrite::OpenMode::ReadOnly);
+  if (!reader.isDataSet(StatePath) || !reader.isGroup(ActivePath) ||
+      linkedId(reader).empty()) {
+    return false;
+  }
 
-  if (!EmdFormat::write(fileName, source)) {
-    cerr << "Failed to write the standard EMD node" << endl;
+  unsigned long long unused = 0;
+  if (reader.hasAttribute("/", UnusedBytesAttribute)) {
+    unused = reader.attribute<unsigned long long>("/", UnusedBytesAttribute);
+  }
+  return unused <= static_cast<unsigned long long>(info.size()) / 2;
+}
+
+// Replace a file with one written next to it. The file is moved aside
+// first, and moved back if the new one can't take its place.
+bool replaceFile(const std::string& fileName, const std::string& newFile)
+{
+  QString target(fileName.c_str());
+  QString previous = target + ReplacedSuffix.c_str();
+  QFile::remove(previous);
+  if (QFile::exists(target) && !QFile::rename(target, previous)) {
+    cerr << "Failed to move " << fileName << " aside" << endl;
+    return false;
+  }
+  if (!QFile::rename(newFile.c_str(), target)) {
+    cerr << "Failed to move " << newFile << " to " << fileName << endl;
+    QFile::rename(previous, target);
     return false;
   }
+  QFile::remove(previous);
+  return true;
+}
 
-  // We will create a soft link to the active id later
-  auto activeId = source->id().toStdString();
+// Serialize the state, and snapshot the data sources to write: all of them,
+// or only the modified ones when a previous save is updated.
+bool prepare(const std::string& fileName, bool update, QByteArray& state,
+             std::string& activeId, std::vector<Node>& nodes)
+{
+  DataSource* active = ActiveObjects::instance().activeDataSource();
+  if (!active) {
+    cerr << "There is no active data source to save" << endl;
+    return false;
+  }
+  activeId = active->id().toStdString();
 
-  // Now, write the state file string to a dataset
   QFileInfo info(fileName.c_str());
   QJsonObject stateObject;
   auto success =
@@ -50,21 +392,15 @@ bool Tvh5Format::write(const std::string& fileName)
     cerr << "Failed to serialize the state of Tomviz" << endl;
     return false;
   }
+  state = QJsonDocument(stateObject).toJson();
 
-  QByteArray state = QJsonDocument(stateObject).toJson();
-
-  // Write the state file to "tomviz_state"
-  using h5::H5ReadWrite;
-  H5ReadWrite::OpenMode mode = H5ReadWrite::OpenMode::ReadWrite;
-  H5ReadWrite writer(fileName, mode);
-
-  if (!writer.writeData("/", "tomviz_state", { static_cast<int>(state.size()) }, state.data())) {
-    cerr << "Failed to write tomviz_state" << endl;
-    return false;
+  std::unique_ptr<h5::H5ReadWrite> reader;
+  if (update) {
+    reader.reset(new h5::H5ReadWrite(fileName,
+                                     h5::H5ReadWrite::OpenMode::ReadOnly));
   }
 
-  // Now, write all the data sources
-  writer.createGroup("/tomviz_datasources");
+  nodes.clear();
   auto sources = ModuleManager::instance().allDataSources();
   for (auto* ds : sources) {
     if (!ds) {
@@ -72,36 +408,178 @@ bool Tvh5Format::write(const std::string& fileName)
       continue;
     }
 
-    // Name the group after its id
+    // Name the group after its id. The active one is the standard EMD node.
     auto id = ds->id().toStdString();
+    auto path = id == activeId ? ActivePath : dataSourcePath(id);
 
-    if (id == activeId) {
-      // Make a soft link rather than writing the data again
-      writer.createSoftLink("/data/tomography", "/tomviz_datasources/" + id);
+    // Unmodified data sources are kept as they are in the file
+    if (reader && ds->isSavedTo(fileName.c_str()) &&
+        reader->isGroup(dataSourcePath(id))) {
       continue;
     }
 
-    std::string group = "/tomviz_datasources/" + id;
-    writer.createGroup(group);
+    Node node;
+    node.source = ds;
+    node.path = path;
+    node.image = vtkSmartPointer<vtkImageData>::New();
+    node.image->ShallowCopy(ds->imageData());
+    node.mtime = ds->imageData()->GetMTime();
+    nodes.push_back(node);
+  }
+  return true;
+}
 
-    // Write the data here
-    if (!EmdFormat::writeNode(writer, group, ds->imageData())) {
-      cerr << "Failed to write data source: " << id << endl;
-      return false;
+} // namespace
+
+bool Tvh5Format::write(const std::string& fileName, const QVariantMap& options)
+{
+  QByteArray state;
+  std::string activeId;
+  std::vector<Node> nodes;
+  if (!prepare(fileName, false, state, activeId, nodes)) {
+    return false;
+  }
+
+  bool success = false;
+  runWithHDF5Lock([&]() {
+    success = writeFile(fileName, activeId, state, nodes, options, Progress());
+  });
+  if (!success) {
+    return false;
+  }
+
+  for (const auto& node : nodes) {
+    node.source->setSavedTo(fileName.c_str(), node.mtime);
+  }
+  return true;
+}
+
+bool Tvh5Format::save(const std::string& fileName, const QVariantMap& options)
+{
+  // Events are processed while the data is written, saves started by them,
+  // such as autosaves, are refused.
+  static bool saving = false;
+  if (saving) {
+    cerr << "A save is already in progress" << endl;
+    return false;
+  }
+  saving = true;
+  std::shared_ptr<void> doneSaving(nullptr, [](void*) { saving = false; });
+
+  bool update = false;
+  bool prepared = false;
+  QByteArray state;
+  std::string activeId;
+  std::vector<Node> nodes;
+  runWithHDF5Lock([&]() {
+    update = canUpdate(fileName);
+    prepared = prepare(fileName, update, state, activeId, nodes);
+  });
+  if (!prepared) {
+    return false;
+  }
+
+  std::vector<std::string> ids;
+  for (auto* ds : ModuleManager::instance().allDataSources()) {
+    if (ds) {
+      ids.push_back(ds->id().toStdString());
     }
   }
 
+  // A new file is written next to the one it replaces. The lock is held for
+  // the whole save, so no other HDF5 calls come in between.
+  auto partFile = fileName + SavingSuffix;
+  std::atomic<bool> canceled(false);
+  auto run = [&](const Progress& progress) {
+    bool written = false;
+    runWithHDF5Lock([&]() {
+      if (update) {
+        written = updateFile(fileName, activeId, ids, state, nodes, options,
+                             progress);
+      } else {
+        written =
+          writeFile(partFile, activeId, state, nodes, options, progress) &&
+          replaceFile(fileName, partFile);
+      }
+    });
+    return written;
+  };
+
+  bool success = false;
+  if (!qobject_cast<QApplication*>(QCoreApplication::instance()) ||
+      nodes.empty()) {
+    // Only the state and the links are written, which is quick
+    success = run(Progress());
+  } else {
+    // Write the data on a worker thread, with the input blocked by the
+    // progress dialog. The snapshots share the arrays of the images, which
+    // the pipelines replace rather than modify.
+    QProgressDialog dialog("Saving state...", "Cancel", 0,
+                           static_cast<int>(nodes.size()),
+                           tomviz::mainWidget());
+    dialog.setWindowModality(Qt::ApplicationModal);
+    dialog.setMinimumDuration(0);
+    dialog.setValue(0);
+    dialog.show();
+    QObject::connect(&dialog, &QProgressDialog::canceled,
+                     [&canceled]() { canceled = true; });
+
+    auto progress = [&dialog, &canceled](int written) {
+      QMetaObject::invokeMethod(
+        &dialog, [&dialog, written]() { dialog.setValue(written); },
+        Qt::QueuedConnection);
+      return !canceled;
+    };
+
+    QEventLoop loop;
+    QFutureWatcher<bool> watcher;
+    QObject::connect(&watcher, &QFutureWatcher<bool>::finished, &loop,
+                     &QEventLoop::quit);
+    watcher.setFuture(QtConcurrent::run([&run, progress]() {
+      return run(progress);
+    }));
+    loop.exec();
+    success = watcher.result();
+  }
+
+  if (!success) {
+    if (!update) {
+      QFile::remove(partFile.c_str());
+    }
+    if (!canceled) {
+      cerr << "Failed to save the state to " << fileName << endl;
+    }
+    return false;
+  }
+
+  for (const auto& node : nodes) {
+    if (node.source) {
+      node.source->setSavedTo(fileName.c_str(), node.mtime);
+    }
+  }
   return true;
 }
 
 bool Tvh5Format::read(const std::string& fileName)
 {
-  // Read the state from "tomviz_state"
-  using h5::H5ReadWrite;
-  H5ReadWrite::OpenMode mode = H5ReadWrite::OpenMode::ReadOnly;
-  H5ReadWrite reader(fileName, mode);
+  // The HDF5 lock is only held around the reads from the file, not while
+  // the state is deserialized or the views are set up.
+  std::unique_ptr<h5::H5ReadWrite> reader;
+  runWithHDF5Lock([&]() {
+    reader.reset(
+      new h5::H5ReadWrite(fileName, h5::H5ReadWrite::OpenMode::ReadOnly));
+  });
+  bool success = readFile(*reader, fileName);
+  // Closing the file is an HDF5 call too
+  runWithHDF5Lock([&]() { reader.reset(); });
+  return success;
+}
 
-  auto stateVec = reader.readData<char>("tomviz_state");
+bool Tvh5Format::readFile(h5::H5ReadWrite& reader, const std::string& fileName)
+{
+  // Read the state from "tomviz_state"
+  std::vector<char> stateVec;
+  runWithHDF5Lock([&]() { stateVec = reader.readData<char>("tomviz_state"); });
   QString stateStr = std::string(stateVec.begin(), stateVec.end()).c_str();
 
   auto doc = QJsonDocument::fromJson(stateStr.toUtf8());
@@ -148,9 +626,58 @@ bool Tvh5Format::read(const std::string& fileName)
   // the view to the state given in the state file.
   ModuleManager::instance().setViews(state["views"].toArray());
 
+  // Swap in the finer levels of the multiscale pyramids
+  for (const auto& refinement : m_refinements) {
+    refine(refinement.first, refinement.second / 2);
+  }
+  m_refinements.clear();
+
   return true;
 }
 
+void Tvh5Format::refine(QPointer<DataSource> dataSource, int factor)
+{
+  if (!dataSource) {
+    return;
+  }
+
+  // Read each level on a worker thread, and swap it in on the GUI thread,
+  // so that every level gets rendered before the next, finer one is read.
+  int strides[3] = { factor, factor, factor };
+  auto reader = dataSource->resampleReader(strides);
+  if (!reader) {
+    return;
+  }
+
+  using Image = vtkSmartPointer<vtkImageData>;
+  using ImageWatcher = QFutureWatcher<Image>;
+  auto* watcher = new ImageWatcher(dataSource);
+  QObject::connect(watcher, &ImageWatcher::finished, dataSource, [=]() {
+    watcher->deleteLater();
+    Image image = watcher->result();
+    if (!image) {
+      cerr << "Failed to read the level downsampled by " << factor << endl;
+      return;
+    }
+
+    int levelStrides[3] = { factor, factor, factor };
+    dataSource->setResampledData(image, levelStrides);
+    if (factor > 1) {
+      refine(dataSource, factor / 2);
+    } else {
+      // The whole volume is loaded
+      dataSource->setWasSubsampled(false);
+    }
+    // The file still has the data, saving it does not need to write it
+    dataSource->setSavedTo(dataSource->fileName(),
+                           dataSource->imageData()->GetMTime());
+  });
+  watcher->setFuture(QtConcurrent::run([reader]() {
+    Image image = Image::New();
+    return reader(image) ? image : Image();
+  }));
+}
+
 bool Tvh5Format::loadDataSource(h5::H5ReadWrite& reader,
                                 const QJsonObject& dsObject,
                                 DataSource** active, Operator* parent)
@@ -161,11 +688,27 @@ bool Tvh5Format::loadDataSource(h5::H5ReadWrite& reader,
     return false;
   }
 
-  // First, create the image data
+  // First, create the image data. Root data sources with a multiscale
+  // pyramid start out with its coarsest level.
   std::string path = "/tomviz_datasources/" + id;
   vtkNew<vtkImageData> image;
   QVariantMap options = { { "askForSubsample", false } };
-  if (!EmdFormat::readNode(reader, path, image, options)) {
+  int factor = 1;
+  bool read = false;
+  std::string fileName;
+  runWithHDF5Lock([&]() {
+    fileName = reader.fileName();
+    if (!parent) {
+      auto factors =
+        GenericHDF5Format::multiscaleFactors(reader, path + "/data");
+      if (!factors.empty()) {
+        factor = factors.back();
+        options["subsampleStrides"] = QVariantList({ factor, factor, factor });
+      }
+    }
+    read = EmdFormat::readNode(reader, path, image, options);
+  });
+  if (!read) {
     cerr << "Failed to read data at: " << path << endl;
     return false;
   }
@@ -179,7 +722,7 @@ bool Tvh5Format::loadDataSource(h5::H5ReadWrite& reader,
   auto* dataSource = new DataSource(image, type, pipeline);
 
   // Save this info in case we write the data source in the future
-  dataSource->setFileName(reader.fileName().c_str());
+  dataSource->setFileName(fileName.c_str());
   dataSource->setTvh5NodePath(path.c_str());
 
   if (parent) {
@@ -196,6 +739,21 @@ bool Tvh5Format::loadDataSource(h5::H5ReadWrite& reader,
     dataSource->deserialize(dsObject);
   }
 
+  if (factor > 1) {
+    // Keep the physical size of the full resolution volume
+    double spacing[3];
+    dataSource->getSpacing(spacing);
+    for (auto& s : spacing) {
+      s *= factor;
+    }
+    dataSource->setSpacing(spacing, false);
+    m_refinements.append({ dataSource, factor });
+  }
+
+  // Saving to the same file only needs to write the modified data sources
+  dataSource->setSavedTo(dataSource->fileName(),
+                         dataSource->imageData()->GetMTime());
+
   // Set the active data source
   if (dsObject.value("active").toBool()) {
     *active = dataSource;
@@ -6,6 +6,11 @@
 
 #include <string>
 
+#include <QList>
+#include <QPair>
+#include <QPointer>
+#include <QVariantMap>
+
 class QJsonObject;
 
 namespace h5 {
@@ -20,15 +25,38 @@ class Operator;
 class Tvh5Format
 {
 public:
-  static bool write(const std::string& fileName);
+  // The write options select the chunking and compression of the volumes,
+  // see GenericHDF5Format::writeVolume().
+  static bool write(const std::string& fileName,
+                    const QVariantMap& options = QVariantMap());
+  // Save the state like write(), but incrementally: when the file was
+  // written by a previous save, only the state and the data sources modified
+  // since are replaced in it. The data is written on a worker thread while a
+  // progress dialog, which can cancel the save, blocks the input. A canceled
+  // or failed save leaves the file as it was. The space of the replaced data
+  // is not reused by HDF5, the whole file is written again once half of it
+  // is unused.
+  static bool save(const std::string& fileName,
+                   const QVariantMap& options = QVariantMap());
+  // Data sources with a multiscale pyramid are displayed at its coarsest
+  // level first, the finer levels are swapped in after the state is loaded.
   static bool read(const std::string& fileName);
 
 private:
+  static bool readFile(h5::H5ReadWrite& reader, const std::string& fileName);
+
   // Load a data source from data in a Tvh5 file
   // If the active data source is found, it is set to @param active
   static bool loadDataSource(h5::H5ReadWrite& reader,
                              const QJsonObject& dsObject, DataSource** active,
                              Operator* parent = nullptr);
+
+  // Read the level of the pyramid downsampled by factor on a worker thread,
+  // swap it in, then do the same for the finer ones
+  static void refine(QPointer<DataSource> dataSource, int factor);
+
+  // Data sources loaded from a pyramid level, and its downsampling factor
+  static QList<QPair<QPointer<DataSource>, int>> m_refinements;
 };
 } // namespace tomviz
 
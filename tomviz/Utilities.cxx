@@ -7,6 +7,8 @@
 #include "DataSource.h"
 #include "tomvizConfig.h"
 
+#include <h5cpp/h5readwrite.h>
+
 #include <pqAnimationCue.h>
 #include <pqAnimationManager.h>
 #include <pqAnimationScene.h>
@@ -60,12 +62,16 @@
 #include <QDebug>
 #include <QDesktopServices>
 #include <QDir>
+#include <QEventLoop>
 #include <QFileDialog>
 #include <QJsonArray>
 #include <QLayout>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QStandardPaths>
 #include <QString>
+#include <QThread>
+#include <QTimer>
 #include <QUrl>
 
 namespace tomviz {
@@ -1817,4 +1823,40 @@ void relabelXAndZAxes(vtkImageData* image)
   image->SetFieldData(fd);
 }
 
+void runWithHDF5Lock(const std::function<void()>& function)
+{
+  auto& mutex = h5::H5ReadWrite::mutex();
+  auto* app = qobject_cast<QApplication*>(QCoreApplication::instance());
+  if (!app || QThread::currentThread() != app->thread()) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    function();
+    return;
+  }
+
+  if (!mutex.try_lock()) {
+    // Nothing the user does may run while waiting, it could delete the
+    // caller, so user input is excluded from the loop and the dialog is
+    // shown right away.
+    QProgressDialog dialog("Waiting for another file to be read or written...",
+                           QString(), 0, 0, mainWidget());
+    dialog.setWindowModality(Qt::ApplicationModal);
+    dialog.setMinimumDuration(0);
+    dialog.setValue(0);
+
+    QEventLoop loop;
+    QTimer timer;
+    QObject::connect(&timer, &QTimer::timeout, &loop, [&]() {
+      if (mutex.try_lock()) {
+        timer.stop();
+        loop.quit();
+      }
+    });
+    timer.start(10);
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+  }
+
+  std::lock_guard<std::recursive_mutex> lock(mutex, std::adopt_lock);
+  function();
+}
+
 } // namespace tomviz
@@ -22,6 +22,7 @@
 #include <QStringList>
 #include <QVariant>
 
+#include <functional>
 #include <vector>
 
 class pqAnimationScene;
@@ -324,6 +325,16 @@ bool loadPlugins();
  */
 void relabelXAndZAxes(vtkImageData* image);
 
+/**
+ * Run a function that reads or writes HDF5 files holding the lock that every
+ * call into HDF5 holds, see h5::H5ReadWrite::mutex(), so that no other
+ * thread's calls come in between. On the GUI thread, while another thread
+ * holds the lock, events other than user input keep being processed, under
+ * a modal progress dialog, rather than waiting for it. Prefer reading on a
+ * worker thread, the GUI thread should rarely have to wait.
+ */
+void runWithHDF5Lock(const std::function<void()>& function);
+
 } // namespace tomviz
 
 #endif
@@ -156,9 +156,22 @@ WebExportWidget::WebExportWidget(QWidget* p) : QDialog(p)
   m_scale->setValue(1);
   m_scale->setMinimumWidth(100);
 
+  QLabel* bitsLabel = new QLabel("Quantization");
+  m_volumeBits = new QComboBox();
+  m_volumeBits->addItem("None", 0);
+  m_volumeBits->addItem("16 bit", 16);
+  m_volumeBits->addItem("8 bit", 8);
+
+  m_volumeCompression = new QCheckBox("Compress");
+
   QHBoxLayout* scaleGroupLayout = new QHBoxLayout;
   scaleGroupLayout->addWidget(scaleLabel);
   scaleGroupLayout->addWidget(m_scale);
+  scaleGroupLayout->addStretch();
+  scaleGroupLayout->addWidget(bitsLabel);
+  scaleGroupLayout->addWidget(m_volumeBits);
+  scaleGroupLayout->addStretch();
+  scaleGroupLayout->addWidget(m_volumeCompression);
 
   m_volumeResampleGroup = new QWidget();
   m_volumeResampleGroup->setLayout(scaleGroupLayout);
@@ -233,6 +246,8 @@ QMap<QString, QVariant> WebExportWidget::getKeywordArguments()
   m_kwargs["maxOpacity"] = QVariant(m_maxOpacity->value());
   m_kwargs["tentWidth"] = QVariant(m_spanValue->value());
   m_kwargs["volumeScale"] = QVariant(m_scale->value());
+  m_kwargs["volumeBits"] = m_volumeBits->currentData();
+  m_kwargs["volumeCompression"] = QVariant(m_volumeCompression->isChecked());
   m_kwargs["multiValue"] = QVariant(m_multiValue->text());
 
   return m_kwargs;
@@ -277,6 +292,8 @@ void WebExportWidget::writeWidgetSettings()
   settingsMap["maxOpacity"] = m_maxOpacity->value();
   settingsMap["tentWidth"] = m_spanValue->value();
   settingsMap["volumeScale"] = m_scale->value();
+  settingsMap["volumeBits"] = m_volumeBits->currentIndex();
+  settingsMap["volumeCompression"] = m_volumeCompression->isChecked();
   settingsMap["multiValue"] = m_multiValue->text();
 
   writeSettings(settingsMap);
@@ -322,6 +339,15 @@ void WebExportWidget::restoreSettings()
     m_scale->setValue(settingsMap.value("volumeScale").toInt());
   }
 
+  if (settingsMap.contains("volumeBits")) {
+    m_volumeBits->setCurrentIndex(settingsMap.value("volumeBits").toInt());
+  }
+
+  if (settingsMap.contains("volumeCompression")) {
+    m_volumeCompression->setChecked(
+      settingsMap.value("volumeCompression").toBool());
+  }
+
   if (settingsMap.contains("multiValue")) {
     m_multiValue->setText(settingsMap.value("multiValue").toString());
   }
@@ -47,7 +47,9 @@ private:
   void restoreSettings();
 
   QCheckBox* m_keepData;
+  QCheckBox* m_volumeCompression;
   QComboBox* m_exportType;
+  QComboBox* m_volumeBits;
   QLineEdit* m_multiValue;
   QDialogButtonBox* m_buttonBox;
   QPushButton* m_helpButton;
@@ -5,12 +5,128 @@
 
 #include "JsonRpcClient.h"
 
+#include <QJsonDocument>
 #include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QUrl>
+#include <QtEndian>
 
 namespace tomviz {
 
+namespace {
+// The most bytes a stream reply holds before the server is left to wait
+const qint64 STREAM_READ_BUFFER_SIZE = 64 * 1024 * 1024;
+// The largest frame a stream accepts, anything larger is a corrupt header
+const qint64 STREAM_MAX_FRAME_SIZE = qint64(4) << 30;
+} // namespace
+
+AcquisitionClientStream::AcquisitionClientStream(QNetworkReply* reply,
+                                                 QObject* parent)
+  : AcquisitionClientBaseRequest(parent), m_reply(reply)
+{
+  m_reply->setParent(this);
+  QObject::connect(m_reply, &QNetworkReply::readyRead, this,
+                   &AcquisitionClientStream::readFrames);
+  QObject::connect(m_reply, &QNetworkReply::finished, this,
+                   &AcquisitionClientStream::onFinished);
+}
+
+AcquisitionClientStream::~AcquisitionClientStream() = default;
+
+void AcquisitionClientStream::abort()
+{
+  if (m_reply == nullptr) {
+    return;
+  }
+
+  m_reply->disconnect(this);
+  m_reply->abort();
+  m_reply->deleteLater();
+  m_reply = nullptr;
+  m_buffer.clear();
+}
+
+void AcquisitionClientStream::readFrames()
+{
+  m_buffer.append(m_reply->readAll());
+
+  QList<AcquisitionFrame> frames;
+  qint64 offset = 0;
+  while (m_buffer.size() - offset >= 4) {
+    auto headerLength = static_cast<qint64>(qFromLittleEndian<quint32>(
+      reinterpret_cast<const uchar*>(m_buffer.constData() + offset)));
+    // A heartbeat
+    if (headerLength == 0) {
+      offset += 4;
+      continue;
+    }
+    if (m_buffer.size() - offset - 4 < headerLength) {
+      break;
+    }
+
+    QJsonParseError parseError;
+    auto header = QJsonDocument::fromJson(
+      m_buffer.mid(offset + 4, headerLength), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !header.isObject()) {
+      abort();
+      emit error("Invalid frame header in acquisition stream.",
+                 QJsonValue(parseError.error));
+      return;
+    }
+
+    auto object = header.object();
+    auto size = object["size"].toInteger(-1);
+    if (size < 0 || size > STREAM_MAX_FRAME_SIZE) {
+      abort();
+      emit error("Invalid frame size in acquisition stream.",
+                 QJsonValue(size));
+      return;
+    }
+    if (m_buffer.size() - offset - 4 - headerLength < size) {
+      break;
+    }
+
+    AcquisitionFrame frame;
+    frame.mimeType = object["mimeType"].toString();
+    frame.meta = object["meta"].toObject();
+    frame.data = m_buffer.mid(offset + 4 + headerLength, size);
+    frames.append(frame);
+    offset += 4 + headerLength + size;
+  }
+  m_buffer.remove(0, offset);
+
+  if (!frames.isEmpty()) {
+    emit framesReceived(frames);
+  }
+}
+
+void AcquisitionClientStream::onFinished()
+{
+  if (m_reply->bytesAvailable() > 0) {
+    readFrames();
+    // Aborted while handling the last frames
+    if (m_reply == nullptr) {
+      return;
+    }
+  }
+
+  auto reply = m_reply;
+  m_reply = nullptr;
+  reply->deleteLater();
+
+  if (reply->error() != QNetworkReply::NoError) {
+    QJsonValue data(reply->error());
+    emit error(reply->errorString(), data);
+    return;
+  }
+
+  emit finished();
+}
+
 AcquisitionClient::AcquisitionClient(const QString& url, QObject* parent)
-  : QObject(parent), m_jsonRpcClient(new JsonRpcClient(url, this))
+  : QObject(parent), m_jsonRpcClient(new JsonRpcClient(url, this)),
+    m_streamManager(new QNetworkAccessManager(this))
 {}
 
 AcquisitionClient::~AcquisitionClient() = default;
@@ -58,6 +174,18 @@ AcquisitionClientImageRequest* AcquisitionClient::stem_acquire()
   return makeImageRequest("stem_acquire");
 }
 
+AcquisitionClientStream* AcquisitionClient::stream()
+{
+  // The stream is served next to the JSON-RPC endpoint
+  QUrl url(this->url());
+  url.setPath("/stream");
+
+  auto reply = m_streamManager->get(QNetworkRequest(url));
+  reply->setReadBufferSize(STREAM_READ_BUFFER_SIZE);
+
+  return new AcquisitionClientStream(reply, this);
+}
+
 AcquisitionClientRequest* AcquisitionClient::describe(const QString& method)
 {
   QJsonObject params;
@@ -6,8 +6,13 @@
 
 #include <QObject>
 
+#include <QByteArray>
 #include <QJsonObject>
 #include <QJsonValue>
+#include <QList>
+
+class QNetworkAccessManager;
+class QNetworkReply;
 
 namespace tomviz {
 
@@ -53,6 +58,47 @@ signals:
                 const QJsonObject& meta);
 };
 
+/// A frame pushed by the server on a stream
+struct AcquisitionFrame
+{
+  QString mimeType;
+  QByteArray data;
+  QJsonObject meta;
+};
+
+/**
+ * The frames streamed by the server, as they are acquired. Each message is
+ * the length of a JSON header as a little endian uint32, the header, giving
+ * the MIME type, size and meta data of the frame, then the frame itself. An
+ * empty header is a heartbeat of an idle stream.
+ *
+ * The frames are handed over in the batches they arrive in. The reply only
+ * buffers a bounded amount, so while the frames are being handled the server
+ * blocks rather than queueing frames up in memory.
+ */
+class AcquisitionClientStream : public AcquisitionClientBaseRequest
+{
+  Q_OBJECT
+
+public:
+  explicit AcquisitionClientStream(QNetworkReply* reply, QObject* parent = 0);
+  ~AcquisitionClientStream() override;
+
+  /// Closes the stream, without emitting finished() or error()
+  void abort();
+
+signals:
+  void framesReceived(const QList<AcquisitionFrame>& frames);
+  void finished();
+
+private:
+  void readFrames();
+  void onFinished();
+
+  QNetworkReply* m_reply;
+  QByteArray m_buffer;
+};
+
 class AcquisitionClient : public QObject
 {
   Q_OBJECT
@@ -78,6 +124,9 @@ public slots:
 
   AcquisitionClientImageRequest* stem_acquire();
 
+  /// Frames pushed as they are acquired, as an alternative to stem_acquire()
+  AcquisitionClientStream* stream();
+
   AcquisitionClientRequest* describe(const QString& method);
 
   AcquisitionClientRequest* describe();
@@ -96,6 +145,7 @@ private slots:
 
 private:
   JsonRpcClient* m_jsonRpcClient;
+  QNetworkAccessManager* m_streamManager;
 };
 } // namespace tomviz
 
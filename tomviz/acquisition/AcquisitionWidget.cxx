@@ -7,6 +7,7 @@
 
 #include "AcquisitionClient.h"
 #include "ActiveObjects.h"
+#include "FrameDecoder.h"
 #include "Utilities.h"
 
 #include <pqApplicationCore.h>
@@ -23,13 +24,10 @@
 #include <vtkRenderWindowInteractor.h>
 #include <vtkRenderer.h>
 #include <vtkScalarsToColors.h>
-#include <vtkTIFFReader.h>
 
 #include <QBuffer>
 #include <QCloseEvent>
 #include <QDebug>
-#include <QDir>
-#include <QFile>
 
 namespace tomviz {
 
@@ -191,38 +189,11 @@ void AcquisitionWidget::acquirePreview(const QJsonValue& result)
 
 void AcquisitionWidget::previewReady(QString mimeType, QByteArray result)
 {
-  if (mimeType != "image/tiff") {
-    qDebug() << "image/tiff is the only supported mime type right now.\n"
-             << mimeType << "\n";
+  auto image = FrameDecoder::decode(mimeType, result);
+  if (!image) {
     return;
   }
-
-  QDir dir(QDir::homePath() + "/tomviz-data");
-  if (!dir.exists()) {
-    dir.mkpath(dir.path());
-  }
-
-  QString path = "/tomviz_";
-
-  if (m_tiltAngle > 0.0) {
-    path.append('+');
-  }
-  path.append(QString::number(m_tiltAngle, 'g', 2));
-  path.append(".tiff");
-
-  QFile file(dir.path() + path);
-  if (!file.open(QIODevice::WriteOnly)) {
-    qWarning() << "Failed to open file for writing:" << file.fileName();
-    return;
-  }
-  file.write(result);
-  qDebug() << "Data file:" << file.fileName();
-  file.close();
-
-  vtkNew<vtkTIFFReader> reader;
-  reader->SetFileName(file.fileName().toLatin1());
-  reader->Update();
-  m_imageData = reader->GetOutput();
+  m_imageData = image;
   m_imageSlice->GetProperty()->SetInterpolationTypeToNearest();
   m_imageSliceMapper->SetInputData(m_imageData);
   m_imageSliceMapper->Update();
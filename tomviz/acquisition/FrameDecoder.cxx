@@ -0,0 +1,379 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "FrameDecoder.h"
+
+#include <vtkByteSwap.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkType.h>
+
+#include "vtk_tiff.h"
+
+#include <QDebug>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QSysInfo>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// A read only TIFF "file" over the bytes of a frame
+struct MemoryFile
+{
+  const char* data;
+  toff_t size;
+  toff_t offset;
+};
+
+tmsize_t readProc(thandle_t handle, void* buffer, tmsize_t size)
+{
+  auto file = static_cast<MemoryFile*>(handle);
+  if (size <= 0 || file->offset >= file->size) {
+    return 0;
+  }
+  auto count = std::min(static_cast<toff_t>(size), file->size - file->offset);
+  std::memcpy(buffer, file->data + file->offset, count);
+  file->offset += count;
+  return static_cast<tmsize_t>(count);
+}
+
+tmsize_t writeProc(thandle_t, void*, tmsize_t)
+{
+  return 0;
+}
+
+toff_t seekProc(thandle_t handle, toff_t offset, int whence)
+{
+  auto file = static_cast<MemoryFile*>(handle);
+  switch (whence) {
+    case SEEK_SET:
+      file->offset = offset;
+      break;
+    case SEEK_CUR:
+      file->offset += offset;
+      break;
+    case SEEK_END:
+      file->offset = file->size + offset;
+      break;
+    default:
+      return static_cast<toff_t>(-1);
+  }
+  return file->offset;
+}
+
+int closeProc(thandle_t)
+{
+  return 0;
+}
+
+toff_t sizeProc(thandle_t handle)
+{
+  return static_cast<MemoryFile*>(handle)->size;
+}
+
+// The buffer is already in memory, so libtiff can read from it directly
+int mapProc(thandle_t handle, void** base, toff_t* size)
+{
+  auto file = static_cast<MemoryFile*>(handle);
+  *base = const_cast<char*>(file->data);
+  *size = file->size;
+  return 1;
+}
+
+void unmapProc(thandle_t, void*, toff_t) {}
+
+int tiffType(int format, int bits)
+{
+  switch (format) {
+    case SAMPLEFORMAT_UINT:
+      switch (bits) {
+        case 8:
+          return VTK_UNSIGNED_CHAR;
+        case 16:
+          return VTK_UNSIGNED_SHORT;
+        case 32:
+          return VTK_UNSIGNED_INT;
+        case 64:
+          return VTK_UNSIGNED_LONG_LONG;
+      }
+      break;
+    case SAMPLEFORMAT_INT:
+      switch (bits) {
+        case 8:
+          return VTK_SIGNED_CHAR;
+        case 16:
+          return VTK_SHORT;
+        case 32:
+          return VTK_INT;
+        case 64:
+          return VTK_LONG_LONG;
+      }
+      break;
+    case SAMPLEFORMAT_IEEEFP:
+      switch (bits) {
+        case 32:
+          return VTK_FLOAT;
+        case 64:
+          return VTK_DOUBLE;
+      }
+      break;
+  }
+  return -1;
+}
+
+int npyType(QChar kind, int size)
+{
+  switch (kind.toLatin1()) {
+    case 'b':
+      return size == 1 ? VTK_UNSIGNED_CHAR : -1;
+    case 'u':
+      return tiffType(SAMPLEFORMAT_UINT, size * 8);
+    case 'i':
+      return tiffType(SAMPLEFORMAT_INT, size * 8);
+    case 'f':
+      return tiffType(SAMPLEFORMAT_IEEEFP, size * 8);
+  }
+  return -1;
+}
+
+// Stripped images are read a row at a time, straight into their place
+bool readStrips(TIFF* tiff, unsigned char* out, uint32_t width,
+                uint32_t height, size_t pixelBytes, bool flip)
+{
+  size_t rowBytes = width * pixelBytes;
+  if (static_cast<size_t>(TIFFScanlineSize64(tiff)) != rowBytes) {
+    return false;
+  }
+  for (uint32_t row = 0; row < height; ++row) {
+    auto dst = out + (flip ? height - 1 - row : row) * rowBytes;
+    if (TIFFReadScanline(tiff, dst, row, 0) < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool readTiles(TIFF* tiff, unsigned char* out, uint32_t width,
+               uint32_t height, size_t pixelBytes, bool flip)
+{
+  uint32_t tileWidth = 0, tileHeight = 0;
+  if (!TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &tileWidth) ||
+      !TIFFGetField(tiff, TIFFTAG_TILELENGTH, &tileHeight)) {
+    return false;
+  }
+  std::vector<unsigned char> tile(TIFFTileSize64(tiff));
+  if (tile.size() < size_t(tileWidth) * tileHeight * pixelBytes) {
+    return false;
+  }
+  size_t rowBytes = width * pixelBytes;
+  for (uint32_t y = 0; y < height; y += tileHeight) {
+    for (uint32_t x = 0; x < width; x += tileWidth) {
+      if (TIFFReadTile(tiff, tile.data(), x, y, 0, 0) < 0) {
+        return false;
+      }
+      uint32_t rows = std::min(tileHeight, height - y);
+      size_t bytes = std::min(tileWidth, width - x) * pixelBytes;
+      for (uint32_t i = 0; i < rows; ++i) {
+        uint32_t row = y + i;
+        auto dst = out + (flip ? height - 1 - row : row) * rowBytes +
+                   x * pixelBytes;
+        std::memcpy(dst, tile.data() + i * tileWidth * pixelBytes, bytes);
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+namespace tomviz {
+
+vtkSmartPointer<vtkImageData> FrameDecoder::decode(const QString& mimeType,
+                                                   const QByteArray& data)
+{
+  // Ignore any parameters, such as "; charset=binary"
+  auto type = mimeType.section(';', 0, 0).trimmed();
+  if (type == "image/tiff") {
+    return decodeTiff(data);
+  } else if (type == "application/octet-stream") {
+    return decodeNpy(data);
+  }
+
+  qWarning() << "Unsupported frame mime type:" << mimeType;
+  return nullptr;
+}
+
+QString FrameDecoder::suffix(const QString& mimeType)
+{
+  auto type = mimeType.section(';', 0, 0).trimmed();
+  return type == "application/octet-stream" ? "npy" : "tiff";
+}
+
+vtkSmartPointer<vtkImageData> FrameDecoder::decodeTiff(const QByteArray& data)
+{
+  MemoryFile file = { data.constData(), static_cast<toff_t>(data.size()), 0 };
+  TIFF* tiff = TIFFClientOpen("frame", "r", &file, readProc, writeProc,
+                              seekProc, closeProc, sizeProc, mapProc,
+                              unmapProc);
+  if (!tiff) {
+    qWarning() << "Failed to open the TIFF frame.";
+    return nullptr;
+  }
+
+  uint32_t width = 0, height = 0;
+  uint16_t bits = 8, format = SAMPLEFORMAT_UINT, samples = 1;
+  uint16_t planar = PLANARCONFIG_CONTIG, orientation = ORIENTATION_TOPLEFT;
+  TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &width);
+  TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &height);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_BITSPERSAMPLE, &bits);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLEFORMAT, &format);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLESPERPIXEL, &samples);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_PLANARCONFIG, &planar);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_ORIENTATION, &orientation);
+
+  int type = tiffType(format, bits);
+  if (width == 0 || height == 0 || type < 0 ||
+      (samples > 1 && planar != PLANARCONFIG_CONTIG)) {
+    qWarning() << "Unsupported TIFF frame:" << width << "x" << height << bits
+               << "bits," << samples << "samples";
+    TIFFClose(tiff);
+    return nullptr;
+  }
+
+  auto image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(width, height, 1);
+  image->AllocateScalars(type, samples);
+  image->GetPointData()->GetScalars()->SetName("Tiff Scalars");
+
+  auto out = static_cast<unsigned char*>(image->GetScalarPointer());
+  size_t pixelBytes = samples * (bits / 8);
+  bool flip = orientation != ORIENTATION_BOTLEFT;
+  bool ok = TIFFIsTiled(tiff)
+              ? readTiles(tiff, out, width, height, pixelBytes, flip)
+              : readStrips(tiff, out, width, height, pixelBytes, flip);
+  TIFFClose(tiff);
+
+  if (!ok) {
+    qWarning() << "Failed to decode the TIFF frame.";
+    return nullptr;
+  }
+  return image;
+}
+
+vtkSmartPointer<vtkImageData> FrameDecoder::decodeNpy(const QByteArray& data)
+{
+  // The magic string, the format version, then the header length
+  static const QByteArray magic("\x93NUMPY");
+  if (!data.startsWith(magic) || data.size() < 10) {
+    qWarning() << "The raw frame doesn't have a NumPy header.";
+    return nullptr;
+  }
+  auto bytes = reinterpret_cast<const unsigned char*>(data.constData());
+  size_t headerLength = bytes[8] | (bytes[9] << 8);
+  size_t offset = 10;
+  if (bytes[6] >= 2) {
+    if (data.size() < 12) {
+      return nullptr;
+    }
+    headerLength |= (bytes[10] << 16) | (size_t(bytes[11]) << 24);
+    offset = 12;
+  }
+  if (offset + headerLength > static_cast<size_t>(data.size())) {
+    qWarning() << "The raw frame header is truncated.";
+    return nullptr;
+  }
+  auto header = QString::fromLatin1(data.mid(offset, headerLength));
+  offset += headerLength;
+
+  // The header is a Python dictionary literal, for example:
+  // {'descr': '<u2', 'fortran_order': False, 'shape': (512, 512), }
+  static const QRegularExpression descrExp(
+    "'descr':\\s*'([<>|=])([biuf])(\\d+)'");
+  static const QRegularExpression orderExp(
+    "'fortran_order':\\s*(True|False)");
+  static const QRegularExpression shapeExp("'shape':\\s*\\(([^)]*)\\)");
+  auto descr = descrExp.match(header);
+  auto order = orderExp.match(header);
+  auto shapeMatch = shapeExp.match(header);
+  if (!descr.hasMatch() || !order.hasMatch() || !shapeMatch.hasMatch()) {
+    qWarning() << "Unsupported raw frame header:" << header;
+    return nullptr;
+  }
+
+  int elementSize = descr.captured(3).toInt();
+  int type = npyType(descr.captured(2).at(0), elementSize);
+  bool fortran = order.captured(1) == "True";
+  std::vector<qint64> shape;
+  bool validShape = true;
+  for (auto& value :
+       shapeMatch.captured(1).split(',', Qt::SkipEmptyParts)) {
+    bool ok = false;
+    qint64 dim = value.trimmed().toLongLong(&ok);
+    validShape = validShape && ok && dim > 0 &&
+                 dim <= std::numeric_limits<int>::max();
+    shape.push_back(dim);
+  }
+  if (type < 0 || !validShape || shape.size() < 2 || shape.size() > 3) {
+    qWarning() << "Unsupported raw frame:" << header;
+    return nullptr;
+  }
+
+  // (rows, columns) or (slices, rows, columns)
+  if (shape.size() == 2) {
+    shape.insert(shape.begin(), 1);
+  }
+  qint64 depth = shape[0], height = shape[1], width = shape[2];
+
+  // The values must fit in the payload, which also keeps the product of the
+  // dimensions from overflowing.
+  size_t available = (data.size() - offset) / elementSize;
+  size_t count = 1;
+  for (auto dim : shape) {
+    if (static_cast<size_t>(dim) > available / count) {
+      qWarning() << "The raw frame is smaller than its header says.";
+      return nullptr;
+    }
+    count *= dim;
+  }
+
+  auto image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(width, height, depth);
+  image->AllocateScalars(type, 1);
+  image->GetPointData()->GetScalars()->SetName("ImageScalars");
+
+  auto in = data.constData() + offset;
+  auto out = static_cast<char*>(image->GetScalarPointer());
+  size_t rowBytes = width * elementSize;
+  for (qint64 z = 0; z < depth; ++z) {
+    for (qint64 y = 0; y < height; ++y) {
+      auto dst = out + ((z * height) + (height - 1 - y)) * rowBytes;
+      if (!fortran) {
+        std::memcpy(dst, in + ((z * height) + y) * rowBytes, rowBytes);
+        continue;
+      }
+      // Column major, the first index varies fastest
+      for (qint64 x = 0; x < width; ++x) {
+        auto src = in + ((x * height + y) * depth + z) * elementSize;
+        std::memcpy(dst + x * elementSize, src, elementSize);
+      }
+    }
+  }
+
+  bool bigEndian = descr.captured(1) == ">";
+  bool littleEndian = descr.captured(1) == "<";
+  bool nativeBig = QSysInfo::ByteOrder == QSysInfo::BigEndian;
+  if (elementSize > 1 && ((bigEndian && !nativeBig) ||
+                          (littleEndian && nativeBig))) {
+    vtkByteSwap::SwapVoidRange(out, count, elementSize);
+  }
+
+  return image;
+}
+
+} // namespace tomviz
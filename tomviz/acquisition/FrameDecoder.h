@@ -0,0 +1,45 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizFrameDecoder_h
+#define tomvizFrameDecoder_h
+
+#include <QByteArray>
+#include <QString>
+
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
+namespace tomviz {
+
+/**
+ * Decodes the frames received from an acquisition server straight from
+ * memory, without a round trip through a file.
+ *
+ * "image/tiff" frames are read with libtiff, through client I/O over the
+ * buffer. Only the first page is read, as vtkTIFFReader did for the frames.
+ *
+ * "application/octet-stream" frames are raw values after a NumPy (.npy)
+ * header giving their dtype and shape, as written by numpy.save(). A 2D
+ * (rows, columns) array is a single slice, a 3D array is a stack of them.
+ *
+ * Rows are flipped so that the first row is at the top of the image, as
+ * vtkTIFFReader presents it.
+ */
+class FrameDecoder
+{
+public:
+  /// Returns nullptr, with a warning, if the frame can't be decoded.
+  static vtkSmartPointer<vtkImageData> decode(const QString& mimeType,
+                                              const QByteArray& data);
+
+  /// The file extension to save a frame of this MIME type with.
+  static QString suffix(const QString& mimeType);
+
+  static vtkSmartPointer<vtkImageData> decodeTiff(const QByteArray& data);
+  static vtkSmartPointer<vtkImageData> decodeNpy(const QByteArray& data);
+};
+} // namespace tomviz
+
+#endif // tomvizFrameDecoder_h
@@ -8,6 +8,7 @@
 #include "AcquisitionClient.h"
 #include "ActiveObjects.h"
 #include "ConnectionDialog.h"
+#include "FrameDecoder.h"
 #include "InterfaceBuilder.h"
 #include "StartServerDialog.h"
 
@@ -21,19 +22,21 @@
 #include <vtkSMProxy.h>
 
 #include <vtkCamera.h>
+#include <vtkDataArray.h>
 #include <vtkImageData.h>
 #include <vtkImageProperty.h>
 #include <vtkImageSlice.h>
 #include <vtkImageSliceMapper.h>
 #include <vtkInteractorStyleRubberBand2D.h>
+#include <vtkPointData.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderer.h>
 #include <vtkScalarsToColors.h>
-#include <vtkTIFFReader.h>
 
 #include <QBuffer>
 #include <QCloseEvent>
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
@@ -48,6 +51,9 @@
 #include <QTabWidget>
 #include <QTimer>
 #include <QVBoxLayout>
+#include <QtConcurrent>
+
+#include <cstring>
 
 namespace tomviz {
 
@@ -137,6 +143,8 @@ void PassiveAcquisitionWidget::readSettings()
   if (!watchPath.isEmpty()) {
     m_ui->watchPathLineEdit->setText(watchPath);
   }
+  m_ui->saveFramesCheckBox->setChecked(
+    settings->value("saveFrames", false).toBool());
 
   settings->endGroup();
 }
@@ -147,6 +155,7 @@ void PassiveAcquisitionWidget::writeSettings()
   settings->beginGroup("acquisition");
   settings->setValue("passive.geometry", geometry());
   settings->setValue("watchPath", m_ui->watchPathLineEdit->text());
+  settings->setValue("saveFrames", m_ui->saveFramesCheckBox->isChecked());
   settings->endGroup();
 }
 
@@ -206,60 +215,171 @@ void PassiveAcquisitionWidget::connectToServer(bool startServer)
 void PassiveAcquisitionWidget::imageReady(QString mimeType, QByteArray result,
                                           float angle, bool hasAngle)
 {
-  if (mimeType != "image/tiff") {
-    qDebug() << "image/tiff is the only supported mime type right now.\n"
-             << mimeType << "\n";
+  if (m_ui->saveFramesCheckBox->isChecked()) {
+    saveFrame(mimeType, result, angle);
+  }
+
+  auto image = FrameDecoder::decode(mimeType, result);
+  if (!image) {
     return;
   }
+  addImages({ image }, { angle }, hasAngle);
+}
 
-  QDir dir(QDir::homePath() + "/tomviz-data");
-  if (!dir.exists()) {
-    dir.mkpath(dir.path());
+void PassiveAcquisitionWidget::framesReady(
+  const QList<AcquisitionFrame>& frames)
+{
+  QList<vtkSmartPointer<vtkImageData>> images;
+  QList<float> angles;
+  bool hasAngle = false;
+  for (auto& frame : frames) {
+    float angle = 0;
+    if (frame.meta.contains("angle")) {
+      angle = frame.meta["angle"].toString().toFloat();
+      hasAngle = true;
+    }
+    if (m_ui->saveFramesCheckBox->isChecked()) {
+      saveFrame(frame.mimeType, frame.data, angle);
+    }
+
+    auto image = FrameDecoder::decode(frame.mimeType, frame.data);
+    if (image) {
+      images.append(image);
+      angles.append(angle);
+    }
+  }
+
+  if (!images.isEmpty()) {
+    addImages(images, angles, hasAngle);
   }
+}
 
-  QString path = "/tomviz_";
+namespace {
 
-  if (angle > 0.0) {
-    path.append('+');
+bool canStack(vtkImageData* first, vtkImageData* image)
+{
+  int firstDims[3], dims[3];
+  first->GetDimensions(firstDims);
+  image->GetDimensions(dims);
+  return firstDims[0] == dims[0] && firstDims[1] == dims[1] &&
+         first->GetScalarType() == image->GetScalarType() &&
+         first->GetNumberOfScalarComponents() ==
+           image->GetNumberOfScalarComponents();
+}
+
+// Copies images of the same shape into one, one after the other in z
+vtkSmartPointer<vtkImageData> stackImages(
+  const QList<vtkSmartPointer<vtkImageData>>& images)
+{
+  auto first = images.first();
+  if (images.size() == 1) {
+    return first;
   }
-  path.append(QString::number(angle, 'g', 2));
-  path.append(".tiff");
 
-  QFile file(dir.path() + path);
-  if (!file.open(QIODevice::WriteOnly)) {
-    qWarning() << "Failed to open file for writing:" << file.fileName();
-    return;
+  int dims[3];
+  first->GetDimensions(dims);
+  int depth = 0;
+  for (auto& image : images) {
+    depth += image->GetDimensions()[2];
   }
-  file.write(result);
-  qDebug() << "Data file:" << file.fileName();
-  file.close();
-
-  vtkNew<vtkTIFFReader> reader;
-  reader->SetFileName(file.fileName().toLatin1());
-  reader->Update();
-  m_imageData = reader->GetOutput();
-
-  // If we haven't added it, add our live data source to the pipeline.
-  if (!m_dataSource) {
-    DataSource::DataSourceType t =
-      hasAngle ? DataSource::TiltSeries : DataSource::Volume;
-    m_dataSource = new DataSource(m_imageData, t);
-    m_dataSource->setLabel("Live!");
-    auto pipeline = new Pipeline(m_dataSource);
-    PipelineManager::instance().addPipeline(pipeline);
-    ModuleManager::instance().addDataSource(m_dataSource);
-    pipeline->addDefaultModules(m_dataSource);
-  } else {
-    m_dataSource->appendSlice(m_imageData);
+
+  auto stack = vtkSmartPointer<vtkImageData>::New();
+  stack->SetDimensions(dims[0], dims[1], depth);
+  stack->SetOrigin(first->GetOrigin());
+  stack->SetSpacing(first->GetSpacing());
+  stack->AllocateScalars(first->GetScalarType(),
+                         first->GetNumberOfScalarComponents());
+  stack->GetPointData()->GetScalars()->SetName(
+    first->GetPointData()->GetScalars()->GetName());
+
+  auto out = static_cast<char*>(stack->GetScalarPointer());
+  for (auto& image : images) {
+    auto scalars = image->GetPointData()->GetScalars();
+    auto bytes = static_cast<size_t>(scalars->GetNumberOfValues()) *
+                 scalars->GetDataTypeSize();
+    std::memcpy(out, image->GetScalarPointer(), bytes);
+    out += bytes;
   }
 
-  if (m_dataSource->type() == DataSource::TiltSeries) {
-    auto tiltAngles = m_dataSource->getTiltAngles();
-    tiltAngles << angle;
-    m_dataSource->setTiltAngles(tiltAngles);
+  return stack;
+}
+
+} // namespace
+
+void PassiveAcquisitionWidget::addImages(
+  const QList<vtkSmartPointer<vtkImageData>>& images,
+  const QList<float>& angles, bool hasAngle)
+{
+  int i = 0;
+  while (i < images.size()) {
+    // Consecutive frames of the same shape are appended together, so that the
+    // pipeline runs once for them rather than once per frame.
+    int end = i + 1;
+    while (end < images.size() && canStack(images[i], images[end])) {
+      ++end;
+    }
+    auto stack = stackImages(images.mid(i, end - i));
+    QVector<double> stackAngles;
+    for (int j = i; j < end; ++j) {
+      for (int k = 0; k < images[j]->GetDimensions()[2]; ++k) {
+        stackAngles << angles[j];
+      }
+    }
+    i = end;
+
+    // If we haven't added it, add our live data source to the pipeline.
+    if (!m_dataSource) {
+      DataSource::DataSourceType t =
+        hasAngle ? DataSource::TiltSeries : DataSource::Volume;
+      m_dataSource = new DataSource(stack, t);
+      m_dataSource->setLabel("Live!");
+      auto pipeline = new Pipeline(m_dataSource);
+      PipelineManager::instance().addPipeline(pipeline);
+      ModuleManager::instance().addDataSource(m_dataSource);
+      pipeline->addDefaultModules(m_dataSource);
+    } else if (!m_dataSource->appendSlice(stack)) {
+      continue;
+    }
+    m_imageData = stack;
+
+    if (m_dataSource->type() == DataSource::TiltSeries) {
+      auto data = vtkImageData::SafeDownCast(m_dataSource->dataObject());
+      auto tiltAngles = m_dataSource->getTiltAngles();
+      tiltAngles.resize(data->GetDimensions()[2] - stackAngles.size());
+      tiltAngles << stackAngles;
+      m_dataSource->setTiltAngles(tiltAngles);
+    }
   }
 }
 
+void PassiveAcquisitionWidget::saveFrame(const QString& mimeType,
+                                         const QByteArray& frame, float angle)
+{
+  QDir dir(QDir::homePath() + "/tomviz-data");
+  if (!dir.exists()) {
+    dir.mkpath(dir.path());
+  }
+
+  // The time stamp keeps repeated angles from overwriting each other
+  QString name = QString("tomviz_%1%2_%3.%4")
+                   .arg(angle > 0.0 ? "+" : "")
+                   .arg(QString::number(angle, 'g', 2))
+                   .arg(QDateTime::currentDateTime().toString(
+                     "yyyyMMdd-hhmmss-zzz"))
+                   .arg(FrameDecoder::suffix(mimeType));
+  QString fileName = dir.filePath(name);
+
+  // Written off the GUI thread, the frame is decoded from memory anyway
+  QtConcurrent::run([fileName, frame]() {
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+      qWarning() << "Failed to open file for writing:" << fileName;
+      return;
+    }
+    file.write(frame);
+  });
+}
+
 void PassiveAcquisitionWidget::onError(const QString& errorMessage,
                                        const QJsonValue& errorData)
 {
@@ -291,6 +411,27 @@ void PassiveAcquisitionWidget::watchSource()
 {
   m_ui->watchButton->setEnabled(false);
   m_ui->stopWatchingButton->setEnabled(true);
+
+  // Frames are pushed as soon as they are acquired, servers without a stream
+  // are polled instead.
+  m_stream = m_client->stream();
+  connect(m_stream, &AcquisitionClientStream::framesReceived, this,
+          &PassiveAcquisitionWidget::framesReady);
+  connect(m_stream, &AcquisitionClientStream::finished, this,
+          &PassiveAcquisitionWidget::stopWatching);
+  connect(m_stream, &AcquisitionClientStream::error, this,
+          [this](const QString& errorMessage, const QJsonValue& errorData) {
+            if (errorData.toInt() == QNetworkReply::ContentNotFoundError) {
+              m_stream->deleteLater();
+              pollSource();
+            } else {
+              onError(errorMessage, errorData);
+            }
+          });
+}
+
+void PassiveAcquisitionWidget::pollSource()
+{
   connect(m_watchTimer, &QTimer::timeout, this,
           [this]() {
             auto request = m_client->stem_acquire();
@@ -437,6 +578,10 @@ void PassiveAcquisitionWidget::checkEnableWatchButton()
 
 void PassiveAcquisitionWidget::stopWatching()
 {
+  if (m_stream) {
+    m_stream->abort();
+    m_stream->deleteLater();
+  }
   m_watchTimer->stop();
   m_ui->stopWatchingButton->setEnabled(false);
   m_ui->watchButton->setEnabled(true);
@@ -9,6 +9,7 @@
 #include "MatchInfo.h"
 
 #include <QLabel>
+#include <QList>
 #include <QPointer>
 #include <QScopedPointer>
 #include <QString>
@@ -32,7 +33,9 @@ class PassiveAcquisitionWidget;
 namespace tomviz {
 
 class AcquisitionClient;
+class AcquisitionClientStream;
 class DataSource;
+struct AcquisitionFrame;
 
 class PassiveAcquisitionWidget : public QDialog
 {
@@ -86,6 +89,7 @@ private:
   double m_calY = 0.0;
   QPointer<QWidget> m_connectParamsWidget;
   QPointer<QTimer> m_watchTimer;
+  QPointer<AcquisitionClientStream> m_stream;
   int m_retryCount = 5;
   QProcess* m_serverProcess = nullptr;
 
@@ -97,6 +101,12 @@ private:
   void startLocalServer();
   void displayError(const QString& errorMessage);
   void stopWatching();
+  void pollSource();
+  void framesReady(const QList<AcquisitionFrame>& frames);
+  void addImages(const QList<vtkSmartPointer<vtkImageData>>& images,
+                 const QList<float>& angles, bool hasAngle);
+  void saveFrame(const QString& mimeType, const QByteArray& frame,
+                 float angle);
   void validateTestFileName();
 
   void setupTestTable();
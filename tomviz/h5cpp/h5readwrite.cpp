@@ -4,9 +4,22 @@
 #include "h5readwrite.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <numeric>
+#include <thread>
+#include <type_traits>
+
+#include <vtk_zlib.h>
 
 #include "h5capi.h"
 #include "h5typemaps.h"
@@ -29,6 +42,620 @@ void setOk(bool* ok, bool status)
     *ok = status;
 }
 
+// Identifiers of the Zstandard and Blosc filter plugins, as registered with
+// The HDF Group.
+const H5Z_filter_t ZstdFilter = 32015;
+const H5Z_filter_t BloscFilter = 32001;
+
+// Data sets smaller than this are not worth chunking and compressing.
+const size_t MinimumCompressedSize = 4 << 20;
+
+using h5::HIDCloser;
+
+// Held for each call into the HDF5 library, see H5ReadWrite::mutex()
+using Lock = std::lock_guard<std::recursive_mutex>;
+
+// The number of threads decompressing chunks, 0 for one per core.
+std::atomic<int> ReadThreads(0);
+
+// The selection of a read, padded to three dimensions.
+struct Selection
+{
+  hsize_t start[3];
+  hsize_t strides[3];
+  hsize_t counts[3];
+  // Average the elements of each stride block, rather than taking the
+  // first one.
+  bool average;
+};
+
+// Get the filters of a chunk, in the order they were applied on write.
+// Only Deflate and shuffle can be reversed without the HDF5 filter
+// pipeline, false is returned if there are others.
+bool reversibleFilters(hid_t plistId, vector<H5Z_filter_t>& filters)
+{
+  int filterCount = H5Pget_nfilters(plistId);
+  for (int i = 0; i < filterCount; ++i) {
+    unsigned int flags = 0;
+    size_t valueCount = 0;
+    unsigned int config = 0;
+    H5Z_filter_t filter = H5Pget_filter2(plistId, i, &flags, &valueCount,
+                                         nullptr, 0, nullptr, &config);
+    if (filter != H5Z_FILTER_DEFLATE && filter != H5Z_FILTER_SHUFFLE)
+      return false;
+
+    filters.push_back(filter);
+  }
+  return true;
+}
+
+// Reverse the filters of a raw chunk that are not skipped in its filter
+// mask. chunk is resized to chunkBytes.
+bool decodeChunk(vector<char>& raw, uint32_t mask,
+                 const vector<H5Z_filter_t>& filters, size_t elementSize,
+                 size_t chunkBytes, vector<char>& chunk)
+{
+  for (size_t i = filters.size(); i-- > 0;) {
+    if (mask & (1u << i))
+      continue;
+
+    chunk.resize(chunkBytes);
+    if (filters[i] == H5Z_FILTER_DEFLATE) {
+      uLongf size = static_cast<uLongf>(chunkBytes);
+      if (uncompress(reinterpret_cast<Bytef*>(chunk.data()), &size,
+                     reinterpret_cast<const Bytef*>(raw.data()),
+                     static_cast<uLong>(raw.size())) != Z_OK ||
+          size != chunkBytes) {
+        return false;
+      }
+    } else {
+      // The shuffle filter stores byte b of element e at b * n + e, the
+      // bytes left over from a partial element are copied as they are.
+      if (raw.size() != chunkBytes)
+        return false;
+
+      size_t n = chunkBytes / elementSize;
+      for (size_t b = 0; b < elementSize; ++b) {
+        const char* in = raw.data() + b * n;
+        for (size_t e = 0; e < n; ++e)
+          chunk[e * elementSize + b] = in[e];
+      }
+      std::copy(raw.begin() + n * elementSize, raw.end(),
+                chunk.begin() + n * elementSize);
+    }
+    raw.swap(chunk);
+  }
+  chunk.swap(raw);
+  return chunk.size() == chunkBytes;
+}
+
+// The range [first, last] of the outputs, along one dimension, that take
+// elements from [begin, end) of the data set. When averaging, an output
+// takes all of the elements of its stride block. False if there are none.
+bool selectedRange(const Selection& selection, int dim, hsize_t begin,
+                   hsize_t end, hsize_t& first, hsize_t& last)
+{
+  hsize_t start = selection.start[dim];
+  hsize_t stride = selection.strides[dim];
+  if (end <= start || selection.counts[dim] == 0)
+    return false;
+
+  if (selection.average)
+    first = begin > start ? (begin - start) / stride : 0;
+  else
+    first = begin > start ? (begin - start + stride - 1) / stride : 0;
+  last = std::min((end - 1 - start) / stride, selection.counts[dim] - 1);
+  return first <= last;
+}
+
+// Copy the selected elements of a block of the data set, whose first
+// element is at origin, to the C ordered output of the selection.
+void scatterBlock(const char* block, const hsize_t origin[3],
+                  const hsize_t blockDims[3], const Selection& selection,
+                  size_t elementSize, char* output)
+{
+  hsize_t first[3], last[3];
+  for (int i = 0; i < 3; ++i) {
+    if (!selectedRange(selection, i, origin[i], origin[i] + blockDims[i],
+                       first[i], last[i])) {
+      return;
+    }
+  }
+
+  const hsize_t stride = selection.strides[2];
+  const size_t rowCount = static_cast<size_t>(last[2] - first[2] + 1);
+  for (hsize_t k0 = first[0]; k0 <= last[0]; ++k0) {
+    hsize_t b0 = selection.start[0] + k0 * selection.strides[0] - origin[0];
+    for (hsize_t k1 = first[1]; k1 <= last[1]; ++k1) {
+      hsize_t b1 = selection.start[1] + k1 * selection.strides[1] - origin[1];
+      hsize_t b2 = selection.start[2] + first[2] * stride - origin[2];
+      const char* in =
+        block + ((b0 * blockDims[1] + b1) * blockDims[2] + b2) * elementSize;
+      char* out = output + ((k0 * selection.counts[1] + k1) *
+                              selection.counts[2] +
+                            first[2]) *
+                             elementSize;
+      if (stride == 1) {
+        std::memcpy(out, in, rowCount * elementSize);
+      } else {
+        for (size_t k2 = 0; k2 < rowCount; ++k2) {
+          std::memcpy(out, in, elementSize);
+          out += elementSize;
+          in += stride * elementSize;
+        }
+      }
+    }
+  }
+}
+
+// Call f with a value of the C++ type of an H5 memory type.
+template <typename F>
+bool dispatchType(hid_t memTypeId, F&& f)
+{
+  size_t size = H5Tget_size(memTypeId);
+  if (H5Tget_class(memTypeId) == H5T_FLOAT) {
+    if (size == sizeof(float))
+      f(float());
+    else if (size == sizeof(double))
+      f(double());
+    else
+      return false;
+    return true;
+  }
+
+  if (H5Tget_class(memTypeId) != H5T_INTEGER)
+    return false;
+
+  bool isSigned = H5Tget_sign(memTypeId) == H5T_SGN_2;
+  switch (size) {
+    case 1:
+      isSigned ? f(int8_t()) : f(uint8_t());
+      break;
+    case 2:
+      isSigned ? f(int16_t()) : f(uint16_t());
+      break;
+    case 4:
+      isSigned ? f(int32_t()) : f(uint32_t());
+      break;
+    case 8:
+      isSigned ? f(int64_t()) : f(uint64_t());
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+// The sums of the stride blocks of the output planes (along the first
+// dimension) that are being averaged.
+class BinSums
+{
+public:
+  BinSums(const Selection& selection, const hsize_t dims[3])
+    : m_selection(selection)
+  {
+    std::copy(dims, dims + 3, m_dims);
+    // The number of elements of the stride blocks, which are clipped by
+    // the end of the data set.
+    for (int i = 0; i < 3; ++i) {
+      m_lengths[i].resize(selection.counts[i]);
+      for (hsize_t k = 0; k < selection.counts[i]; ++k) {
+        hsize_t begin = selection.start[i] + k * selection.strides[i];
+        m_lengths[i][k] = std::min(selection.strides[i], dims[i] - begin);
+      }
+    }
+  }
+
+  // Add the planes [first, last], not thread-safe.
+  void addPlanes(hsize_t first, hsize_t last)
+  {
+    size_t planeSize =
+      static_cast<size_t>(m_selection.counts[1] * m_selection.counts[2]);
+    for (hsize_t k0 = first; k0 <= last; ++k0) {
+      if (!m_planes.count(k0))
+        m_planes[k0].assign(planeSize, 0.0);
+    }
+  }
+
+  // Add the elements of a block of the data set to the sums.
+  template <typename T>
+  void add(const T* block, const hsize_t origin[3], const hsize_t blockDims[3])
+  {
+    hsize_t first[3], last[3];
+    for (int i = 0; i < 3; ++i) {
+      if (!selectedRange(m_selection, i, origin[i], origin[i] + blockDims[i],
+                         first[i], last[i])) {
+        return;
+      }
+    }
+
+    const hsize_t* start = m_selection.start;
+    const hsize_t* strides = m_selection.strides;
+    hsize_t blockEnd[3];
+    for (int i = 0; i < 3; ++i)
+      blockEnd[i] = std::min(origin[i] + blockDims[i], m_dims[i]);
+
+    vector<double> row(static_cast<size_t>(last[2] - first[2] + 1));
+    for (hsize_t k0 = first[0]; k0 <= last[0]; ++k0) {
+      double* plane = m_planes.find(k0)->second.data();
+      hsize_t i0Begin = std::max(origin[0], start[0] + k0 * strides[0]);
+      hsize_t i0End = std::min(blockEnd[0], start[0] + (k0 + 1) * strides[0]);
+      for (hsize_t k1 = first[1]; k1 <= last[1]; ++k1) {
+        hsize_t i1Begin = std::max(origin[1], start[1] + k1 * strides[1]);
+        hsize_t i1End =
+          std::min(blockEnd[1], start[1] + (k1 + 1) * strides[1]);
+
+        // Sum the part of the row of stride blocks inside the block
+        std::fill(row.begin(), row.end(), 0.0);
+        hsize_t i2Begin = std::max(origin[2], start[2] + first[2] * strides[2]);
+        hsize_t i2End = std::min(blockEnd[2], start[2] + (last[2] + 1) *
+                                                           strides[2]);
+        for (hsize_t i0 = i0Begin; i0 < i0End; ++i0) {
+          for (hsize_t i1 = i1Begin; i1 < i1End; ++i1) {
+            const T* in =
+              block + ((i0 - origin[0]) * blockDims[1] + (i1 - origin[1])) *
+                        blockDims[2];
+            for (hsize_t i2 = i2Begin; i2 < i2End; ++i2) {
+              row[(i2 - start[2]) / strides[2] - first[2]] +=
+                in[i2 - origin[2]];
+            }
+          }
+        }
+
+        double* sums = plane + k1 * m_selection.counts[2] + first[2];
+        std::lock_guard<std::mutex> lock(m_locks[k1 % LockCount]);
+        for (size_t k2 = 0; k2 < row.size(); ++k2)
+          sums[k2] += row[k2];
+      }
+    }
+  }
+
+  // Write the means of the planes before plane, and forget them. Not
+  // thread-safe.
+  template <typename T>
+  void flush(hsize_t plane, T* output)
+  {
+    size_t planeSize =
+      static_cast<size_t>(m_selection.counts[1] * m_selection.counts[2]);
+    for (auto it = m_planes.begin();
+         it != m_planes.end() && it->first < plane;) {
+      hsize_t k0 = it->first;
+      const double* sums = it->second.data();
+      T* out = output + k0 * planeSize;
+      for (hsize_t k1 = 0; k1 < m_selection.counts[1]; ++k1) {
+        double n01 = static_cast<double>(m_lengths[0][k0] * m_lengths[1][k1]);
+        for (hsize_t k2 = 0; k2 < m_selection.counts[2]; ++k2) {
+          double mean = *sums++ / (n01 * m_lengths[2][k2]);
+          if (std::is_integral<T>::value)
+            mean = std::round(mean);
+          *out++ = static_cast<T>(mean);
+        }
+      }
+      it = m_planes.erase(it);
+    }
+  }
+
+private:
+  static const int LockCount = 64;
+
+  const Selection& m_selection;
+  hsize_t m_dims[3];
+  vector<hsize_t> m_lengths[3];
+  map<hsize_t, vector<double>> m_planes;
+  std::mutex m_locks[LockCount];
+};
+
+enum class BlockRead
+{
+  Unsupported,
+  Failed,
+  Done
+};
+
+// Read the selection of a data set a block at a time, so every block is
+// read (and decompressed) once, even for strided selections. The blocks
+// are the chunks of chunked data sets, and slabs of contiguous ones.
+//
+// The blocks are read on this thread, as HDF5 may not be thread-safe. The
+// raw chunks of data sets compressed with Deflate are read, to be
+// decompressed, and then copied or averaged into the output, on a pool of
+// threads.
+BlockRead readBlocks(hid_t dataSetId, hid_t typeId, hid_t memTypeId,
+                     const vector<hsize_t>& start,
+                     const vector<hsize_t>& strides,
+                     const vector<hsize_t>& counts, bool average, void* data)
+{
+  int threadCount = ReadThreads;
+  if (threadCount <= 0)
+    threadCount = static_cast<int>(std::thread::hardware_concurrency());
+  threadCount = std::max(threadCount, 1);
+
+  size_t ndims = counts.size();
+  if (ndims < 1 || ndims > 3)
+    return BlockRead::Unsupported;
+
+  bool strided = std::any_of(strides.begin(), strides.end(),
+                             [](hsize_t s) { return s > 1; });
+  average = average && strided;
+
+  hid_t plistId = H5Dget_create_plist(dataSetId);
+  if (plistId < 0)
+    return BlockRead::Unsupported;
+
+  HIDCloser plistCloser(plistId, H5Pclose);
+
+  // Pad everything to three dimensions
+  hsize_t dims[3] = { 1, 1, 1 };
+  Selection selection = { { 0, 0, 0 }, { 1, 1, 1 }, { 1, 1, 1 }, average };
+  size_t pad = 3 - ndims;
+  {
+    hid_t spaceId = H5Dget_space(dataSetId);
+    HIDCloser spaceCloser(spaceId, H5Sclose);
+    if (H5Sget_simple_extent_dims(spaceId, dims + pad, nullptr) !=
+        static_cast<int>(ndims)) {
+      return BlockRead::Unsupported;
+    }
+  }
+  for (size_t i = 0; i < ndims; ++i) {
+    selection.start[pad + i] = start[i];
+    selection.strides[pad + i] = std::max<hsize_t>(strides[i], 1);
+    selection.counts[pad + i] = counts[i];
+  }
+
+  const size_t elementSize = H5Tget_size(memTypeId);
+  hsize_t blockDims[3] = { 1, 1, 1 };
+  vector<H5Z_filter_t> filters;
+  bool rawChunks = false;
+  if (H5Pget_layout(plistId) == H5D_CHUNKED) {
+    if (H5Pget_chunk(plistId, static_cast<int>(ndims), blockDims + pad) !=
+        static_cast<int>(ndims)) {
+      return BlockRead::Unsupported;
+    }
+    rawChunks = H5Tequal(typeId, memTypeId) > 0 &&
+                reversibleFilters(plistId, filters) && !filters.empty();
+    // Without strides, H5Dread reads every chunk once already
+    if (!strided && (!rawChunks || threadCount < 2))
+      return BlockRead::Unsupported;
+  } else if (average) {
+    // Slabs of whole stride blocks
+    size_t rowSize = static_cast<size_t>(dims[1] * dims[2]) * elementSize;
+    hsize_t rows = std::max<size_t>(1, MinimumCompressedSize * 4 / rowSize);
+    blockDims[0] = std::max(selection.strides[0],
+                            rows - rows % selection.strides[0]);
+    blockDims[1] = dims[1];
+    blockDims[2] = dims[2];
+  } else {
+    return BlockRead::Unsupported;
+  }
+
+  // Resolve the element type here, the worker threads must not call into
+  // HDF5 while this thread reads.
+  using AddBlock = void (*)(BinSums&, const char*, const hsize_t*,
+                            const hsize_t*);
+  using FlushPlanes = void (*)(BinSums&, hsize_t, void*);
+  AddBlock addBlock = nullptr;
+  FlushPlanes flushPlanes = nullptr;
+  if (average && !dispatchType(memTypeId, [&](auto t) {
+        using T = decltype(t);
+        addBlock = [](BinSums& sums, const char* block, const hsize_t* origin,
+                      const hsize_t* blockDims) {
+          sums.add(reinterpret_cast<const T*>(block), origin, blockDims);
+        };
+        flushPlanes = [](BinSums& sums, hsize_t plane, void* out) {
+          sums.flush(plane, static_cast<T*>(out));
+        };
+      })) {
+    return BlockRead::Unsupported;
+  }
+
+  // The blocks holding selected elements, grouped by their first index.
+  // Some may be skipped entirely by large strides.
+  vector<std::array<hsize_t, 3>> origins;
+  vector<hsize_t> sizes;
+  hsize_t first[3], last[3];
+  for (int i = 0; i < 3; ++i) {
+    if (selection.counts[i] == 0)
+      return BlockRead::Done;
+
+    hsize_t end = selection.start[i] +
+                  (selection.counts[i] - 1) * selection.strides[i] +
+                  (average ? selection.strides[i] - 1 : 0);
+    first[i] = selection.start[i] / blockDims[i];
+    last[i] = std::min(end, dims[i] - 1) / blockDims[i];
+  }
+  std::array<hsize_t, 3> origin;
+  for (hsize_t c0 = first[0]; c0 <= last[0]; ++c0) {
+    for (hsize_t c1 = first[1]; c1 <= last[1]; ++c1) {
+      for (hsize_t c2 = first[2]; c2 <= last[2]; ++c2) {
+        origin = { c0 * blockDims[0], c1 * blockDims[1], c2 * blockDims[2] };
+        bool selected = true;
+        for (int i = 0; i < 3 && selected; ++i) {
+          hsize_t a, b;
+          selected = selectedRange(selection, i, origin[i],
+                                   origin[i] + blockDims[i], a, b);
+        }
+        if (!selected)
+          continue;
+
+        // Chunks that were never written hold the fill value, leave them
+        // to H5Dread.
+        hsize_t size = 0;
+        if (rawChunks &&
+            (H5Dget_chunk_storage_size(dataSetId, origin.data() + pad,
+                                       &size) < 0 ||
+             size == 0)) {
+          rawChunks = false;
+          if (!strided)
+            return BlockRead::Unsupported;
+        }
+        origins.push_back(origin);
+        sizes.push_back(size);
+      }
+    }
+  }
+  if (!strided && origins.size() < 2)
+    return BlockRead::Unsupported;
+
+  const size_t chunkBytes =
+    static_cast<size_t>(blockDims[0] * blockDims[1] * blockDims[2]) *
+    elementSize;
+  BinSums sums(selection, dims);
+
+  struct Block
+  {
+    size_t index;
+    uint32_t mask;
+    bool raw;
+    hsize_t dims[3];
+    vector<char> data;
+  };
+
+  std::atomic<bool> failed(false);
+  auto process = [&](Block& block, vector<char>& chunk) {
+    if (block.raw) {
+      if (!decodeChunk(block.data, block.mask, filters, elementSize,
+                       chunkBytes, chunk)) {
+        failed = true;
+        return;
+      }
+      block.data.swap(chunk);
+    }
+
+    const hsize_t* blockOrigin = origins[block.index].data();
+    if (average) {
+      addBlock(sums, block.data.data(), blockOrigin, block.dims);
+    } else {
+      scatterBlock(block.data.data(), blockOrigin, block.dims, selection,
+                   elementSize, static_cast<char*>(data));
+    }
+  };
+
+  auto flush = [&](hsize_t plane) { flushPlanes(sums, plane, data); };
+
+  std::deque<Block> queue;
+  const size_t maximumQueued = 2 * threadCount;
+  size_t busy = 0;
+  std::mutex mutex;
+  std::condition_variable ready, space, idle;
+  bool done = false;
+
+  auto work = [&]() {
+    vector<char> chunk;
+    while (true) {
+      Block block;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [&]() { return !queue.empty() || done; });
+        if (queue.empty())
+          return;
+
+        block = std::move(queue.front());
+        queue.pop_front();
+        ++busy;
+      }
+      space.notify_one();
+
+      if (!failed)
+        process(block, chunk);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        --busy;
+      }
+      idle.notify_all();
+    }
+  };
+
+  // Reading on this thread is enough when nothing needs decompressing
+  vector<std::thread> threads;
+  if (rawChunks) {
+    threadCount = std::min(threadCount, static_cast<int>(origins.size()));
+    for (int i = 0; threadCount > 1 && i < threadCount; ++i)
+      threads.emplace_back(work);
+  }
+
+  auto waitUntilIdle = [&]() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [&]() { return queue.empty() && busy == 0; });
+  };
+
+  vector<char> chunk;
+  hsize_t row = dims[0];
+  for (size_t i = 0; i < origins.size() && !failed; ++i) {
+    const auto& o = origins[i];
+    if (average && o[0] != row) {
+      // Every block of the previous rows has been summed, so the planes
+      // before the ones of this row are complete.
+      row = o[0];
+      hsize_t firstPlane, lastPlane;
+      selectedRange(selection, 0, row, row + blockDims[0], firstPlane,
+                    lastPlane);
+      waitUntilIdle();
+      flush(firstPlane);
+      sums.addPlanes(firstPlane, lastPlane);
+    }
+
+    Block block = { i, 0, rawChunks, {}, {} };
+    if (rawChunks) {
+      std::copy(blockDims, blockDims + 3, block.dims);
+      block.data.resize(sizes[i]);
+      if (H5Dread_chunk(dataSetId, H5P_DEFAULT, o.data() + pad, &block.mask,
+                        block.data.data()) < 0) {
+        failed = true;
+        break;
+      }
+    } else {
+      // The block, clipped by the end of the data set
+      for (int j = 0; j < 3; ++j)
+        block.dims[j] = std::min(blockDims[j], dims[j] - o[j]);
+      block.data.resize(static_cast<size_t>(block.dims[0] * block.dims[1] *
+                                            block.dims[2]) *
+                        elementSize);
+      hid_t spaceId = H5Dget_space(dataSetId);
+      HIDCloser spaceCloser(spaceId, H5Sclose);
+      hid_t memSpaceId =
+        H5Screate_simple(static_cast<int>(ndims), block.dims + pad, nullptr);
+      HIDCloser memSpaceCloser(memSpaceId, H5Sclose);
+      if (H5Sselect_hyperslab(spaceId, H5S_SELECT_SET, o.data() + pad,
+                              nullptr, block.dims + pad, nullptr) < 0 ||
+          H5Dread(dataSetId, memTypeId, memSpaceId, spaceId, H5P_DEFAULT,
+                  block.data.data()) < 0) {
+        failed = true;
+        break;
+      }
+    }
+
+    if (threads.empty()) {
+      process(block, chunk);
+      continue;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      space.wait(lock, [&]() { return queue.size() < maximumQueued; });
+      queue.push_back(std::move(block));
+    }
+    ready.notify_one();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+  }
+  ready.notify_all();
+  for (auto& thread : threads)
+    thread.join();
+
+  if (failed) {
+    cerr << "Failed to read the blocks of the data set\n";
+    return BlockRead::Failed;
+  }
+  if (average)
+    flush(selection.counts[0]);
+
+  return BlockRead::Done;
+}
+
 } // end namespace
 
 namespace h5 {
@@ -157,6 +784,13 @@ public:
 
     HIDCloser parentCloser(parentId, closer);
 
+    // An existing attribute is replaced
+    if (H5Aexists(parentId, name.c_str()) > 0 &&
+        H5Adelete(parentId, name.c_str()) < 0) {
+      cerr << "Failed to replace attribute " << name << "\n";
+      return false;
+    }
+
     hid_t dataspaceId = H5Screate_simple(1, &dims, nullptr);
     hid_t attributeId = H5Acreate2(parentId, name.c_str(), fileTypeId,
                                    dataspaceId, H5P_DEFAULT, H5P_DEFAULT);
@@ -167,15 +801,130 @@ public:
     return H5Awrite(attributeId, typeId, value) >= 0;
   }
 
-  bool writeData(const string& path, const string& name,
-                 const std::vector<int>& dims, const void* data,
-                 hid_t dataTypeId, hid_t memTypeId)
+  bool filterAvailable(H5Z_filter_t filter)
+  {
+    // Looking for a missing plugin prints errors we do not care about.
+    bool errorsWereOff = m_errorHandlingIsOff;
+    turnOffErrors();
+    bool available = H5Zfilter_avail(filter) > 0;
+    if (!errorsWereOff)
+      turnOnErrors();
+    return available;
+  }
+
+  // Returns H5P_DEFAULT for contiguous data sets, a new property list
+  // that the caller must close otherwise, or a negative value on failure.
+  hid_t createDataSetProperties(const std::vector<int>& dims,
+                                hid_t dataTypeId, const WriteOptions& options)
+  {
+    if (!options.isChunked())
+      return H5P_DEFAULT;
+
+    // Chunks cannot be empty
+    for (auto dim : dims) {
+      if (dim <= 0)
+        return H5P_DEFAULT;
+    }
+
+    vector<int> chunks = options.chunkDimensions;
+    if (chunks.empty()) {
+      chunks = H5ReadWrite::guessChunkDimensions(dims, H5Tget_size(dataTypeId));
+    } else if (chunks.size() != dims.size()) {
+      cerr << "Chunk dimensions do not match the data set dimensions\n";
+      return H5I_INVALID_HID;
+    }
+
+    vector<hsize_t> h5chunks;
+    for (size_t i = 0; i < dims.size(); ++i) {
+      h5chunks.push_back(
+        static_cast<hsize_t>(std::max(1, std::min(chunks[i], dims[i]))));
+    }
+
+    hid_t plistId = H5Pcreate(H5P_DATASET_CREATE);
+    if (plistId < 0) {
+      cerr << "Failed to create the data set creation property list\n";
+      return H5I_INVALID_HID;
+    }
+    HIDCloser plistCloser(plistId, H5Pclose);
+
+    if (H5Pset_chunk(plistId, static_cast<int>(h5chunks.size()),
+                     h5chunks.data()) < 0) {
+      cerr << "Failed to set the chunk dimensions\n";
+      return H5I_INVALID_HID;
+    }
+
+    using Compression = WriteOptions::Compression;
+    auto compression = options.compression;
+    if ((compression == Compression::Zstd && !filterAvailable(ZstdFilter)) ||
+        (compression == Compression::Blosc && !filterAvailable(BloscFilter))) {
+      cerr << "Warning: the " << H5ReadWrite::compressionToString(compression)
+           << " filter is not available, using Deflate instead\n";
+      compression = Compression::Deflate;
+    }
+    if (compression == Compression::Deflate &&
+        !filterAvailable(H5Z_FILTER_DEFLATE)) {
+      cerr << "Warning: the Deflate filter is not available, the data will "
+              "not be compressed\n";
+      compression = Compression::None;
+    }
+
+    // Blosc does its own shuffling
+    if (options.shuffle && compression != Compression::Blosc)
+      H5Pset_shuffle(plistId);
+
+    herr_t status = 0;
+    int level = std::max(0, options.compressionLevel);
+    switch (compression) {
+      case Compression::Deflate:
+        status = H5Pset_deflate(plistId, std::min(level, 9));
+        break;
+      case Compression::Zstd: {
+        unsigned int values[1] = { static_cast<unsigned int>(level) };
+        status = H5Pset_filter(plistId, ZstdFilter, H5Z_FLAG_OPTIONAL, 1,
+                               values);
+        break;
+      }
+      case Compression::Blosc: {
+        // The first four values are filled in by the filter itself. The
+        // last one selects the blosclz compressor.
+        unsigned int bloscLevel = static_cast<unsigned int>(std::min(level, 9));
+        unsigned int values[7] = {
+          0, 0, 0, 0, bloscLevel, options.shuffle ? 1u : 0u, 0
+        };
+        status = H5Pset_filter(plistId, BloscFilter, H5Z_FLAG_OPTIONAL, 7,
+                               values);
+        break;
+      }
+      case Compression::None:
+        break;
+    }
+    if (status < 0) {
+      cerr << "Failed to set the compression filter\n";
+      return H5I_INVALID_HID;
+    }
+
+    // Hand the property list over to the caller
+    return plistCloser.release();
+  }
+
+  // Returns the id of the new data set, or a negative value on failure.
+  hid_t createDataSet(const string& path, const string& name,
+                      const std::vector<int>& dims, hid_t dataTypeId,
+                      const WriteOptions& options)
   {
     if (!fileIsValid()) {
       cerr << "File is invalid\n";
-      return false;
+      return H5I_INVALID_HID;
     }
 
+    hid_t createPlistId = createDataSetProperties(dims, dataTypeId, options);
+    if (createPlistId < 0)
+      return H5I_INVALID_HID;
+
+    HIDCloser createPlistCloser(
+      createPlistId == H5P_DEFAULT ? H5I_INVALID_HID : createPlistId,
+      H5Pclose);
+
     std::vector<hsize_t> h5dim;
     for (size_t i = 0; i < dims.size(); ++i) {
       h5dim.push_back(static_cast<hsize_t>(dims[i]));
@@ -183,11 +932,23 @@ public:
     hid_t groupId = H5Gopen(m_fileId, path.c_str(), H5P_DEFAULT);
     hid_t dataSpaceId =
       H5Screate_simple(static_cast<int>(dims.size()), &h5dim[0], nullptr);
-    hid_t dataId = H5Dcreate(groupId, name.c_str(), dataTypeId, dataSpaceId,
-                             H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 
     HIDCloser groupCloser(groupId, H5Gclose);
     HIDCloser spaceCloser(dataSpaceId, H5Sclose);
+
+    return H5Dcreate(groupId, name.c_str(), dataTypeId, dataSpaceId,
+                     H5P_DEFAULT, createPlistId, H5P_DEFAULT);
+  }
+
+  bool writeData(const string& path, const string& name,
+                 const std::vector<int>& dims, const void* data,
+                 hid_t dataTypeId, hid_t memTypeId,
+                 const WriteOptions& options)
+  {
+    hid_t dataId = createDataSet(path, name, dims, dataTypeId, options);
+    if (dataId < 0)
+      return false;
+
     HIDCloser dataCloser(dataId, H5Dclose);
 
     hid_t status =
@@ -196,6 +957,41 @@ public:
     return status >= 0;
   }
 
+  bool writeHyperslab(const string& path, hid_t memTypeId, const void* data,
+                      const size_t* start, const size_t* counts)
+  {
+    hid_t dataSetId = H5Dopen(m_fileId, path.c_str(), H5P_DEFAULT);
+    if (dataSetId < 0) {
+      cerr << "Failed to get dataSetId\n";
+      return false;
+    }
+
+    HIDCloser dataSetCloser(dataSetId, H5Dclose);
+
+    hid_t dataSpaceId = H5Dget_space(dataSetId);
+    if (dataSpaceId < 0) {
+      cerr << "Failed to get dataSpaceId\n";
+      return false;
+    }
+
+    HIDCloser dataSpaceCloser(dataSpaceId, H5Sclose);
+
+    int ndims = H5Sget_simple_extent_ndims(dataSpaceId);
+    vector<hsize_t> startVector(start, start + ndims);
+    vector<hsize_t> countsVector(counts, counts + ndims);
+    if (H5Sselect_hyperslab(dataSpaceId, H5S_SELECT_SET, startVector.data(),
+                            nullptr, countsVector.data(), nullptr) < 0) {
+      cerr << "Failed to select the hyperslab\n";
+      return false;
+    }
+
+    hid_t memSpace = H5Screate_simple(ndims, countsVector.data(), nullptr);
+    HIDCloser memSpaceCloser(memSpace, H5Sclose);
+
+    return H5Dwrite(dataSetId, memTypeId, memSpace, dataSpaceId, H5P_DEFAULT,
+                    data) >= 0;
+  }
+
   vector<int> getDimensions(const string& path)
   {
     vector<int> result;
@@ -244,12 +1040,69 @@ public:
     return result;
   }
 
+  bool writeOptions(const string& path, WriteOptions& options)
+  {
+    hid_t dataSetId = H5Dopen(m_fileId, path.c_str(), H5P_DEFAULT);
+    if (dataSetId < 0) {
+      cerr << "Failed to get dataSetId\n";
+      return false;
+    }
+
+    HIDCloser dataSetCloser(dataSetId, H5Dclose);
+
+    hid_t plistId = H5Dget_create_plist(dataSetId);
+    if (plistId < 0) {
+      cerr << "Failed to get the data set creation property list\n";
+      return false;
+    }
+
+    HIDCloser plistCloser(plistId, H5Pclose);
+
+    options = WriteOptions();
+    if (H5Pget_layout(plistId) != H5D_CHUNKED)
+      return true;
+
+    int dimCount = H5Pget_chunk(plistId, 0, nullptr);
+    if (dimCount < 1) {
+      cerr << "Failed to get the chunk dimensions\n";
+      return false;
+    }
+    vector<hsize_t> chunks(dimCount);
+    H5Pget_chunk(plistId, dimCount, chunks.data());
+    options.chunkDimensions.assign(chunks.begin(), chunks.end());
+
+    using Compression = WriteOptions::Compression;
+    int filterCount = H5Pget_nfilters(plistId);
+    for (int i = 0; i < filterCount; ++i) {
+      unsigned int flags = 0;
+      size_t valueCount = 8;
+      unsigned int values[8] = {};
+      unsigned int config = 0;
+      H5Z_filter_t filter = H5Pget_filter2(plistId, i, &flags, &valueCount,
+                                           values, 0, nullptr, &config);
+      if (filter == H5Z_FILTER_SHUFFLE) {
+        options.shuffle = true;
+      } else if (filter == H5Z_FILTER_DEFLATE) {
+        options.compression = Compression::Deflate;
+        options.compressionLevel = valueCount > 0 ? values[0] : 0;
+      } else if (filter == ZstdFilter) {
+        options.compression = Compression::Zstd;
+        options.compressionLevel = valueCount > 0 ? values[0] : 0;
+      } else if (filter == BloscFilter) {
+        options.compression = Compression::Blosc;
+        options.compressionLevel = valueCount > 4 ? values[4] : 0;
+        options.shuffle = valueCount > 5 && values[5] != 0;
+      }
+    }
+    return true;
+  }
+
   // void* data needs to be of the appropriate type and size.
   // start and counts, if set, get forwarded directly to
   // H5Sselect_hyperslab().
   bool readData(const string& path, hid_t dataTypeId, hid_t memTypeId,
                 void* data, int* strides = nullptr, size_t* start = nullptr,
-                size_t* counts = nullptr)
+                size_t* counts = nullptr, bool average = false)
   {
     hid_t dataSetId = H5Dopen(m_fileId, path.c_str(), H5P_DEFAULT);
     if (dataSetId < 0) {
@@ -268,37 +1121,36 @@ public:
 
     HIDCloser dataSpaceCloser(dataSpaceId, H5Sclose);
 
+    // First, get the dimensions
+    vector<int> dims = getDimensions(path);
+    size_t ndims = dims.size();
+
+    // Set defaults if needed
+    vector<hsize_t> stridesVector;
+    if (strides)
+      stridesVector = vector<hsize_t>(strides, strides + ndims);
+    else
+      stridesVector = vector<hsize_t>(ndims, 1);
+
+    vector<hsize_t> startVector;
+    if (start)
+      startVector = vector<hsize_t>(start, start + ndims);
+    else
+      startVector = vector<hsize_t>(ndims, 0);
+
+    vector<hsize_t> countsVector;
+    if (counts) {
+      countsVector = vector<hsize_t>(counts, counts + ndims);
+    } else {
+      countsVector.resize(ndims);
+      for (size_t i = 0; i < countsVector.size(); ++i)
+        countsVector[i] = (dims[i] - startVector[i]) / stridesVector[i];
+    }
+
     hid_t memSpace = H5S_ALL;
     HIDCloser memSpaceCloser(-1, H5Sclose);
     // Select a hyperslab if needed
     if (strides || start || counts) {
-
-      // First, get the dimensions
-      vector<int> dims = getDimensions(path);
-      size_t ndims = dims.size();
-
-      // Set defaults if needed
-      vector<hsize_t> stridesVector;
-      if (strides)
-        stridesVector = vector<hsize_t>(strides, strides + ndims);
-      else
-        stridesVector = vector<hsize_t>(ndims, 1);
-
-      vector<hsize_t> startVector;
-      if (start)
-        startVector = vector<hsize_t>(start, start + ndims);
-      else
-        startVector = vector<hsize_t>(ndims, 0);
-
-      vector<hsize_t> countsVector;
-      if (counts) {
-        countsVector = vector<hsize_t>(counts, counts + ndims);
-      } else {
-        countsVector.resize(ndims);
-        for (size_t i = 0; i < countsVector.size(); ++i)
-          countsVector[i] = (dims[i] - startVector[i]) / stridesVector[i];
-      }
-
       // Next, select the hyperslab
       H5Sselect_hyperslab(dataSpaceId, H5S_SELECT_SET, startVector.data(),
                           stridesVector.data(), countsVector.data(), nullptr);
@@ -321,6 +1173,13 @@ public:
       return false;
     }
 
+    // Read strided selections of chunked data sets a chunk at a time,
+    // decompressing the chunks on several threads when possible.
+    auto blockRead = readBlocks(dataSetId, typeId, memTypeId, startVector,
+                                stridesVector, countsVector, average, data);
+    if (blockRead != BlockRead::Unsupported)
+      return blockRead == BlockRead::Done;
+
     return H5Dread(dataSetId, memTypeId, memSpace, dataSpaceId, H5P_DEFAULT,
                    data) >= 0;
   }
@@ -388,6 +1247,31 @@ public:
     return visitor.dataSets;
   }
 
+  unsigned long long storageSize(const string& path)
+  {
+    if (!fileIsValid())
+      return 0;
+
+    vector<string> dataSets;
+    if (isDataSet(path)) {
+      dataSets.push_back(path);
+    } else {
+      for (const auto& name : allDataSets(path))
+        dataSets.push_back(path + "/" + name);
+    }
+
+    unsigned long long size = 0;
+    for (const auto& dataSet : dataSets) {
+      hid_t dataSetId = H5Dopen(fileId(), dataSet.c_str(), H5P_DEFAULT);
+      if (dataSetId < 0)
+        continue;
+
+      HIDCloser dataSetCloser(dataSetId, H5Dclose);
+      size += H5Dget_storage_size(dataSetId);
+    }
+    return size;
+  }
+
   bool createSoftLink(const string& target, const string& path)
   {
     if (!fileIsValid())
@@ -489,24 +1373,39 @@ public:
   void* m_clientErrorData;
 };
 
+std::recursive_mutex& H5ReadWrite::mutex()
+{
+  static std::recursive_mutex libraryMutex;
+  return libraryMutex;
+}
+
 H5ReadWrite::H5ReadWrite(const string& file, OpenMode mode)
-  : m_impl(new H5ReadWriteImpl(file, mode))
-{}
+{
+  Lock lock(mutex());
+  m_impl.reset(new H5ReadWriteImpl(file, mode));
+}
 
-H5ReadWrite::~H5ReadWrite() = default;
+H5ReadWrite::~H5ReadWrite()
+{
+  Lock lock(mutex());
+  m_impl.reset();
+}
 
 string H5ReadWrite::fileName() const
 {
+  Lock lock(mutex());
   return m_impl->fileName();
 }
 
 void H5ReadWrite::close()
 {
+  Lock lock(mutex());
   m_impl->clear();
 }
 
 vector<string> H5ReadWrite::children(const string& path, bool* ok)
 {
+  Lock lock(mutex());
   setOk(ok, false);
   vector<string> result;
 
@@ -540,6 +1439,7 @@ vector<string> H5ReadWrite::children(const string& path, bool* ok)
 template <typename T>
 T H5ReadWrite::attribute(const string& path, const string& name, bool* ok)
 {
+  Lock lock(mutex());
   setOk(ok, false);
   T result;
 
@@ -615,16 +1515,19 @@ string H5ReadWrite::attribute<string>(const string& path, const string& name,
 
 bool H5ReadWrite::hasAttribute(const string& path)
 {
+  Lock lock(mutex());
   return m_impl->hasAttribute(path);
 }
 
 bool H5ReadWrite::hasAttribute(const string& path, const string& name)
 {
+  Lock lock(mutex());
   return m_impl->attributeExists(path, name);
 }
 
 DataType H5ReadWrite::attributeType(const string& path, const string& name)
 {
+  Lock lock(mutex());
   if (!m_impl->attributeExists(path, name)) {
     cerr << "Attribute " << path << name << " not found!" << endl;
     return DataType::None;
@@ -648,21 +1551,31 @@ DataType H5ReadWrite::attributeType(const string& path, const string& name)
 
 bool H5ReadWrite::isDataSet(const string& path)
 {
+  Lock lock(mutex());
   return m_impl->isDataSet(path);
 }
 
 bool H5ReadWrite::isGroup(const string& path)
 {
+  Lock lock(mutex());
   return m_impl->isGroup(path);
 }
 
 vector<string> H5ReadWrite::allDataSets(const string& path)
 {
+  Lock lock(mutex());
   return m_impl->allDataSets(path);
 }
 
+unsigned long long H5ReadWrite::storageSize(const string& path)
+{
+  Lock lock(mutex());
+  return m_impl->storageSize(path);
+}
+
 DataType H5ReadWrite::dataType(const string& path)
 {
+  Lock lock(mutex());
   if (!m_impl->isDataSet(path)) {
     cerr << path << " is not a data set.\n";
     return DataType::None;
@@ -685,11 +1598,13 @@ DataType H5ReadWrite::dataType(const string& path)
 
 vector<int> H5ReadWrite::getDimensions(const string& path)
 {
+  Lock lock(mutex());
   return m_impl->getDimensions(path);
 }
 
 int H5ReadWrite::dimensionCount(const string& path)
 {
+  Lock lock(mutex());
   vector<int> dims = getDimensions(path);
   if (dims.empty()) {
     cerr << "Failed to get the dimensions\n";
@@ -702,6 +1617,7 @@ int H5ReadWrite::dimensionCount(const string& path)
 template <typename T>
 vector<T> H5ReadWrite::readData(const string& path)
 {
+  Lock lock(mutex());
   vector<int> dims;
   vector<T> result = readData<T>(path, dims);
   if (result.empty()) {
@@ -723,6 +1639,7 @@ vector<T> H5ReadWrite::readData(const string& path)
 template <typename T>
 vector<T> H5ReadWrite::readData(const string& path, vector<int>& dims)
 {
+  Lock lock(mutex());
   vector<T> result;
 
   dims = getDimensions(path);
@@ -747,6 +1664,7 @@ vector<T> H5ReadWrite::readData(const string& path, vector<int>& dims)
 template <typename T>
 bool H5ReadWrite::readData(const string& path, T* data)
 {
+  Lock lock(mutex());
   const hid_t dataTypeId = BasicTypeToH5<T>::dataTypeId();
   const hid_t memTypeId = BasicTypeToH5<T>::memTypeId();
 
@@ -759,8 +1677,10 @@ bool H5ReadWrite::readData(const string& path, T* data)
 }
 
 bool H5ReadWrite::readData(const string& path, const DataType& type, void* data,
-                           int* strides, size_t* start, size_t* counts)
+                           int* strides, size_t* start, size_t* counts,
+                           bool average)
 {
+  Lock lock(mutex());
   auto it = DataTypeToH5DataType.find(type);
   if (it == DataTypeToH5DataType.end()) {
     cerr << "Failed to get H5 data type for " << dataTypeToString(type) << "\n";
@@ -778,7 +1698,7 @@ bool H5ReadWrite::readData(const string& path, const DataType& type, void* data,
   hid_t memTypeId = memIt->second;
 
   if (!m_impl->readData(path, dataTypeId, memTypeId, data, strides, start,
-                        counts)) {
+                        counts, average)) {
     cerr << "Failed to read the data\n";
     return false;
   }
@@ -786,20 +1706,65 @@ bool H5ReadWrite::readData(const string& path, const DataType& type, void* data,
   return true;
 }
 
+bool H5ReadWrite::createDataSet(const string& path, const string& name,
+                                const vector<int>& dims, const DataType& type,
+                                const WriteOptions& options)
+{
+  Lock lock(mutex());
+  auto it = DataTypeToH5DataType.find(type);
+  if (it == DataTypeToH5DataType.end()) {
+    cerr << "Failed to get H5 data type for " << dataTypeToString(type) << "\n";
+    return false;
+  }
+
+  hid_t dataId = m_impl->createDataSet(path, name, dims, it->second, options);
+  if (dataId < 0)
+    return false;
+
+  H5Dclose(dataId);
+  return true;
+}
+
+bool H5ReadWrite::writeHyperslab(const string& path, const DataType& type,
+                                 const void* data, const size_t* start,
+                                 const size_t* counts)
+{
+  Lock lock(mutex());
+  auto it = DataTypeToH5MemType.find(type);
+  if (it == DataTypeToH5MemType.end()) {
+    cerr << "Failed to get H5 mem type for " << dataTypeToString(type) << "\n";
+    return false;
+  }
+
+  return m_impl->writeHyperslab(path, it->second, data, start, counts);
+}
+
+WriteOptions H5ReadWrite::writeOptions(const string& path, bool* ok)
+{
+  Lock lock(mutex());
+  WriteOptions options;
+  setOk(ok, m_impl->writeOptions(path, options));
+  return options;
+}
+
 template <typename T>
 bool H5ReadWrite::writeData(const string& path, const string& name,
-                            const vector<int>& dims, const T* data)
+                            const vector<int>& dims, const T* data,
+                            const WriteOptions& options)
 {
+  Lock lock(mutex());
   const hid_t dataTypeId = BasicTypeToH5<T>::dataTypeId();
   const hid_t memTypeId = BasicTypeToH5<T>::memTypeId();
 
-  return m_impl->writeData(path, name, dims, data, dataTypeId, memTypeId);
+  return m_impl->writeData(path, name, dims, data, dataTypeId, memTypeId,
+                           options);
 }
 
 bool H5ReadWrite::writeData(const string& path, const string& name,
                             const vector<int>& dims, const DataType& type,
-                            const void* data)
+                            const void* data, const WriteOptions& options)
 {
+  Lock lock(mutex());
   auto it = DataTypeToH5DataType.find(type);
   if (it == DataTypeToH5DataType.end()) {
     cerr << "Failed to get H5 data type for " << dataTypeToString(type) << "\n";
@@ -816,12 +1781,14 @@ bool H5ReadWrite::writeData(const string& path, const string& name,
 
   hid_t memTypeId = memIt->second;
 
-  return m_impl->writeData(path, name, dims, data, dataTypeId, memTypeId);
+  return m_impl->writeData(path, name, dims, data, dataTypeId, memTypeId,
+                           options);
 }
 
 template <typename T>
 bool H5ReadWrite::setAttribute(const string& path, const string& name, T value)
 {
+  Lock lock(mutex());
   const hid_t dataTypeId = BasicTypeToH5<T>::dataTypeId();
   const hid_t memTypeId = BasicTypeToH5<T>::memTypeId();
 
@@ -834,6 +1801,7 @@ bool H5ReadWrite::setAttribute<const string&>(const string& path,
                                               const string& name,
                                               const string& value)
 {
+  Lock lock(mutex());
   if (!m_impl->fileIsValid()) {
     cerr << "File is not valid\n";
     return false;
@@ -892,6 +1860,7 @@ bool H5ReadWrite::setAttribute<const char*>(const string& path,
 
 bool H5ReadWrite::createGroup(const string& path)
 {
+  Lock lock(mutex());
   if (!m_impl->fileIsValid()) {
     cerr << "File is not valid\n";
     return false;
@@ -911,14 +1880,47 @@ bool H5ReadWrite::createGroup(const string& path)
 
 bool H5ReadWrite::createSoftLink(const string& target, const string& path)
 {
+  Lock lock(mutex());
   return m_impl->createSoftLink(target, path);
 }
 
 bool H5ReadWrite::isSoftLink(const string& path)
 {
+  Lock lock(mutex());
   return m_impl->isSoftLink(path);
 }
 
+bool H5ReadWrite::removeLink(const string& path)
+{
+  Lock lock(mutex());
+  if (!m_impl->fileIsValid()) {
+    cerr << "File is not valid\n";
+    return false;
+  }
+
+  if (H5Ldelete(m_impl->fileId(), path.c_str(), H5P_DEFAULT) < 0) {
+    cerr << "Failed to remove " << path << "\n";
+    return false;
+  }
+  return true;
+}
+
+bool H5ReadWrite::moveLink(const string& source, const string& destination)
+{
+  Lock lock(mutex());
+  if (!m_impl->fileIsValid()) {
+    cerr << "File is not valid\n";
+    return false;
+  }
+
+  if (H5Lmove(m_impl->fileId(), source.c_str(), m_impl->fileId(),
+              destination.c_str(), H5P_DEFAULT, H5P_DEFAULT) < 0) {
+    cerr << "Failed to move " << source << " to " << destination << "\n";
+    return false;
+  }
+  return true;
+}
+
 string H5ReadWrite::dataTypeToString(const DataType& type)
 {
   // Internal map. Keep it updated with the enum.
@@ -938,6 +1940,108 @@ string H5ReadWrite::dataTypeToString(const DataType& type)
   return it->second;
 }
 
+size_t H5ReadWrite::dataTypeSize(const DataType& type)
+{
+  Lock lock(mutex());
+  auto it = DataTypeToH5DataType.find(type);
+  if (it == DataTypeToH5DataType.end())
+    return 0;
+
+  return H5Tget_size(it->second);
+}
+
+// Internal map. Keep it updated with the enum.
+static const map<WriteOptions::Compression, const char*> CompressionToString = {
+  { WriteOptions::Compression::None, "None" },
+  { WriteOptions::Compression::Deflate, "Deflate" },
+  { WriteOptions::Compression::Zstd, "Zstd" },
+  { WriteOptions::Compression::Blosc, "Blosc" }
+};
+
+string H5ReadWrite::compressionToString(
+  const WriteOptions::Compression& compression)
+{
+  auto it = CompressionToString.find(compression);
+  if (it == CompressionToString.end())
+    return "";
+
+  return it->second;
+}
+
+WriteOptions::Compression H5ReadWrite::compressionFromString(
+  const string& compression, bool* ok)
+{
+  string lower(compression);
+  std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+  for (const auto& it : CompressionToString) {
+    string name(it.second);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name == lower) {
+      setOk(ok, true);
+      return it.first;
+    }
+  }
+
+  setOk(ok, false);
+  return WriteOptions::Compression::None;
+}
+
+WriteOptions H5ReadWrite::defaultWriteOptions(const DataType& type,
+                                              const vector<int>& dims)
+{
+  WriteOptions options;
+  size_t elementSize = dataTypeSize(type);
+  size_t size = elementSize;
+  for (auto dim : dims)
+    size *= static_cast<size_t>(std::max(dim, 0));
+
+  // Floating point data is mostly noise in the low bits, Deflate saves
+  // little on it for a large write slow down.
+  bool isFloat = type == DataType::Float || type == DataType::Double;
+  if (size < MinimumCompressedSize || isFloat)
+    return options;
+
+  // Higher levels barely shrink label maps further, but write much slower.
+  options.chunkDimensions = guessChunkDimensions(dims, elementSize);
+  options.compression = WriteOptions::Compression::Deflate;
+  options.compressionLevel = 1;
+  options.shuffle = elementSize > 1;
+  return options;
+}
+
+void H5ReadWrite::setReadThreads(int threads)
+{
+  ReadThreads = std::max(threads, 0);
+}
+
+int H5ReadWrite::readThreads()
+{
+  return ReadThreads;
+}
+
+vector<int> H5ReadWrite::guessChunkDimensions(const vector<int>& dims,
+                                              size_t elementSize,
+                                              size_t chunkSize)
+{
+  vector<int> chunks(dims);
+  for (auto& chunk : chunks)
+    chunk = std::max(chunk, 1);
+
+  auto bytes = [&chunks, elementSize]() {
+    return std::accumulate(chunks.begin(), chunks.end(), elementSize,
+                           [](size_t a, int b) { return a * b; });
+  };
+
+  while (bytes() > chunkSize) {
+    auto largest = std::max_element(chunks.begin(), chunks.end());
+    if (*largest <= 1)
+      break;
+
+    *largest = (*largest + 1) / 2;
+  }
+  return chunks;
+}
+
 // Instantiate our allowable templates here
 // attribute()
 template char H5ReadWrite::attribute(const string&, const string&, bool*);
@@ -1019,26 +2123,36 @@ template bool H5ReadWrite::setAttribute(const string&, const string&,
 
 // writeData
 template bool H5ReadWrite::writeData(const string&, const string&,
-                                     const vector<int>&, const char*);
+                                     const vector<int>&, const char*,
+                                     const WriteOptions&);
 template bool H5ReadWrite::writeData(const string&, const string&,
-                                     const vector<int>&, const short*);
+                                     const vector<int>&, const short*,
+                                     const WriteOptions&);
 template bool H5ReadWrite::writeData(const string&, const string&,
-                                     const vector<int>&, const int*);
+                                     const vector<int>&, const int*,
+                                     const WriteOptions&);
 template bool H5ReadWrite::writeData(const string&, const string&,
-                                     const vector<int>&, const long long*);
+                                     const vector<int>&, const long long*,
+                                     const WriteOptions&);
 template bool H5ReadWrite::writeData(const string&, const string&,
-                                     const vector<int>&, const unsigned char*);
+                                     const vector<int>&, const unsigned char*,
+                                     const WriteOptions&);
 template bool H5ReadWrite::writeData(const string&, const string&,
-                                     const vector<int>&, const unsigned short*);
+                                     const vector<int>&, const unsigned short*,
+                                     const WriteOptions&);
 template bool H5ReadWrite::writeData(const string&, const string&,
-                                     const vector<int>&, const unsigned int*);
+                                     const vector<int>&, const unsigned int*,
+                                     const WriteOptions&);
 template bool H5ReadWrite::writeData(const string&, const string&,
                                      const vector<int>&,
-                                     const unsigned long long*);
+                                     const unsigned long long*,
+                                     const WriteOptions&);
 template bool H5ReadWrite::writeData(const string&, const string&,
-                                     const vector<int>&, const float*);
+                                     const vector<int>&, const float*,
+                                     const WriteOptions&);
 template bool H5ReadWrite::writeData(const string&, const string&,
-                                     const vector<int>&, const double*);
+                                     const vector<int>&, const double*,
+                                     const WriteOptions&);
 
 // We need to create specializations for these
 // template vector<string> H5ReadWrite::readData(const string&);
@@ -5,11 +5,56 @@
 #define tomvizH5ReadWrite_h
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace h5 {
 
+/**
+ * Options used when creating a data set. The default values create a
+ * contiguous, uncompressed data set.
+ */
+struct WriteOptions
+{
+  /** Enumeration of the compression filters. */
+  enum class Compression
+  {
+    None,
+    Deflate,
+    Zstd,
+    Blosc
+  };
+
+  /**
+   * The dimensions of a chunk, in the same order as the dimensions of the
+   * data set. If empty, the data set is contiguous, unless a filter is
+   * requested, in which case a chunk shape is guessed.
+   */
+  std::vector<int> chunkDimensions;
+
+  /**
+   * The compression filter. Zstd and Blosc are HDF5 filter plugins, if
+   * they cannot be loaded Deflate is used instead.
+   */
+  Compression compression = Compression::None;
+
+  /**
+   * The compression level: 1 to 9 for Deflate and Blosc, 1 to 22 for Zstd.
+   */
+  int compressionLevel = 4;
+
+  /** Shuffle the bytes of the elements before compressing them. */
+  bool shuffle = false;
+
+  /** True if the data set will be chunked. */
+  bool isChunked() const
+  {
+    return !chunkDimensions.empty() || compression != Compression::None ||
+           shuffle;
+  }
+};
+
 class H5ReadWrite
 {
 public:
@@ -30,6 +75,13 @@ public:
   explicit H5ReadWrite(const std::string& fileName,
                        OpenMode mode = OpenMode::ReadOnly);
 
+  /**
+   * The HDF5 library is not thread safe. Every call into it, through any
+   * H5ReadWrite on any thread, holds this recursive lock. Hold it to make
+   * several calls with no other thread's calls in between.
+   */
+  static std::recursive_mutex& mutex();
+
   /** Closes the file and destroys the H5ReadWrite */
   ~H5ReadWrite();
 
@@ -65,6 +117,56 @@ public:
   /** Get a string representation of the enum DataType */
   static std::string dataTypeToString(const DataType& type);
 
+  /** Get the size in bytes of one element of type @p type */
+  static size_t dataTypeSize(const DataType& type);
+
+  /** Get a string representation of the enum WriteOptions::Compression */
+  static std::string compressionToString(
+    const WriteOptions::Compression& compression);
+
+  /**
+   * Get the WriteOptions::Compression from its string representation.
+   * @param ok If used, set to true on success and false on failure.
+   */
+  static WriteOptions::Compression compressionFromString(
+    const std::string& compression, bool* ok = nullptr);
+
+  /**
+   * Get the write options suited to a data set. Integer data sets, such as
+   * label maps, that are not small are chunked and compressed with a fast
+   * Deflate level, with the shuffle filter for multi-byte types. Small and
+   * floating point data sets, which compress poorly, are left contiguous.
+   * @param type The type of the data set.
+   * @param dimensions The dimensions of the data set.
+   * @return The suggested options.
+   */
+  static WriteOptions defaultWriteOptions(const DataType& type,
+                                          const std::vector<int>& dimensions);
+
+  /**
+   * Guess the dimensions of chunks of about @p chunkSize bytes. The
+   * largest dimension (the slowest varying on ties) is halved until the
+   * chunk is small enough.
+   * @param dimensions The dimensions of the data set.
+   * @param elementSize The size of an element in bytes.
+   * @param chunkSize The target size of a chunk in bytes.
+   * @return The chunk dimensions.
+   */
+  static std::vector<int> guessChunkDimensions(
+    const std::vector<int>& dimensions, size_t elementSize,
+    size_t chunkSize = 1 << 20);
+
+  /**
+   * Set the number of threads decompressing the chunks of a read. Data
+   * sets compressed with Deflate, and optionally shuffled, are read a raw
+   * chunk at a time and decompressed in parallel, other data sets are
+   * decompressed by the HDF5 library on a single thread.
+   * @param threads The number of threads, 0 (the default) for one per
+   *                core, 1 to always let the HDF5 library read the data.
+   */
+  static void setReadThreads(int threads);
+  static int readThreads();
+
   /**
    * Get the children of a path.
    * @param ok If used, set to true on success and false on failure.
@@ -134,6 +236,14 @@ public:
    */
   std::vector<std::string> allDataSets(const std::string& path = "");
 
+  /**
+   * Get the size of the storage allocated to a data set, or to all of the
+   * data sets under a group, in the file.
+   * @param path The path to the data set or group.
+   * @return The size in bytes, 0 if an error occurred.
+   */
+  unsigned long long storageSize(const std::string& path);
+
   /**
    * Get a data set's type. An error will occur if @p path is not a dataset.
    * @param path The path to the data set.
@@ -155,6 +265,15 @@ public:
    */
   std::vector<int> getDimensions(const std::string& path);
 
+  /**
+   * Get the options a data set was created with: its chunk dimensions
+   * and filters.
+   * @param path The path to the data set.
+   * @param ok If used, set to true on success and false on failure.
+   * @return The options of the data set.
+   */
+  WriteOptions writeOptions(const std::string& path, bool* ok = nullptr);
+
   /**
    * Read a 1-dimensional data set and interpret it as type T. If @p path
    * is not a data set, @p path is not a 1-dimensional data set, or T is
@@ -209,11 +328,14 @@ public:
    * @param counts The number of data elements to be read. If used,
    *               must have a length of ndims. If unspecified,
    *               as much data will be read as possible.
+   * @param average If true, each element read is the mean of the block of
+   *                strides[0] x strides[1] x ... elements it starts,
+   *                rather than just that element (binning).
    * @return True on success, false on failure.
    */
   bool readData(const std::string& path, const DataType& type, void* data,
                 int* strides = nullptr, size_t* start = nullptr,
-                size_t* counts = nullptr);
+                size_t* counts = nullptr, bool average = false);
 
   /**
    * Write data to a specified path.
@@ -221,12 +343,14 @@ public:
    * @param name The name of the data.
    * @param dimensions The dimensions of the data.
    * @param data The data to write.
+   * @param options The storage layout and filters of the data set.
    * @return True on success, false on failure.
    */
   template <typename T>
   bool writeData(const std::string& path, const std::string& name,
                  const std::vector<int>& dimensions,
-                 const std::vector<T>& data);
+                 const std::vector<T>& data,
+                 const WriteOptions& options = WriteOptions());
 
   /**
    * Write data to a specified path.
@@ -234,11 +358,13 @@ public:
    * @param name The name of the data.
    * @param dimensions The dimensions of the data.
    * @param data The data to write.
+   * @param options The storage layout and filters of the data set.
    * @return True on success, false on failure.
    */
   template <typename T>
   bool writeData(const std::string& path, const std::string& name,
-                 const std::vector<int>& dimensions, const T* data);
+                 const std::vector<int>& dimensions, const T* data,
+                 const WriteOptions& options = WriteOptions());
 
   /**
    * Write data to a specified path.
@@ -247,11 +373,42 @@ public:
    * @param dimensions The dimensions of the data.
    * @param type The type of data to write.
    * @param data The data to write.
+   * @param options The storage layout and filters of the data set.
    * @return True on success, false on failure.
    */
   bool writeData(const std::string& path, const std::string& name,
                  const std::vector<int>& dimensions, const DataType& type,
-                 const void* data);
+                 const void* data,
+                 const WriteOptions& options = WriteOptions());
+
+  /**
+   * Create a data set without writing any data to it. The data can then
+   * be written in blocks with writeHyperslab().
+   * @param path The path where the data set will be created.
+   * @param name The name of the data set.
+   * @param dimensions The dimensions of the data set.
+   * @param type The type of the data set.
+   * @param options The storage layout and filters of the data set.
+   * @return True on success, false on failure.
+   */
+  bool createDataSet(const std::string& path, const std::string& name,
+                     const std::vector<int>& dimensions, const DataType& type,
+                     const WriteOptions& options = WriteOptions());
+
+  /**
+   * Write a block of data into an existing data set.
+   * @param path The path to the data set.
+   * @param type The type of the data.
+   * @param data The block of data, C ordered, of size
+   *             counts[0] * counts[1] * ...
+   * @param start The start of the block in the data set. Must have a length
+   *              of ndims.
+   * @param counts The dimensions of the block. Must have a length of ndims.
+   * @return True on success, false on failure.
+   */
+  bool writeHyperslab(const std::string& path, const DataType& type,
+                      const void* data, const size_t* start,
+                      const size_t* counts);
 
   /**
    * Set an attribute on a specified path.
@@ -286,6 +443,23 @@ public:
    */
   bool isSoftLink(const std::string& path);
 
+  /**
+   * Remove a link, such as a group, a data set or a soft link. The object
+   * it links to is deleted once nothing links to it, but the space it used
+   * is not returned, the file does not shrink.
+   * @param path The path to the link that will be removed.
+   * @return True on success, false on failure.
+   */
+  bool removeLink(const std::string& path);
+
+  /**
+   * Move a link to another path, for instance to rename a group.
+   * @param source The path to the link that will be moved.
+   * @param destination The new path of the link.
+   * @return True on success, false on failure.
+   */
+  bool moveLink(const std::string& source, const std::string& destination);
+
 private:
   class H5ReadWriteImpl;
   std::unique_ptr<H5ReadWriteImpl> m_impl;
@@ -294,9 +468,10 @@ private:
 template <typename T>
 bool H5ReadWrite::writeData(const std::string& path, const std::string& name,
                             const std::vector<int>& dims,
-                            const std::vector<T>& data)
+                            const std::vector<T>& data,
+                            const WriteOptions& options)
 {
-  return writeData(path, name, dims, data.data());
+  return writeData(path, name, dims, data.data(), options);
 }
 
 } // namespace h5
@@ -25,6 +25,14 @@ public:
     m_value = value;
   }
 
+  // Give up the ownership of the value without closing it
+  hid_t release()
+  {
+    hid_t value = m_value;
+    m_value = H5I_INVALID_HID;
+    return value;
+  }
+
   herr_t close()
   {
     herr_t result = 0;
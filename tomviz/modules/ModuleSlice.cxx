@@ -7,17 +7,20 @@
 #include "DataSource.h"
 #include "DoubleSliderWidget.h"
 #include "IntSliderWidget.h"
+#include "LazyVolume.h"
 #include "ScalarsComboBox.h"
 #include "Utilities.h"
 #include "vtkActiveScalarsProducer.h"
 
 #include <vtkCamera.h>
 #include <vtkCommand.h>
+#include <vtkDataArray.h>
 #include <vtkDataObject.h>
 #include <vtkImageData.h>
 #include <vtkNew.h>
 #include <vtkNonOrthoImagePlaneWidget.h>
 #include <vtkPlane.h>
+#include <vtkPointData.h>
 #include <vtkProperty.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
@@ -42,10 +45,15 @@
 #include <QPushButton>
 #include <QSpinBox>
 #include <QVBoxLayout>
+#include <QtConcurrent>
 
 namespace tomviz {
 
-ModuleSlice::ModuleSlice(QObject* parentObject) : Module(parentObject) {}
+ModuleSlice::ModuleSlice(QObject* parentObject) : Module(parentObject)
+{
+  connect(&m_fullResolutionWatcher, &QFutureWatcherBase::finished, this,
+          &ModuleSlice::onFullResolutionSliceRead);
+}
 
 ModuleSlice::~ModuleSlice()
 {
@@ -372,6 +380,7 @@ void ModuleSlice::dataUpdated()
   // In case there are new slices, update min and max
   updateSliceWidget();
   m_widget->UpdatePlacement();
+  updateFullResolutionTexture();
   emit renderNeeded();
 }
 
@@ -381,6 +390,9 @@ void ModuleSlice::dataChanged()
   // vtk pipeline, requiring manual updates to keep in sync like here.
   // It really should be implemented as a filter.
   m_producer->SetOutput(dataSource()->dataObject());
+  // The file may have been read again
+  m_fullResolutionAxis = m_fullResolutionIndex = -1;
+  m_readingAxis = m_readingIndex = -1;
   dataPropertiesChanged();
   dataUpdated();
 }
@@ -614,8 +626,155 @@ void ModuleSlice::dataSourceRotated(double newX, double newY, double newZ)
   m_widget->SetDisplayOrientation(orientation);
 }
 
+bool ModuleSlice::fullResolutionSliceIndex(int& axis, int& index) const
+{
+  // Only a subsampled proxy of the volume is loaded, read orthogonal slices
+  // of its scalars at full resolution instead.
+  auto lazy = dataSource()->lazyVolume();
+  if (!lazy || !isOrtho() || m_sliceThickness != 1) {
+    return false;
+  }
+
+  QString arrayName = activeScalars() == Module::defaultScalarsIdx()
+                        ? dataSource()->activeScalars()
+                        : dataSource()->scalarsName(activeScalars());
+  if (arrayName != dataSource()->scalarsName(0)) {
+    return false;
+  }
+
+  int strides[3], dims[3];
+  dataSource()->subsampleStrides(strides);
+  if (lazy->reversedAxes()) {
+    std::swap(strides[0], strides[2]);
+  }
+  lazy->dimensions(dims);
+  axis = directionAxis(m_direction);
+  index = std::min(m_slice * strides[axis], dims[axis] - 1);
+  return true;
+}
+
+void ModuleSlice::setFullResolutionSlice(vtkImageData* slice, int axis,
+                                         int index)
+{
+  int strides[3];
+  dataSource()->subsampleStrides(strides);
+  double spacing[3];
+  imageData()->GetSpacing(spacing);
+  for (int i = 0; i < 3; ++i) {
+    spacing[i] /= strides[i];
+  }
+  m_fullResolutionSlice->ShallowCopy(slice);
+  m_fullResolutionSlice->SetSpacing(spacing);
+  m_fullResolutionSlice->SetOrigin(imageData()->GetOrigin());
+  m_fullResolutionAxis = axis;
+  m_fullResolutionIndex = index;
+}
+
+bool ModuleSlice::readFullResolutionSlice()
+{
+  int axis, index;
+  if (!fullResolutionSliceIndex(axis, index)) {
+    return false;
+  }
+  if (axis == m_fullResolutionAxis && index == m_fullResolutionIndex) {
+    return true;
+  }
+
+  auto lazy = dataSource()->lazyVolume();
+  vtkNew<vtkImageData> slice;
+  bool read = false;
+  runWithHDF5Lock([&]() { read = lazy->readSlice(axis, index, slice); });
+  if (!read) {
+    return false;
+  }
+
+  setFullResolutionSlice(slice, axis, index);
+  return true;
+}
+
+void ModuleSlice::updateFullResolutionTexture()
+{
+  if (!m_widget) {
+    return;
+  }
+
+  int axis, index;
+  if (!fullResolutionSliceIndex(axis, index)) {
+    m_widget->SetTextureInputData(nullptr);
+    return;
+  }
+
+  if (axis != m_fullResolutionAxis || index != m_fullResolutionIndex) {
+    // Show the resliced proxy until the slice has been read
+    m_widget->SetTextureInputData(nullptr);
+    if (m_fullResolutionWatcher.isRunning() ||
+        (axis == m_readingAxis && index == m_readingIndex)) {
+      // The slice is read next, or it could not be read
+      return;
+    }
+
+    // Read it in the background, so moving the slice doesn't wait for the
+    // file.
+    auto lazy = dataSource()->lazyVolume();
+    m_readingAxis = axis;
+    m_readingIndex = index;
+    m_fullResolutionWatcher.setFuture(QtConcurrent::run([lazy, axis, index]() {
+      auto slice = vtkSmartPointer<vtkImageData>::New();
+      bool read = false;
+      runWithHDF5Lock([&]() { read = lazy->readSlice(axis, index, slice); });
+      return read ? slice : nullptr;
+    }));
+    return;
+  }
+
+  // The texture's axes are those of the plane: Y and Z for X normals, Z and
+  // X for Y normals, X and Y for Z normals.
+  int dims[3];
+  m_fullResolutionSlice->GetDimensions(dims);
+  vtkSmartPointer<vtkDataArray> scalars =
+    m_fullResolutionSlice->GetPointData()->GetScalars();
+  if (axis == 1) {
+    // The slice is stored X first
+    auto transposed = vtkSmartPointer<vtkDataArray>::Take(
+      scalars->NewInstance());
+    transposed->SetNumberOfComponents(scalars->GetNumberOfComponents());
+    transposed->SetNumberOfTuples(scalars->GetNumberOfTuples());
+    for (vtkIdType z = 0; z < dims[2]; ++z) {
+      for (vtkIdType x = 0; x < dims[0]; ++x) {
+        transposed->SetTuple(z + x * dims[2], x + z * dims[0], scalars);
+      }
+    }
+    scalars = transposed;
+  }
+  m_fullResolutionTexture->SetDimensions(dims[(axis + 1) % 3],
+                                         dims[(axis + 2) % 3], 1);
+  m_fullResolutionTexture->GetPointData()->SetScalars(scalars);
+  m_widget->SetTextureInputData(m_fullResolutionTexture);
+}
+
+void ModuleSlice::onFullResolutionSliceRead()
+{
+  if (!m_widget) {
+    return;
+  }
+
+  auto slice = m_fullResolutionWatcher.result();
+  // The data may have changed while the slice was read
+  if (slice && m_readingAxis >= 0) {
+    setFullResolutionSlice(slice, m_readingAxis, m_readingIndex);
+  }
+
+  // The plane may have moved on to another slice meanwhile
+  updateFullResolutionTexture();
+  emit renderNeeded();
+}
+
 vtkDataObject* ModuleSlice::dataToExport()
 {
+  if (readFullResolutionSlice()) {
+    return m_fullResolutionSlice;
+  }
+
   return m_widget->GetResliceOutput();
 }
 
@@ -646,6 +805,7 @@ void ModuleSlice::onScalarArrayChanged()
     arrayName = dataSource()->scalarsName(activeScalars());
   }
   m_producer->SetActiveScalars(arrayName.toLatin1().data());
+  updateFullResolutionTexture();
   emit renderNeeded();
 }
 
@@ -680,6 +840,9 @@ void ModuleSlice::onDirectionChanged(Direction direction)
   }
 
   if (!isOrtho()) {
+    // Full resolution slices are only shown on orthogonal planes
+    m_widget->SetTextureInputData(nullptr);
+    emit renderNeeded();
     return;
   }
 
@@ -791,6 +954,7 @@ void ModuleSlice::onThicknessChanged(int value)
     m_thicknessSpin->setValue(value);
   }
   m_widget->SetSliceThickness(value);
+  updateFullResolutionTexture();
   emit renderNeeded();
 }
 
@@ -6,6 +6,8 @@
 
 #include "Module.h"
 
+#include <QFutureWatcher>
+
 #include <vtkNew.h>
 #include <vtkSmartPointer.h>
 
@@ -14,6 +16,7 @@ class QComboBox;
 class QSpinBox;
 class pqLineEdit;
 class vtkActiveScalarsProducer;
+class vtkImageData;
 class vtkNonOrthoImagePlaneWidget;
 
 namespace tomviz {
@@ -126,6 +129,20 @@ private slots:
 private:
   bool setupWidget(vtkSMViewProxy* view);
 
+  /// The axis and full resolution index of the current slice, if the data
+  /// source was loaded lazily. Returns false if it does not apply.
+  bool fullResolutionSliceIndex(int& axis, int& index) const;
+  /// Keep a slice that was read from the volume of a lazily loaded data
+  /// source.
+  void setFullResolutionSlice(vtkImageData* slice, int axis, int index);
+  /// Read the current slice from the volume of a lazily loaded data source,
+  /// returns false if it does not apply.
+  bool readFullResolutionSlice();
+  /// Texture the plane with the full resolution slice, if there is one. A
+  /// slice that hasn't been read yet is read in the background.
+  void updateFullResolutionTexture();
+  void onFullResolutionSliceRead();
+
   Q_DISABLE_COPY(ModuleSlice)
 
   vtkSmartPointer<vtkNonOrthoImagePlaneWidget> m_widget;
@@ -157,6 +174,18 @@ private:
   QPointer<pqLineEdit> m_normalInputs[3];
 
   vtkNew<vtkActiveScalarsProducer> m_producer;
+
+  // Displayed and exported instead of the resliced proxy if the data was
+  // loaded lazily
+  vtkNew<vtkImageData> m_fullResolutionSlice;
+  vtkNew<vtkImageData> m_fullResolutionTexture;
+  int m_fullResolutionAxis = -1;
+  int m_fullResolutionIndex = -1;
+
+  // The slice read in the background, or last read
+  QFutureWatcher<vtkSmartPointer<vtkImageData>> m_fullResolutionWatcher;
+  int m_readingAxis = -1;
+  int m_readingIndex = -1;
 };
 } // namespace tomviz
 
@@ -20,6 +20,7 @@
 #include <vtkObjectFactory.h>
 #include <vtkPiecewiseFunction.h>
 #include <vtkPlane.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
 #include <vtkSmartVolumeMapper.h>
 #include <vtkTrivialProducer.h>
@@ -36,7 +37,9 @@
 #include <QFormLayout>
 #include <QSignalBlocker>
 #include <QVBoxLayout>
+#include <QtConcurrent>
 
+#include <algorithm>
 #include <cmath>
 
 namespace tomviz {
@@ -64,6 +67,8 @@ vtkStandardNewMacro(SmartVolumeMapper)
   // set or the shader will fail to compile.
   // (likely fixed in https://gitlab.kitware.com/vtk/vtk/-/merge_requests/8909)
   m_gradientOpacity->AddPoint(0.0, 1.0);
+  connect(&m_rgbaWatcher, &QFutureWatcher<void>::finished, this,
+          &ModuleVolume::onRgbaMappingReady);
   connect(&HistogramManager::instance(), &HistogramManager::histogram2DReady,
           this, [=](vtkSmartPointer<vtkImageData> image,
                     vtkSmartPointer<vtkImageData> histogram2D) {
@@ -147,6 +152,10 @@ bool ModuleVolume::initialize(DataSource* data, vtkSMViewProxy* vtkView)
           &ModuleVolume::onScalarArrayChanged);
   connect(data, &DataSource::componentNamesModified, this,
           &ModuleVolume::onComponentNamesModified);
+  // The background mapping reads the scalars, it must be done with them
+  // before they are modified in place.
+  connect(data, &DataSource::scalarsAboutToChange, this,
+          [this]() { m_rgbaWatcher.waitForFinished(); });
 
   // Work around mapper bug on the mac, see the following issue for details:
   // https://github.com/OpenChemistry/tomviz/issues/1776
@@ -272,7 +281,7 @@ void ModuleVolume::onComponentNamesModified()
 void ModuleVolume::updateMapperInput(DataSource* data)
 {
   if (useRgbaMapping()) {
-    m_volumeMapper->SetInputDataObject(m_rgbaDataObject);
+    m_volumeMapper->SetInputDataObject(m_rgbaBuffers[m_rgbaFront].image);
   } else if (data || (data = dataSource())) {
     auto* output = data->producer()->GetOutputPort();
     m_volumeMapper->SetInputConnection(output);
@@ -290,22 +299,51 @@ void ModuleVolume::computeRange(vtkDataArray* array, double range[2])
   }
 }
 
-static double computeNorm(double* vals, int num)
+namespace {
+
+// Rescales the components of a 3 component array from their ranges to
+// [0, 1], and computes the magnitude of the vectors into the 4th component
+// of the output. Only the output components flagged in channels are written.
+template <typename T>
+void mapRgba(const T* input, T* output, vtkIdType numTuples,
+             const std::array<bool, 4>& channels,
+             const std::vector<std::array<double, 2>>& ranges)
 {
-  double result = 0;
-  for (int i = 0; i < num; ++i) {
-    result += std::pow(vals[i], 2.0);
+  double scales[3];
+  for (int j = 0; j < 3; ++j) {
+    scales[j] = 1.0 / (ranges[j][1] - ranges[j][0]);
   }
-  return std::sqrt(result);
+
+  vtkSMPTools::For(0, numTuples, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i) {
+      const T* in = input + 3 * i;
+      T* out = output + 4 * i;
+      for (int j = 0; j < 3; ++j) {
+        if (channels[j]) {
+          out[j] = static_cast<T>((in[j] - ranges[j][0]) * scales[j]);
+        }
+      }
+      if (channels[3]) {
+        double x = in[0], y = in[1], z = in[2];
+        out[3] = static_cast<T>(std::sqrt(x * x + y * y + z * z));
+      }
+    }
+  });
 }
 
-static double rescale(double val, double* oldRange, double* newRange)
+void mapRgba(vtkDataArray* input, vtkDataArray* output,
+             const std::array<bool, 4>& channels,
+             const std::vector<std::array<double, 2>>& ranges)
 {
-  return (val - oldRange[0]) * (newRange[1] - newRange[0]) /
-           (oldRange[1] - oldRange[0]) +
-         newRange[0];
+  switch (input->GetDataType()) {
+    vtkTemplateMacro(mapRgba(static_cast<VTK_TT*>(input->GetVoidPointer(0)),
+                             static_cast<VTK_TT*>(output->GetVoidPointer(0)),
+                             input->GetNumberOfTuples(), channels, ranges));
+  }
 }
 
+} // namespace
+
 void ModuleVolume::updateVectorMode()
 {
   int vectorMode = vtkSmartVolumeMapper::DISABLED;
@@ -334,27 +372,83 @@ bool ModuleVolume::useRgbaMapping()
 
 void ModuleVolume::updateRgbaMappingDataObject()
 {
+  if (!useRgbaMapping()) {
+    return;
+  }
+
+  // The latest ranges are mapped once the mapping in progress is ready.
+  if (m_rgbaMappingRunning) {
+    m_rgbaMappingPending = true;
+    return;
+  }
+  m_rgbaMappingPending = false;
+
   auto* imageData = dataSource()->imageData();
-  auto* input = dataSource()->scalars();
+  vtkSmartPointer<vtkDataArray> input = dataSource()->scalars();
+  auto ranges = activeRgbaRanges();
+  auto& front = m_rgbaBuffers[m_rgbaFront];
+  auto& back = m_rgbaBuffers[1 - m_rgbaFront];
 
   // FIXME: we should probably do a filter instead of an object.
-  m_rgbaDataObject->SetDimensions(imageData->GetDimensions());
-  m_rgbaDataObject->AllocateScalars(input->GetDataType(), 4);
-
-  auto* output = m_rgbaDataObject->GetPointData()->GetScalars();
-
-  // Rescale from 0 to 1 for the coloring.
-  double newRange[2] = { 0.0, 1.0 };
-  auto oldRanges = activeRgbaRanges();
-  for (int i = 0; i < input->GetNumberOfTuples(); ++i) {
-    for (int j = 0; j < 3; ++j) {
-      double oldVal = input->GetComponent(i, j);
-      double newVal = rescale(oldVal, oldRanges[j].data(), newRange);
-      output->SetComponent(i, j, newVal);
-    }
-    auto* vals = input->GetTuple3(i);
-    auto norm = computeNorm(vals, 3);
-    output->SetComponent(i, 3, norm);
+  int dims[3], backDims[3];
+  imageData->GetDimensions(dims);
+  back.image->GetDimensions(backDims);
+  vtkSmartPointer<vtkDataArray> output =
+    back.image->GetPointData()->GetScalars();
+  bool inputChanged =
+    !output || back.input.GetPointer() != input.GetPointer() ||
+    back.inputTime != input->GetMTime() ||
+    !std::equal(dims, dims + 3, backDims);
+  // The buffer is kept, unless the size or type of the input changed
+  back.image->SetDimensions(dims);
+  if (!output || output->GetNumberOfTuples() != input->GetNumberOfTuples() ||
+      output->GetDataType() != input->GetDataType()) {
+    back.image->AllocateScalars(input->GetDataType(), 4);
+    output = back.image->GetPointData()->GetScalars();
+  }
+
+  // Only the components whose range changed since this buffer was mapped
+  std::array<bool, 4> channels;
+  for (int j = 0; j < 3; ++j) {
+    channels[j] = inputChanged || back.ranges.size() != ranges.size() ||
+                  back.ranges[j] != ranges[j];
+  }
+  channels[3] = inputChanged;
+
+  back.input = input.GetPointer();
+  back.inputTime = input->GetMTime();
+  back.ranges = ranges;
+
+  // Without any previous mapping to show, map it right away. Otherwise the
+  // last one stays shown meanwhile, even if its input has since been
+  // replaced.
+  if (!front.image->GetPointData()->GetScalars()) {
+    mapRgba(input, output, channels, ranges);
+    onRgbaMappingReady();
+    return;
+  }
+
+  m_rgbaMappingRunning = true;
+  m_rgbaWatcher.setFuture(
+    QtConcurrent::run([input, output, channels, ranges]() {
+      mapRgba(input, output, channels, ranges);
+    }));
+}
+
+void ModuleVolume::onRgbaMappingReady()
+{
+  m_rgbaMappingRunning = false;
+  m_rgbaFront = 1 - m_rgbaFront;
+  auto& front = m_rgbaBuffers[m_rgbaFront];
+  front.image->GetPointData()->GetScalars()->Modified();
+
+  if (useRgbaMapping()) {
+    m_volumeMapper->SetInputDataObject(front.image);
+    emit renderNeeded();
+  }
+
+  if (m_rgbaMappingPending) {
+    updateRgbaMappingDataObject();
   }
 }
 
@@ -9,13 +9,16 @@
 #include <vtkNew.h>
 #include <vtkWeakPointer.h>
 
+#include <QFutureWatcher>
 #include <QMap>
 #include <QPointer>
 
 #include <array>
+#include <vector>
 
 class vtkPVRenderView;
 
+class vtkDataArray;
 class vtkImageClip;
 class vtkImageData;
 class vtkPiecewiseFunction;
@@ -100,8 +103,25 @@ private:
   QPointer<ModuleVolumeWidget> m_controllers;
   QPointer<ScalarsComboBox> m_scalarsCombo;
 
-  // Data object used for mapping 3-components to Rgba
-  vtkNew<vtkImageData> m_rgbaDataObject;
+  // Data objects used for mapping 3-components to Rgba. The one at
+  // m_rgbaFront is shown, while the next mapping is computed into the other
+  // one in the background.
+  struct RgbaBuffer
+  {
+    vtkNew<vtkImageData> image;
+    // What the components were last computed from, so that only the ones
+    // whose range changed are computed again.
+    vtkWeakPointer<vtkDataArray> input;
+    vtkMTimeType inputTime = 0;
+    std::vector<std::array<double, 2>> ranges;
+  };
+  std::array<RgbaBuffer, 2> m_rgbaBuffers;
+  int m_rgbaFront = 0;
+  QFutureWatcher<void> m_rgbaWatcher;
+  // Until onRgbaMappingReady() takes the mapping, which can be after the
+  // job itself has finished.
+  bool m_rgbaMappingRunning = false;
+  bool m_rgbaMappingPending = false;
 
   bool m_useRgbaMapping = false;
   bool m_rgbaMappingCombineComponents = true;
@@ -140,6 +160,7 @@ private slots:
 
   void onDataChanged();
   void onComponentNamesModified();
+  void onRgbaMappingReady();
 };
 } // namespace tomviz
 
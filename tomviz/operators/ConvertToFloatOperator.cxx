@@ -24,7 +24,10 @@ void convertToFloat(vtkFloatArray* fArray, int nComps, vtkIdType nTuples,
 
 namespace tomviz {
 
-ConvertToFloatOperator::ConvertToFloatOperator(QObject* p) : Operator(p) {}
+ConvertToFloatOperator::ConvertToFloatOperator(QObject* p) : Operator(p)
+{
+  setSliceLocal(true);
+}
 
 QIcon ConvertToFloatOperator::icon() const
 {
@@ -0,0 +1,347 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "CrossCorrelationAlignOperator.h"
+
+#include "DataSource.h"
+#include "EditOperatorWidget.h"
+#include "FourierTransform.h"
+#include "OperatorResult.h"
+#include "TranslateAlignOperator.h"
+
+#include "vtkDataArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkFieldData.h"
+#include "vtkImageData.h"
+#include "vtkNew.h"
+#include "vtkPointData.h"
+#include "vtkSMPTools.h"
+#include "vtkTable.h"
+
+#include <QHBoxLayout>
+#include <QJsonObject>
+#include <QLabel>
+#include <QPointer>
+#include <QSpinBox>
+#include <QVBoxLayout>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+class CrossCorrelationAlignWidget : public tomviz::EditOperatorWidget
+{
+  Q_OBJECT
+
+public:
+  CrossCorrelationAlignWidget(tomviz::CrossCorrelationAlignOperator* source,
+                              QWidget* p)
+    : tomviz::EditOperatorWidget(p), m_operator(source)
+  {
+    auto* cutoffLabel = new QLabel("Band pass cutoff:", this);
+    cutoffLabel->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+
+    m_cutoff = new QSpinBox(this);
+    m_cutoff->setRange(1, 64);
+    m_cutoff->setValue(source->filterCutoff());
+    m_cutoff->setToolTip("Frequencies above 0.5 / cutoff cycles per pixel "
+                         "are ignored when correlating the projections.");
+
+    auto* vBoxLayout = new QVBoxLayout(this);
+    auto* cutoffHBoxLayout = new QHBoxLayout;
+    cutoffHBoxLayout->addWidget(cutoffLabel);
+    cutoffHBoxLayout->addWidget(m_cutoff);
+    vBoxLayout->addLayout(cutoffHBoxLayout);
+
+    setLayout(vBoxLayout);
+  }
+
+  void applyChangesToOperator() override
+  {
+    if (m_operator) {
+      m_operator->setFilterCutoff(m_cutoff->value());
+    }
+  }
+
+private:
+  QPointer<tomviz::CrossCorrelationAlignOperator> m_operator;
+  QSpinBox* m_cutoff;
+};
+} // namespace
+
+#include "CrossCorrelationAlignOperator.moc"
+
+namespace {
+
+using tomviz::FourierTransform::Complex;
+
+const double Pi = 3.14159265358979323846;
+
+// Number of projections handed to the thread pool between progress updates
+// and cancel checks.
+const int BatchSize = 16;
+
+template <typename T>
+void copySlice(const T* data, size_t sliceSize, int slice, Complex* out)
+{
+  const T* in = data + slice * sliceSize;
+  for (size_t i = 0; i < sliceSize; ++i) {
+    out[i] = Complex(static_cast<float>(in[i]), 0.0f);
+  }
+}
+
+// Fit a parabola through three samples around a maximum and return the
+// position of its vertex relative to the center sample, in [-0.5, 0.5].
+double parabolicPeak(double left, double center, double right)
+{
+  double denominator = left - 2.0 * center + right;
+  if (denominator >= 0.0) {
+    return 0.0;
+  }
+  return std::max(-0.5, std::min(0.5, 0.5 * (left - right) / denominator));
+}
+} // namespace
+
+namespace tomviz {
+
+CrossCorrelationAlignOperator::CrossCorrelationAlignOperator(DataSource* ds,
+                                                             QObject* p)
+  : Operator(p), m_dataSource(ds)
+{
+  setSupportsCancel(true);
+  setNumberOfResults(1);
+  auto res = resultAt(0);
+  res->setName("alignments");
+  res->setLabel("Alignments");
+  vtkNew<vtkTable> table;
+  setResult(0, table);
+}
+
+QIcon CrossCorrelationAlignOperator::icon() const
+{
+  return QIcon("");
+}
+
+Operator* CrossCorrelationAlignOperator::clone() const
+{
+  auto op = new CrossCorrelationAlignOperator(m_dataSource);
+  op->setFilterCutoff(m_filterCutoff);
+  return op;
+}
+
+EditOperatorWidget* CrossCorrelationAlignOperator::getEditorContentsWithData(
+  QWidget* p, vtkSmartPointer<vtkImageData>)
+{
+  return new CrossCorrelationAlignWidget(this, p);
+}
+
+QJsonObject CrossCorrelationAlignOperator::serialize() const
+{
+  auto json = Operator::serialize();
+  json["filterCutoff"] = m_filterCutoff;
+  return json;
+}
+
+bool CrossCorrelationAlignOperator::deserialize(const QJsonObject& json)
+{
+  if (json.contains("filterCutoff")) {
+    m_filterCutoff = json["filterCutoff"].toInt(m_filterCutoff);
+  }
+  return true;
+}
+
+void CrossCorrelationAlignOperator::setFilterCutoff(int cutoff)
+{
+  m_filterCutoff = std::max(1, cutoff);
+  emit transformModified();
+}
+
+QVector<vtkVector2i> CrossCorrelationAlignOperator::integerAlignOffsets() const
+{
+  QVector<vtkVector2i> offsets(m_offsets.size());
+  for (int i = 0; i < m_offsets.size(); ++i) {
+    offsets[i] = vtkVector2i(static_cast<int>(std::lround(m_offsets[i][0])),
+                             static_cast<int>(std::lround(m_offsets[i][1])));
+  }
+  return offsets;
+}
+
+QVector<vtkVector2d> CrossCorrelationAlignOperator::computeOffsets(
+  vtkImageData* tiltSeries)
+{
+  vtkDataArray* scalars = tiltSeries->GetPointData()->GetScalars();
+  if (!scalars) {
+    return QVector<vtkVector2d>();
+  }
+
+  int dims[3];
+  tiltSeries->GetDimensions(dims);
+  const int nx = dims[0];
+  const int ny = dims[1];
+  const int numProjections = dims[2];
+  const size_t sliceSize = static_cast<size_t>(nx) * ny;
+  QVector<vtkVector2d> offsets(numProjections, vtkVector2d(0.0, 0.0));
+  if (numProjections < 2) {
+    return offsets;
+  }
+
+  // The reference is the zero degree projection, or the middle one.
+  int reference = numProjections / 2;
+  auto tiltAngles = tiltSeries->GetFieldData()->GetArray("tilt_angles");
+  if (tiltAngles) {
+    for (vtkIdType i = 0; i < tiltAngles->GetNumberOfTuples(); ++i) {
+      if (tiltAngles->GetTuple1(i) == 0.0 && i < numProjections) {
+        reference = static_cast<int>(i);
+        break;
+      }
+    }
+  }
+
+  // Real space window removing the edge discontinuities, and Fourier space
+  // band pass filter, the same as the ones used by the Python operator.
+  std::vector<float> window(sliceSize);
+  std::vector<float> bandPass(sliceSize);
+  const double cutoff = m_filterCutoff;
+  for (int y = 0; y < ny; ++y) {
+    double wy = std::sin(Pi * (y + 1) / ny);
+    float ky = FourierTransform::frequency(y, ny);
+    for (int x = 0; x < nx; ++x) {
+      double wx = std::sin(Pi * (x + 1) / nx);
+      window[y * nx + x] = static_cast<float>(wx * wx * wy * wy);
+      float kx = FourierTransform::frequency(x, nx);
+      double kr = std::sqrt(kx * kx + ky * ky);
+      double s = std::sin(2.0 * cutoff * Pi * kr);
+      bandPass[y * nx + x] =
+        kr <= 0.5 / cutoff ? static_cast<float>(s * s) : 0.0f;
+    }
+  }
+
+  const FourierTransform::Plan2D plan(nx, ny);
+  setTotalProgressSteps(2 * numProjections - 1);
+  int progress = 0;
+
+  // Precompute the windowed, mean subtracted spectrum of every projection.
+  std::vector<Complex> spectra(sliceSize * numProjections);
+  for (int begin = 0; begin < numProjections && !isCanceled();
+       begin += BatchSize) {
+    int end = std::min(begin + BatchSize, numProjections);
+    vtkSMPTools::For(begin, end, [&](vtkIdType first, vtkIdType last) {
+      for (vtkIdType i = first; i < last; ++i) {
+        Complex* spectrum = spectra.data() + i * sliceSize;
+        switch (scalars->GetDataType()) {
+          vtkTemplateMacro(copySlice(
+            static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)), sliceSize,
+            static_cast<int>(i), spectrum));
+        }
+        double mean = 0.0;
+        for (size_t j = 0; j < sliceSize; ++j) {
+          mean += spectrum[j].real();
+        }
+        mean /= sliceSize;
+        for (size_t j = 0; j < sliceSize; ++j) {
+          spectrum[j] = Complex(
+            static_cast<float>((spectrum[j].real() - mean) * window[j]), 0.0f);
+        }
+        plan.forward(spectrum);
+      }
+    });
+    progress += end - begin;
+    setProgressStep(progress);
+  }
+
+  // Correlate every pair of neighbors concurrently. shifts[i] moves
+  // projection i + 1 onto projection i.
+  std::vector<vtkVector2d> shifts(numProjections - 1);
+  for (int begin = 0; begin < numProjections - 1 && !isCanceled();
+       begin += BatchSize) {
+    int end = std::min(begin + BatchSize, numProjections - 1);
+    vtkSMPTools::For(begin, end, [&](vtkIdType first, vtkIdType last) {
+      std::vector<Complex> correlation(sliceSize);
+      std::vector<float> magnitude(sliceSize);
+      for (vtkIdType i = first; i < last; ++i) {
+        const Complex* image = spectra.data() + (i + 1) * sliceSize;
+        const Complex* neighbor = spectra.data() + i * sliceSize;
+        for (size_t j = 0; j < sliceSize; ++j) {
+          correlation[j] = std::conj(image[j]) * neighbor[j] * bandPass[j];
+        }
+        plan.inverse(correlation.data());
+
+        size_t peak = 0;
+        for (size_t j = 0; j < sliceSize; ++j) {
+          magnitude[j] = std::abs(correlation[j]);
+          if (magnitude[j] > magnitude[peak]) {
+            peak = j;
+          }
+        }
+        int px = static_cast<int>(peak % nx);
+        int py = static_cast<int>(peak / nx);
+        auto at = [&](int x, int y) {
+          return magnitude[((y + ny) % ny) * nx + (x + nx) % nx];
+        };
+        double dx = parabolicPeak(at(px - 1, py), at(px, py), at(px + 1, py));
+        double dy = parabolicPeak(at(px, py - 1), at(px, py), at(px, py + 1));
+        // The correlation is circular, map the peak to a signed shift.
+        shifts[i] = vtkVector2d((px > nx / 2 ? px - nx : px) + dx,
+                                (py > ny / 2 ? py - ny : py) + dy);
+      }
+    });
+    progress += end - begin;
+    setProgressStep(progress);
+  }
+
+  if (isCanceled()) {
+    return QVector<vtkVector2d>();
+  }
+
+  // Walk the reference chain outwards, accumulating the neighbor shifts.
+  for (int i = reference + 1; i < numProjections; ++i) {
+    offsets[i] = vtkVector2d(offsets[i - 1][0] + shifts[i - 1][0],
+                             offsets[i - 1][1] + shifts[i - 1][1]);
+  }
+  for (int i = reference - 1; i >= 0; --i) {
+    offsets[i] = vtkVector2d(offsets[i + 1][0] - shifts[i][0],
+                             offsets[i + 1][1] - shifts[i][1]);
+  }
+  return offsets;
+}
+
+bool CrossCorrelationAlignOperator::applyTransform(vtkDataObject* data)
+{
+  auto image = vtkImageData::SafeDownCast(data);
+  if (!image) {
+    return false;
+  }
+
+  auto offsets = computeOffsets(image);
+  if (isCanceled() || offsets.isEmpty()) {
+    return false;
+  }
+  m_offsets = offsets;
+
+  TranslateAlignOperator::applyAlignOffsets(
+    image, m_offsets, TranslateAlignOperator::Interpolation::Linear);
+  offsetsToResult();
+  emit alignOffsetsComputed(integerAlignOffsets());
+  return true;
+}
+
+void CrossCorrelationAlignOperator::offsetsToResult()
+{
+  vtkNew<vtkDoubleArray> arrX;
+  arrX->SetName("X Offset");
+  vtkNew<vtkDoubleArray> arrY;
+  arrY->SetName("Y Offset");
+
+  vtkNew<vtkTable> table;
+  table->AddColumn(arrX);
+  table->AddColumn(arrY);
+  table->SetNumberOfRows(m_offsets.size());
+
+  for (int i = 0; i < m_offsets.size(); ++i) {
+    table->SetValue(i, 0, m_offsets[i][0]);
+    table->SetValue(i, 1, m_offsets[i][1]);
+  }
+  setResult(0, table);
+}
+} // namespace tomviz
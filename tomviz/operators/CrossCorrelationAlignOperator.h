@@ -0,0 +1,78 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizCrossCorrelationAlignOperator_h
+#define tomvizCrossCorrelationAlignOperator_h
+
+#include "Operator.h"
+
+#include "vtkVector.h"
+
+#include <QPointer>
+#include <QVector>
+
+namespace tomviz {
+
+class DataSource;
+
+/// Native version of the "Auto Tilt Image Align (XCORR)" Python operator.
+/// Every projection is aligned to its neighbor closer to the reference (zero
+/// degree, or middle) projection by band pass filtered cross-correlation.
+/// The spectra of all the projections are computed up front in parallel, so
+/// the only sequential part of the reference chain is accumulating the
+/// neighbor to neighbor shifts.
+class CrossCorrelationAlignOperator : public Operator
+{
+  Q_OBJECT
+
+public:
+  CrossCorrelationAlignOperator(DataSource* dataSource,
+                                QObject* parent = nullptr);
+
+  QString label() const override { return "Cross Correlation Align"; }
+  QIcon icon() const override;
+  Operator* clone() const override;
+
+  EditOperatorWidget* getEditorContentsWithData(
+    QWidget* parent, vtkSmartPointer<vtkImageData> data) override;
+  bool hasCustomUI() const override { return true; }
+
+  QJsonObject serialize() const override;
+  bool deserialize(const QJsonObject& json) override;
+
+  /// The band pass filter keeps frequencies up to 0.5 / cutoff cycles per
+  /// pixel, as in the Python operator. Defaults to 4.
+  void setFilterCutoff(int cutoff);
+  int filterCutoff() const { return m_filterCutoff; }
+
+  /// Offsets found by the last run, with sub-pixel precision.
+  const QVector<vtkVector2d>& alignOffsets() const { return m_offsets; }
+
+  /// Offsets found by the last run rounded to whole pixels, in the format
+  /// TranslateAlignOperator::setAlignOffsets() consumes.
+  QVector<vtkVector2i> integerAlignOffsets() const;
+
+  /// Compute the offsets aligning the active scalars of the tilt series,
+  /// without modifying it. Returns an empty vector if canceled.
+  QVector<vtkVector2d> computeOffsets(vtkImageData* tiltSeries);
+
+signals:
+  /// Emitted once the offsets have been computed, in the format
+  /// TranslateAlignOperator::setAlignOffsets() consumes.
+  void alignOffsetsComputed(const QVector<vtkVector2i>& offsets);
+
+protected:
+  bool applyTransform(vtkDataObject* data) override;
+
+private:
+  void offsetsToResult();
+
+  int m_filterCutoff = 4;
+  QVector<vtkVector2d> m_offsets;
+  const QPointer<DataSource> m_dataSource;
+
+  Q_DISABLE_COPY(CrossCorrelationAlignOperator)
+};
+} // namespace tomviz
+
+#endif
@@ -152,6 +152,12 @@ public:
   /// method by subclasses.
   bool supportsCompletionMidTransform() const { return m_supportsCompletion; }
 
+  /// Returns true if each slice of the output only depends on the same slice
+  /// of the input, so that slices appended to the input can be transformed on
+  /// their own. Defaults to false, can be set by the setSliceLocal(bool)
+  /// method by subclasses.
+  bool isSliceLocal() const { return m_sliceLocal; }
+
   /// Return the total number of progress updates (assuming each update
   /// increments the progress from 0 to some maximum.  If the operator doesn't
   /// support incremental progress updates, leave value set to zero
@@ -307,12 +313,17 @@ protected:
   /// it.
   void setSupportsCompletion(bool b) { m_supportsCompletion = b; }
 
+  /// Method to set whether the operator is slice local, see isSliceLocal().
+  /// The transform must then also accept a volume of any number of slices.
+  void setSliceLocal(bool b) { m_sliceLocal = b; }
+
 private:
   Q_DISABLE_COPY(Operator)
 
   QList<OperatorResult*> m_results;
   bool m_supportsCancel = false;
   bool m_supportsCompletion = false;
+  bool m_sliceLocal = false;
   bool m_hasChildDataSource = false;
   bool m_modified = true;
   bool m_new = true;
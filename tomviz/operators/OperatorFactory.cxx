@@ -7,6 +7,7 @@
 #include "ConvertToFloatOperator.h"
 #include "ConvertToVolumeOperator.h"
 #include "CropOperator.h"
+#include "CrossCorrelationAlignOperator.h"
 #include "OperatorPython.h"
 #include "ReconstructionOperator.h"
 #include "SetTiltAnglesOperator.h"
@@ -37,6 +38,7 @@ QList<QString> OperatorFactory::operatorTypes()
         << "ConvertToFloat"
         << "ConvertToVolume"
         << "Crop"
+        << "CrossCorrelationAlign"
         << "CxxReconstruction"
         << "Python"
         << "SetTiltAngles"
@@ -71,6 +73,8 @@ Operator* OperatorFactory::createOperator(const QString& type, DataSource* ds)
     op = new ConvertToVolumeOperator(ds);
   } else if (type == "Crop") {
     op = new CropOperator(ds);
+  } else if (type == "CrossCorrelationAlign") {
+    op = new CrossCorrelationAlignOperator(ds);
   } else if (type == "CxxReconstruction") {
     op = new ReconstructionOperator(ds);
   } else if (type == "SetTiltAngles") {
@@ -102,6 +106,9 @@ const char* OperatorFactory::operatorType(const Operator* op)
   if (qobject_cast<const CropOperator*>(op)) {
     return "Crop";
   }
+  if (qobject_cast<const CrossCorrelationAlignOperator*>(op)) {
+    return "CrossCorrelationAlign";
+  }
   if (qobject_cast<const ReconstructionOperator*>(op)) {
     return "CxxReconstruction";
   }
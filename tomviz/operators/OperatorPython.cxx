@@ -335,6 +335,10 @@ void OperatorPython::setJSONDescription(const QString& str)
     m_customWidgetID = widgetNode.toString();
   }
 
+  // Operators that transform each slice on its own can process appended
+  // slices without the rest of the volume
+  setSliceLocal(root["sliceLocal"].toBool(false));
+
   m_resultNames.clear();
 
   // Get the number of results
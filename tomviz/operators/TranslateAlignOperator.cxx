@@ -5,69 +5,228 @@
 
 #include "AlignWidget.h"
 #include "DataSource.h"
+#include "FourierTransform.h"
 #include "OperatorResult.h"
 
+#include "vtkDoubleArray.h"
 #include "vtkImageData.h"
 #include "vtkIntArray.h"
 #include "vtkNew.h"
 #include "vtkPointData.h"
+#include "vtkSMPTools.h"
 #include "vtkTable.h"
 
 #include <QJsonArray>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
 namespace {
 
-// We are assuming an image that begins at 0, 0, 0.
-vtkIdType imageIndex(const vtkVector3i& incs, const vtkVector3i& pos)
+using tomviz::FourierTransform::Complex;
+
+const double Pi = 3.14159265358979323846;
+
+template <typename T>
+T toValueType(double value, std::true_type)
+{
+  value = std::round(value);
+  value = std::max(value, static_cast<double>(std::numeric_limits<T>::lowest()));
+  value = std::min(value, static_cast<double>(std::numeric_limits<T>::max()));
+  return static_cast<T>(value);
+}
+
+template <typename T>
+T toValueType(double value, std::false_type)
+{
+  return static_cast<T>(value);
+}
+
+// Convert an interpolated value back, rounding and clamping for integers.
+template <typename T>
+T toValueType(double value)
+{
+  return toValueType<T>(value, std::is_integral<T>());
+}
+
+// Everything needed to shift one slice of one component of an array. The
+// input and output point at the first value of the slice, consecutive
+// pixels are "step" values apart.
+struct SliceShift
+{
+  int width;
+  int height;
+  int step;
+  vtkVector2d offset;
+};
+
+// out(x, y) = in(x - offset[0], y - offset[1]), pixels from outside of the
+// slice are zero. Whole rows are copied at once.
+template <typename T>
+void shiftSliceInteger(const T* in, T* out, const SliceShift& s)
+{
+  const int ox = static_cast<int>(s.offset[0]);
+  const int oy = static_cast<int>(s.offset[1]);
+  const int xBegin = std::max(0, ox);
+  const int xEnd = std::min(s.width, s.width + ox);
+  for (int y = 0; y < s.height; ++y) {
+    T* outRow = out + static_cast<size_t>(y) * s.width * s.step;
+    int sy = y - oy;
+    if (sy < 0 || sy >= s.height || xBegin >= xEnd) {
+      std::fill(outRow, outRow + static_cast<size_t>(s.width) * s.step, T(0));
+      continue;
+    }
+    const T* inRow = in + static_cast<size_t>(sy) * s.width * s.step;
+    std::fill(outRow, outRow + static_cast<size_t>(xBegin) * s.step, T(0));
+    std::copy(inRow + static_cast<size_t>(xBegin - ox) * s.step,
+              inRow + static_cast<size_t>(xEnd - ox) * s.step,
+              outRow + static_cast<size_t>(xBegin) * s.step);
+    std::fill(outRow + static_cast<size_t>(xEnd) * s.step,
+              outRow + static_cast<size_t>(s.width) * s.step, T(0));
+  }
+}
+
+// Interpolation weights for a constant shift along one axis. The output at
+// i is sum(weights[k] * in[i + first + k]).
+struct ShiftKernel
+{
+  int first;
+  std::vector<double> weights;
+};
+
+ShiftKernel shiftKernel(double offset,
+                        tomviz::TranslateAlignOperator::Interpolation mode)
 {
-  return pos[0] * incs[0] + pos[1] * incs[1] + pos[2] * incs[2];
+  // Sample position of output pixel i is i - offset = i + base + t.
+  double position = -offset;
+  int base = static_cast<int>(std::floor(position));
+  double t = position - base;
+  ShiftKernel kernel;
+  if (mode == tomviz::TranslateAlignOperator::Interpolation::Cubic) {
+    // Keys cubic convolution (a = -0.5), interpolating and C1 continuous.
+    const double a = -0.5;
+    auto w = [a](double x) {
+      x = std::abs(x);
+      if (x <= 1.0) {
+        return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+      } else if (x < 2.0) {
+        return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+      }
+      return 0.0;
+    };
+    kernel.first = base - 1;
+    kernel.weights = { w(t + 1.0), w(t), w(1.0 - t), w(2.0 - t) };
+  } else {
+    kernel.first = base;
+    kernel.weights = { 1.0 - t, t };
+  }
+  return kernel;
 }
 
+// Separable linear or cubic shift, rows first into a double buffer.
 template <typename T>
-void applyImageOffsets(T* in, T* out, vtkImageData* image,
-                       const QVector<vtkVector2i>& offsets)
-{
-  // We know that the input and output images are the same size, with the
-  // supplied offsets applied to each slice. Copy the pixels, applying offsets.
-  int* extents = image->GetExtent();
-  vtkVector3i extent(extents[1] - extents[0] + 1, extents[3] - extents[2] + 1,
-                     extents[5] - extents[4] + 1);
-  vtkVector3i incs(1, 1 * extent[0], 1 * extent[0] * extent[1]);
-
-  // Zero out our output array, we should do this more intelligently in future.
-  T* ptr = out;
-  for (int i = 0; i < extent[0] * extent[1] * extent[2]; ++i) {
-    *ptr++ = 0;
-  }
-
-  // We need to go slice by slice, applying the pixel offsets to the new image.
-  for (int i = 0; i < extent[2]; ++i) {
-    vtkVector2i offset = offsets[i];
-    int idx = imageIndex(incs, vtkVector3i(0, 0, i));
-    T* inPtr = in + idx;
-    T* outPtr = out + idx;
-    for (int y = 0; y < extent[1]; ++y) {
-      if (y + offset[1] >= extent[1]) {
-        break;
-      } else if (y + offset[1] < 0) {
-        inPtr += incs[1];
-        outPtr += incs[1];
-        continue;
+void shiftSliceInterpolated(
+  const T* in, T* out, const SliceShift& s,
+  tomviz::TranslateAlignOperator::Interpolation mode,
+  std::vector<double>& buffer)
+{
+  auto kx = shiftKernel(s.offset[0], mode);
+  auto ky = shiftKernel(s.offset[1], mode);
+  buffer.assign(static_cast<size_t>(s.width) * s.height, 0.0);
+  for (int y = 0; y < s.height; ++y) {
+    const T* inRow = in + static_cast<size_t>(y) * s.width * s.step;
+    double* row = buffer.data() + static_cast<size_t>(y) * s.width;
+    for (int x = 0; x < s.width; ++x) {
+      double value = 0.0;
+      for (size_t k = 0; k < kx.weights.size(); ++k) {
+        int sx = x + kx.first + static_cast<int>(k);
+        if (sx >= 0 && sx < s.width) {
+          value += kx.weights[k] * inRow[static_cast<size_t>(sx) * s.step];
+        }
       }
-      for (int x = 0; x < extent[0]; ++x) {
-        if (x + offset[0] >= extent[0]) {
-          inPtr += offset[0];
-          outPtr += offset[0];
-          break;
-        } else if (x + offset[0] < 0) {
-          ++inPtr;
-          ++outPtr;
-          continue;
+      row[x] = value;
+    }
+  }
+  for (int y = 0; y < s.height; ++y) {
+    T* outRow = out + static_cast<size_t>(y) * s.width * s.step;
+    for (int x = 0; x < s.width; ++x) {
+      double value = 0.0;
+      for (size_t k = 0; k < ky.weights.size(); ++k) {
+        int sy = y + ky.first + static_cast<int>(k);
+        if (sy >= 0 && sy < s.height) {
+          value += ky.weights[k] * buffer[static_cast<size_t>(sy) * s.width + x];
         }
-        *(outPtr + offset[0] + incs[1] * offset[1]) = *inPtr;
-        ++inPtr;
-        ++outPtr;
       }
+      outRow[static_cast<size_t>(x) * s.step] = toValueType<T>(value);
+    }
+  }
+}
+
+// Shift by multiplying the spectrum with a linear phase ramp. The shift is
+// circular, content leaving one edge comes back on the other.
+template <typename T>
+void shiftSliceFourier(const T* in, T* out, const SliceShift& s,
+                       const tomviz::FourierTransform::Plan2D& plan,
+                       std::vector<Complex>& buffer)
+{
+  buffer.resize(static_cast<size_t>(s.width) * s.height);
+  for (size_t i = 0; i < buffer.size(); ++i) {
+    buffer[i] = Complex(static_cast<float>(in[i * s.step]), 0.0f);
+  }
+  plan.forward(buffer.data());
+  for (int y = 0; y < s.height; ++y) {
+    double ky = tomviz::FourierTransform::frequency(y, s.height);
+    for (int x = 0; x < s.width; ++x) {
+      double kx = tomviz::FourierTransform::frequency(x, s.width);
+      double phase = -2.0 * Pi * (kx * s.offset[0] + ky * s.offset[1]);
+      buffer[static_cast<size_t>(y) * s.width + x] *=
+        Complex(std::polar(1.0, phase));
+    }
+  }
+  plan.inverse(buffer.data());
+  for (size_t i = 0; i < buffer.size(); ++i) {
+    out[i * s.step] = toValueType<T>(buffer[i].real());
+  }
+}
+
+template <typename T>
+void shiftSlice(vtkDataArray* inArray, vtkDataArray* outArray, int slice,
+                const int dims[3], const vtkVector2d& offset,
+                tomviz::TranslateAlignOperator::Interpolation mode,
+                const tomviz::FourierTransform::Plan2D* plan)
+{
+  const int components = inArray->GetNumberOfComponents();
+  const size_t sliceValues =
+    static_cast<size_t>(dims[0]) * dims[1] * components;
+  const T* in = static_cast<const T*>(inArray->GetVoidPointer(0)) +
+                slice * sliceValues;
+  T* out = static_cast<T*>(outArray->GetVoidPointer(0)) + slice * sliceValues;
+  SliceShift s{ dims[0], dims[1], components, offset };
+
+  bool integral = offset[0] == std::floor(offset[0]) &&
+                  offset[1] == std::floor(offset[1]);
+  // Fourier shifts wrap around, so keep using them for whole pixel offsets
+  // to treat every slice of a series the same way.
+  if (integral &&
+      mode != tomviz::TranslateAlignOperator::Interpolation::Fourier) {
+    // Whole rows of all components at once.
+    s.width *= components;
+    s.step = 1;
+    s.offset[0] *= components;
+    shiftSliceInteger(in, out, s);
+    return;
+  }
+
+  std::vector<double> buffer;
+  std::vector<Complex> spectrum;
+  for (int c = 0; c < components; ++c) {
+    if (mode == tomviz::TranslateAlignOperator::Interpolation::Fourier) {
+      shiftSliceFourier(in + c, out + c, s, *plan, spectrum);
+    } else {
+      shiftSliceInterpolated(in + c, out + c, s, mode, buffer);
     }
   }
 }
@@ -97,43 +256,113 @@ void TranslateAlignOperator::initializeResults()
 
 bool TranslateAlignOperator::applyTransform(vtkDataObject* data)
 {
-  vtkNew<vtkImageData> outImage;
   vtkImageData* inImage = vtkImageData::SafeDownCast(data);
   assert(inImage);
-  outImage->DeepCopy(data);
-
-  auto numArrays = inImage->GetPointData()->GetNumberOfArrays();
-
-  for (int i = 0; i < numArrays; ++i) {
-    std::string arrayName = inImage->GetPointData()->GetArrayName(i);
-    switch (inImage->GetScalarType()) {
-      vtkTemplateMacro(
-        applyImageOffsets(
-          reinterpret_cast<VTK_TT*>(
-            inImage->GetPointData()->GetScalars(arrayName.c_str())->GetVoidPointer(0)),
-          reinterpret_cast<VTK_TT*>(
-            outImage->GetPointData()->GetScalars(arrayName.c_str())->GetVoidPointer(0)),
-          inImage, offsets));
-    }
+  if (m_subPixelOffsets.isEmpty()) {
+    applyAlignOffsets(inImage, offsets);
+  } else {
+    applyAlignOffsets(inImage, m_subPixelOffsets, m_interpolation);
   }
 
   offsetsToResult();
-  data->ShallowCopy(outImage);
   return true;
 }
 
+void TranslateAlignOperator::applyAlignOffsets(
+  vtkImageData* image, const QVector<vtkVector2i>& offsets)
+{
+  QVector<vtkVector2d> doubleOffsets(offsets.size());
+  for (int i = 0; i < offsets.size(); ++i) {
+    doubleOffsets[i] = vtkVector2d(offsets[i][0], offsets[i][1]);
+  }
+  applyAlignOffsets(image, doubleOffsets, Interpolation::Linear);
+}
+
+void TranslateAlignOperator::applyAlignOffsets(
+  vtkImageData* image, const QVector<vtkVector2d>& offsets,
+  Interpolation interpolation)
+{
+  int dims[3];
+  image->GetDimensions(dims);
+  auto pointData = image->GetPointData();
+
+  // Shifted copies of every array, filled in a single parallel pass over the
+  // slices. Each output value is written exactly once.
+  std::vector<vtkDataArray*> inArrays;
+  std::vector<vtkSmartPointer<vtkDataArray>> outArrays;
+  for (int i = 0; i < pointData->GetNumberOfArrays(); ++i) {
+    auto inArray = pointData->GetArray(i);
+    if (!inArray || !inArray->GetName()) {
+      continue;
+    }
+    vtkSmartPointer<vtkDataArray> outArray;
+    outArray.TakeReference(inArray->NewInstance());
+    outArray->SetName(inArray->GetName());
+    outArray->SetNumberOfComponents(inArray->GetNumberOfComponents());
+    outArray->SetNumberOfTuples(inArray->GetNumberOfTuples());
+    inArrays.push_back(inArray);
+    outArrays.push_back(outArray);
+  }
+
+  std::unique_ptr<FourierTransform::Plan2D> plan;
+  if (interpolation == Interpolation::Fourier) {
+    plan.reset(new FourierTransform::Plan2D(dims[0], dims[1]));
+  }
+
+  vtkSMPTools::For(0, dims[2], [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType z = begin; z < end; ++z) {
+      vtkVector2d offset(0.0, 0.0);
+      if (z < offsets.size()) {
+        offset = offsets[z];
+      }
+      for (size_t i = 0; i < inArrays.size(); ++i) {
+        switch (inArrays[i]->GetDataType()) {
+          vtkTemplateMacro(shiftSlice<VTK_TT>(
+            inArrays[i], outArrays[i], static_cast<int>(z), dims, offset,
+            interpolation, plan.get()));
+        }
+      }
+    }
+  });
+
+  // Replace the arrays by name, keeping the active scalars.
+  std::string activeName;
+  if (pointData->GetScalars() && pointData->GetScalars()->GetName()) {
+    activeName = pointData->GetScalars()->GetName();
+  }
+  for (auto& outArray : outArrays) {
+    pointData->AddArray(outArray);
+  }
+  if (!activeName.empty()) {
+    pointData->SetActiveScalars(activeName.c_str());
+  }
+  image->Modified();
+}
+
 Operator* TranslateAlignOperator::clone() const
 {
   TranslateAlignOperator* op = new TranslateAlignOperator(this->dataSource);
-  op->setAlignOffsets(this->offsets);
+  if (m_subPixelOffsets.isEmpty()) {
+    op->setAlignOffsets(this->offsets);
+  } else {
+    op->setSubPixelAlignOffsets(m_subPixelOffsets);
+  }
+  op->setInterpolation(m_interpolation);
   return op;
 }
 
 void TranslateAlignOperator::offsetsToResult()
 {
-  vtkNew<vtkIntArray> arrX;
+  vtkSmartPointer<vtkDataArray> arrX;
+  vtkSmartPointer<vtkDataArray> arrY;
+  if (m_subPixelOffsets.isEmpty()) {
+    arrX = vtkSmartPointer<vtkIntArray>::New();
+    arrY = vtkSmartPointer<vtkIntArray>::New();
+  } else {
+    arrX = vtkSmartPointer<vtkDoubleArray>::New();
+    arrY = vtkSmartPointer<vtkDoubleArray>::New();
+  }
   arrX->SetName("X Offset");
-  vtkNew<vtkIntArray> arrY;
   arrY->SetName("Y Offset");
 
   vtkNew<vtkTable> table;
@@ -142,8 +371,13 @@ void TranslateAlignOperator::offsetsToResult()
   table->SetNumberOfRows(offsets.size());
 
   for (int i = 0; i < offsets.size(); ++i) {
-    table->SetValue(i, 0, offsets[i][0]);
-    table->SetValue(i, 1, offsets[i][1]);
+    if (m_subPixelOffsets.isEmpty()) {
+      table->SetValue(i, 0, offsets[i][0]);
+      table->SetValue(i, 1, offsets[i][1]);
+    } else {
+      table->SetValue(i, 0, m_subPixelOffsets[i][0]);
+      table->SetValue(i, 1, m_subPixelOffsets[i][1]);
+    }
   }
   setResult(0, table);
 }
@@ -166,6 +400,26 @@ QJsonObject TranslateAlignOperator::serialize() const
     json["draftOffsets"] = draftOffsetArray;
   }
 
+  if (!m_subPixelOffsets.isEmpty()) {
+    QJsonArray subPixelOffsetArray;
+    foreach (auto offset, m_subPixelOffsets) {
+      subPixelOffsetArray << offset[0] << offset[1];
+    }
+    json["subPixelOffsets"] = subPixelOffsetArray;
+  }
+
+  switch (m_interpolation) {
+    case Interpolation::Linear:
+      json["interpolation"] = "linear";
+      break;
+    case Interpolation::Cubic:
+      json["interpolation"] = "cubic";
+      break;
+    case Interpolation::Fourier:
+      json["interpolation"] = "fourier";
+      break;
+  }
+
   return json;
 }
 
@@ -189,6 +443,27 @@ bool TranslateAlignOperator::deserialize(const QJsonObject& json)
     }
   }
 
+  m_subPixelOffsets.clear();
+  if (json.contains("subPixelOffsets") && json["subPixelOffsets"].isArray()) {
+    auto subPixelOffsetArray = json["subPixelOffsets"].toArray();
+    m_subPixelOffsets.resize(subPixelOffsetArray.size() / 2);
+    for (int i = 0; i < subPixelOffsetArray.size() / 2; ++i) {
+      m_subPixelOffsets[i][0] = subPixelOffsetArray[2 * i].toDouble();
+      m_subPixelOffsets[i][1] = subPixelOffsetArray[2 * i + 1].toDouble();
+    }
+  }
+
+  if (json.contains("interpolation")) {
+    auto interpolation = json["interpolation"].toString();
+    if (interpolation == "cubic") {
+      m_interpolation = Interpolation::Cubic;
+    } else if (interpolation == "fourier") {
+      m_interpolation = Interpolation::Fourier;
+    } else {
+      m_interpolation = Interpolation::Linear;
+    }
+  }
+
   return true;
 }
 
@@ -203,9 +478,35 @@ void TranslateAlignOperator::setAlignOffsets(
 {
   this->offsets.resize(newOffsets.size());
   std::copy(newOffsets.begin(), newOffsets.end(), this->offsets.begin());
+  m_subPixelOffsets.clear();
+  emit this->transformModified();
+}
+
+void TranslateAlignOperator::setSubPixelAlignOffsets(
+  const QVector<vtkVector2d>& newOffsets)
+{
+  m_subPixelOffsets = newOffsets;
+  // Keep the whole pixel offsets in sync for the manual alignment widget.
+  this->offsets.resize(newOffsets.size());
+  for (int i = 0; i < newOffsets.size(); ++i) {
+    this->offsets[i] =
+      vtkVector2i(static_cast<int>(std::lround(newOffsets[i][0])),
+                  static_cast<int>(std::lround(newOffsets[i][1])));
+  }
   emit this->transformModified();
 }
 
+void TranslateAlignOperator::setInterpolation(Interpolation interpolation)
+{
+  if (m_interpolation == interpolation) {
+    return;
+  }
+  m_interpolation = interpolation;
+  if (!m_subPixelOffsets.isEmpty()) {
+    emit this->transformModified();
+  }
+}
+
 void TranslateAlignOperator::setDraftAlignOffsets(
   const QVector<vtkVector2i>& newOffsets)
 {
@@ -32,7 +32,29 @@ public:
   EditOperatorWidget* getEditorContentsWithData(
     QWidget* parent, vtkSmartPointer<vtkImageData> data) override;
 
+  /// How sub-pixel offsets are applied. Whole pixel offsets are always
+  /// applied exactly, except with Fourier interpolation, which wraps around.
+  enum class Interpolation
+  {
+    Linear,
+    Cubic,
+    Fourier
+  };
+
   void setAlignOffsets(const QVector<vtkVector2i>& offsets);
+
+  /// Set offsets with sub-pixel precision, e.g. from an automated aligner.
+  /// The whole pixel offsets are set to the rounded values, editing them
+  /// through setAlignOffsets() drops the sub-pixel offsets.
+  void setSubPixelAlignOffsets(const QVector<vtkVector2d>& offsets);
+  const QVector<vtkVector2d>& getSubPixelAlignOffsets() const
+  {
+    return m_subPixelOffsets;
+  }
+
+  void setInterpolation(Interpolation interpolation);
+  Interpolation interpolation() const { return m_interpolation; }
+
   void setDraftAlignOffsets(const QVector<vtkVector2i>& offsets);
   const QVector<vtkVector2i>& getAlignOffsets() const { return offsets; }
   const QVector<vtkVector2i>& getDraftAlignOffsets() const
@@ -42,6 +64,15 @@ public:
 
   DataSource* getDataSource() const { return this->dataSource; }
 
+  /// Shift each slice of every point data array in image by the matching
+  /// offset. Pixels shifted in from outside of the slice are set to zero.
+  /// The slices are processed in parallel, every array in the same pass.
+  static void applyAlignOffsets(vtkImageData* image,
+                                const QVector<vtkVector2i>& offsets);
+  static void applyAlignOffsets(vtkImageData* image,
+                                const QVector<vtkVector2d>& offsets,
+                                Interpolation interpolation);
+
   bool hasCustomUI() const override { return true; }
 
 protected:
@@ -52,6 +83,8 @@ protected:
 private:
   QVector<vtkVector2i> offsets;
   QVector<vtkVector2i> m_draftOffsets;
+  QVector<vtkVector2d> m_subPixelOffsets;
+  Interpolation m_interpolation = Interpolation::Linear;
   const QPointer<DataSource> dataSource;
 };
 } // namespace tomviz
@@ -0,0 +1,412 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "TiltAxisSearch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+using tomviz::FourierTransform::Complex;
+
+const double Pi = 3.14159265358979323846;
+
+// Number of candidates evaluated between two progress callbacks.
+const size_t BatchSize = 16;
+
+int threadCount(int threads)
+{
+  if (threads > 0) {
+    return threads;
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Run f(i, worker) for every i in [0, count) on "threads" threads, the
+// calling thread included. Items are handed out one at a time, as their cost
+// varies a lot between candidates.
+void parallelFor(int count, int threads,
+                 const std::function<void(int, int)>& f)
+{
+  std::atomic<int> next(0);
+  auto work = [&](int worker) {
+    for (int i = next++; i < count; i = next++) {
+      f(i, worker);
+    }
+  };
+  int workers = std::min(threads, count);
+  std::vector<std::thread> pool;
+  for (int w = 1; w < workers; ++w) {
+    pool.emplace_back(work, w);
+  }
+  work(0);
+  for (auto& thread : pool) {
+    thread.join();
+  }
+}
+
+std::vector<double> sweep(double min, double max, double step)
+{
+  std::vector<double> candidates;
+  int count = static_cast<int>(std::ceil((max - min) / step - 1e-9));
+  for (int i = 0; i < count; ++i) {
+    candidates.push_back(min + i * step);
+  }
+  return candidates;
+}
+
+// Next power of two, as used by the Python ramp filter.
+int paddedLength(int n)
+{
+  int padded = 1;
+  while (padded < n) {
+    padded <<= 1;
+  }
+  return padded;
+}
+} // namespace
+
+namespace tomviz {
+
+namespace TiltAxisSearch {
+
+Result coarseToFine(const Evaluator& evaluate, double min, double max,
+                    double coarseStep, double fineStep, bool minimize,
+                    const ProgressCallback& progress)
+{
+  // Plan both levels first so the progress total is known.
+  std::vector<double> steps = { coarseStep };
+  if (fineStep > 0.0 && fineStep < coarseStep) {
+    steps.push_back(fineStep);
+  }
+  int total = static_cast<int>(sweep(min, max, coarseStep).size());
+  if (steps.size() > 1) {
+    total += static_cast<int>(2.0 * coarseStep / fineStep + 1e-9) + 1;
+  }
+
+  Result result;
+  int bestIndex = -1;
+  std::vector<double> candidates = sweep(min, max, coarseStep);
+  for (size_t level = 0; level < steps.size(); ++level) {
+    if (level > 0) {
+      // Sample [best - coarse step, best + coarse step], both included.
+      double center = result.candidates[bestIndex];
+      int count = static_cast<int>(2.0 * coarseStep / fineStep + 1e-9) + 1;
+      candidates.clear();
+      for (int i = 0; i < count; ++i) {
+        candidates.push_back(center - coarseStep + i * fineStep);
+      }
+      // The best of the fine sweep wins, as in the Python operators.
+      bestIndex = -1;
+    }
+
+    for (size_t begin = 0; begin < candidates.size(); begin += BatchSize) {
+      size_t end = std::min(begin + BatchSize, candidates.size());
+      std::vector<double> batch(candidates.begin() + begin,
+                                candidates.begin() + end);
+      auto scores = evaluate(batch);
+      for (size_t i = 0; i < batch.size(); ++i) {
+        result.candidates.push_back(batch[i]);
+        result.scores.push_back(scores[i]);
+        int index = static_cast<int>(result.scores.size()) - 1;
+        if (bestIndex < 0 ||
+            (minimize ? scores[i] < result.scores[bestIndex]
+                      : scores[i] > result.scores[bestIndex])) {
+          bestIndex = index;
+        }
+      }
+
+      int done = static_cast<int>(result.candidates.size());
+      if (progress && progress(std::min(done, total), total)) {
+        result.canceled = true;
+        return result;
+      }
+    }
+    if (bestIndex < 0) {
+      break;
+    }
+    result.best = result.candidates[bestIndex];
+  }
+  return result;
+}
+
+RotationSearch::RotationSearch(const float* tiltSeries, int nx, int ny,
+                               int numberOfProjections, int threads)
+  : m_nx(nx), m_ny(ny), m_threads(threadCount(threads)),
+    m_variance(static_cast<size_t>(nx) * ny, 0.0)
+{
+  const size_t sliceSize = static_cast<size_t>(nx) * ny;
+  const FourierTransform::Plan2D plan(nx, ny);
+
+  auto spectrum = [&](int projection, std::vector<Complex>& buffer) {
+    const float* image = tiltSeries + projection * sliceSize;
+    buffer.resize(sliceSize);
+    for (size_t i = 0; i < sliceSize; ++i) {
+      buffer[i] = Complex(image[i], 0.0f);
+    }
+    plan.forward(buffer.data());
+  };
+
+  // Normalize by the DC term of the first projection, like the Python code.
+  std::vector<Complex> first;
+  spectrum(0, first);
+  double norm = std::abs(first[0]);
+  if (norm == 0.0) {
+    norm = 1.0;
+  }
+
+  // Per worker running sums of the rescaled intensity and of its square,
+  // stored fftshift-ed.
+  std::vector<std::vector<double>> sums(m_threads);
+  std::vector<std::vector<double>> squares(m_threads);
+  std::vector<std::vector<Complex>> buffers(m_threads);
+  parallelFor(numberOfProjections, m_threads, [&](int projection, int worker) {
+    auto& sum = sums[worker];
+    auto& square = squares[worker];
+    if (sum.empty()) {
+      sum.assign(sliceSize, 0.0);
+      square.assign(sliceSize, 0.0);
+    }
+    auto& buffer = buffers[worker];
+    spectrum(projection, buffer);
+    for (int y = 0; y < ny; ++y) {
+      int sy = (y + ny / 2) % ny;
+      for (int x = 0; x < nx; ++x) {
+        int sx = (x + nx / 2) % nx;
+        double value =
+          std::pow(std::abs(buffer[static_cast<size_t>(y) * nx + x]) / norm,
+                   0.2);
+        size_t index = static_cast<size_t>(sy) * nx + sx;
+        sum[index] += value;
+        square[index] += value * value;
+      }
+    }
+  });
+
+  for (size_t i = 0; i < sliceSize; ++i) {
+    double sum = 0.0;
+    double square = 0.0;
+    for (int w = 0; w < m_threads; ++w) {
+      if (!sums[w].empty()) {
+        sum += sums[w][i];
+        square += squares[w][i];
+      }
+    }
+    double mean = sum / numberOfProjections;
+    m_variance[i] = std::max(0.0, square / numberOfProjections - mean * mean);
+  }
+}
+
+double RotationSearch::lineIntensity(double angle) const
+{
+  const int n = std::min(m_nx, m_ny) / 3;
+  const int cx = m_nx / 2;
+  const int cy = m_ny / 2;
+  const double radians = angle * Pi / 180.0;
+  auto inside = [this](int x, int y) {
+    return x >= 0 && x < m_nx && y >= 0 && y < m_ny;
+  };
+
+  // Bilinear samples along the line, normalized by the weights of the
+  // samples that fall inside of the image.
+  double total = 0.0;
+  for (int i = 0; i < n; ++i) {
+    double x = i * std::cos(radians);
+    double y = i * std::sin(radians);
+    double sx = std::abs(std::floor(x) - x);
+    double sy = std::abs(std::floor(y) - y);
+    int x0 = static_cast<int>(std::floor(x)) + cx;
+    int x1 = static_cast<int>(std::ceil(x)) + cx;
+    int y0 = static_cast<int>(std::floor(y)) + cy;
+    int y1 = static_cast<int>(std::ceil(y)) + cy;
+    const int px[4] = { x0, x1, x0, x1 };
+    const int py[4] = { y0, y0, y1, y1 };
+    const double weights[4] = { (1 - sx) * (1 - sy), sx * (1 - sy),
+                                (1 - sx) * sy, sx * sy };
+    double w = 0.0;
+    double v = 0.0;
+    for (int k = 0; k < 4; ++k) {
+      if (inside(px[k], py[k])) {
+        w += weights[k];
+        v += weights[k] *
+             m_variance[static_cast<size_t>(py[k]) * m_nx + px[k]];
+      }
+    }
+    if (w != 0.0) {
+      total += v / w;
+    }
+  }
+  return total;
+}
+
+std::vector<double> RotationSearch::evaluate(
+  const std::vector<double>& angles) const
+{
+  std::vector<double> scores(angles.size());
+  parallelFor(static_cast<int>(angles.size()), m_threads,
+              [&](int i, int) { scores[i] = lineIntensity(angles[i]); });
+  return scores;
+}
+
+Result RotationSearch::search(double min, double max, double coarseStep,
+                              double fineStep,
+                              const ProgressCallback& progress) const
+{
+  return coarseToFine(
+    [this](const std::vector<double>& angles) { return evaluate(angles); },
+    min, max, coarseStep, fineStep, true, progress);
+}
+
+ShiftSearch::ShiftSearch(const float* tiltSeries, int nx, int ny,
+                         int numberOfProjections,
+                         const std::vector<double>& angles,
+                         const std::vector<int>& slices, int threads)
+  : m_ny(ny), m_numberOfProjections(numberOfProjections),
+    m_paddedSize(paddedLength(ny)), m_threads(threadCount(threads)),
+    m_angles(angles), m_plan(m_paddedSize),
+    m_numberOfSlices(static_cast<int>(slices.size()))
+{
+  // Ramp filter, 2 |f| as in makeFilter().
+  m_ramp.resize(m_paddedSize);
+  for (int i = 0; i < m_paddedSize; ++i) {
+    m_ramp[i] = 2.0f * std::abs(FourierTransform::frequency(i, m_paddedSize));
+  }
+
+  // Gather the contiguous sinograms of the selected slices.
+  const size_t sliceSize = static_cast<size_t>(nx) * ny;
+  m_sinograms.resize(static_cast<size_t>(m_numberOfSlices) *
+                     numberOfProjections * ny);
+  for (int s = 0; s < m_numberOfSlices; ++s) {
+    for (int projection = 0; projection < numberOfProjections; ++projection) {
+      float* ray =
+        m_sinograms.data() +
+        (static_cast<size_t>(s) * numberOfProjections + projection) * ny;
+      const float* image = tiltSeries + projection * sliceSize;
+      for (int y = 0; y < ny; ++y) {
+        ray[y] = image[static_cast<size_t>(y) * nx + slices[s]];
+      }
+    }
+  }
+
+  // Without padding, the ramp filter is a circular convolution, which
+  // commutes with the roll of the shifts: filter every ray once, the shifts
+  // then only roll the filtered rays. Padded rays are filtered for each
+  // shift, since the roll wraps around within the ray, not the padded one,
+  // which no phase ramp of the padded spectrum reproduces.
+  m_prefiltered = m_paddedSize == ny;
+  if (m_prefiltered) {
+    std::vector<Complex> buffer(ny);
+    for (size_t offset = 0; offset < m_sinograms.size(); offset += ny) {
+      float* ray = m_sinograms.data() + offset;
+      for (int y = 0; y < ny; ++y) {
+        buffer[y] = Complex(ray[y]);
+      }
+      filter(buffer);
+      for (int y = 0; y < ny; ++y) {
+        ray[y] = buffer[y].real();
+      }
+    }
+  }
+}
+
+void ShiftSearch::filter(std::vector<Complex>& buffer) const
+{
+  m_plan.forward(buffer.data());
+  for (int k = 0; k < m_paddedSize; ++k) {
+    buffer[k] *= m_ramp[k];
+  }
+  m_plan.inverse(buffer.data());
+}
+
+double ShiftSearch::reconstructionMaximum(int slice, double shift) const
+{
+  const int n = m_ny;
+  const int center = m_ny / 2;
+  // Shifts are whole pixels and wrap around, as np.roll does.
+  const int roll = ((static_cast<int>(std::lround(shift)) % n) + n) % n;
+
+  // Shift, then ramp filter every projection of the sinogram, zero padded.
+  std::vector<float> sinogram(static_cast<size_t>(m_numberOfProjections) * n);
+  std::vector<Complex> buffer(m_prefiltered ? 0 : m_paddedSize);
+  for (int j = 0; j < m_numberOfProjections; ++j) {
+    const float* ray =
+      m_sinograms.data() +
+      (static_cast<size_t>(slice) * m_numberOfProjections + j) * n;
+    float* filtered = sinogram.data() + static_cast<size_t>(j) * n;
+    if (m_prefiltered) {
+      for (int r = 0; r < n; ++r) {
+        filtered[(r + roll) % n] = ray[r];
+      }
+      continue;
+    }
+    for (int r = 0; r < n; ++r) {
+      buffer[(r + roll) % n] = Complex(ray[r]);
+    }
+    std::fill(buffer.begin() + n, buffer.end(), Complex(0.0f));
+    filter(buffer);
+    for (int r = 0; r < n; ++r) {
+      filtered[r] = buffer[r].real();
+    }
+  }
+
+  // Linear interpolation back projection onto an n x n grid.
+  std::vector<double> recon(static_cast<size_t>(n) * n, 0.0);
+  for (int j = 0; j < m_numberOfProjections; ++j) {
+    double angle = m_angles[j] * Pi / 180.0;
+    double c = std::cos(angle);
+    double s = std::sin(angle);
+    const float* projection = sinogram.data() + static_cast<size_t>(j) * n;
+    for (int xi = 0; xi < n; ++xi) {
+      double xpr = xi - n / 2;
+      double* row = recon.data() + static_cast<size_t>(xi) * n;
+      for (int yi = 0; yi < n; ++yi) {
+        double t = (yi - n / 2) * c - xpr * s + center;
+        if (t < 0.0 || t > n - 1) {
+          continue;
+        }
+        int r = static_cast<int>(t);
+        double f = t - r;
+        double value = projection[r];
+        if (r + 1 < n) {
+          value += f * (projection[r + 1] - projection[r]);
+        }
+        row[yi] += value;
+      }
+    }
+  }
+  double maximum = *std::max_element(recon.begin(), recon.end());
+  return maximum * Pi / 2.0 / m_numberOfProjections;
+}
+
+std::vector<double> ShiftSearch::evaluate(
+  const std::vector<double>& shifts) const
+{
+  // Every (shift, slice) pair is an independent trial reconstruction.
+  std::vector<double> maxima(shifts.size() * m_numberOfSlices);
+  parallelFor(static_cast<int>(maxima.size()), m_threads, [&](int item, int) {
+    int candidate = item / m_numberOfSlices;
+    int slice = item % m_numberOfSlices;
+    maxima[item] = reconstructionMaximum(slice, shifts[candidate]);
+  });
+
+  std::vector<double> scores(shifts.size(), 0.0);
+  for (size_t i = 0; i < maxima.size(); ++i) {
+    scores[i / m_numberOfSlices] += maxima[i];
+  }
+  return scores;
+}
+
+Result ShiftSearch::search(double min, double max, double coarseStep,
+                           double fineStep,
+                           const ProgressCallback& progress) const
+{
+  return coarseToFine(
+    [this](const std::vector<double>& shifts) { return evaluate(shifts); },
+    min, max, coarseStep, fineStep, false, progress);
+}
+
+} // namespace TiltAxisSearch
+} // namespace tomviz
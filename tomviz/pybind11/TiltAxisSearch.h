@@ -0,0 +1,115 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizTiltAxisSearch_h
+#define tomvizTiltAxisSearch_h
+
+#include "FourierTransform.h"
+
+#include <functional>
+#include <vector>
+
+namespace tomviz {
+
+namespace TiltAxisSearch {
+
+/// Called from the calling thread between batches of candidates with the
+/// number of candidates evaluated so far and the total. Return true to
+/// cancel the search.
+using ProgressCallback = std::function<bool(int done, int total)>;
+
+/// Score all candidates, returns one score per candidate.
+using Evaluator =
+  std::function<std::vector<double>(const std::vector<double>& candidates)>;
+
+struct Result
+{
+  bool canceled = false;
+  double best = 0.0;
+  /// Every candidate evaluated, over all levels, and its score.
+  std::vector<double> candidates;
+  std::vector<double> scores;
+};
+
+/// Coarse-to-fine search of [min, max), as the Python operators do it. The
+/// range is first sampled every coarseStep, then [best - coarseStep, best +
+/// coarseStep] around the best candidate is sampled every fineStep, and the
+/// best of those wins. A fineStep <= 0 or >= coarseStep only does the coarse
+/// sweep.
+Result coarseToFine(const Evaluator& evaluate, double min, double max,
+                    double coarseStep, double fineStep, bool minimize,
+                    const ProgressCallback& progress = nullptr);
+
+/// Search for the in-plane rotation of the tilt axis, the same metric as the
+/// "Auto Tilt Axis Align" Python operator: the variance over the projections
+/// of the (rescaled) power spectra is integrated along a line through the
+/// origin, and the tilt axis is at the angle minimizing it. The spectra are
+/// computed once, in parallel, when the search is built.
+class RotationSearch
+{
+public:
+  /// tiltSeries holds nx * ny * numberOfProjections values, x fastest.
+  RotationSearch(const float* tiltSeries, int nx, int ny,
+                 int numberOfProjections, int threads = 0);
+
+  /// Scores (lower is better) of angles in degrees, evaluated concurrently.
+  std::vector<double> evaluate(const std::vector<double>& angles) const;
+
+  Result search(double min = -90.0, double max = 90.0,
+                double coarseStep = 2.0, double fineStep = 0.1,
+                const ProgressCallback& progress = nullptr) const;
+
+private:
+  double lineIntensity(double angle) const;
+
+  int m_nx;
+  int m_ny;
+  int m_threads;
+  std::vector<double> m_variance;
+};
+
+/// Search for the shift of the tilt axis along y, the same metric as the
+/// "Auto Tilt Axis Shift Align" Python operator: trial filtered back
+/// projections of a few x slices are computed for each candidate shift, and
+/// the tilt axis is at the shift maximizing the sum of their maxima. Shifts
+/// are rounded to whole pixels and wrap around, like np.roll in the Python
+/// operator, so that both find the same shift.
+class ShiftSearch
+{
+public:
+  /// tiltSeries holds nx * ny * numberOfProjections values, x fastest.
+  /// angles holds numberOfProjections tilt angles in degrees.
+  ShiftSearch(const float* tiltSeries, int nx, int ny, int numberOfProjections,
+              const std::vector<double>& angles,
+              const std::vector<int>& slices, int threads = 0);
+
+  /// Scores (higher is better) of shifts in pixels, evaluated concurrently.
+  std::vector<double> evaluate(const std::vector<double>& shifts) const;
+
+  Result search(double min = -20.0, double max = 21.0,
+                double coarseStep = 1.0, double fineStep = 0.0,
+                const ProgressCallback& progress = nullptr) const;
+
+private:
+  double reconstructionMaximum(int slice, double shift) const;
+  // Ramp filter buffer, of the padded size, in place.
+  void filter(std::vector<FourierTransform::Complex>& buffer) const;
+
+  int m_ny;
+  int m_numberOfProjections;
+  int m_paddedSize;
+  int m_threads;
+  std::vector<double> m_angles;
+  // The rays of the selected sinograms, one per slice and projection,
+  // already ramp filtered if m_prefiltered.
+  std::vector<float> m_sinograms;
+  bool m_prefiltered = false;
+  std::vector<float> m_ramp;
+  FourierTransform::Plan m_plan;
+  int m_numberOfSlices;
+};
+
+} // namespace TiltAxisSearch
+} // namespace tomviz
+
+#endif
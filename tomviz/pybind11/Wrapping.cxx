@@ -3,6 +3,7 @@
 
 #include "OperatorPythonWrapper.h"
 #include "PybindVTKTypeCaster.h"
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -10,6 +11,7 @@
 
 #include "PipelineStateManager.h"
 #include "PythonTypeConversions.h"
+#include "TiltAxisSearch.h"
 #include "vtkImageData.h"
 
 namespace py = pybind11;
@@ -19,6 +21,88 @@ using tomviz::MetadataType;
 
 PYBIND11_VTK_TYPECASTER(vtkImageData)
 
+namespace {
+
+using TiltSeries =
+  py::array_t<float, py::array::f_style | py::array::forcecast>;
+
+// The search runs without the GIL, it is only taken back to call the
+// Python progress callable, which returns true to cancel.
+tomviz::TiltAxisSearch::ProgressCallback progressCallback(
+  const py::object& progress)
+{
+  if (progress.is_none()) {
+    return nullptr;
+  }
+  return [&progress](int done, int total) {
+    py::gil_scoped_acquire acquire;
+    return static_cast<bool>(py::bool_(progress(done, total)));
+  };
+}
+
+py::object searchResult(const tomviz::TiltAxisSearch::Result& result)
+{
+  if (result.canceled) {
+    return py::none();
+  }
+  return py::make_tuple(result.best, result.candidates, result.scores);
+}
+
+void checkTiltSeries(const TiltSeries& tiltSeries)
+{
+  if (tiltSeries.ndim() != 3) {
+    throw py::value_error("The tilt series must be 3D");
+  }
+}
+
+py::object tiltAxisRotationSearch(const TiltSeries& tiltSeries, double min,
+                                  double max, double coarseStep,
+                                  double fineStep, int threads,
+                                  const py::object& progress)
+{
+  checkTiltSeries(tiltSeries);
+  auto callback = progressCallback(progress);
+  tomviz::TiltAxisSearch::Result result;
+  {
+    py::gil_scoped_release release;
+    tomviz::TiltAxisSearch::RotationSearch search(
+      tiltSeries.data(), static_cast<int>(tiltSeries.shape(0)),
+      static_cast<int>(tiltSeries.shape(1)),
+      static_cast<int>(tiltSeries.shape(2)), threads);
+    result = search.search(min, max, coarseStep, fineStep, callback);
+  }
+  return searchResult(result);
+}
+
+py::object tiltAxisShiftSearch(const TiltSeries& tiltSeries,
+                               const std::vector<double>& angles,
+                               const std::vector<int>& slices, double min,
+                               double max, double coarseStep, double fineStep,
+                               int threads, const py::object& progress)
+{
+  checkTiltSeries(tiltSeries);
+  const int nx = static_cast<int>(tiltSeries.shape(0));
+  if (angles.size() != static_cast<size_t>(tiltSeries.shape(2))) {
+    throw py::value_error("There must be one tilt angle per projection");
+  }
+  for (int slice : slices) {
+    if (slice < 0 || slice >= nx) {
+      throw py::value_error("Slice index out of range");
+    }
+  }
+  auto callback = progressCallback(progress);
+  tomviz::TiltAxisSearch::Result result;
+  {
+    py::gil_scoped_release release;
+    tomviz::TiltAxisSearch::ShiftSearch search(
+      tiltSeries.data(), nx, static_cast<int>(tiltSeries.shape(1)),
+      static_cast<int>(tiltSeries.shape(2)), angles, slices, threads);
+    result = search.search(min, max, coarseStep, fineStep, callback);
+  }
+  return searchResult(result);
+}
+} // namespace
+
 PYBIND11_MODULE(_wrapping, m)
 {
   m.doc() = "tomviz wrapped classes";
@@ -80,4 +164,17 @@ PYBIND11_MODULE(_wrapping, m)
     .def("execute_pipeline", &PipelineStateManager::executePipeline)
     .def("pipeline_paused", &PipelineStateManager::pipelinePaused);
 
+  m.def("tilt_axis_rotation_search", &tiltAxisRotationSearch,
+        "Search for the in-plane rotation of the tilt axis, in degrees. "
+        "Returns (best, candidates, scores), or None if canceled.",
+        py::arg("tilt_series"), py::arg("min") = -90.0, py::arg("max") = 90.0,
+        py::arg("coarse_step") = 2.0, py::arg("fine_step") = 0.1,
+        py::arg("threads") = 0, py::arg("progress") = py::none());
+  m.def("tilt_axis_shift_search", &tiltAxisShiftSearch,
+        "Search for the shift of the tilt axis along y, in pixels. "
+        "Returns (best, candidates, scores), or None if canceled.",
+        py::arg("tilt_series"), py::arg("angles"), py::arg("slices"),
+        py::arg("min") = -20.0, py::arg("max") = 21.0,
+        py::arg("coarse_step") = 1.0, py::arg("fine_step") = 0.0,
+        py::arg("threads") = 0, py::arg("progress") = py::none());
 }
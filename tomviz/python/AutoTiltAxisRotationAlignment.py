@@ -3,6 +3,12 @@ import numpy as np
 from scipy import ndimage
 import tomviz.operators
 
+try:
+    # The native search is only available inside of the application.
+    from tomviz._wrapping import tilt_axis_rotation_search
+except ImportError:
+    tilt_axis_rotation_search = None
+
 
 class AutoTiltAxisRotationAlignOperator(tomviz.operators.CancelableOperator):
 
@@ -18,6 +24,42 @@ class AutoTiltAxisRotationAlignOperator(tomviz.operators.CancelableOperator):
         if tiltSeries is None: #Check if data exists
             raise RuntimeError("No data array found!")
 
+        if tilt_axis_rotation_search is not None:
+            rot_ang = self.native_search(tiltSeries)
+        else:
+            rot_ang = self.search(tiltSeries)
+        if rot_ang is None:
+            return
+
+        self.progress.message = 'Rotating tilt series'
+        axes = ((0, 1))
+        shape = utils.rotate_shape(tiltSeries, -rot_ang, axes=axes)
+
+        print("rotate tilt series by %f degrees" % -rot_ang)
+
+        for name in dataset.scalars_names:
+            array = dataset.scalars(name)
+            result = np.empty(shape, array.dtype, order='F')
+            ndimage.interpolation.rotate(
+                array, -rot_ang, axes=axes, output=result)
+
+            # Set the result as the new scalars.
+            dataset.set_scalars(name, result)
+
+    def native_search(self, tiltSeries):
+        self.progress.message = 'Searching for the tilt axis rotation'
+
+        def progress(done, total):
+            self.progress.maximum = total
+            self.progress.value = done
+            return self.canceled
+
+        result = tilt_axis_rotation_search(tiltSeries, progress=progress)
+        if result is None:
+            return None
+        return result[0]
+
+    def search(self, tiltSeries):
         (Nslice, Nray, Nproj) = tiltSeries.shape
         Intensity = np.zeros(tiltSeries.shape)
 
@@ -85,21 +127,7 @@ class AutoTiltAxisRotationAlignOperator(tomviz.operators.CancelableOperator):
         I_sum = np.sum(I, axis=1)
         minIntensityIndex = np.argmin(I_sum)
         rot_ang = fineAngles[minIntensityIndex]
-
-        self.progress.message = 'Rotating tilt series'
-        axes = ((0, 1))
-        shape = utils.rotate_shape(tiltSeries, -rot_ang, axes=axes)
-
-        print("rotate tilt series by %f degrees" % -rot_ang)
-
-        for name in dataset.scalars_names:
-            array = dataset.scalars(name)
-            result = np.empty(shape, array.dtype, order='F')
-            ndimage.interpolation.rotate(
-                array, -rot_ang, axes=axes, output=result)
-
-            # Set the result as the new scalars.
-            dataset.set_scalars(name, result)
+        return rot_ang
 
 
 def calculateLineIntensity(Intensity_var, angle_d, N):
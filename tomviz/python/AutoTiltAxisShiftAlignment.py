@@ -5,6 +5,12 @@ from scipy import ndimage
 import tomviz.operators
 from tomviz.utils import pad_array
 
+try:
+    # The native search is only available inside of the application.
+    from tomviz._wrapping import tilt_axis_shift_search
+except ImportError:
+    tilt_axis_shift_search = None
+
 
 class AutoTiltAxisShiftAlignmentOperator(tomviz.operators.CancelableOperator):
 
@@ -71,6 +77,42 @@ class AutoTiltAxisShiftAlignmentOperator(tomviz.operators.CancelableOperator):
         print('Trial reconstruction slices:')
         print(slices)
 
+        if tilt_axis_shift_search is not None:
+            shift = self.native_search(tiltSeries, tilt_angles, slices)
+        else:
+            shift = self.search(tiltSeries, tilt_angles, slices, shifts)
+        if shift is None:
+            return
+
+        print(f'shift: {shift}')
+
+        if transforms_save_file:
+            np.savez(
+                transforms_save_file,
+                shift=shift,
+                spacing=dataset.spacing,
+            )
+            print('Saved transforms file to:', transforms_save_file)
+
+        return self.apply_shift_to_arrays(dataset, shift, apply_to_all_arrays)
+
+    def native_search(self, tiltSeries, tilt_angles, slices):
+        self.progress.message = 'Searching for the tilt axis shift'
+
+        def progress(done, total):
+            self.progress.maximum = total
+            self.progress.value = done
+            return self.canceled
+
+        result = tilt_axis_shift_search(tiltSeries, tilt_angles, slices,
+                                        progress=progress)
+        if result is None:
+            return None
+        return result[0]
+
+    def search(self, tiltSeries, tilt_angles, slices, shifts):
+        Ny = tiltSeries.shape[1]
+        num_slices = slices.size
         I = np.zeros(shifts.size)
 
         self.progress.maximum = shifts.size - 1
@@ -94,17 +136,7 @@ class AutoTiltAxisShiftAlignmentOperator(tomviz.operators.CancelableOperator):
             self.progress.value = step
 
         shift = shifts[np.argmax(I)]
-        print(f'shift: {shift}')
-
-        if transforms_save_file:
-            np.savez(
-                transforms_save_file,
-                shift=shift,
-                spacing=dataset.spacing,
-            )
-            print('Saved transforms file to:', transforms_save_file)
-
-        return self.apply_shift_to_arrays(dataset, shift, apply_to_all_arrays)
+        return shift
 
     def transform_from_file(self, dataset, transform_file: str = '',
                             apply_to_all_arrays: bool = True):
@@ -34,8 +34,18 @@ def create_reader_instance(reader_class):
     return reader_class()
 
 
-def execute_reader(obj, path):
-    return obj.read(path)
+def execute_reader(obj, path, options=None):
+    if options is None:
+        return obj.read(path)
+    return obj.read(path, options)
+
+
+def reader_volume_info(obj, path):
+    """The (x, y, z) dimensions and value size of the volume in a file, as a
+    list, for the readers that can subsample it. None otherwise."""
+    if not hasattr(obj, 'volume_info'):
+        return None
+    return obj.volume_info(path)
 
 
 def list_python_writers():
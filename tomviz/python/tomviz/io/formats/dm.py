@@ -0,0 +1,71 @@
+# -*- coding: utf-8 -*-
+
+###############################################################################
+# This source file is part of the Tomviz project, https://tomviz.org/.
+# It is released under the 3-Clause BSD License, see "LICENSE".
+###############################################################################
+import numpy as np
+
+from tomviz.io import FileType, IOBase, Reader
+from tomviz.io import dm as dm_io
+
+import tomviz.internal_utils
+
+from vtk import vtkImageData
+
+# The number of nanometers in the calibration units
+_UNITS = {
+    'nm': 1.0,
+    'um': 1e3,
+    'µm': 1e3,
+    'mm': 1e6,
+    'm': 1e9,
+    'pm': 1e-3,
+    'A': 0.1,
+    'Å': 0.1,
+}
+
+
+class DMBase(IOBase):
+
+    @staticmethod
+    def file_type():
+        return FileType('Gatan DigitalMicrograph', ['dm3', 'dm4'])
+
+
+class DMReader(Reader, DMBase):
+    """Used when the native reader fails, reads the same image in the same
+    order as it does."""
+
+    def read(self, path):
+        with dm_io.FileDM(path, on_memory=False) as f:
+            dataset = f.getDataset(0)
+
+        data = dataset['data']
+        sizes = list(dataset['pixelSize'])
+        units = list(dataset['pixelUnit'])
+
+        # Stack the diffraction patterns of 4D data sets
+        if data.ndim == 4:
+            data = data.reshape((-1,) + data.shape[2:])
+            sizes = sizes[-3:]
+            units = units[-3:]
+
+        # Convert from C ordered (z, y, x) to Fortran ordered (x, y, z)
+        data = np.asfortranarray(data.T)
+        data = data.reshape(data.shape + (1,) * (3 - data.ndim), order='F')
+
+        spacing = [1.0, 1.0, 1.0]
+        for i, (size, unit) in enumerate(zip(sizes[::-1], units[::-1])):
+            if i < 3 and size > 0:
+                spacing[i] = size * _UNITS.get(unit, 1.0)
+
+        image_data = vtkImageData()
+        (x, y, z) = data.shape
+
+        image_data.SetOrigin(0, 0, 0)
+        image_data.SetSpacing(spacing)
+        image_data.SetExtent(0, x - 1, 0, y - 1, 0, z - 1)
+        tomviz.internal_utils.set_array(image_data, data)
+
+        return image_data
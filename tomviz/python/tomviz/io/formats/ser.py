@@ -0,0 +1,53 @@
+# -*- coding: utf-8 -*-
+
+###############################################################################
+# This source file is part of the Tomviz project, https://tomviz.org/.
+# It is released under the 3-Clause BSD License, see "LICENSE".
+###############################################################################
+import numpy as np
+
+from tomviz.io import FileType, IOBase, Reader
+from tomviz.io import ser as ser_io
+
+import tomviz.internal_utils
+
+from vtk import vtkImageData
+
+
+class SerBase(IOBase):
+
+    @staticmethod
+    def file_type():
+        return FileType('TIA series', ['ser'])
+
+
+class SerReader(Reader, SerBase):
+    """Used when the native reader fails. Images are stacked along Z, and
+    spectra along Y."""
+
+    def read(self, path):
+        spacing = [1.0, 1.0, 1.0]
+        with ser_io.FileSER(path) as f:
+            elements = []
+            for i in range(f.head['ValidNumberElements']):
+                data, meta = f.getDataset(i)
+                elements.append(data)
+            if f.head['DataTypeID'] == 0x4122:
+                # The calibrations are in meters
+                for i, calibration in enumerate(meta['Calibration']):
+                    if calibration['CalibrationDelta'] > 0:
+                        spacing[i] = calibration['CalibrationDelta'] * 1e9
+
+        # Convert from C ordered (z, y, x) to Fortran ordered (x, y, z)
+        data = np.asfortranarray(np.stack(elements).T)
+        data = data.reshape(data.shape + (1,) * (3 - data.ndim), order='F')
+
+        image_data = vtkImageData()
+        (x, y, z) = data.shape
+
+        image_data.SetOrigin(0, 0, 0)
+        image_data.SetSpacing(spacing)
+        image_data.SetExtent(0, x - 1, 0, y - 1, 0, z - 1)
+        tomviz.internal_utils.set_array(image_data, data)
+
+        return image_data
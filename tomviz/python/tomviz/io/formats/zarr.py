@@ -0,0 +1,123 @@
+# -*- coding: utf-8 -*-
+
+###############################################################################
+# This source file is part of the Tomviz project, https://tomviz.org/.
+# It is released under the 3-Clause BSD License, see "LICENSE".
+###############################################################################
+import numpy as np
+
+from tomviz.io import FileType, IOBase, Reader, Writer
+from tomviz.io import zarr as zarr_io
+
+import tomviz.internal_utils
+
+from vtk import vtkImageData
+
+
+class ZarrBase(IOBase):
+
+    @staticmethod
+    def file_type():
+        # Stores are directories, they can also be opened from their metadata
+        return FileType('Zarr', ['zarr', 'zarray', 'zgroup', 'zattrs'])
+
+
+class ZarrWriter(Writer, ZarrBase):
+
+    def write(self, path, data_object):
+        data = tomviz.internal_utils.get_array(data_object)
+
+        # Convert from Fortran ordered (x, y, z) to C ordered (z, y, x)
+        spacing = list(data_object.GetSpacing())[::-1]
+        zarr_io.write_array(path, data.T, spacing=spacing)
+
+
+class ZarrReader(Reader, ZarrBase):
+    """Reads Zarr v2 and v3 arrays, and the full resolution of OME-Zarr
+    images. The options are the subsample settings of the HDF5 readers, in
+    (x, y, z) order."""
+
+    def volume_info(self, path):
+        """The (x, y, z) dimensions and the value size of the volume, which
+        the subsample settings apply to."""
+        array = zarr_io.Array(zarr_io.find_array(path)[0])
+        if len(array.shape) < 2:
+            return None
+
+        dims = list(array.shape[-3:][::-1])
+        dims += [1] * (3 - len(dims))
+        return dims + [array.dtype.itemsize]
+
+    def read(self, path, options=None):
+        settings = (options or {}).get('subsampleSettings', {})
+        strides = settings.get('strides')
+        bounds = settings.get('volumeBounds')
+        # Average the voxels of each stride block, rather than sampling
+        average = settings.get('average', False) and strides is not None
+        if average:
+            block = list(strides)
+            strides = None
+
+        shape = zarr_io.Array(zarr_io.find_array(path)[0]).shape
+        if len(shape) < 2:
+            return vtkImageData()
+
+        # Extra leading axes (time, channels) are read at their first index
+        extra = len(shape) - 3
+        c_strides = None
+        if strides is not None:
+            c_strides = [1] * extra + list(strides)[::-1]
+            c_strides = c_strides[-len(shape):]
+        c_bounds = None
+        if bounds is not None and all(b >= 0 for b in bounds):
+            pairs = [bounds[i:i + 2] for i in range(0, 6, 2)][::-1]
+            c_bounds = [(0, 1)] * extra + pairs
+            c_bounds = c_bounds[-len(shape):]
+        elif extra > 0:
+            c_bounds = [(0, 1)] * extra + [None] * 3
+
+        data, scale = zarr_io.read_array(path, c_bounds, c_strides)
+        data = data.reshape(data.shape[max(0, extra):])
+        if average:
+            data, scale = _average(data, block[::-1][-data.ndim:], scale)
+
+        # Convert from C ordered (z, y, x) to Fortran ordered (x, y, z)
+        data = np.asfortranarray(data.T)
+        data = data.reshape(data.shape + (1,) * (3 - data.ndim), order='F')
+
+        spacing = [1.0, 1.0, 1.0]
+        if scale is not None:
+            for i, value in enumerate(scale[::-1][:3]):
+                if value > 0:
+                    spacing[i] = value
+
+        image_data = vtkImageData()
+        (x, y, z) = data.shape
+
+        image_data.SetOrigin(0, 0, 0)
+        image_data.SetSpacing(spacing)
+        image_data.SetExtent(0, x - 1, 0, y - 1, 0, z - 1)
+        tomviz.internal_utils.set_array(image_data, data)
+
+        return image_data
+
+
+def _average(data, block, scale):
+    """Average blocks of a C ordered array, dropping partial blocks at the
+    ends as strided reads of HDF5 files do."""
+    counts = [max(n // b, 1) for n, b in zip(data.shape, block)]
+    block = [min(b, n) for n, b in zip(data.shape, block)]
+    data = data[tuple(slice(0, c * b) for c, b in zip(counts, block))]
+    shape = []
+    for c, b in zip(counts, block):
+        shape += [c, b]
+    mean = data.reshape(shape).mean(axis=tuple(range(1, 2 * len(counts), 2)))
+    if np.issubdtype(data.dtype, np.integer):
+        mean = np.rint(mean)
+
+    if scale is not None:
+        # The scale of the leading axes isn't affected
+        factors = [1] * (len(scale) - len(block)) + block
+        scale = [s * f for s, f in zip(scale, factors)]
+
+    return mean.astype(data.dtype), scale
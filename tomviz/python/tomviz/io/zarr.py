@@ -0,0 +1,511 @@
+# -*- coding: utf-8 -*-
+
+###############################################################################
+# This source file is part of the Tomviz project, https://tomviz.org/.
+# It is released under the 3-Clause BSD License, see "LICENSE".
+###############################################################################
+"""Reads and writes Zarr v2 and v3 stores in local directories, including
+OME-Zarr multiscale images.
+
+Only numpy and the standard library are required. gzip and zlib chunks are
+always supported, zstd and blosc chunks need numcodecs (zstandard will also
+do for zstd). Chunks are decoded and encoded in parallel on a thread pool,
+the codecs release the GIL while they run.
+"""
+from concurrent.futures import ThreadPoolExecutor
+import gzip
+import itertools
+import json
+import math
+import os
+import shutil
+import zlib
+
+import numpy as np
+
+_V2_FILES = ('.zarray', '.zgroup', '.zattrs')
+_V3_FILE = 'zarr.json'
+
+# The Zarr v3 data types
+_V3_DTYPES = {
+    'bool': '|b1',
+    'int8': '|i1',
+    'int16': 'i2',
+    'int32': 'i4',
+    'int64': 'i8',
+    'uint8': '|u1',
+    'uint16': 'u2',
+    'uint32': 'u4',
+    'uint64': 'u8',
+    'float32': 'f4',
+    'float64': 'f8',
+}
+
+
+class ZarrError(Exception):
+    pass
+
+
+def _default_workers():
+    return min(32, os.cpu_count() or 1)
+
+
+def _read_json(path):
+    with open(path, 'r') as f:
+        return json.load(f)
+
+
+def _write_json(path, value):
+    with open(path, 'w') as f:
+        json.dump(value, f, indent=2)
+
+
+class _Codec(object):
+    """A bytes to bytes compressor, from its v2 or v3 configuration."""
+
+    def __init__(self, name, config):
+        self.name = name
+        self.config = dict(config)
+        if name not in ('gzip', 'zlib', 'zstd', 'blosc'):
+            raise ZarrError('Unsupported Zarr codec: %s' % name)
+
+        self._impl = None
+        if name in ('zstd', 'blosc'):
+            self._impl = self._load(name)
+
+    def _load(self, name):
+        try:
+            import numcodecs
+            config = {'id': name}
+            config.update(self.config)
+            if name == 'blosc' and isinstance(config.get('shuffle'), str):
+                # v3 spells the shuffle out
+                config['shuffle'] = {'noshuffle': 0, 'shuffle': 1,
+                                     'bitshuffle': 2}[config['shuffle']]
+            config.pop('typesize', None)
+            return numcodecs.get_codec(config)
+        except ImportError:
+            pass
+
+        if name == 'zstd':
+            try:
+                import zstandard
+            except ImportError:
+                pass
+            else:
+                level = self.config.get('level', 3)
+                return _ZstandardCodec(zstandard, level)
+
+        raise ZarrError('Reading or writing %s chunks requires numcodecs' %
+                        name)
+
+    def decode(self, data):
+        if self.name == 'gzip':
+            return gzip.decompress(data)
+        if self.name == 'zlib':
+            return zlib.decompress(data)
+        return self._impl.decode(data)
+
+    def encode(self, data):
+        level = self.config.get('level', 1)
+        if self.name == 'gzip':
+            return gzip.compress(data, compresslevel=level)
+        if self.name == 'zlib':
+            return zlib.compress(data, level)
+        return self._impl.encode(data)
+
+
+class _ZstandardCodec(object):
+
+    def __init__(self, zstandard, level):
+        self._zstandard = zstandard
+        self._level = level
+
+    def decode(self, data):
+        return self._zstandard.ZstdDecompressor().decompress(data)
+
+    def encode(self, data):
+        compressor = self._zstandard.ZstdCompressor(level=self._level)
+        return compressor.compress(bytes(data))
+
+
+def default_compressor():
+    """The fastest of the compressors that are available, as a v2 config."""
+    for name, config in (('blosc', {'cname': 'lz4', 'clevel': 5,
+                                    'shuffle': 1}),
+                         ('zstd', {'level': 3})):
+        try:
+            _Codec(name, config)
+        except ZarrError:
+            continue
+        return dict(config, id=name)
+
+    return {'id': 'zlib', 'level': 1}
+
+
+class Array(object):
+    """The metadata of an array in a store, and its chunks."""
+
+    def __init__(self, path):
+        self.path = path
+        if os.path.exists(os.path.join(path, '.zarray')):
+            self._init_v2(_read_json(os.path.join(path, '.zarray')))
+        elif os.path.exists(os.path.join(path, _V3_FILE)):
+            self._init_v3(_read_json(os.path.join(path, _V3_FILE)))
+        else:
+            raise ZarrError('No Zarr array found in %s' % path)
+
+    def _init_v2(self, meta):
+        self.version = 2
+        self.shape = tuple(meta['shape'])
+        self.chunks = tuple(meta['chunks'])
+        self.dtype = np.dtype(meta['dtype'])
+        self.order = meta.get('order', 'C')
+        self.fill_value = meta.get('fill_value') or 0
+        if meta.get('filters'):
+            raise ZarrError('Zarr filters are not supported')
+
+        compressor = meta.get('compressor')
+        self.codecs = []
+        if compressor:
+            config = dict(compressor)
+            self.codecs.append(_Codec(config.pop('id'), config))
+
+        self.separator = meta.get('dimension_separator', '.')
+        self.key_prefix = ''
+        self.checksum = False
+
+    def _init_v3(self, meta):
+        if meta.get('node_type') != 'array':
+            raise ZarrError('%s is not a Zarr array' % self.path)
+
+        self.version = 3
+        self.shape = tuple(meta['shape'])
+        grid = meta['chunk_grid']
+        if grid['name'] != 'regular':
+            raise ZarrError('Unsupported chunk grid: %s' % grid['name'])
+        self.chunks = tuple(grid['configuration']['chunk_shape'])
+
+        data_type = meta['data_type']
+        if data_type not in _V3_DTYPES:
+            raise ZarrError('Unsupported data type: %s' % data_type)
+        self.fill_value = meta.get('fill_value') or 0
+
+        self.order = 'C'
+        self.codecs = []
+        self.checksum = False
+        endian = '<'
+        for codec in meta['codecs']:
+            name = codec['name']
+            config = codec.get('configuration', {})
+            if name == 'transpose':
+                order = list(config['order'])
+                if order == list(range(len(self.shape)))[::-1]:
+                    self.order = 'F'
+                elif order != list(range(len(self.shape))):
+                    raise ZarrError('Unsupported transpose: %s' % order)
+            elif name == 'bytes':
+                endian = '>' if config.get('endian') == 'big' else '<'
+            elif name == 'crc32c':
+                # The checksum is dropped, not verified
+                self.checksum = True
+            elif name == 'sharding_indexed':
+                raise ZarrError('Sharded Zarr arrays are not supported')
+            else:
+                self.codecs.append(_Codec(name, config))
+
+        dtype = _V3_DTYPES[data_type]
+        self.dtype = np.dtype(dtype if dtype[0] == '|' else endian + dtype)
+
+        encoding = meta.get('chunk_key_encoding', {'name': 'default'})
+        config = encoding.get('configuration', {})
+        if encoding['name'] == 'v2':
+            self.separator = config.get('separator', '.')
+            self.key_prefix = ''
+        else:
+            self.separator = config.get('separator', '/')
+            self.key_prefix = 'c' + self.separator
+
+    def chunk_path(self, index):
+        key = self.separator.join(str(i) for i in index)
+        if not index:
+            key = '0' if self.version == 2 else 'c'
+        return os.path.join(self.path, *(self.key_prefix + key).split('/'))
+
+    def read_chunk(self, index):
+        """The chunk at a grid index, filled where it was never written."""
+        try:
+            with open(self.chunk_path(index), 'rb') as f:
+                data = f.read()
+        except FileNotFoundError:
+            return np.full(self.chunks, self.fill_value, dtype=self.dtype)
+
+        if self.checksum:
+            data = data[:-4]
+        for codec in reversed(self.codecs):
+            data = codec.decode(data)
+
+        chunk = np.frombuffer(data, dtype=self.dtype)
+        return chunk.reshape(self.chunks, order=self.order)
+
+    def write_chunk(self, index, chunk):
+        data = np.asarray(chunk, dtype=self.dtype).tobytes(order=self.order)
+        for codec in self.codecs:
+            data = codec.encode(data)
+
+        path = self.chunk_path(index)
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        with open(path, 'wb') as f:
+            f.write(data)
+
+
+def find_array(path):
+    """The path of the full resolution array of a store, and its OME-Zarr
+    scale, if any."""
+    if os.path.basename(path) in _V2_FILES + (_V3_FILE,):
+        path = os.path.dirname(path)
+
+    attributes = {}
+    if os.path.exists(os.path.join(path, '.zattrs')):
+        attributes = _read_json(os.path.join(path, '.zattrs'))
+    elif os.path.exists(os.path.join(path, _V3_FILE)):
+        meta = _read_json(os.path.join(path, _V3_FILE))
+        if meta.get('node_type') == 'array':
+            return path, None
+        attributes = meta.get('attributes', {})
+        # OME-Zarr 0.5 nests its metadata
+        attributes = attributes.get('ome', attributes)
+
+    multiscales = attributes.get('multiscales')
+    if not multiscales:
+        return path, None
+
+    dataset = multiscales[0]['datasets'][0]
+    scale = None
+    for transform in dataset.get('coordinateTransformations', []):
+        if transform.get('type') == 'scale':
+            scale = transform['scale']
+
+    return os.path.join(path, dataset['path']), scale
+
+
+def _selection(shape, bounds, strides):
+    """The [start, end) bounds and strides of every axis, in C order."""
+    ndim = len(shape)
+    if bounds is None:
+        bounds = [None] * ndim
+    if strides is None:
+        strides = [1] * ndim
+    if len(bounds) != ndim or len(strides) != ndim:
+        raise ZarrError('Expected bounds and strides for %d axes' % ndim)
+
+    ranges = []
+    for size, bound, stride in zip(shape, bounds, strides):
+        start, end = (0, size) if bound is None else bound
+        start, end = max(0, start), min(size, end)
+        if start >= end or stride < 1:
+            raise ZarrError('Invalid subsample: %s, %s' % (bounds, strides))
+        ranges.append(range(start, end, stride))
+    return ranges
+
+
+def _axis_pieces(selected, chunk):
+    """For every chunk along an axis that holds selected indices: the chunk
+    index, the slice within the chunk and the slice of the output."""
+    pieces = []
+    for c in range(selected[0] // chunk, selected[-1] // chunk + 1):
+        begin, end = c * chunk, (c + 1) * chunk
+        # The selected indices are sorted, find the ones in this chunk
+        first = max(0, -(-(begin - selected.start) // selected.step))
+        last = min(len(selected), -(-(end - selected.start) // selected.step))
+        if first >= last:
+            continue
+        pieces.append((c,
+                       slice(selected[first] - begin,
+                             selected[last - 1] - begin + 1, selected.step),
+                       slice(first, last)))
+    return pieces
+
+
+def read_array(path, bounds=None, strides=None, workers=None):
+    """Read an array, or the full resolution of an OME-Zarr image.
+
+    bounds are [start, end) pairs and strides the step of every axis, in the
+    C order of the store, as the subsample options of HDF5 files. Only the
+    chunks that hold selected values are read.
+
+    :returns the C ordered array and the OME-Zarr scale, or None.
+    """
+    path, scale = find_array(path)
+    array = Array(path)
+    ranges = _selection(array.shape, bounds, strides)
+
+    out = np.empty([len(r) for r in ranges], dtype=array.dtype.newbyteorder(
+        '='))
+    pieces = [_axis_pieces(r, c) for r, c in zip(ranges, array.chunks)]
+
+    def read(piece):
+        index = tuple(p[0] for p in piece)
+        chunk = array.read_chunk(index)
+        out[tuple(p[2] for p in piece)] = chunk[tuple(p[1] for p in piece)]
+
+    with ThreadPoolExecutor(workers or _default_workers()) as executor:
+        # Raise the first error, if any
+        list(executor.map(read, itertools.product(*pieces)))
+
+    if scale is not None:
+        # The scale of the selection
+        scale = [s * r.step for s, r in zip(scale, ranges)]
+
+    return out, scale
+
+
+def _create_array(path, shape, dtype, chunks, compressor, version):
+    os.makedirs(path)
+    dtype = np.dtype(dtype)
+    if version == 2:
+        meta = {
+            'zarr_format': 2,
+            'shape': list(shape),
+            'chunks': list(chunks),
+            'dtype': dtype.str,
+            'compressor': compressor,
+            'fill_value': 0,
+            'order': 'C',
+            'filters': None,
+            'dimension_separator': '/',
+        }
+        _write_json(os.path.join(path, '.zarray'), meta)
+    else:
+        codecs = [{'name': 'bytes', 'configuration': {'endian': 'little'}}]
+        if compressor:
+            config = dict(compressor)
+            name = config.pop('id')
+            if name == 'blosc':
+                config['shuffle'] = ['noshuffle', 'shuffle',
+                                     'bitshuffle'][config['shuffle']]
+                config['typesize'] = dtype.itemsize
+            elif name == 'zlib':
+                # v3 has no zlib codec
+                name = 'gzip'
+            codecs.append({'name': name, 'configuration': config})
+
+        meta = {
+            'zarr_format': 3,
+            'node_type': 'array',
+            'shape': list(shape),
+            'data_type': dtype.name,
+            'chunk_grid': {'name': 'regular',
+                           'configuration': {'chunk_shape': list(chunks)}},
+            'chunk_key_encoding': {'name': 'default',
+                                   'configuration': {'separator': '/'}},
+            'fill_value': 0,
+            'codecs': codecs,
+        }
+        _write_json(os.path.join(path, _V3_FILE), meta)
+
+    return Array(path)
+
+
+def _write_chunks(array, data, workers):
+    grid = [range(math.ceil(s / c)) for s, c in zip(array.shape,
+                                                    array.chunks)]
+
+    def write(index):
+        region = tuple(slice(i * c, (i + 1) * c)
+                       for i, c in zip(index, array.chunks))
+        values = data[region]
+        if values.shape != array.chunks:
+            # Edge chunks are padded to the full chunk shape
+            chunk = np.zeros(array.chunks, dtype=array.dtype)
+            chunk[tuple(slice(0, s) for s in values.shape)] = values
+            values = chunk
+        array.write_chunk(index, values)
+
+    with ThreadPoolExecutor(workers) as executor:
+        list(executor.map(write, itertools.product(*grid)))
+
+
+def _downsample(data):
+    """Halve every axis of at least two values, averaging the blocks."""
+    shape = [s // 2 if s > 1 else 1 for s in data.shape]
+    factors = [2 if s > 1 else 1 for s in data.shape]
+    blocks = data[tuple(slice(0, s * f) for s, f in zip(shape, factors))]
+    blocks = blocks.reshape([v for s, f in zip(shape, factors)
+                             for v in (s, f)])
+    mean = blocks.mean(axis=tuple(range(1, 2 * len(shape), 2)))
+    if np.issubdtype(data.dtype, np.integer):
+        mean = np.rint(mean)
+    return mean.astype(data.dtype), factors
+
+
+def _is_store(path):
+    return any(os.path.exists(os.path.join(path, name))
+               for name in _V2_FILES + (_V3_FILE,))
+
+
+def write_array(path, data, spacing=None, chunks=None, compressor='default',
+                version=2, levels=None, axis_names=('z', 'y', 'x'),
+                workers=None):
+    """Write a C ordered array as an OME-Zarr multiscale image.
+
+    The full resolution array is written at "0", followed by levels that
+    halve every axis until the largest one fits in a chunk. compressor is a
+    v2 compressor config (or None); the default one is the fastest of blosc,
+    zstd and zlib that is available. Version 3 stores follow OME-Zarr 0.5.
+    """
+    if version not in (2, 3):
+        raise ZarrError('Unsupported Zarr version: %s' % version)
+    if os.path.exists(path):
+        if not _is_store(path):
+            raise ZarrError('%s exists and is not a Zarr store' % path)
+        shutil.rmtree(path)
+
+    data = np.ascontiguousarray(data)
+    if compressor == 'default':
+        compressor = default_compressor()
+    if chunks is None:
+        chunks = [min(s, 128) for s in data.shape]
+    chunks = tuple(max(1, min(s, c)) for s, c in zip(data.shape, chunks))
+    if spacing is None:
+        spacing = [1.0] * data.ndim
+    if levels is None:
+        levels = 1
+        shape = data.shape
+        while max(shape) > max(chunks) and levels < 8:
+            shape = [max(1, s // 2) for s in shape]
+            levels += 1
+
+    workers = workers or _default_workers()
+    os.makedirs(path)
+    datasets = []
+    scale = [float(s) for s in spacing]
+    for level in range(levels):
+        if level > 0:
+            data, factors = _downsample(data)
+            scale = [s * f for s, f in zip(scale, factors)]
+        array = _create_array(os.path.join(path, str(level)), data.shape,
+                              data.dtype, chunks, compressor, version)
+        _write_chunks(array, data, workers)
+        datasets.append({
+            'path': str(level),
+            'coordinateTransformations': [{'type': 'scale',
+                                           'scale': list(scale)}],
+        })
+
+    multiscales = [{
+        'axes': [{'name': name, 'type': 'space'} for name in axis_names],
+        'datasets': datasets,
+    }]
+    if version == 2:
+        multiscales[0]['version'] = '0.4'
+        _write_json(os.path.join(path, '.zgroup'), {'zarr_format': 2})
+        _write_json(os.path.join(path, '.zattrs'),
+                    {'multiscales': multiscales})
+    else:
+        _write_json(os.path.join(path, _V3_FILE), {
+            'zarr_format': 3,
+            'node_type': 'group',
+            'attributes': {'ome': {'version': '0.5',
+                                   'multiscales': multiscales}},
+        })
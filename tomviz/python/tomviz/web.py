@@ -1,10 +1,16 @@
 import base64
+from concurrent.futures import ThreadPoolExecutor
+import gzip
 import json
 import os
+import re
 import shutil
 import zipfile
 import tempfile
 
+import numpy as np
+import vtk.util.numpy_support as np_s
+
 from paraview import simple
 from paraview.web.dataset_builder import ImageDataSetBuilder
 from paraview.web.dataset_builder import CompositeDataSetBuilder
@@ -16,12 +22,71 @@ JS_FILENAME = 'tomviz.js'
 HTML_WITH_DATA_FILENAME = 'tomviz_data.html'
 DATA_FILENAME = 'data.tomviz'
 
-arrayTypesMapping = '  bBhHiIlLfd'
+# Compressed data files are split in blocks named <name>.<index>.gz
+BLOCK_SIZE = 4 * 1024 * 1024
+BLOCK_PATTERN = re.compile(r'^(.*)\.(\d+)\.gz$')
+
+# Inflates the blocks of the compressed resources, in document order, into
+# the resources the viewer reads, before starting it.
+INFLATE_SCRIPT = """<script>
+(async function () {
+  function decode(text) {
+    var binary = atob(text);
+    var bytes = new Uint8Array(binary.length);
+    for (var i = 0; i < binary.length; i++) {
+      bytes[i] = binary.charCodeAt(i);
+    }
+    return bytes;
+  }
+  function encode(bytes) {
+    var chunks = [];
+    for (var i = 0; i < bytes.length; i += 0x8000) {
+      chunks.push(String.fromCharCode.apply(
+        null, bytes.subarray(i, i + 0x8000)));
+    }
+    return btoa(chunks.join(''));
+  }
+  var groups = {};
+  var order = [];
+  var blocks = document.querySelectorAll('.webResource[data-block]');
+  blocks.forEach(function (div) {
+    var url = div.getAttribute('data-url');
+    if (!groups[url]) {
+      groups[url] = [];
+      order.push(url);
+    }
+    groups[url][Number(div.getAttribute('data-block'))] = div;
+  });
+  for (var url of order) {
+    var parts = await Promise.all(groups[url].map(function (div) {
+      var stream = new Blob([decode(div.textContent)]).stream()
+        .pipeThrough(new DecompressionStream('gzip'));
+      return new Response(stream).arrayBuffer();
+    }));
+    var size = parts.reduce(function (s, p) { return s + p.byteLength; }, 0);
+    var bytes = new Uint8Array(size);
+    var offset = 0;
+    parts.forEach(function (part) {
+      bytes.set(new Uint8Array(part), offset);
+      offset += part.byteLength;
+    });
+    groups[url].forEach(function (div) { div.remove(); });
+    var resource = document.createElement('div');
+    resource.className = 'webResource';
+    resource.setAttribute('data-url', url);
+    resource.textContent = encode(bytes);
+    document.body.appendChild(resource);
+  }
+  ready();
+})();
+</script></body>"""
+
+# The typed arrays of the numpy (and array module) type codes
 jsMapping = {
     'b': 'Int8Array',
     'B': 'Uint8Array',
     'h': 'Int16Array',
-    'H': 'Int16Array',
+    'H': 'Uint16Array',
     'i': 'Int32Array',
     'I': 'Uint32Array',
     'l': 'Int32Array',
@@ -115,27 +180,34 @@ def bundleDataToHTML(temp_dir, htmlFilePath, dataFilePath=None, compress=False):
     webResources = ['<style>.webResource { display: none; }</style>']
 
     if os.path.exists(dataDir):
-        for dirName, subdirList, fileList in os.walk(dataDir):
-            for fname in fileList:
-                fullPath = os.path.join(dirName, fname)
-                filePath = os.path.relpath(fullPath, dataDir)
-                relPath = '%s/%s' % (DATA_DIRECTORY, filePath)
-                content = ''
-
-                if fname.endswith('.json'):
-                    with open(fullPath, 'r', encoding='utf8') as data:
-                        content = data.read()
-                else:
-                    with open(fullPath, 'rb') as data:
-                        dataContent = data.read()
-                        content = base64.b64encode(dataContent)
-                        content = content.decode().replace('\n', '')
-
-                webResources.append(
-                    '<div class="webResource" data-url="%s">%s</div>'
-                    % (relPath, content))
-
-        webResources.append('<script>ready()</script></body>')
+        hasBlocks = False
+        for relPath, fullPath in data_files(dataDir):
+            content = ''
+            attributes = 'data-url="%s"' % relPath
+
+            if relPath.endswith('.json'):
+                with open(fullPath, 'r', encoding='utf8') as data:
+                    content = data.read()
+            else:
+                with open(fullPath, 'rb') as data:
+                    dataContent = data.read()
+                    content = base64.b64encode(dataContent)
+                    content = content.decode().replace('\n', '')
+
+                match = BLOCK_PATTERN.match(relPath)
+                if match:
+                    hasBlocks = True
+                    attributes = 'data-url="%s" data-block="%s"' % (
+                        match.group(1), match.group(2))
+
+            webResources.append(
+                '<div class="webResource" %s>%s</div>'
+                % (attributes, content))
+
+        if hasBlocks:
+            webResources.append(INFLATE_SCRIPT)
+        else:
+            webResources.append('<script>ready()</script></body>')
 
         # Create new output file
         with open(srcHtmlPath, mode='r', encoding='utf8') as srcHtml:
@@ -147,16 +219,43 @@ def bundleDataToHTML(temp_dir, htmlFilePath, dataFilePath=None, compress=False):
                     else:
                         dstHtml.write(line)
 
-        # Generate zip file for the data
+        # Generate zip file for the data, with the blocks inflated back
         if dataFilePath is not None and os.path.exists(dataDir):
+            blocks = {}
             with zipfile.ZipFile(dataFilePath, mode='w') as zf:
-                for dirName, subdirList, fileList in os.walk(dataDir):
-                    for fname in fileList:
-                        fullPath = os.path.join(dirName, fname)
-                        filePath = os.path.relpath(fullPath, dataDir)
-                        relPath = '%s/%s' % (DATA_DIRECTORY, filePath)
-                        zf.write(fullPath, arcname=relPath,
-                                 compress_type=compression_type)
+                for relPath, fullPath in data_files(dataDir):
+                    match = BLOCK_PATTERN.match(relPath)
+                    if match:
+                        blocks.setdefault(match.group(1), []).append(
+                            (int(match.group(2)), fullPath))
+                        continue
+                    zf.write(fullPath, arcname=relPath,
+                             compress_type=compression_type)
+
+                for relPath, paths in blocks.items():
+                    content = b''.join(read_block(path)
+                                       for _, path in sorted(paths))
+                    zf.writestr(relPath, content,
+                                compress_type=zipfile.ZIP_DEFLATED)
+
+
+def data_files(dataDir):
+    """The (relative, full) paths of the data files."""
+    files = []
+    for dirName, subdirList, fileList in os.walk(dataDir):
+        for fname in fileList:
+            fullPath = os.path.join(dirName, fname)
+            filePath = os.path.relpath(fullPath, dataDir)
+            filePath = filePath.replace(os.sep, '/')
+            relPath = '%s/%s' % (DATA_DIRECTORY, filePath)
+            files.append((relPath, fullPath))
+
+    return sorted(files)
+
+
+def read_block(path):
+    with open(path, 'rb') as f:
+        return gzip.decompress(f.read())
 
 
 def get_proxy(id):
@@ -346,24 +445,59 @@ def get_trivial_producer():
     return None
 
 
-def array_sampler(srcDims, dstDims, scale, inputArray):
+def sample_volume(data, scale):
+    """Every scale-th voxel of a Fortran ordered (x, y, z) volume."""
     if scale == 1:
-        return inputArray
+        return data
 
-    newSize = dstDims[0] * dstDims[1] * dstDims[2]
-    outputArray = inputArray.NewInstance()
-    outputArray.SetNumberOfTuples(newSize)
-    offset = 0
-    for k in range(dstDims[2]):
-        for j in range(dstDims[1]):
-            for i in range(dstDims[0]):
-                srcIdx = (i * scale)
-                srcIdx += (j * scale * srcDims[0])
-                srcIdx += (k * scale * srcDims[0] * srcDims[1])
-                outputArray.SetValue(offset, inputArray.GetValue(srcIdx))
-                offset += 1
+    dstDims = [int(v / scale) for v in data.shape]
+    return data[:dstDims[0] * scale:scale,
+                :dstDims[1] * scale:scale,
+                :dstDims[2] * scale:scale]
+
+
+def quantization(data, bits):
+    """The (scale, offset) mapping the range of data onto bits bit integers,
+    values are quantized * scale + offset."""
+    valueMin = float(np.min(data))
+    valueMax = float(np.max(data))
+    if valueMax == valueMin:
+        return 1.0, valueMin
+    return (valueMax - valueMin) / (2 ** bits - 1), valueMin
+
+
+def quantize_volume(data, bits, scale, offset):
+    """Quantize slabs of a volume in parallel, numpy releases the GIL."""
+    dtype = np.uint8 if bits == 8 else np.uint16
+    output = np.empty(data.shape, dtype=dtype, order='F')
 
-    return outputArray
+    def quantize(z):
+        values = (data[:, :, z].astype(np.float64) - offset) / scale
+        output[:, :, z] = np.clip(np.rint(values), 0, 2 ** bits - 1)
+
+    with ThreadPoolExecutor() as executor:
+        list(executor.map(quantize, range(data.shape[2])))
+
+    return output
+
+
+def write_data_file(path, data, compress):
+    """Write the values of a volume, X varying fastest. Compressed files are
+    split in blocks compressed in parallel, see BLOCK_PATTERN."""
+    content = memoryview(np.asfortranarray(data).ravel(order='F')).cast('B')
+    if not compress:
+        with open(path, 'wb') as f:
+            f.write(content)
+        return
+
+    def write_block(index):
+        block = content[index * BLOCK_SIZE:(index + 1) * BLOCK_SIZE]
+        with open('%s.%d.gz' % (path, index), 'wb') as f:
+            f.write(gzip.compress(block, compresslevel=6))
+
+    count = max(1, -(-len(content) // BLOCK_SIZE))
+    with ThreadPoolExecutor() as executor:
+        list(executor.map(write_block, range(count)))
 
 # -----------------------------------------------------------------------------
 # Image based exporter
@@ -554,12 +688,46 @@ def export_contour_exploration_geometry(destinationPath, **kwargs):
 # -----------------------------------------------------------------------------
 
 
+def volume_json(name, data, dataId, metadata):
+    return {
+        'origin': [0, 0, 0],
+        'spacing': [1, 1, 1],
+        'extent': [0, data.shape[0] - 1,
+                   0, data.shape[1] - 1,
+                   0, data.shape[2] - 1],
+        'vtkClass': 'vtkImageData',
+        'metadata': metadata,
+        'pointData': {
+            'vtkClass': 'vtkDataSetAttributes',
+            'arrays': [{
+                'data': {
+                    'numberOfComponents': 1,
+                    'name': name,
+                    'vtkClass': 'vtkDataArray',
+                    'dataType': jsMapping[data.dtype.char],
+                    'ref': {
+                        'registration': 'setScalars',
+                        'encode': 'LittleEndian',
+                        'basepath': 'data',
+                        'id': dataId
+                    },
+                    'size': data.size
+                }
+            }]
+        }
+    }
+
+
 def export_volume(destinationPath, **kwargs):
     producer = get_trivial_producer()
     if not producer:
         return
 
     scale = int(kwargs['volumeScale'])
+    # Quantize to 8 or 16 bit integers, 0 keeps the values as they are
+    bits = int(kwargs.get('volumeBits', 0))
+    compress = bool(kwargs.get('volumeCompression', False))
+
     view = simple.GetRenderView()
     arraName = producer.GetPointDataInformation().GetArray(0).Name
     indexJSON = {
@@ -576,30 +744,6 @@ def export_volume(destinationPath, **kwargs):
         }],
         'metadata': {}
     }
-    volumeJSON = {
-        'origin': [0, 0, 0],
-        'spacing': [1, 1, 1],
-        'extent': [0, 1, 0, 1, 0, 1],
-        'vtkClass': 'vtkImageData',
-        'pointData': {
-            'vtkClass': 'vtkDataSetAttributes',
-            'arrays': [{
-                'data': {
-                    'numberOfComponents': 1,
-                    'name': arraName,
-                    'vtkClass': 'vtkDataArray',
-                    'dataType': 'Uint8Array',
-                    'ref': {
-                        'registration': 'setScalars',
-                        'encode': 'LittleEndian',
-                        'basepath': 'data',
-                        'id': 'fieldData'
-                    },
-                    'size': 0
-                }
-            }]
-        }
-    }
 
     # Add color map
     indexJSON['LookupTables'] = get_volume_lookuptable_section(view)
@@ -609,23 +753,27 @@ def export_volume(destinationPath, **kwargs):
     if not os.path.exists(dataDir):
         os.makedirs(dataDir)
 
-    # Extract data
+    # Extract data, in VTK (Fortran) order
     imageData = producer.SMProxy.GetClientSideObject().GetOutputDataObject(0)
     extent = imageData.GetExtent()
     srcDims = (extent[1] - extent[0] + 1,
                extent[3] - extent[2] + 1,
                extent[5] - extent[4] + 1)
-    dstDims = [int(v / scale) for v in srcDims]
-    volumeJSON['extent'] = [0, dstDims[0] - 1,
-                            0, dstDims[1] - 1,
-                            0, dstDims[2] - 1]
-
-    scalars = array_sampler(srcDims, dstDims, scale,
-                            imageData.GetPointData().GetScalars())
-    arraySize = scalars.GetNumberOfValues()
-    volumeJSON['pointData']['arrays'][0]['data']['size'] = arraySize
-    volumeJSON['pointData']['arrays'][0]['data']['dataType']  \
-        = jsMapping[arrayTypesMapping[scalars.GetDataType()]]
+    scalars = imageData.GetPointData().GetScalars()
+    data = np_s.vtk_to_numpy(scalars)
+    if scalars.GetNumberOfComponents() > 1:
+        data = data[:, 0]
+    data = sample_volume(data.reshape(srcDims, order='F'), scale)
+
+    metadata = {}
+    if bits in (8, 16):
+        valueScale, valueOffset = quantization(data, bits)
+        data = quantize_volume(data, bits, valueScale, valueOffset)
+        metadata['quantization'] = {
+            'bits': bits,
+            'scale': valueScale,
+            'offset': valueOffset
+        }
 
     # Extract piecewise function
     pvw = get_volume_piecewise(view)
@@ -635,22 +783,28 @@ def export_volume(destinationPath, **kwargs):
         for i in range(pvw.GetSize()):
             pvw.GetNodeValue(i, currentPoints)
             piecewiseNodes.append([v for v in currentPoints])
-        indexJSON['metadata'] = {'piecewise': piecewiseNodes}
+        if 'quantization' in metadata:
+            # The nodes map the quantized values as they did the data
+            for node in piecewiseNodes:
+                node[0] = (node[0] - valueOffset) / valueScale
+        metadata['piecewise'] = piecewiseNodes
+    indexJSON['metadata'] = metadata
 
     # Index file
     indexPath = os.path.join(destinationPath, 'index.json')
     with open(indexPath, 'w', encoding='utf8') as f:
         f.write(json.dumps(indexJSON, indent=2))
 
-    # Image Data file
+    # Image Data file. The viewer (the prebuilt tomviz.js) only reads
+    # volume.json, coarser levels of detail would be bundled but never shown.
+    volumeJSON = volume_json(arraName, data, 'fieldData',
+                             metadata.get('quantization', {}))
     volumePath = os.path.join(destinationPath, 'volume.json')
     with open(volumePath, 'w', encoding='utf8') as f:
         f.write(json.dumps(volumeJSON, indent=2))
 
     # Write data field
-    fieldDataPath = os.path.join(destinationPath, 'data', 'fieldData')
-    with open(fieldDataPath, 'wb') as f:
-        f.write(memoryview(scalars))
+    write_data_file(os.path.join(dataDir, 'fieldData'), data, compress)
 
 # -----------------------------------------------------------------------------
 # Composite exporter
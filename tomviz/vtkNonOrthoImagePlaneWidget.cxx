@@ -1325,6 +1325,16 @@ vtkImageData* vtkNonOrthoImagePlaneWidget::GetResliceOutput()
   return this->Reslice->GetOutput();
 }
 
+void vtkNonOrthoImagePlaneWidget::SetTextureInputData(vtkImageData* image)
+{
+  if (image) {
+    this->Texture->SetInputData(image);
+  } else if (this->ImageData) {
+    this->Texture->SetInputConnection(this->Reslice->GetOutputPort());
+  }
+  this->Modified();
+}
+
 void vtkNonOrthoImagePlaneWidget::SetPicker(vtkAbstractPropPicker* picker)
 {
   // we have to have a picker for slice motion, window level and cursor to work
@@ -235,6 +235,12 @@ public:
   // Convenience method to get the vtkImageReslice output.
   vtkImageData* GetResliceOutput();
 
+  // Description:
+  // Texture the plane with a 2D image covering it, along the axes of the
+  // plane, rather than with the vtkImageReslice output. E.g. a slice of the
+  // input at a higher resolution. nullptr restores the reslice output.
+  void SetTextureInputData(vtkImageData* image);
+
   // Description:
   // Set the callback that is called every time the mouse is moving over the
   // slice.
@@ -9,6 +9,8 @@
 #include "vtkImageData.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPTools.h"
 #include "vtkSmartPointer.h"
 #include "vtkStringArray.h"
 
@@ -19,6 +21,8 @@
 #include <iostream>
 #include <string>
 #include <algorithm>
+#include <atomic>
+#include <vector>
 
 extern "C" {
 #include "vtk_tiff.h"
@@ -134,6 +138,103 @@ bool ReadTemplatedImage(T* out, Flip flip,
   }
   return true;
 }
+
+// The part of a page to copy into the output
+struct PageRegion
+{
+  unsigned int Width;
+  unsigned int Height;
+  int StartCol;
+  int EndCol;
+  int StartRow;
+  int EndRow;
+  bool Flip;
+  size_t PixelSize;
+  size_t RowIncrement;
+};
+
+// Decodes only the strips or tiles of the current directory that overlap the
+// region, so the rows before it are never decompressed.
+bool ReadPageRegion(TIFF* image, char* out, const PageRegion& region)
+{
+  int height = static_cast<int>(region.Height);
+  int fileStartRow = region.Flip ? height - region.EndRow - 1
+                                 : region.StartRow;
+  int fileEndRow = region.Flip ? height - region.StartRow - 1
+                               : region.EndRow;
+  auto copyRow = [&](const char* in, int fileRow, int startCol, int endCol)
+  {
+    int row = region.Flip ? height - fileRow - 1 : fileRow;
+    memcpy(out + (row - region.StartRow) * region.RowIncrement +
+             (startCol - region.StartCol) * region.PixelSize,
+           in, (endCol - startCol + 1) * region.PixelSize);
+  };
+
+  if (TIFFIsTiled(image))
+  {
+    unsigned int tileWidth = 0, tileHeight = 0;
+    if (!TIFFGetField(image, TIFFTAG_TILEWIDTH, &tileWidth) ||
+        !TIFFGetField(image, TIFFTAG_TILELENGTH, &tileHeight))
+    {
+      return false;
+    }
+    std::vector<char> tile(TIFFTileSize(image));
+    int firstTileRow = fileStartRow - fileStartRow % tileHeight;
+    int firstTileCol = region.StartCol - region.StartCol % tileWidth;
+    for (int tileRow = firstTileRow; tileRow <= fileEndRow;
+         tileRow += tileHeight)
+    {
+      for (int tileCol = firstTileCol; tileCol <= region.EndCol;
+           tileCol += tileWidth)
+      {
+        ttile_t index = TIFFComputeTile(image, tileCol, tileRow, 0, 0);
+        if (TIFFReadEncodedTile(image, index, tile.data(), -1) < 0)
+        {
+          return false;
+        }
+        // Edge tiles are padded to the full tile size
+        int startCol = std::max(tileCol, region.StartCol);
+        int endCol =
+          std::min(tileCol + static_cast<int>(tileWidth) - 1, region.EndCol);
+        int startRow = std::max(tileRow, fileStartRow);
+        int endRow =
+          std::min(tileRow + static_cast<int>(tileHeight) - 1, fileEndRow);
+        for (int fileRow = startRow; fileRow <= endRow; ++fileRow)
+        {
+          copyRow(tile.data() + ((fileRow - tileRow) * tileWidth +
+                                 (startCol - tileCol)) * region.PixelSize,
+                  fileRow, startCol, endCol);
+        }
+      }
+    }
+    return true;
+  }
+
+  unsigned int rowsPerStrip = 0;
+  TIFFGetFieldDefaulted(image, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+  rowsPerStrip = std::min(std::max(rowsPerStrip, 1u), region.Height);
+  const size_t scanLineSize = region.Width * region.PixelSize;
+  std::vector<char> strip(TIFFStripSize(image));
+  for (int firstRow = fileStartRow - fileStartRow % rowsPerStrip;
+       firstRow <= fileEndRow; firstRow += rowsPerStrip)
+  {
+    tstrip_t index = TIFFComputeStrip(image, firstRow, 0);
+    if (TIFFReadEncodedStrip(image, index, strip.data(), -1) < 0)
+    {
+      return false;
+    }
+    int startRow = std::max(firstRow, fileStartRow);
+    int endRow =
+      std::min(firstRow + static_cast<int>(rowsPerStrip) - 1, fileEndRow);
+    for (int fileRow = startRow; fileRow <= endRow; ++fileRow)
+    {
+      copyRow(strip.data() + (fileRow - firstRow) * scanLineSize +
+                region.StartCol * region.PixelSize,
+              fileRow, region.StartCol, region.EndCol);
+    }
+  }
+  return true;
+}
 }
 
 //-------------------------------------------------------------------------
@@ -167,6 +268,9 @@ public:
   unsigned int TileHeight;
   unsigned short NumberOfTiles;
   unsigned int SubFiles;
+  // The directory offsets of the pages that are slices, to jump to a page
+  // without walking the directories before it
+  std::vector<toff_t> PageOffsets;
   unsigned int ResolutionUnit;
   float XResolution;
   float YResolution;
@@ -247,6 +351,7 @@ void vtkOMETiffReader::vtkOMETiffReaderInternal::Clean()
   this->XResolution = 1;
   this->YResolution = 1;
   this->SubFiles = 0;
+  this->PageOffsets.clear();
   this->SampleFormat = 1;
   this->ResolutionUnit = 1; // none
   this->IsOpen = false;
@@ -293,6 +398,8 @@ bool vtkOMETiffReader::vtkOMETiffReaderInternal::Initialize()
     TIFFGetField(this->Image, TIFFTAG_YRESOLUTION, &this->YResolution);
     TIFFGetField(this->Image, TIFFTAG_RESOLUTIONUNIT, &this->ResolutionUnit);
 
+    this->PageOffsets.assign(1, TIFFCurrentDirOffset(this->Image));
+
     // Check the number of pages. First by looking at the number of directories.
     this->NumberOfPages = TIFFNumberOfDirectories(this->Image);
     if (this->NumberOfPages == 0)
@@ -324,20 +431,35 @@ bool vtkOMETiffReader::vtkOMETiffReaderInternal::Initialize()
     if (this->NumberOfPages > 1)
     {
       this->SubFiles = 0;
+      this->PageOffsets.clear();
+      std::vector<toff_t> subFileOffsets;
 
       for (unsigned int page = 0; page<this->NumberOfPages; ++page)
       {
+        toff_t offset = TIFFCurrentDirOffset(this->Image);
+        this->PageOffsets.push_back(offset);
         long subfiletype = 6;
         if (TIFFGetField(this->Image, TIFFTAG_SUBFILETYPE, &subfiletype))
         {
           if (subfiletype == 0)
           {
             this->SubFiles += 1;
+            subFileOffsets.push_back(offset);
           }
         }
+        else
+        {
+          subFileOffsets.push_back(offset);
+        }
         TIFFReadDirectory(this->Image);
       }
 
+      // Only the subfiles are slices, if there are any
+      if (this->SubFiles > 0)
+      {
+        this->PageOffsets = subFileOffsets;
+      }
+
       // Set the directory to the first image
       TIFFSetDirectory(this->Image, 0);
     }
@@ -615,6 +737,14 @@ void vtkOMETiffReader::Process2(OT *outPtr, int *)
 template <class OT>
 void vtkOMETiffReader::Process(OT *outPtr, int outExtent[6], vtkIdType outIncr[3])
 {
+  // grayscale pages, decoded in parallel
+  if (this->ReadPages(outPtr, sizeof(OT)))
+  {
+    // close the TIFF file
+    this->InternalImage->Clean();
+    return;
+  }
+
   // multiple number of pages
   if (this->InternalImage->NumberOfPages > 1)
   {
@@ -922,6 +1052,83 @@ void vtkOMETiffReader::ReadVolume(T* buffer)
   }
 }
 
+//-------------------------------------------------------------------------
+bool vtkOMETiffReader::ReadPages(void* buffer, int scalarSize)
+{
+  vtkOMETiffReaderInternal* internal = this->InternalImage;
+  if (!internal->IsOpen && !internal->Open(this->GetInternalFileName()))
+  {
+    return false;
+  }
+  if (!internal->CanRead() ||
+      this->GetFormat() != vtkOMETiffReader::GRAYSCALE ||
+      internal->Photometrics != PHOTOMETRIC_MINISBLACK ||
+      internal->SamplesPerPixel != 1 ||
+      internal->BitsPerSample != 8 * scalarSize ||
+      internal->Width != internal->OmeSizeX ||
+      internal->Height != internal->OmeSizeY ||
+      this->OutputIncrements[0] != 1 ||
+      this->OutputExtent[5] >= static_cast<int>(internal->PageOffsets.size()))
+  {
+    return false;
+  }
+
+  PageRegion region;
+  region.Width = internal->Width;
+  region.Height = internal->Height;
+  region.StartCol = this->OutputExtent[0];
+  region.EndCol = this->OutputExtent[1];
+  region.StartRow = this->OutputExtent[2];
+  region.EndRow = this->OutputExtent[3];
+  region.Flip = internal->Orientation != ORIENTATION_TOPLEFT;
+  region.PixelSize = scalarSize;
+  region.RowIncrement = this->OutputIncrements[1] * scalarSize;
+  const size_t sliceIncrement = this->OutputIncrements[2] * scalarSize;
+  const int startSlice = this->OutputExtent[4];
+  const char* fileName = this->GetInternalFileName();
+
+  vtkSMPThreadLocal<TIFF*> images(nullptr);
+  std::atomic<bool> failed(false);
+  vtkSMPTools::For(startSlice, this->OutputExtent[5] + 1,
+                   [&](vtkIdType begin, vtkIdType end)
+  {
+    TIFF*& image = images.Local();
+    if (!image)
+    {
+      image = TIFFOpen(fileName, "r");
+    }
+    for (vtkIdType slice = begin; slice < end && !failed; ++slice)
+    {
+      char* out = static_cast<char*>(buffer) +
+                  (slice - startSlice) * sliceIncrement;
+      if (!image ||
+          !TIFFSetSubDirectory(image, internal->PageOffsets[slice]) ||
+          !ReadPageRegion(image, out, region))
+      {
+        failed = true;
+      }
+    }
+  });
+
+  for (auto it = images.begin(); it != images.end(); ++it)
+  {
+    if (*it)
+    {
+      TIFFClose(*it);
+    }
+  }
+  if (failed)
+  {
+    // Process() reads the pages again, one at a time, and reports their
+    // errors
+    vtkWarningMacro(<< "Problem reading the pages of the TIFF file in "
+                       "parallel, reading them serially.");
+    return false;
+  }
+  this->UpdateProgress(1.0);
+  return true;
+}
+
 /** Read a tiled tiff */
 void vtkOMETiffReader::ReadTiles(void* buffer)
 {
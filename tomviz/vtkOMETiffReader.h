@@ -90,6 +90,13 @@ private:
    */
   void ReadTiles(void* buffer);
 
+  /**
+   * Decodes the pages of the output extent in parallel, by strip or by tile,
+   * with one TIFF handle per thread. Returns false if the image needs the
+   * generic readers instead, or if a page could not be read.
+   */
+  bool ReadPages(void* buffer, int scalarSize);
+
   /**
    * Reads a generic image.
    */